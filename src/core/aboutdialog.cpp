@@ -30,9 +30,11 @@
 #include "aboutdialog.h"
 #include <QDomDocument>
 #include "util/sys/sysinfo.h"
+#include "util/threads/workerthreadbase.h"
 #include "interfaces/ihavediaginfo.h"
 #include "core.h"
 #include "coreproxy.h"
+#include "entitydispatchindex.h"
 
 namespace LeechCraft
 {
@@ -241,6 +243,13 @@ namespace LeechCraft
 		if (!unPathedModules.isEmpty ())
 			text += QString ("Adapted plugins:") + "\n" + unPathedModules.join ("\n") + "\n\n";
 
+		text += pm->GetEntityDispatchIndex ()->GetDiagInfo ();
+		text += pm->GetCastableLookupsDiagInfo ();
+
+		const auto& workersInfo = Util::WorkerThreadBase::GetDiagInfo ();
+		if (!workersInfo.isEmpty ())
+			text += "\nWorker threads:\n" + workersInfo;
+
 		Ui_.DiagInfo_->setPlainText (text);
 	}
 }
@@ -364,7 +364,7 @@ namespace LeechCraft
 
 			CustomCookieJar *jar = static_cast<CustomCookieJar*> (NetworkAccessManager_->cookieJar ());
 			jar->setAllCookies (QList<QNetworkCookie> ());
-			jar->Save ();
+			jar->FlushJournal ();
 		}
 		else if (name == "SetStartupPassword")
 		{
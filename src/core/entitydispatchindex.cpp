@@ -0,0 +1,286 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+
+#include "entitydispatchindex.h"
+#include <algorithm>
+#include <QUrl>
+#include <QtDebug>
+#include "interfaces/iinfo.h"
+#include "interfaces/idownload.h"
+#include "interfaces/ientityhandler.h"
+#include "interfaces/ientitydispatchhints.h"
+#include "interfaces/structures.h"
+
+namespace LeechCraft
+{
+	void EntityDispatchIndex::Timing::Add (qint64 nsecs)
+	{
+		++Count_;
+		TotalNs_ += nsecs;
+		MaxNs_ = std::max (MaxNs_, nsecs);
+	}
+
+	void EntityDispatchIndex::Update (const QObjectList& plugins,
+			const ManifestGetter_f& getManifest,
+			const QList<PendingHints>& pending)
+	{
+		QWriteLocker locker { &Lock_ };
+		if (IsBuilt_ && plugins == Plugins_)
+			return;
+
+		Plugins_ = plugins;
+		Pending_ = pending;
+		Order_.clear ();
+		Downloaders_ = {};
+		Handlers_ = {};
+
+		for (int i = 0; i < plugins.size (); ++i)
+		{
+			const auto plugin = plugins.at (i);
+			Order_ [plugin] = i;
+
+			const bool isDl = qobject_cast<IDownload*> (plugin);
+			const bool isEh = qobject_cast<IEntityHandler*> (plugin);
+			if (!isDl && !isEh)
+				continue;
+
+			const auto& manifest = getManifest (plugin);
+			if (isDl)
+				AddToBucket (Downloaders_, plugin, manifest);
+			if (isEh)
+				AddToBucket (Handlers_, plugin, manifest);
+		}
+
+		IsBuilt_ = true;
+
+		QMutexLocker timingsLocker { &TimingsLock_ };
+		for (auto i = PluginTimings_.begin (); i != PluginTimings_.end (); )
+			if (Order_.contains (i.key ()))
+				++i;
+			else
+				i = PluginTimings_.erase (i);
+	}
+
+	bool EntityDispatchIndex::IsBuilt () const
+	{
+		QReadLocker locker { &Lock_ };
+		return IsBuilt_;
+	}
+
+	QObjectList EntityDispatchIndex::GetCandidates (Kind kind, const Entity& e) const
+	{
+		QReadLocker locker { &Lock_ };
+		return Collect (GetBucket (kind), e);
+	}
+
+	EntityDispatchIndex::Verdict EntityDispatchIndex::Precheck (Kind kind, const Entity& e) const
+	{
+		QReadLocker locker { &Lock_ };
+		const auto& bucket = GetBucket (kind);
+		if (!bucket.Unhinted_.isEmpty () ||
+				!bucket.Dynamic_.isEmpty () ||
+				!CollectHinted (bucket, e).isEmpty ())
+			return Verdict::MustQuery;
+
+		const bool pendingMatches = std::any_of (Pending_.begin (), Pending_.end (),
+				[&e] (const PendingHints& hints) { return MatchesHints (e, hints.Mimes_, hints.Schemes_); });
+		return pendingMatches ?
+				Verdict::MustQuery :
+				Verdict::CannotHandle;
+	}
+
+	void EntityDispatchIndex::RecordDispatch (const Entity& e, qint64 nsecs, const PluginTimings_t& pluginTimings)
+	{
+		const auto& mime = e.Mime_.isEmpty () ?
+				QString { "<%1>" }.arg (e.Entity_.typeName ()) :
+				e.Mime_;
+
+		QMutexLocker locker { &TimingsLock_ };
+		MimeTimings_ [mime].Add (nsecs);
+		for (auto i = pluginTimings.begin (), end = pluginTimings.end (); i != end; ++i)
+			PluginTimings_ [i.key ()].Add (i.value ());
+	}
+
+	namespace
+	{
+		template<typename K, typename T, typename F>
+		QString FormatTimings (const QHash<K, T>& timings, const F& keyName)
+		{
+			auto keys = timings.keys ();
+			std::sort (keys.begin (), keys.end (),
+					[&timings] (const K& left, const K& right)
+						{ return timings [left].TotalNs_ > timings [right].TotalNs_; });
+
+			QString result;
+			for (const auto& key : keys)
+			{
+				const auto& timing = timings [key];
+				result += QString { "  %1: %2 calls, %3 us total, %4 us avg, %5 us max\n" }
+						.arg (keyName (key))
+						.arg (timing.Count_)
+						.arg (timing.TotalNs_ / 1000)
+						.arg (timing.TotalNs_ / 1000 / std::max<qint64> (timing.Count_, 1))
+						.arg (timing.MaxNs_ / 1000);
+			}
+			return result;
+		}
+	}
+
+	QString EntityDispatchIndex::GetDiagInfo () const
+	{
+		QMutexLocker locker { &TimingsLock_ };
+
+		QString result;
+		result += "Entity dispatch timings by entity type:\n";
+		result += FormatTimings (MimeTimings_, [] (const QString& mime) { return mime; });
+		result += "Entity dispatch timings by plugin:\n";
+		result += FormatTimings (PluginTimings_,
+				[] (QObject *plugin)
+				{
+					const auto ii = qobject_cast<IInfo*> (plugin);
+					return ii ? ii->GetName () : plugin->objectName ();
+				});
+		return result;
+	}
+
+	void EntityDispatchIndex::AddToBucket (Bucket& bucket, QObject *plugin, const QVariantMap& manifest)
+	{
+		if (manifest ["DynamicEntityHandling"].toBool ())
+		{
+			bucket.Dynamic_ << plugin;
+			return;
+		}
+
+		QStringList mimes;
+		QStringList schemes;
+		if (const auto hints = qobject_cast<IEntityDispatchHints*> (plugin))
+		{
+			mimes = hints->GetHandledMimes ();
+			schemes = hints->GetHandledUrlSchemes ();
+		}
+		else
+		{
+			mimes = manifest ["HandledMimes"].toStringList ();
+			schemes = manifest ["HandledUrlSchemes"].toStringList ();
+
+			if (mimes.isEmpty () && schemes.isEmpty ())
+			{
+				bucket.Unhinted_ << plugin;
+				return;
+			}
+		}
+
+		for (const auto& mime : mimes)
+		{
+			if (mime.endsWith ("/*"))
+				bucket.MimeTypes_ [mime.left (mime.size () - 2)] << plugin;
+			else
+				bucket.Mimes_ [mime] << plugin;
+		}
+
+		for (const auto& scheme : schemes)
+			bucket.Schemes_ [scheme.toLower ()] << plugin;
+	}
+
+	const EntityDispatchIndex::Bucket& EntityDispatchIndex::GetBucket (Kind kind) const
+	{
+		switch (kind)
+		{
+		case Kind::Downloader:
+			return Downloaders_;
+		case Kind::Handler:
+			return Handlers_;
+		}
+
+		return Handlers_;
+	}
+
+	namespace
+	{
+		QString GetScheme (const QVariant& entity)
+		{
+			switch (entity.type ())
+			{
+			case QVariant::Url:
+				return entity.toUrl ().scheme ().toLower ();
+			case QVariant::String:
+				return QUrl { entity.toString () }.scheme ().toLower ();
+			default:
+				return {};
+			}
+		}
+	}
+
+	bool EntityDispatchIndex::MatchesHints (const Entity& e,
+			const QStringList& mimes, const QStringList& schemes)
+	{
+		if (!e.Mime_.isEmpty ())
+		{
+			if (mimes.contains (e.Mime_))
+				return true;
+
+			const auto& wildcard = e.Mime_.section ('/', 0, 0) + "/*";
+			if (mimes.contains (wildcard))
+				return true;
+		}
+
+		const auto& scheme = GetScheme (e.Entity_);
+		return !scheme.isEmpty () && schemes.contains (scheme, Qt::CaseInsensitive);
+	}
+
+	QObjectList EntityDispatchIndex::CollectHinted (const Bucket& bucket, const Entity& e) const
+	{
+		QObjectList hinted;
+		if (!e.Mime_.isEmpty ())
+		{
+			hinted += bucket.Mimes_.value (e.Mime_);
+			hinted += bucket.MimeTypes_.value (e.Mime_.section ('/', 0, 0));
+		}
+
+		const auto& scheme = GetScheme (e.Entity_);
+		if (!scheme.isEmpty ())
+			hinted += bucket.Schemes_.value (scheme);
+
+		return hinted;
+	}
+
+	QObjectList EntityDispatchIndex::Collect (const Bucket& bucket, const Entity& e) const
+	{
+		const auto& hinted = CollectHinted (bucket, e);
+		if (hinted.isEmpty () && bucket.Dynamic_.isEmpty ())
+			return bucket.Unhinted_;
+
+		auto result = bucket.Unhinted_ + bucket.Dynamic_ + hinted;
+		std::sort (result.begin (), result.end (),
+				[this] (QObject *left, QObject *right) { return Order_ [left] < Order_ [right]; });
+		result.erase (std::unique (result.begin (), result.end ()), result.end ());
+		return result;
+	}
+}
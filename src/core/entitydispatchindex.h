@@ -0,0 +1,187 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+
+#pragma once
+
+#include <functional>
+#include <QHash>
+#include <QObjectList>
+#include <QVariantMap>
+#include <QReadWriteLock>
+#include <QMutex>
+#include <QStringList>
+
+namespace LeechCraft
+{
+	struct Entity;
+
+	/** @brief Preselects the plugins that may be interested in an entity.
+	 *
+	 * The index groups the IDownload and IEntityHandler plugins by the
+	 * MIME types and URL schemes declared via IEntityDispatchHints or
+	 * via the HandledMimes and HandledUrlSchemes keys of the plugin
+	 * manifest, so only the relevant plugins are asked whether they can
+	 * handle an entity. Plugins declaring no hints at all are always
+	 * considered candidates.
+	 *
+	 * A plugin may explicitly opt out of the hints by setting the
+	 * DynamicEntityHandling manifest key. Such plugins are always
+	 * considered candidates as well.
+	 *
+	 * The index is (re)built in the main thread via Update(), while
+	 * GetCandidates() and Precheck() may be called from any thread.
+	 *
+	 * The index also collects the timings of the entity dispatches,
+	 * which are available via GetDiagInfo().
+	 */
+	class EntityDispatchIndex
+	{
+	public:
+		enum class Kind
+		{
+			Downloader,
+			Handler
+		};
+
+		/** @brief The answer of the index alone about an entity.
+		 */
+		enum class Verdict
+		{
+			/** @brief No plugin can be interested in the entity.
+			 */
+			CannotHandle,
+
+			/** @brief Some plugins may be interested in the entity, so
+			 * they should be queried.
+			 */
+			MustQuery
+		};
+
+		/** @brief The hints declared by a plugin that isn't loaded yet.
+		 */
+		struct PendingHints
+		{
+			QStringList Mimes_;
+			QStringList Schemes_;
+		};
+
+		typedef std::function<QVariantMap (QObject*)> ManifestGetter_f;
+		typedef QHash<QObject*, qint64> PluginTimings_t;
+	private:
+		struct Bucket
+		{
+			QObjectList Unhinted_;
+			QObjectList Dynamic_;
+			QHash<QString, QObjectList> Mimes_;
+			QHash<QString, QObjectList> MimeTypes_;
+			QHash<QString, QObjectList> Schemes_;
+		};
+
+		mutable QReadWriteLock Lock_;
+		bool IsBuilt_ = false;
+		QObjectList Plugins_;
+		QHash<QObject*, int> Order_;
+		Bucket Downloaders_;
+		Bucket Handlers_;
+		QList<PendingHints> Pending_;
+
+		struct Timing
+		{
+			quint64 Count_ = 0;
+			qint64 TotalNs_ = 0;
+			qint64 MaxNs_ = 0;
+
+			void Add (qint64);
+		};
+
+		mutable QMutex TimingsLock_;
+		QHash<QString, Timing> MimeTimings_;
+		QHash<QObject*, Timing> PluginTimings_;
+	public:
+		/** @brief Rebuilds the index if the list of plugins changed.
+		 *
+		 * This function must be called from the main thread.
+		 *
+		 * @param[in] plugins The list of all the loaded plugins.
+		 * @param[in] getManifest The function returning the manifest
+		 * of the given plugin.
+		 * @param[in] pending The hints of the lazy plugins that aren't
+		 * loaded yet.
+		 */
+		void Update (const QObjectList& plugins,
+				const ManifestGetter_f& getManifest,
+				const QList<PendingHints>& pending);
+
+		/** @brief Checks whether the index has been built at least once.
+		 */
+		bool IsBuilt () const;
+
+		/** @brief Returns the plugins of the given kind which may be
+		 * interested in the given entity.
+		 *
+		 * The plugins are returned in the order they appear in the
+		 * list passed to Update().
+		 */
+		QObjectList GetCandidates (Kind, const Entity&) const;
+
+		/** @brief Tells whether the entity can be ruled out without
+		 * querying any plugin.
+		 *
+		 * The hints are only used to rule the plugins out: a plugin
+		 * whose hints match the entity may still reject it in its
+		 * CouldHandle(), so MustQuery is returned if any hinted,
+		 * unhinted or dynamic plugin, or a lazy plugin that isn't
+		 * loaded yet, may be interested in the entity.
+		 */
+		Verdict Precheck (Kind, const Entity&) const;
+
+		/** @brief Checks whether the entity matches the given hints.
+		 *
+		 * The hints have the same format as the ones returned by
+		 * IEntityDispatchHints.
+		 */
+		static bool MatchesHints (const Entity&, const QStringList& mimes, const QStringList& schemes);
+
+		/** @brief Records the timings of a single entity dispatch.
+		 *
+		 * @param[in] e The dispatched entity.
+		 * @param[in] nsecs The total time of the dispatch.
+		 * @param[in] pluginTimings The time each queried plugin took.
+		 */
+		void RecordDispatch (const Entity& e, qint64 nsecs, const PluginTimings_t& pluginTimings);
+
+		QString GetDiagInfo () const;
+	private:
+		void AddToBucket (Bucket&, QObject*, const QVariantMap&);
+		const Bucket& GetBucket (Kind) const;
+		QObjectList CollectHinted (const Bucket&, const Entity&) const;
+		QObjectList Collect (const Bucket&, const Entity&) const;
+	};
+}
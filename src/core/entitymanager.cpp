@@ -31,6 +31,7 @@
 #include <functional>
 #include <algorithm>
 #include <QThread>
+#include <QElapsedTimer>
 #include <QDesktopServices>
 #include <QUrl>
 #include "util/util.h"
@@ -42,6 +43,7 @@
 #include "interfaces/entitytesthandleresult.h"
 #include "core.h"
 #include "pluginmanager.h"
+#include "entitydispatchindex.h"
 #include "xmlsettingsmanager.h"
 #include "handlerchoicedialog.h"
 
@@ -55,17 +57,22 @@ namespace LeechCraft
 	namespace
 	{
 		template<typename T, typename F>
-		QObjectList GetSubtype (const Entity& e, bool fullScan, const F& queryFunc)
+		QObjectList GetSubtype (const Entity& e, EntityDispatchIndex::Kind kind, bool fullScan,
+				EntityDispatchIndex::PluginTimings_t& timings, const F& queryFunc)
 		{
-			auto pm = Core::Instance ().GetPluginManager ();
+			const auto index = Core::Instance ().GetPluginManager ()->GetEntityDispatchIndex ();
+
 			QMap<int, QObjectList> result;
 			int cutoffPriority = 0;
-			for (const auto& plugin : pm->GetAllCastableRoots<T> ())
+			for (const auto& plugin : index->GetCandidates (kind, e))
 			{
 				EntityTestHandleResult r;
 				try
 				{
+					QElapsedTimer timer;
+					timer.start ();
 					r = queryFunc (e, qobject_cast<T> (plugin));
+					timings [plugin] += timer.nsecsElapsed ();
 				}
 				catch (const std::exception& e)
 				{
@@ -116,6 +123,15 @@ namespace LeechCraft
 			if (Core::Instance ().IsShuttingDown ())
 				return {};
 
+			const auto pm = Core::Instance ().GetPluginManager ();
+			pm->LoadLazyPlugins (e);
+
+			pm->UpdateEntityDispatchIndex ();
+			const auto index = pm->GetEntityDispatchIndex ();
+
+			QElapsedTimer timer;
+			timer.start ();
+
 			const auto& unwanted = e.Additional_ ["IgnorePlugins"].toStringList ();
 			auto removeUnwanted = [&unwanted] (QObjectList& handlers)
 			{
@@ -125,10 +141,12 @@ namespace LeechCraft
 				handlers.erase (remBegin, handlers.end ());
 			};
 
+			EntityDispatchIndex::PluginTimings_t timings;
+
 			QObjectList result;
 			if (!(e.Parameters_ & TaskParameter::OnlyHandle))
 			{
-				auto sub = GetSubtype<IDownload*> (e, true,
+				auto sub = GetSubtype<IDownload*> (e, EntityDispatchIndex::Kind::Downloader, true, timings,
 						[] (Entity e, IDownload *dl) { return dl->CouldDownload (e); });
 				removeUnwanted (sub);
 				if (downloaders)
@@ -137,13 +155,15 @@ namespace LeechCraft
 			}
 			if (!(e.Parameters_ & TaskParameter::OnlyDownload))
 			{
-				auto sub = GetSubtype<IEntityHandler*> (e, true,
+				auto sub = GetSubtype<IEntityHandler*> (e, EntityDispatchIndex::Kind::Handler, true, timings,
 						[] (Entity e, IEntityHandler *eh) { return eh->CouldHandle (e); });
 				removeUnwanted (sub);
 				if (handlers)
 					*handlers = sub.size ();
 				result += sub;
 			}
+
+			index->RecordDispatch (e, timer.nsecsElapsed (), timings);
 			return result;
 		}
 
@@ -280,10 +300,42 @@ namespace LeechCraft
 		return {};
 	}
 
+	namespace
+	{
+		/* Answers whether the entity can be ruled out from the dispatch
+		 * index alone, without calling into any plugin, so this is safe
+		 * to call from any thread.
+		 */
+		EntityDispatchIndex::Verdict Precheck (const Entity& e)
+		{
+			const auto index = Core::Instance ().GetPluginManager ()->GetEntityDispatchIndex ();
+			if (!index->IsBuilt ())
+				return EntityDispatchIndex::Verdict::MustQuery;
+
+			QList<EntityDispatchIndex::Verdict> verdicts;
+			if (!(e.Parameters_ & TaskParameter::OnlyHandle))
+				verdicts << index->Precheck (EntityDispatchIndex::Kind::Downloader, e);
+			if (!(e.Parameters_ & TaskParameter::OnlyDownload))
+				verdicts << index->Precheck (EntityDispatchIndex::Kind::Handler, e);
+
+			if (verdicts.contains (EntityDispatchIndex::Verdict::MustQuery))
+				return EntityDispatchIndex::Verdict::MustQuery;
+			return EntityDispatchIndex::Verdict::CannotHandle;
+		}
+	}
+
 	bool EntityManager::CouldHandle (const Entity& e)
 	{
 		if (QThread::currentThread () != thread ())
 		{
+			switch (Precheck (e))
+			{
+			case EntityDispatchIndex::Verdict::CannotHandle:
+				return false;
+			case EntityDispatchIndex::Verdict::MustQuery:
+				break;
+			}
+
 			bool res = false;
 			QMetaObject::invokeMethod (this,
 					"CouldHandle",
@@ -98,15 +98,19 @@ NetworkAccessManager::NetworkAccessManager (QObject *parent)
 			<< "so continuing without cache";
 	}
 
-	QFile file (QDir::homePath () +
-			"/.leechcraft/core/cookies.txt");
-	if (file.open (QIODevice::ReadOnly))
-		CookieJar_->Load (file.readAll ());
-	else
-		qWarning () << Q_FUNC_INFO
-			<< "could not open file"
-			<< file.fileName ()
-			<< file.errorString ();
+	if (!CookieJar_->LoadJournal (QDir::homePath () + "/.leechcraft/core/cookies.journal"))
+	{
+		// Import the cookies saved by the previous versions.
+		QFile file (QDir::homePath () +
+				"/.leechcraft/core/cookies.txt");
+		if (file.open (QIODevice::ReadOnly))
+			CookieJar_->Load (file.readAll ());
+		else
+			qWarning () << Q_FUNC_INFO
+				<< "could not open file"
+				<< file.fileName ()
+				<< file.errorString ();
+	}
 
 	connect (CookieSaveTimer_,
 			SIGNAL (timeout ()),
@@ -166,19 +170,12 @@ void LeechCraft::NetworkAccessManager::saveCookies () const
 		return;
 	}
 
-	QFile file (QDir::homePath () +
-			"/.leechcraft/core/cookies.txt");
-	if (!file.open (QIODevice::WriteOnly | QIODevice::Truncate))
-	{
-		emit error (tr ("Could not save cookies, error opening cookie file."));
-		qWarning () << Q_FUNC_INFO
-			<< file.errorString ();
-		return;
-	}
-
 	const bool saveEnabled = !XmlSettingsManager::Instance ()->
 			property ("DeleteCookiesOnExit").toBool ();
-	file.write (saveEnabled ? CookieJar_->Save () : QByteArray ());
+	if (saveEnabled)
+		CookieJar_->FlushJournal ();
+	else
+		CookieJar_->DiscardJournal ();
 }
 
 void LeechCraft::NetworkAccessManager::handleFilterTrackingCookies ()
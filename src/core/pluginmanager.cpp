@@ -39,11 +39,16 @@
 #include <QtConcurrentMap>
 #include <QMessageBox>
 #include <QMainWindow>
+#include <QThread>
+#include <QReadLocker>
 #include <util/util.h>
 #include <util/exceptions.h>
 #include <util/sll/prelude.h>
 #include <util/sll/util.h>
+#include <util/threads/affinity.h>
 #include <interfaces/iinfo.h>
+#include <interfaces/idownload.h>
+#include <interfaces/ientityhandler.h>
 #include <interfaces/iplugin2.h>
 #include <interfaces/ipluginready.h>
 #include <interfaces/ipluginadaptor.h>
@@ -55,6 +60,9 @@
 #include "xmlsettingsmanager.h"
 #include "coreproxy.h"
 #include "plugintreebuilder.h"
+#include "entitydispatchindex.h"
+#include "pluginregistry.h"
+#include "startuptrace.h"
 #include "config.h"
 #include "coreinstanceobject.h"
 #include "shortcutmanager.h"
@@ -75,6 +83,8 @@ namespace LeechCraft
 	: QAbstractItemModel (parent)
 	, DBusMode_ (static_cast<Application*> (qApp)->GetVarMap ().count ("multiprocess"))
 	, PluginTreeBuilder_ (new PluginTreeBuilder)
+	, DispatchIndex_ (std::make_shared<EntityDispatchIndex> ())
+	, Registry_ (std::make_shared<PluginRegistry> ())
 	, CacheValid_ (false)
 	{
 		Headers_ << tr ("Name")
@@ -386,52 +396,157 @@ namespace LeechCraft
 		}
 	};
 
-	QObject* PluginManager::TryFirstInit (QObjectList ordered, PluginLoadProcess *proc)
+	namespace
+	{
+		struct InitTask
+		{
+			QObject *Object_;
+			QString Name_;
+			ICoreProxy_ptr Proxy_;
+		};
+
+		/* Returns an empty string on success and the error otherwise.
+		 */
+		QString RunInit (const InitTask& task)
+		{
+			const auto measure = StartupTrace::Instance ().Measure ("Init", task.Name_);
+			try
+			{
+				qobject_cast<IInfo*> (task.Object_)->Init (task.Proxy_);
+			}
+			catch (const std::exception& e)
+			{
+				return QString::fromUtf8 (e.what ());
+			}
+			catch (...)
+			{
+				return "unknown exception";
+			}
+
+			return {};
+		}
+
+		/* Runs Init() of a plugin whose instance has been detached from
+		 * the main thread, so the objects it parents to the instance live
+		 * in the calling thread and are brought back together with it.
+		 */
+		QString RunDetachedInit (const InitTask& task)
+		{
+			QString error;
+			Util::RunAttached (task.Object_, qApp->thread (),
+					[&task, &error] { error = RunInit (task); });
+			return error;
+		}
+	}
+
+	QObjectList PluginManager::TryFirstInit (const QObjectList& ordered,
+			QSet<QObject*>& initialized, PluginLoadProcess *proc)
 	{
 		QSettings settings (QCoreApplication::organizationName (),
 				QCoreApplication::applicationName () + "-pg");
 		settings.beginGroup ("Plugins");
 		const auto guard = Util::MakeScopeGuard ([&settings] { settings.endGroup (); });
 
-		for (const auto obj : ordered)
+		auto handleInitialized = [this, &settings, &initialized, proc] (QObject *obj)
 		{
-			const auto ii = qobject_cast<IInfo*> (obj);
-			try
+			initialized << obj;
+			++*proc;
+
+			const auto& path = GetPluginLibraryPath (obj);
+			if (path.isEmpty ())
+				return;
+
+			settings.beginGroup (path);
+			settings.setValue ("Info", qobject_cast<IInfo*> (obj)->GetInfo ());
+			settings.endGroup ();
+		};
+
+		auto makeTask = [] (QObject *obj)
+		{
+			return InitTask { obj, qobject_cast<IInfo*> (obj)->GetName (), std::make_shared<CoreProxy> () };
+		};
+
+		auto pending = Util::Filter (ordered,
+				[&initialized] (QObject *obj) { return !initialized.contains (obj); });
+		while (!pending.isEmpty ())
+		{
+			const auto& batch = Util::Filter (pending,
+					[this, &initialized] (QObject *obj)
+					{
+						if (!IsThreadSafeInit (obj))
+							return false;
+
+						const auto& deps = PluginTreeBuilder_->GetDependencies (obj);
+						return std::all_of (deps.begin (), deps.end (),
+								[&initialized] (QObject *dep) { return initialized.contains (dep); });
+					});
+
+			if (batch.size () > 1)
 			{
-				qDebug () << "Initializing" << ii->GetName ();
-				emit loadProgress (tr ("Initializing %1: stage one...").arg (ii->GetName ()));
-				ii->Init (std::make_shared<CoreProxy> ());
+				emit loadProgress (tr ("Initializing %n plugin(s) in parallel: stage one...", 0, batch.size ()));
 
-				const auto& path = GetPluginLibraryPath (obj);
-				if (path.isEmpty ())
-					continue;
+				// Qt only lets a thread pull in an object with no thread
+				// affinity, and RunDetachedInit() brings it back.
+				for (const auto obj : batch)
+					obj->moveToThread (nullptr);
 
-				settings.beginGroup (path);
-				settings.setValue ("Info", ii->GetInfo ());
-				settings.endGroup ();
+				auto future = QtConcurrent::mapped (Util::Map (batch, makeTask),
+						std::function<QString (InitTask)> (RunDetachedInit));
+				future.waitForFinished ();
+				const auto& errors = future.results ();
+
+				QObjectList failed;
+				for (int i = 0; i < batch.size (); ++i)
+				{
+					const auto obj = batch.at (i);
+					pending.removeOne (obj);
+
+					if (errors.at (i).isEmpty ())
+						handleInitialized (obj);
+					else
+					{
+						qWarning () << Q_FUNC_INFO
+								<< "while initializing"
+								<< obj
+								<< "got"
+								<< errors.at (i);
+						failed << obj;
+					}
+				}
+
+				if (!failed.isEmpty ())
+					return failed;
+
+				continue;
 			}
-			catch (const std::exception& e)
+
+			const auto obj = pending.takeFirst ();
+			const auto& task = makeTask (obj);
+
+			qDebug () << "Initializing" << task.Name_;
+			emit loadProgress (tr ("Initializing %1: stage one...").arg (task.Name_));
+
+			const auto& error = RunInit (task);
+			if (!error.isEmpty ())
 			{
 				qWarning () << Q_FUNC_INFO
 						<< "while initializing"
 						<< obj
 						<< "got"
-						<< e.what ();
-				return obj;
-			}
-			catch (...)
-			{
-				qWarning () << Q_FUNC_INFO
-						<< "while initializing"
-						<< obj
-						<< "caught unknown exception";
-				return obj;
+						<< error;
+				return { obj };
 			}
 
-			++*proc;
+			handleInitialized (obj);
 		}
 
-		return 0;
+		return {};
+	}
+
+	bool PluginManager::IsThreadSafeInit (QObject *obj) const
+	{
+		const auto& loader = Obj2Loader_.value (obj);
+		return loader && Registry_->GetManifest (loader) ["ThreadSafeInit"].toBool ();
 	}
 
 	void PluginManager::TryUnload (QObjectList plugins)
@@ -455,8 +570,19 @@ namespace LeechCraft
 
 	void PluginManager::Init (bool safeMode)
 	{
+		const auto& varMap = static_cast<Application*> (qApp)->GetVarMap ();
+		const auto& tracePath = varMap.count ("startup-trace") ?
+				QString::fromStdString (varMap ["startup-trace"].as<std::string> ()) :
+				QString {};
+		auto& trace = StartupTrace::Instance ();
+		trace.SetEnabled (!tracePath.isEmpty ());
+
 		DefaultPluginIcon_ = QIcon ("lcicons:/resources/images/defaultpluginicon.svg");
-		CheckPlugins ();
+
+		{
+			const auto measure = trace.Measure ("Stage", "CheckPlugins");
+			CheckPlugins ();
+		}
 		FillInstances ();
 
 		if (safeMode)
@@ -487,8 +613,11 @@ namespace LeechCraft
 				std::make_shared<PluginLoadProcess> (tr ("Plugins initialization: second stage..."),
 						ordered.size ());
 
+		auto fstMeasure = trace.Measure ("Stage", "Init");
 		const auto& failed = FirstInitAll (fstInitProc.get ());
+		fstMeasure = {};
 
+		UpdateEntityDispatchIndex ();
 		SetInitStage (InitStage::BeforeSecond);
 
 		for (const auto obj : ordered)
@@ -509,6 +638,7 @@ namespace LeechCraft
 
 		sndInitProc->SetCount (ordered.size ());
 
+		auto sndMeasure = trace.Measure ("Stage", "SecondInit");
 		for (const auto obj : ordered)
 		{
 			++*sndInitProc;
@@ -516,6 +646,7 @@ namespace LeechCraft
 			try
 			{
 				emit loadProgress (tr ("Initializing %1: stage two...").arg (ii->GetName ()));
+				const auto measure = trace.Measure ("SecondInit", ii->GetName ());
 				ii->SecondInit ();
 			}
 			catch (const std::exception& e)
@@ -529,14 +660,25 @@ namespace LeechCraft
 			}
 		}
 
+		sndMeasure = {};
+
 		SetInitStage (InitStage::PostSecond);
 
-		for (const auto plugin : GetAllPlugins ())
-			Core::Instance ().PostSecondInit (plugin);
+		{
+			const auto measure = trace.Measure ("Stage", "PostSecondInit");
+			for (const auto plugin : GetAllPlugins ())
+				Core::Instance ().PostSecondInit (plugin);
+		}
 
 		SetInitStage (InitStage::Complete);
 
 		TryUnload (failed);
+
+		if (!tracePath.isEmpty ())
+		{
+			trace.Write (tracePath);
+			trace.SetEnabled (false);
+		}
 	}
 
 	void PluginManager::Release ()
@@ -590,6 +732,7 @@ namespace LeechCraft
 		PluginTreeBuilder_.reset ();
 		FeatureProviders_.clear ();
 		AvailablePlugins_.clear ();
+		LazyPlugins_.clear ();
 		Obj2Loader_.clear ();
 		Plugins_.clear ();
 		PluginContainers_.clear ();
@@ -621,10 +764,65 @@ namespace LeechCraft
 			std::sort (SortedCache_.begin (), SortedCache_.end (),
 					[] (QObject *p1, QObject *p2)
 						{ return qobject_cast<IInfo*> (p1)->GetName () < qobject_cast<IInfo*> (p2)->GetName (); });
+
+			QWriteLocker locker { &CastableLock_ };
+			CastableCache_.clear ();
 		}
 		return SortedCache_;
 	}
 
+	QObjectList PluginManager::GetCastableRoots (const char *iid) const
+	{
+		const auto& allPlugins = GetAllPlugins ();
+
+		const auto& key = QByteArray::fromRawData (iid, qstrlen (iid));
+		{
+			QReadLocker locker { &CastableLock_ };
+			const auto pos = CastableCache_.constFind (key);
+			if (pos != CastableCache_.constEnd ())
+			{
+				++*pos->Lookups_;
+				return pos->Roots_;
+			}
+		}
+
+		QObjectList roots;
+		for (const auto plugin : allPlugins)
+			if (plugin->qt_metacast (iid))
+				roots << plugin;
+
+		const QByteArray ownedKey { iid };
+
+		QWriteLocker locker { &CastableLock_ };
+		auto& lookups = CastableLookups_ [ownedKey];
+		if (!lookups)
+			lookups = std::make_shared<std::atomic<quint64>> (0);
+		++*lookups;
+
+		CastableCache_ [ownedKey] = { roots, lookups };
+		return roots;
+	}
+
+	QString PluginManager::GetCastableLookupsDiagInfo () const
+	{
+		QReadLocker locker { &CastableLock_ };
+
+		auto iids = CastableLookups_.keys ();
+		std::sort (iids.begin (), iids.end (),
+				[this] (const QByteArray& left, const QByteArray& right)
+				{
+					return CastableLookups_.value (left)->load () > CastableLookups_.value (right)->load ();
+				});
+
+		QString result { "Plugin lookups by interface:\n" };
+		for (const auto& iid : iids)
+			result += QString { "  %1: %2 lookups, %3 plugins\n" }
+					.arg (QString::fromLatin1 (iid))
+					.arg (CastableLookups_.value (iid)->load ())
+					.arg (CastableCache_.value (iid).Roots_.size ());
+		return result;
+	}
+
 	QString PluginManager::GetPluginLibraryPath (const QObject *object) const
 	{
 		for (auto loader : PluginContainers_)
@@ -646,6 +844,74 @@ namespace LeechCraft
 		return PluginID2PluginCache_ [id];
 	}
 
+	QObject* PluginManager::LoadPluginByID (const QByteArray& id)
+	{
+		if (const auto plugin = GetPluginByID (id))
+			return plugin;
+
+		if (!CanLoadLazy ())
+			return nullptr;
+
+		const auto pos = std::find_if (LazyPlugins_.begin (), LazyPlugins_.end (),
+				[this, &id] (const Loaders::IPluginLoader_ptr& loader)
+				{
+					return Registry_->GetID (loader->GetFileName ()) == id ||
+							Registry_->GetManifest (loader) ["ID"].toByteArray () == id;
+				});
+		if (pos == LazyPlugins_.end () || !LoadLazy (*pos))
+			return nullptr;
+
+		PluginID2PluginCache_.remove (id);
+		return GetPluginByID (id);
+	}
+
+	void PluginManager::LoadLazyPlugins (const char *iid)
+	{
+		if (!iid || !CanLoadLazy ())
+			return;
+
+		const auto& iidStr = QString::fromLatin1 (iid);
+		const auto& toLoad = Util::Filter (LazyPlugins_,
+				[this, &iidStr] (const Loaders::IPluginLoader_ptr& loader)
+				{
+					return Registry_->GetManifest (loader) ["Interfaces"]
+							.toStringList ().contains (iidStr);
+				});
+		for (const auto& loader : toLoad)
+			LoadLazy (loader);
+	}
+
+	void PluginManager::LoadLazyPlugins (const Entity& e)
+	{
+		if (!CanLoadLazy ())
+			return;
+
+		const QStringList handlerIids
+		{
+			qobject_interface_iid<IDownload*> (),
+			qobject_interface_iid<IEntityHandler*> ()
+		};
+
+		const auto& toLoad = Util::Filter (LazyPlugins_,
+				[this, &e, &handlerIids] (const Loaders::IPluginLoader_ptr& loader)
+				{
+					const auto& manifest = Registry_->GetManifest (loader);
+					const auto& ifaces = manifest ["Interfaces"].toStringList ();
+					if (std::none_of (handlerIids.begin (), handlerIids.end (),
+							[&ifaces] (const QString& iid) { return ifaces.contains (iid); }))
+						return false;
+
+					const auto& mimes = manifest ["HandledMimes"].toStringList ();
+					const auto& schemes = manifest ["HandledUrlSchemes"].toStringList ();
+					if (mimes.isEmpty () && schemes.isEmpty ())
+						return true;
+
+					return EntityDispatchIndex::MatchesHints (e, mimes, schemes);
+				});
+		for (const auto& loader : toLoad)
+			LoadLazy (loader);
+	}
+
 	QObjectList PluginManager::GetFirstLevels (const QByteArray& pclass) const
 	{
 		QObjectList result;
@@ -789,6 +1055,35 @@ namespace LeechCraft
 		return InitStage_;
 	}
 
+	EntityDispatchIndex* PluginManager::GetEntityDispatchIndex () const
+	{
+		return DispatchIndex_.get ();
+	}
+
+	void PluginManager::UpdateEntityDispatchIndex ()
+	{
+		if (QThread::currentThread () != thread ())
+			return;
+
+		QList<EntityDispatchIndex::PendingHints> pending;
+		for (const auto& loader : LazyPlugins_)
+		{
+			const auto& manifest = Registry_->GetManifest (loader);
+			pending.append ({
+					manifest ["HandledMimes"].toStringList (),
+					manifest ["HandledUrlSchemes"].toStringList ()
+				});
+		}
+
+		DispatchIndex_->Update (GetAllPlugins (),
+				[this] (QObject *obj)
+				{
+					const auto& loader = Obj2Loader_.value (obj);
+					return loader ? Registry_->GetManifest (loader) : QVariantMap {};
+				},
+				pending);
+	}
+
 	void PluginManager::SetInitStage (PluginManager::InitStage stage)
 	{
 		if (InitStage_ == stage)
@@ -872,9 +1167,15 @@ namespace LeechCraft
 			QString Error_;
 			bool Unload_;
 
-			Fail (const QString& e, bool unload = false)
+			/** Whether the failure is determined by the library file
+			 * alone and thus may be remembered in the registry.
+			 */
+			bool Persistent_;
+
+			Fail (const QString& e, bool unload = false, bool persistent = false)
 			: Error_ (e)
 			, Unload_ (unload)
+			, Persistent_ (persistent)
 			{
 			}
 		};
@@ -890,9 +1191,9 @@ namespace LeechCraft
 			}
 		}
 
-		void APILevel (Loaders::IPluginLoader_ptr loader)
+		void APILevel (Loaders::IPluginLoader_ptr loader, PluginRegistry *registry)
 		{
-			const auto apiLevel = loader->GetAPILevel ();
+			const auto apiLevel = registry->GetAPILevel (loader);
 			if (apiLevel != CURRENT_API_LEVEL)
 			{
 				qWarning () << Q_FUNC_INFO
@@ -900,7 +1201,9 @@ namespace LeechCraft
 						<< loader->GetFileName ();
 
 				throw Fail (PluginManager::tr ("Could not load plugin from %1: API level mismatch.")
-							.arg (loader->GetFileName ()));
+							.arg (loader->GetFileName ()),
+						false,
+						true);
 			}
 		}
 
@@ -970,16 +1273,23 @@ namespace LeechCraft
 
 		QHash<QByteArray, QString> id2source;
 
+		const auto registry = Registry_.get ();
+
 		QList<std::function<void (Loaders::IPluginLoader_ptr)>> checks
 		{
 			Checks::IsFile,
-			Checks::TryLoad,
-			Checks::APILevel
+			[] (Loaders::IPluginLoader_ptr loader)
+			{
+				const auto measure = StartupTrace::Instance ().Measure ("Load",
+						QFileInfo { loader->GetFileName () }.fileName ());
+				Checks::TryLoad (loader);
+			},
+			[registry] (Loaders::IPluginLoader_ptr loader) { Checks::APILevel (loader, registry); }
 		};
 
 		const bool shouldDump = qgetenv ("LC_DUMP_SOCHECKS") == "1";
 
-		auto thrCheck = [shouldDump, checks] (Loaders::IPluginLoader_ptr loader) -> boost::optional<Checks::Fail>
+		auto thrCheck = [shouldDump, checks, registry] (Loaders::IPluginLoader_ptr loader) -> boost::optional<Checks::Fail>
 		{
 			QElapsedTimer timer;
 			if (shouldDump)
@@ -988,6 +1298,10 @@ namespace LeechCraft
 				qDebug () << loader->GetFileName () << ": beginning checks";
 			}
 
+			const auto& knownFailure = registry->GetFailure (loader->GetFileName ());
+			if (!knownFailure.isEmpty ())
+				return Checks::Fail { knownFailure };
+
 			for (const auto& check : checks)
 				try
 				{
@@ -995,6 +1309,8 @@ namespace LeechCraft
 				}
 				catch (const Checks::Fail& f)
 				{
+					if (f.Persistent_)
+						registry->SetFailure (loader->GetFileName (), f.Error_);
 					return f;
 				}
 			if (shouldDump)
@@ -1008,13 +1324,23 @@ namespace LeechCraft
 			return {};
 		};
 
+		// Lazy plugins that are known to pass the checks aren't even
+		// loaded until they are requested.
+		const auto lazyBegin = std::stable_partition (PluginContainers_.begin (), PluginContainers_.end (),
+				[this] (const Loaders::IPluginLoader_ptr& loader)
+				{
+					return !IsLazy (loader) || !Registry_->IsKnownGood (loader->GetFileName ());
+				});
+		std::copy (lazyBegin, PluginContainers_.end (), std::back_inserter (LazyPlugins_));
+		PluginContainers_.erase (lazyBegin, PluginContainers_.end ());
+
 		QList<boost::optional<Checks::Fail>> fails;
 		if (!DBusMode_)
 		{
 			const auto mid = std::partition (PluginContainers_.begin (), PluginContainers_.end (),
-					[] (const Loaders::IPluginLoader_ptr& loader)
+					[registry] (const Loaders::IPluginLoader_ptr& loader)
 					{
-						return loader->GetManifest () ["RequireGUIThreadLibraryLoading"].toBool ();
+						return registry->GetManifest (loader) ["RequireGUIThreadLibraryLoading"].toBool ();
 					});
 			auto future = QtConcurrent::mapped (mid, PluginContainers_.end (),
 					std::function<boost::optional<Checks::Fail> (Loaders::IPluginLoader_ptr)> (thrCheck));
@@ -1040,6 +1366,10 @@ namespace LeechCraft
 				PluginLoadErrors_ << fails [i]->Error_;
 			}
 
+		for (int i = PluginContainers_.size () - 1; i >= 0; --i)
+			if (IsLazy (PluginContainers_.at (i)))
+				LazyPlugins_ << PluginContainers_.takeAt (i);
+
 		checks.clear ();
 		checks << Checks::TryInstance;
 
@@ -1051,6 +1381,8 @@ namespace LeechCraft
 			for (auto check : checks)
 				try
 				{
+					const auto measure = StartupTrace::Instance ().Measure ("Instance",
+							QFileInfo { loader->GetFileName () }.fileName ());
 					check (loader);
 				}
 				catch (const Checks::Fail& f)
@@ -1081,7 +1413,10 @@ namespace LeechCraft
 					PluginContainers_.removeAt (i--);
 				}
 				else
+				{
 					id2source [id] = loader->GetFileName ();
+					Registry_->SetID (loader->GetFileName (), id);
+				}
 			}
 			catch (const std::exception& e)
 			{
@@ -1113,6 +1448,141 @@ namespace LeechCraft
 		}
 
 		settings.endGroup ();
+
+		Registry_->Save ();
+
+		if (!LazyPlugins_.isEmpty ())
+			qDebug () << Q_FUNC_INFO
+					<< "deferring"
+					<< LazyPlugins_.size ()
+					<< "lazy plugins";
+	}
+
+	bool PluginManager::IsLazy (const Loaders::IPluginLoader_ptr& loader) const
+	{
+		if (DBusMode_)
+			return false;
+
+		const auto& manifest = Registry_->GetManifest (loader);
+		return manifest ["Lazy"].toBool () &&
+				!manifest ["Interfaces"].toStringList ().isEmpty ();
+	}
+
+	bool PluginManager::CanLoadLazy () const
+	{
+		return !LazyPlugins_.isEmpty () &&
+				InitStage_ != InitStage::BeforeFirst &&
+				QThread::currentThread () == thread ();
+	}
+
+	bool PluginManager::LoadLazy (Loaders::IPluginLoader_ptr loader)
+	{
+		if (!LazyPlugins_.removeOne (loader))
+			return false;
+
+		qDebug () << Q_FUNC_INFO
+				<< "loading lazy plugin"
+				<< loader->GetFileName ();
+
+		QObject *inst = nullptr;
+		QByteArray id;
+		try
+		{
+			Checks::TryLoad (loader);
+			Checks::TryInstance (loader);
+
+			inst = loader->Instance ();
+			id = qobject_cast<IInfo*> (inst)->GetUniqueID ();
+		}
+		catch (const Checks::Fail& f)
+		{
+			PluginLoadErrors_ << f.Error_;
+			if (f.Unload_)
+				loader->Unload ();
+			return false;
+		}
+		catch (const std::exception& e)
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "failed to obtain plugin ID for plugin from"
+					<< loader->GetFileName ()
+					<< "with error:"
+					<< e.what ();
+			loader->Unload ();
+			return false;
+		}
+
+		const auto sameId = std::find_if (Plugins_.begin (), Plugins_.end (),
+				[&id] (QObject *plugin)
+				{
+					const auto ii = qobject_cast<IInfo*> (plugin);
+					return ii && ii->GetUniqueID () == id;
+				});
+		if (sameId != Plugins_.end ())
+		{
+			PluginLoadErrors_ << tr ("Plugin with ID %1 is "
+					"already loaded; aborting load "
+					"from %2.")
+				.arg (QString::fromUtf8 (id.constData ()))
+				.arg (loader->GetFileName ());
+			loader->Unload ();
+			return false;
+		}
+
+		Registry_->SetID (loader->GetFileName (), id);
+		Registry_->Save ();
+
+		PluginContainers_ << loader;
+		Plugins_ << inst;
+		Obj2Loader_ [inst] = loader;
+
+		PluginTreeBuilder_->AddObjects ({ inst });
+		PluginTreeBuilder_->Calculate ();
+		CacheValid_ = false;
+		PluginID2PluginCache_.clear ();
+
+		auto dropInstance = [this, loader, inst]
+		{
+			PluginTreeBuilder_->RemoveObject (inst);
+			PluginTreeBuilder_->Calculate ();
+			CacheValid_ = false;
+
+			Plugins_.removeAll (inst);
+			PluginContainers_.removeAll (loader);
+			Obj2Loader_.remove (inst);
+			loader->Unload ();
+		};
+
+		if (!PluginTreeBuilder_->GetResult ().contains (inst))
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "dependencies are not satisfied for"
+					<< loader->GetFileName ();
+			dropInstance ();
+			return false;
+		}
+
+		try
+		{
+			InjectPlugin (inst);
+		}
+		catch (...)
+		{
+			dropInstance ();
+			return false;
+		}
+
+		if (const auto ipr = qobject_cast<IPluginReady*> (inst))
+		{
+			const auto& expected = ipr->GetExpectedPluginClasses ();
+			for (const auto ip2 : GetAllCastableRoots<IPlugin2*> ())
+				if (!qobject_cast<IPlugin2*> (ip2)->GetPluginClasses ().intersect (expected).isEmpty ())
+					ipr->AddPlugin (ip2);
+		}
+
+		UpdateEntityDispatchIndex ();
+
+		return true;
 	}
 
 	void PluginManager::FillInstances ()
@@ -1130,34 +1600,26 @@ namespace LeechCraft
 
 	QObjectList PluginManager::FirstInitAll (PluginLoadProcess *proc)
 	{
-		QObjectList ordered = PluginTreeBuilder_->GetResult ();
-		QObjectList initialized;
+		QSet<QObject*> initialized;
 		QObjectList failedList;
 
-		QObject *failed = 0;
-		while ((failed = TryFirstInit (ordered, proc)))
+		auto ordered = PluginTreeBuilder_->GetResult ();
+
+		QObjectList failed;
+		while (!(failed = TryFirstInit (ordered, initialized, proc)).isEmpty ())
 		{
 			CacheValid_ = false;
 
-			failedList << failed;
-			Q_FOREACH (QObject *obj, ordered)
-			{
-				if (failed == obj)
-					break;
-				initialized << obj;
-			}
-
-			PluginTreeBuilder_->RemoveObject (failed);
+			failedList += failed;
+			for (const auto obj : failed)
+				PluginTreeBuilder_->RemoveObject (obj);
 
 			qDebug () << failed
 					<< "failed to initialize, recalculating dep tree...";
 			PluginTreeBuilder_->Calculate ();
 
 			ordered = PluginTreeBuilder_->GetResult ();
-			Q_FOREACH (QObject *obj, initialized)
-				ordered.removeAll (obj);
-
-			proc->SetCount (ordered.size () + initialized.size ());
+			proc->SetCount (ordered.size ());
 		}
 
 		return failedList;
@@ -29,10 +29,13 @@
 
 #pragma once
 
+#include <atomic>
 #include <memory>
 #include <QAbstractItemModel>
 #include <QMap>
 #include <QMultiMap>
+#include <QSet>
+#include <QReadWriteLock>
 #include <QStringList>
 #include <QDir>
 #include <QIcon>
@@ -44,6 +47,9 @@ namespace LeechCraft
 {
 	class MainWindow;
 	class PluginTreeBuilder;
+	class EntityDispatchIndex;
+	class PluginRegistry;
+	struct Entity;
 
 	class PluginManager : public QAbstractItemModel
 						, public IPluginsManager
@@ -62,6 +68,9 @@ namespace LeechCraft
 
 		QMap<QObject*, Loaders::IPluginLoader_ptr> Obj2Loader_;
 
+		// Lazy plugins that haven't been requested yet
+		PluginsContainer_t LazyPlugins_;
+
 		// All plugins ever seen
 		PluginsContainer_t AvailablePlugins_;
 		QMap<QString, PluginsContainer_t::const_iterator> FeatureProviders_;
@@ -72,10 +81,23 @@ namespace LeechCraft
 		mutable QMap<QByteArray, QObject*> PluginID2PluginCache_;
 
 		std::shared_ptr<PluginTreeBuilder> PluginTreeBuilder_;
+		const std::shared_ptr<EntityDispatchIndex> DispatchIndex_;
+		const std::shared_ptr<PluginRegistry> Registry_;
 
 		mutable bool CacheValid_;
 		mutable QObjectList SortedCache_;
 
+		struct CastableRoots
+		{
+			QObjectList Roots_;
+			std::shared_ptr<std::atomic<quint64>> Lookups_;
+		};
+
+		// Reset whenever SortedCache_ is recalculated.
+		mutable QReadWriteLock CastableLock_;
+		mutable QHash<QByteArray, CastableRoots> CastableCache_;
+		mutable QHash<QByteArray, std::shared_ptr<std::atomic<quint64>>> CastableLookups_;
+
 		class PluginLoadProcess;
 	public:
 		enum Roles
@@ -115,9 +137,19 @@ namespace LeechCraft
 
 		QList<Loaders::IPluginLoader_ptr> GetAllAvailable () const;
 		QObjectList GetAllPlugins () const;
+		QObjectList GetCastableRoots (const char *iid) const;
+		QString GetCastableLookupsDiagInfo () const;
 		QString GetPluginLibraryPath (const QObject*) const;
 
 		QObject* GetPluginByID (const QByteArray&) const;
+		QObject* LoadPluginByID (const QByteArray&);
+
+		void LoadLazyPlugins (const char *iid);
+
+		/** Loads the lazy plugins that may be interested in the given
+		 * entity according to their manifests.
+		 */
+		void LoadLazyPlugins (const Entity&);
 
 		QObjectList GetFirstLevels (const QByteArray& pclass) const;
 		QObjectList GetFirstLevels (const QSet<QByteArray>& pclasses) const;
@@ -138,6 +170,15 @@ namespace LeechCraft
 		const QStringList& GetPluginLoadErrors () const;
 
 		InitStage GetInitStage () const;
+
+		EntityDispatchIndex* GetEntityDispatchIndex () const;
+
+		/** @brief Rebuilds the entity dispatch index if needed.
+		 *
+		 * This function does nothing if called from a thread other than
+		 * the main one.
+		 */
+		void UpdateEntityDispatchIndex ();
 	private:
 		void SetInitStage (InitStage);
 
@@ -160,18 +201,46 @@ namespace LeechCraft
 		 */
 		QList<QObject*> FirstInitAll (PluginLoadProcess*);
 
-		/** Tries to perform IInfo::Init() on plugins and returns the
-		 * first plugin that has failed to initialize. This function
-		 * stops initializing plugins upon first failure. If all plugins
-		 * were initialized successfully, this function returns NULL.
+		/** Tries to perform IInfo::Init() on plugins that aren't in the
+		 * initialized set yet and returns the plugins that have failed
+		 * to initialize. This function stops initializing plugins upon
+		 * first failure. If all plugins were initialized successfully,
+		 * this function returns an empty list.
+		 *
+		 * Plugins declaring ThreadSafeInit in their manifests whose
+		 * dependencies are already initialized are initialized in
+		 * parallel. The rest are initialized one by one in the main
+		 * thread.
+		 */
+		QObjectList TryFirstInit (const QObjectList&, QSet<QObject*>&, PluginLoadProcess*);
+
+		/** Checks whether the manifest of the plugin allows calling its
+		 * IInfo::Init() outside of the main thread.
 		 */
-		QObject* TryFirstInit (QObjectList, PluginLoadProcess*);
+		bool IsThreadSafeInit (QObject*) const;
 
 		/** Plainly tries to find a corresponding QPluginLoader and
 		 * unload the corresponding library.
 		 */
 		void TryUnload (QObjectList);
 
+		/** Checks whether the manifest of the plugin declares it as a
+		 * lazily loadable one.
+		 */
+		bool IsLazy (const Loaders::IPluginLoader_ptr&) const;
+
+		/** Checks whether lazy plugins can be loaded right now, that is,
+		 * the first initialization stage is over and this is the main
+		 * thread.
+		 */
+		bool CanLoadLazy () const;
+
+		/** Loads, instantiates and initializes the given lazy plugin
+		 * pretty much like InjectPlugin() does. Returns whether the
+		 * plugin has been loaded successfully.
+		 */
+		bool LoadLazy (Loaders::IPluginLoader_ptr);
+
 		Loaders::IPluginLoader_ptr MakeLoader (const QString&);
 
 		QList<Plugins_t::iterator> FindProviders (const QString&);
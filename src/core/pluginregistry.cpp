@@ -0,0 +1,252 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "pluginregistry.h"
+#include <QDataStream>
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QtDebug>
+#include <util/sys/paths.h>
+#include <util/sys/savefile.h>
+#include "interfaces/iinfo.h"
+
+namespace LeechCraft
+{
+	namespace
+	{
+		const quint8 RegistryVersion = 1;
+	}
+
+	PluginRegistry::PluginRegistry ()
+	: Path_ { Util::GetUserDir (Util::UserDir::Cache, "core").filePath ("plugins.registry") }
+	{
+		Load ();
+	}
+
+	quint64 PluginRegistry::GetAPILevel (const Loaders::IPluginLoader_ptr& loader)
+	{
+		const auto& path = loader->GetFileName ();
+
+		QMutexLocker locker { &Mutex_ };
+		if (const auto level = GetRecord (path).APILevel_)
+			return level;
+		locker.unlock ();
+
+		const auto level = loader->GetAPILevel ();
+
+		locker.relock ();
+		GetRecord (path).APILevel_ = level;
+		IsDirty_ = true;
+		return level;
+	}
+
+	QVariantMap PluginRegistry::GetManifest (const Loaders::IPluginLoader_ptr& loader)
+	{
+		const auto& path = loader->GetFileName ();
+
+		QMutexLocker locker { &Mutex_ };
+		const auto& record = GetRecord (path);
+		if (record.HasManifest_)
+			return record.Manifest_;
+		locker.unlock ();
+
+		const auto& manifest = loader->GetManifest ();
+
+		locker.relock ();
+		auto& newRecord = GetRecord (path);
+		newRecord.HasManifest_ = true;
+		newRecord.Manifest_ = manifest;
+		IsDirty_ = true;
+		return manifest;
+	}
+
+	bool PluginRegistry::IsKnownGood (const QString& path) const
+	{
+		QMutexLocker locker { &Mutex_ };
+		const auto& record = GetRecord (path);
+		return record.APILevel_ == CURRENT_API_LEVEL &&
+				record.Failure_.isEmpty ();
+	}
+
+	QString PluginRegistry::GetFailure (const QString& path) const
+	{
+		QMutexLocker locker { &Mutex_ };
+		return GetRecord (path).Failure_;
+	}
+
+	void PluginRegistry::SetFailure (const QString& path, const QString& error)
+	{
+		QMutexLocker locker { &Mutex_ };
+		auto& record = GetRecord (path);
+		if (record.Failure_ == error)
+			return;
+
+		record.Failure_ = error;
+		IsDirty_ = true;
+	}
+
+	QByteArray PluginRegistry::GetID (const QString& path) const
+	{
+		QMutexLocker locker { &Mutex_ };
+		return GetRecord (path).ID_;
+	}
+
+	void PluginRegistry::SetID (const QString& path, const QByteArray& id)
+	{
+		QMutexLocker locker { &Mutex_ };
+		auto& record = GetRecord (path);
+		if (record.ID_ == id)
+			return;
+
+		record.ID_ = id;
+		IsDirty_ = true;
+	}
+
+	void PluginRegistry::Save () const
+	{
+		QMutexLocker locker { &Mutex_ };
+		if (!IsDirty_)
+			return;
+
+		Util::SaveFile file { Path_ };
+		if (!file.open (QIODevice::WriteOnly))
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unable to open"
+					<< Path_
+					<< file.errorString ();
+			return;
+		}
+
+		QDataStream out { &file };
+		out.setVersion (QDataStream::Qt_4_8);
+		out << RegistryVersion
+				<< static_cast<quint32> (Records_.size ());
+		for (auto i = Records_.begin (), end = Records_.end (); i != end; ++i)
+			out << i.key ()
+					<< i->MTime_
+					<< i->Size_
+					<< i->APILevel_
+					<< i->HasManifest_
+					<< i->Manifest_
+					<< i->ID_
+					<< i->Failure_;
+
+		if (!file.commit ())
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unable to commit"
+					<< Path_
+					<< file.errorString ();
+			return;
+		}
+
+		IsDirty_ = false;
+	}
+
+	PluginRegistry::Record& PluginRegistry::GetRecord (const QString& path) const
+	{
+		auto& record = Records_ [path];
+		if (record.Checked_)
+			return record;
+
+		const QFileInfo fi { path };
+		const auto mtime = fi.lastModified ().toMSecsSinceEpoch ();
+		const auto size = fi.size ();
+		if (record.MTime_ != mtime || record.Size_ != size)
+		{
+			record = Record {};
+			record.MTime_ = mtime;
+			record.Size_ = size;
+			IsDirty_ = true;
+		}
+
+		record.Checked_ = true;
+		return record;
+	}
+
+	void PluginRegistry::Load ()
+	{
+		QFile file { Path_ };
+		if (!file.exists ())
+			return;
+
+		if (!file.open (QIODevice::ReadOnly))
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unable to open"
+					<< Path_
+					<< file.errorString ();
+			return;
+		}
+
+		QDataStream in { &file };
+		in.setVersion (QDataStream::Qt_4_8);
+
+		quint8 version = 0;
+		in >> version;
+		if (version != RegistryVersion)
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unknown version"
+					<< version;
+			return;
+		}
+
+		quint32 count = 0;
+		in >> count;
+
+		QHash<QString, Record> records;
+		for (quint32 i = 0; i < count && in.status () == QDataStream::Ok; ++i)
+		{
+			QString path;
+			Record record;
+			in >> path
+					>> record.MTime_
+					>> record.Size_
+					>> record.APILevel_
+					>> record.HasManifest_
+					>> record.Manifest_
+					>> record.ID_
+					>> record.Failure_;
+			records [path] = record;
+		}
+
+		if (in.status () != QDataStream::Ok)
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "corrupted registry"
+					<< Path_;
+			return;
+		}
+
+		Records_ = records;
+	}
+}
@@ -0,0 +1,109 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#pragma once
+
+#include <QHash>
+#include <QMutex>
+#include <QStringList>
+#include <QVariantMap>
+#include "loaders/ipluginloader.h"
+
+namespace LeechCraft
+{
+	/** @brief Persistent cache of the plugin libraries' properties.
+	 *
+	 * The registry remembers the API level, the manifest, the plugin ID
+	 * and the deterministic failures (like API level mismatch) for each
+	 * plugin library, keyed by the library path. A record is valid as
+	 * long as the modification time and the size of the library are the
+	 * same as when the record has been made.
+	 *
+	 * This allows skipping loading the libraries just to find out their
+	 * API levels, as well as not loading lazy plugins at all until they
+	 * are needed.
+	 *
+	 * All the methods are thread-safe.
+	 */
+	class PluginRegistry
+	{
+		struct Record
+		{
+			qint64 MTime_ = 0;
+			qint64 Size_ = 0;
+
+			quint64 APILevel_ = 0;
+
+			bool HasManifest_ = false;
+			QVariantMap Manifest_;
+
+			QByteArray ID_;
+			QString Failure_;
+
+			bool Checked_ = false;
+		};
+
+		const QString Path_;
+
+		mutable QMutex Mutex_;
+		mutable QHash<QString, Record> Records_;
+		mutable bool IsDirty_ = false;
+	public:
+		PluginRegistry ();
+
+		/** @brief Returns the API level of the plugin library.
+		 *
+		 * The library is loaded to find out the API level only if the
+		 * level isn't known yet.
+		 */
+		quint64 GetAPILevel (const Loaders::IPluginLoader_ptr&);
+
+		/** @brief Returns the manifest of the plugin library.
+		 */
+		QVariantMap GetManifest (const Loaders::IPluginLoader_ptr&);
+
+		/** @brief Checks whether the library has already passed the
+		 * checks with its current contents.
+		 */
+		bool IsKnownGood (const QString& path) const;
+
+		QString GetFailure (const QString& path) const;
+		void SetFailure (const QString& path, const QString& error);
+
+		QByteArray GetID (const QString& path) const;
+		void SetID (const QString& path, const QByteArray& id);
+
+		/** @brief Writes the registry to the disk if it has changed.
+		 */
+		void Save () const;
+	private:
+		Record& GetRecord (const QString&) const;
+		void Load ();
+	};
+}
@@ -182,6 +182,7 @@ namespace LeechCraft
 		Graph_.clear ();
 		Object2Vertex_.clear ();
 		Result_.clear ();
+		Dependencies_.clear ();
 
 		CreateGraph ();
 		const auto& edge2vert = MakeEdges ();
@@ -212,6 +213,10 @@ namespace LeechCraft
 		boost::topological_sort (fulfilledSubgraph, std::back_inserter (vertices));
 		for (const auto& vertex : vertices)
 			Result_ << fulfilledSubgraph [vertex].Object_;
+
+		for (const auto& pair : edge2vert)
+			if (Graph_ [pair.first].IsFulfilled_ && Graph_ [pair.second].IsFulfilled_)
+				Dependencies_ [Graph_ [pair.first].Object_] << Graph_ [pair.second].Object_;
 	}
 
 	QObjectList PluginTreeBuilder::GetResult () const
@@ -219,6 +224,11 @@ namespace LeechCraft
 		return Result_;
 	}
 
+	QObjectList PluginTreeBuilder::GetDependencies (QObject *object) const
+	{
+		return Dependencies_.value (object);
+	}
+
 	void PluginTreeBuilder::CreateGraph ()
 	{
 		for (const auto object : Instances_)
@@ -819,7 +819,7 @@ namespace LeechCraft
 				const QByteArray& newTabId = parts.at (0);
 				const QByteArray& tabClass = parts.at (1);
 				QObject *plugin = Core::Instance ()
-						.GetPluginManager ()->GetPluginByID (newTabId);
+						.GetPluginManager ()->LoadPluginByID (newTabId);
 				IHaveTabs *iht = qobject_cast<IHaveTabs*> (plugin);
 				if (!iht)
 					qWarning () << Q_FUNC_INFO
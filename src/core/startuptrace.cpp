@@ -0,0 +1,125 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "startuptrace.h"
+#include <QFile>
+#include <QThread>
+#include <QtDebug>
+
+namespace LeechCraft
+{
+	StartupTrace::StartupTrace ()
+	{
+		Timer_.start ();
+	}
+
+	StartupTrace& StartupTrace::Instance ()
+	{
+		static StartupTrace trace;
+		return trace;
+	}
+
+	void StartupTrace::SetEnabled (bool enabled)
+	{
+		Enabled_ = enabled;
+	}
+
+	bool StartupTrace::IsEnabled () const
+	{
+		return Enabled_;
+	}
+
+	Util::DefaultScopeGuard StartupTrace::Measure (const QString& category, const QString& name)
+	{
+		if (!Enabled_)
+			return {};
+
+		const auto start = Timer_.nsecsElapsed ();
+		return Util::MakeScopeGuard ([this, category, name, start] { AddEvent (category, name, start); });
+	}
+
+	namespace
+	{
+		QString Escape (QString str)
+		{
+			str.replace ('\\', "\\\\");
+			str.replace ('"', "\\\"");
+			str.replace ('\n', "\\n");
+			return str;
+		}
+	}
+
+	bool StartupTrace::Write (const QString& path) const
+	{
+		QFile file { path };
+		if (!file.open (QIODevice::WriteOnly | QIODevice::Truncate))
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unable to open"
+					<< path
+					<< file.errorString ();
+			return false;
+		}
+
+		QMutexLocker locker { &Mutex_ };
+
+		QStringList events;
+		for (const auto& event : Events_)
+			events << QString { "{\"name\":\"%1\",\"cat\":\"%2\",\"ph\":\"X\",\"pid\":1,\"tid\":%3,\"ts\":%4,\"dur\":%5}" }
+					.arg (Escape (event.Name_))
+					.arg (Escape (event.Category_))
+					.arg (event.TID_)
+					.arg (event.Start_ / 1000)
+					.arg (event.Duration_ / 1000);
+
+		const auto& json = "{\"traceEvents\":[\n" + events.join (",\n") + "\n]}\n";
+		if (file.write (json.toUtf8 ()) == -1)
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unable to write"
+					<< path
+					<< file.errorString ();
+			return false;
+		}
+
+		return true;
+	}
+
+	void StartupTrace::AddEvent (const QString& category, const QString& name, qint64 start)
+	{
+		const auto duration = Timer_.nsecsElapsed () - start;
+		const auto thread = QThread::currentThreadId ();
+
+		QMutexLocker locker { &Mutex_ };
+		if (!Threads_.contains (thread))
+			Threads_ [thread] = Threads_.size () + 1;
+
+		Events_.append ({ name, category, Threads_ [thread], start, duration });
+	}
+}
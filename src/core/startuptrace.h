@@ -0,0 +1,90 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#pragma once
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QString>
+#include <util/sll/util.h>
+
+namespace LeechCraft
+{
+	/** @brief Collects the timings of the startup stages.
+	 *
+	 * The events are only recorded if the trace has been enabled via
+	 * SetEnabled(). The collected trace can be written in the Chrome
+	 * trace-event JSON format to be viewed in chrome://tracing or a
+	 * compatible viewer.
+	 *
+	 * The events may be recorded from any thread.
+	 */
+	class StartupTrace
+	{
+		struct Event
+		{
+			QString Name_;
+			QString Category_;
+			int TID_;
+			qint64 Start_;
+			qint64 Duration_;
+		};
+
+		bool Enabled_ = false;
+		QElapsedTimer Timer_;
+
+		mutable QMutex Mutex_;
+		QList<Event> Events_;
+		QHash<Qt::HANDLE, int> Threads_;
+
+		StartupTrace ();
+	public:
+		static StartupTrace& Instance ();
+
+		void SetEnabled (bool);
+		bool IsEnabled () const;
+
+		/** @brief Measures the duration of the current scope.
+		 *
+		 * The returned guard records the event with the given
+		 * \em category and \em name when it goes out of scope.
+		 */
+		Util::DefaultScopeGuard Measure (const QString& category, const QString& name);
+
+		/** @brief Writes the trace to the file at the given \em path.
+		 *
+		 * @return Whether the trace has been written successfully.
+		 */
+		bool Write (const QString& path) const;
+	private:
+		void AddEvent (const QString& category, const QString& name, qint64 start);
+	};
+}
@@ -109,6 +109,12 @@ public:
 	virtual bool HandleEntity (LeechCraft::Entity entity, QObject *desired = 0) = 0;
 
 	/** @brief Queries whether the given entity can be handled at all.
+	 *
+	 * If called from a thread other than the main one, this method
+	 * first uses the entity dispatch hints declared by the plugins (see
+	 * IEntityDispatchHints) to rule the entity out without querying
+	 * them. Otherwise the plugins are queried, which blocks until the
+	 * main thread processes the query.
 	 *
 	 * @param[in] entity The entity to test.
 	 *
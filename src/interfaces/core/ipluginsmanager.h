@@ -86,13 +86,36 @@ public:
 	 * and returns only those that can be casted to T via passing the
 	 * result of GetAllPlugins() to Filter<T>().
 	 *
+	 * If T is a plugin interface, the lookup is served by
+	 * GetCastableRoots(). This overload doesn't load the lazy plugins,
+	 * see the non-const one for that.
+	 *
 	 * @return The list of pointers to plugin instances that are
 	 * castable to type T.
 	 */
 	template<typename T>
 	QObjectList GetAllCastableRoots () const
 	{
-		return Filter<T> (GetAllPlugins ());
+		const auto iid = qobject_interface_iid<T> ();
+		if (!iid)
+			return Filter<T> (GetAllPlugins ());
+
+		return GetCastableRoots (iid);
+	}
+
+	/** @brief This is the same as the const GetAllCastableRoots(),
+	 * but loads the lazy plugins declaring T first.
+	 *
+	 * @return The list of pointers to plugin instances that are
+	 * castable to type T.
+	 *
+	 * @sa LoadLazyPlugins()
+	 */
+	template<typename T>
+	QObjectList GetAllCastableRoots ()
+	{
+		LoadLazyPlugins (qobject_interface_iid<T> ());
+		return static_cast<const IPluginsManager*> (this)->GetAllCastableRoots<T> ();
 	}
 
 	/** @brief Similar to GetAlLCastableRoots() and provided for
@@ -115,10 +138,25 @@ public:
 		return result;
 	}
 
+	/** @brief This is the same as the const GetAllCastableTo(), but
+	 * loads the lazy plugins declaring T first.
+	 *
+	 * @return The list of pointers to the requested interface.
+	 */
+	template<typename T>
+	QList<T> GetAllCastableTo ()
+	{
+		QList<T> result;
+		for (const auto root : GetAllCastableRoots<T> ())
+			result << qobject_cast<T> (root);
+		return result;
+	}
+
 	/** @brief Returns plugin identified by its id.
 	 *
 	 * If there is no such plugin with the given id, this function
-	 * returns a null pointer.
+	 * returns a null pointer. Lazy plugins that haven't been loaded
+	 * yet aren't loaded by this function, see LoadPluginByID().
 	 *
 	 * @param[in] id The ID of the plugin.
 	 * @return The plugin instance or null if no such plugin exists.
@@ -192,6 +230,67 @@ public:
 	virtual void OpenSettings (QObject *plugin) = 0;
 
 	virtual ILoadProgressReporter_ptr CreateLoadProgressReporter (QObject *thisPlugin) = 0;
+
+	/** @brief Returns the plugins implementing the given interface.
+	 *
+	 * The result is the same as the one of the const
+	 * GetAllCastableRoots() for the interface with the given \em iid.
+	 * The default implementation filters the result of GetAllPlugins(),
+	 * while the core builds the lookup tables once per interface and
+	 * invalidates them whenever the list of plugins changes.
+	 *
+	 * @param[in] iid The ID of the interface as returned by
+	 * qobject_interface_iid().
+	 * @return The list of plugins implementing the interface.
+	 */
+	virtual QObjectList GetCastableRoots (const char *iid) const
+	{
+		QObjectList result;
+		for (const auto plugin : GetAllPlugins ())
+			if (plugin->qt_metacast (iid))
+				result << plugin;
+		return result;
+	}
+
+	/** @brief Loads the lazy plugins implementing the given interface.
+	 *
+	 * A plugin is lazy if its manifest has the <code>Lazy</code> key
+	 * set to <code>true</code>. Such plugins aren't loaded during the
+	 * startup. Instead, they are loaded and initialized upon first
+	 * demand: when an interface they list in the <code>Interfaces</code>
+	 * manifest key is requested via this function or the non-const
+	 * GetAllCastableRoots(), when they are requested by their ID via
+	 * LoadPluginByID(), or when an entity matching their
+	 * <code>HandledMimes</code> or <code>HandledUrlSchemes</code>
+	 * manifest keys is dispatched.
+	 *
+	 * This function does nothing if called before all the eagerly
+	 * loaded plugins have finished their IInfo::Init(), or if called
+	 * from a thread other than the main one. The default implementation
+	 * does nothing at all.
+	 *
+	 * @param[in] iid The ID of the interface as returned by
+	 * qobject_interface_iid(), or a null pointer.
+	 */
+	virtual void LoadLazyPlugins (const char *iid)
+	{
+		Q_UNUSED (iid)
+	}
+
+	/** @brief Returns plugin identified by its id, loading it if it is
+	 * lazy and hasn't been loaded yet.
+	 *
+	 * The default implementation is the same as GetPluginByID().
+	 *
+	 * @param[in] id The ID of the plugin.
+	 * @return The plugin instance or null if no such plugin exists.
+	 *
+	 * @sa LoadLazyPlugins()
+	 */
+	virtual QObject* LoadPluginByID (const QByteArray& id)
+	{
+		return GetPluginByID (id);
+	}
 };
 
 Q_DECLARE_INTERFACE (IPluginsManager, "org.Deviant.LeechCraft.IPluginsManager/1.0")
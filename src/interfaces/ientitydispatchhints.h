@@ -0,0 +1,82 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+
+#pragma once
+
+#include <QStringList>
+#include <QtPlugin>
+
+/** @brief Interface for entity handlers declaring what they handle.
+ *
+ * By default, the core queries every IDownload and IEntityHandler
+ * plugin for every entity. A plugin implementing this interface
+ * declares beforehand which entities it is interested in, so that it
+ * is only asked about the entities that match its declaration. This
+ * saves a lot of calls to IDownload::CouldDownload() and
+ * IEntityHandler::CouldHandle() for plugins dealing with a few
+ * specific kinds of entities.
+ *
+ * An entity matches the declaration if either its MIME type is listed
+ * in GetHandledMimes() (possibly as a wildcard like "image/*"), or if
+ * it is a QUrl whose scheme is listed in GetHandledUrlSchemes().
+ *
+ * The declaration is queried once when the plugin is loaded, so it
+ * should not change during the lifetime of the plugin.
+ *
+ * The same hints may be declared in the plugin manifest via the
+ * HandledMimes and HandledUrlSchemes keys instead. A plugin that can't
+ * declare its entities beforehand sets the DynamicEntityHandling
+ * manifest key, so that it is always queried.
+ *
+ * @sa IDownload, IEntityHandler
+ */
+class Q_DECL_EXPORT IEntityDispatchHints
+{
+public:
+	virtual ~IEntityDispatchHints () {}
+
+	/** @brief Returns the MIME types of the entities handled by this
+	 * plugin.
+	 *
+	 * A type ending with "/*" matches all the subtypes of the given
+	 * type.
+	 *
+	 * @return The list of MIME types matching the handled entities.
+	 */
+	virtual QStringList GetHandledMimes () const = 0;
+
+	/** @brief Returns the URL schemes handled by this plugin.
+	 *
+	 * @return The list of lowercase URL schemes, like "magnet".
+	 */
+	virtual QStringList GetHandledUrlSchemes () const = 0;
+};
+
+Q_DECLARE_INTERFACE (IEntityDispatchHints, "org.Deviant.LeechCraft.IEntityDispatchHints/1.0")
@@ -80,6 +80,16 @@ public:
 	 * plugins etc. That also means that in this function you can't rely
 	 * on other plugins being initialized.
 	 *
+	 * If the plugin's manifest has the <code>ThreadSafeInit</code> key
+	 * set to <code>true</code>, this function may be called from a
+	 * thread other than the main one, in parallel with Init() of other
+	 * plugins. Such plugins must not touch the GUI or the application
+	 * object in this function, which also rules out installing
+	 * translators. The plugin instance lives in the calling thread
+	 * during this call and is moved back to the main thread afterwards
+	 * along with all its children, so the QObjects created here should
+	 * be parented to the instance.
+	 *
 	 * @param[in] proxy The pointer to proxy to LeechCraft.
 	 *
 	 * @sa Release
@@ -383,8 +393,10 @@ Q_DECLARE_INTERFACE (IInfo, "org.Deviant.LeechCraft.IInfo/1.0")
 
 #if QT_VERSION < 0x050000
 #define LC_PLUGIN_METADATA(id)
+#define LC_PLUGIN_METADATA_FILE(id,file)
 #else
 #define LC_PLUGIN_METADATA(id) Q_PLUGIN_METADATA (IID id)
+#define LC_PLUGIN_METADATA_FILE(id,file) Q_PLUGIN_METADATA (IID id FILE file)
 #endif
 
 #endif
@@ -1528,7 +1528,10 @@ namespace Aggregator
 	void Core::HandleFeedUpdated (const channels_container_t& channels,
 			const Core::PendingJob& pj)
 	{
-		DBUpThread_->ScheduleImpl (&DBUpdateThreadWorker::updateFeed,
+		// Storing the fetched items is bulk work, it shouldn't delay
+		// the things the user is waiting for, like marking a channel.
+		DBUpThread_->ScheduleImplWith ({ DBUpdateThread::Priority::Background },
+				&DBUpdateThreadWorker::updateFeed,
 				channels,
 				pj.URL_);
 	}
@@ -78,6 +78,7 @@
 #include "interfaces/azoth/imucperms.h"
 #include "interfaces/azoth/iupdatablechatentry.h"
 #include "interfaces/azoth/iprovidecommands.h"
+#include "interfaces/azoth/ihavemessagesbuffer.h"
 #ifdef ENABLE_CRYPT
 #include "interfaces/azoth/isupportpgp.h"
 #endif
@@ -110,6 +111,26 @@ namespace LeechCraft
 {
 namespace Azoth
 {
+	namespace
+	{
+		const int ScrollbackPageSize = 100;
+		const int ScrollbackTimeout = 10000;
+
+		int GetMaxRenderedMessages ()
+		{
+			return std::max (XmlSettingsManager::Instance ()
+					.property ("ChatViewMaxMessages").toInt (), ScrollbackPageSize);
+		}
+
+		int GetMessagesCount (ICLEntry *entry)
+		{
+			if (const auto buffer = qobject_cast<IHaveMessagesBuffer*> (entry->GetQObject ()))
+				return buffer->GetMessagesCount ();
+
+			return entry->GetAllMessages ().size ();
+		}
+	}
+
 	QObject *ChatTab::S_ParentMultiTabs_ = 0;
 	TabClassInfo ChatTab::S_ChatTabClass_;
 	TabClassInfo ChatTab::S_MUCTabClass_;
@@ -176,6 +197,7 @@ namespace Azoth
 	, NumUnreadMsgs_ (Core::Instance ().GetUnreadCount (GetEntry<ICLEntry> ()))
 	, CDF_ (new ContactDropFilter (entryId, this))
 	, TypeTimer_ (new QTimer (this))
+	, ScrollbackTimer_ (new QTimer (this))
 	{
 		Ui_.setupUi (this);
 		Ui_.View_->page ()->setNetworkAccessManager (nam);
@@ -221,24 +243,36 @@ namespace Azoth
 				SIGNAL (linkClicked (QUrl, bool)),
 				this,
 				SLOT (handleViewLinkClicked (QUrl, bool)));
+		connect (Ui_.View_->page (),
+				SIGNAL (scrollRequested (int, int, QRect)),
+				this,
+				SLOT (handleViewScrolled ()));
 		connect (Ui_.View_,
 				SIGNAL (chatWindowSearchRequested (QString)),
 				this,
 				SLOT (handleChatWindowSearch (QString)));
 
 		TypeTimer_->setInterval (2000);
+
+		ScrollbackTimer_->setSingleShot (true);
+		ScrollbackTimer_->setInterval (ScrollbackTimeout);
+		connect (ScrollbackTimer_,
+				SIGNAL (timeout ()),
+				this,
+				SLOT (handleScrollbackTimeout ()));
 		connect (TypeTimer_,
 				SIGNAL (timeout ()),
 				this,
 				SLOT (typeTimeout ()));
 
 		DummyMsgManager::Instance ().ClearMessages (GetCLEntry ());
+		ResetRenderWindow ();
 		PrepareTheme ();
 
 		auto entry = GetEntry<ICLEntry> ();
 		const int autoNum = XmlSettingsManager::Instance ()
 				.property ("ShowLastNMessages").toInt ();
-		if (entry->GetAllMessages ().size () <= 100 &&
+		if (GetMessagesCount (entry) <= 100 &&
 				entry->GetEntryType () != ICLEntry::EntryType::MUC &&
 				autoNum)
 			RequestLogs (autoNum);
@@ -283,6 +317,8 @@ namespace Azoth
 
 	void ChatTab::PrepareTheme ()
 	{
+		IsViewLoaded_ = false;
+
 		const auto entry = GetEntry<QObject> ();
 		auto data = Core::Instance ().GetSelectedChatTemplate (entry,
 				Ui_.View_->page ()->mainFrame ());
@@ -755,9 +791,6 @@ namespace Azoth
 
 	void ChatTab::on_View__loadFinished (bool)
 	{
-		Q_FOREACH (IMessage *msg, HistoryMessages_)
-			AppendMessage (msg);
-
 		ICLEntry *e = GetEntry<ICLEntry> ();
 		if (!e)
 		{
@@ -777,8 +810,17 @@ namespace Azoth
 						{ return left->GetDateTime () < right->GetDateTime (); });
 		}
 
-		for (const auto msg : messages)
+		messages = HistoryMessages_ + messages;
+
+		// All the pending messages are already in the list above.
+		PendingMessages_.clear ();
+		RenderedMessages_ = 0;
+		NotRenderedMessages_ = std::max (messages.size () - RenderLimit_, 0);
+
+		Ui_.View_->setUpdatesEnabled (false);
+		for (const auto msg : messages.mid (NotRenderedMessages_))
 			AppendMessage (msg);
+		Ui_.View_->setUpdatesEnabled (true);
 
 		QFile scrollerJS (":/plugins/azoth/resources/scripts/scrollers.js");
 		if (!scrollerJS.open (QIODevice::ReadOnly))
@@ -791,10 +833,76 @@ namespace Azoth
 			Ui_.View_->page ()->mainFrame ()->evaluateJavaScript ("InstallEventListeners(); ScrollToBottom();");
 		}
 
+		IsViewLoaded_ = true;
+
+		if (ScrollbackLoadedCount_)
+		{
+			Ui_.View_->page ()->mainFrame ()->evaluateJavaScript (QString ("ScrollToMessage(%1);")
+						.arg (ScrollbackLoadedCount_));
+			ScrollbackLoadedCount_ = 0;
+			ScrollbackTimer_->stop ();
+		}
+
 		emit hookThemeReloaded (Util::DefaultHookProxy_ptr (new Util::DefaultHookProxy),
 				this, Ui_.View_, GetEntry<QObject> ());
 	}
 
+	void ChatTab::flushPendingMessages ()
+	{
+		IsFlushScheduled_ = false;
+
+		if (PendingMessages_.isEmpty () || !IsViewLoaded_)
+			return;
+
+		const auto pending = PendingMessages_;
+		PendingMessages_.clear ();
+
+		Ui_.View_->setUpdatesEnabled (false);
+		for (const auto& msgObj : pending)
+			if (const auto msg = qobject_cast<IMessage*> (msgObj))
+				AppendMessage (msg);
+		TrimRenderedMessages ();
+		Ui_.View_->setUpdatesEnabled (true);
+	}
+
+	void ChatTab::handleViewScrolled ()
+	{
+		if (!IsViewLoaded_ ||
+				ScrollbackLoadedCount_ ||
+				Ui_.View_->page ()->mainFrame ()->scrollPosition ().y () > 0)
+			return;
+
+		const auto maxRendered = GetMaxRenderedMessages ();
+		if (RenderLimit_ >= maxRendered)
+			return;
+
+		ScrollbackPrevLimit_ = RenderLimit_;
+		RenderLimit_ = std::min (RenderLimit_ + ScrollbackPageSize, maxRendered);
+
+		/* The older messages get to the view after the next page reload,
+		 * which scrolls to the first previously shown message then.
+		 */
+		ScrollbackLoadedCount_ = RenderLimit_ - ScrollbackPrevLimit_;
+
+		if (NotRenderedMessages_)
+			PrepareTheme ();
+		else
+		{
+			// History plugins might have nothing to add, so no reload happens.
+			ScrollbackTimer_->start ();
+			handleHistoryBack ();
+		}
+	}
+
+	void ChatTab::handleScrollbackTimeout ()
+	{
+		if (!ScrollbackLoadedCount_)
+			return;
+
+		RenderLimit_ = ScrollbackPrevLimit_;
+		ScrollbackLoadedCount_ = 0;
+	}
+
 #ifdef ENABLE_MEDIACALLS
 	void ChatTab::handleCallRequested ()
 	{
@@ -855,6 +963,7 @@ namespace Azoth
 			return;
 
 		ScrollbackPos_ = 0;
+		ResetRenderWindow ();
 
 		const auto grace = XmlSettingsManager::Instance ()
 				.property ("ChatClearGraceTime").toInt ();
@@ -1073,7 +1182,7 @@ namespace Azoth
 				Ui_.VariantBox_->setCurrentIndex (idx);
 		}
 
-		AppendMessage (msg);
+		EnqueueMessage (msg);
 	}
 
 	void ChatTab::handleVariantsChanged (QStringList variants)
@@ -1830,7 +1939,7 @@ namespace Azoth
 		}
 	}
 
-	void ChatTab::AppendMessage (IMessage *msg)
+	bool ChatTab::AppendMessage (IMessage *msg)
 	{
 		ICLEntry *other = qobject_cast<ICLEntry*> (msg->OtherPart ());
 		if (!other && msg->OtherPart ())
@@ -1839,37 +1948,37 @@ namespace Azoth
 					<< "message's other part doesn't implement ICLEntry"
 					<< msg->GetQObject ()
 					<< msg->OtherPart ();
-			return;
+			return false;
 		}
 
 		if (msg->GetQObject ()->property ("Azoth/HiddenMessage").toBool ())
-			return;
+			return false;
 
 		ICLEntry *parent = qobject_cast<ICLEntry*> (msg->ParentCLEntry ());
 
 		if (msg->GetDirection () == IMessage::Direction::Out &&
 				other->GetEntryType () == ICLEntry::EntryType::MUC)
-			return;
+			return false;
 
 		if (msg->GetMessageSubType () == IMessage::SubType::ParticipantStatusChange &&
 				(!parent || parent->GetEntryType () == ICLEntry::EntryType::MUC) &&
 				!XmlSettingsManager::Instance ().property ("ShowStatusChangesEvents").toBool ())
-			return;
+			return false;
 
 		if (msg->GetMessageSubType () == IMessage::SubType::ParticipantStatusChange &&
 				(!parent || parent->GetEntryType () != ICLEntry::EntryType::MUC) &&
 				!XmlSettingsManager::Instance ().property ("ShowStatusChangesEventsInPrivates").toBool ())
-			return;
+			return false;
 
 		if ((msg->GetMessageSubType () == IMessage::SubType::ParticipantJoin ||
 					msg->GetMessageSubType () == IMessage::SubType::ParticipantLeave) &&
 				!XmlSettingsManager::Instance ().property ("ShowJoinsLeaves").toBool ())
-			return;
+			return false;
 
 		if (msg->GetMessageSubType () == IMessage::SubType::ParticipantEndedConversation)
 		{
 			if (!XmlSettingsManager::Instance ().property ("ShowEndConversations").toBool ())
-				return;
+				return false;
 			else if (other)
 				msg->SetBody (tr ("%1 ended the conversation.")
 						.arg (other->GetEntryName ()));
@@ -1880,7 +1989,7 @@ namespace Azoth
 		Util::DefaultHookProxy_ptr proxy (new Util::DefaultHookProxy);
 		emit hookGonnaAppendMsg (proxy, msg->GetQObject ());
 		if (proxy->IsCancelled ())
-			return;
+			return false;
 
 		if (XmlSettingsManager::Instance ().property ("SeparateMUCEventLogWindow").toBool () &&
 				(!parent || parent->GetEntryType () == ICLEntry::EntryType::MUC) &&
@@ -1892,7 +2001,7 @@ namespace Azoth
 						.arg (dt)
 						.arg (msg->GetEscapedBody ()));
 			if (msg->GetMessageSubType () != IMessage::SubType::RoomSubjectChange)
-				return;
+				return false;
 		}
 
 		QWebFrame *frame = Ui_.View_->page ()->mainFrame ();
@@ -1935,8 +2044,53 @@ namespace Azoth
 
 		if (!Core::Instance ().AppendMessageByTemplate (frame,
 				msg->GetQObject (), info))
+		{
 			qWarning () << Q_FUNC_INFO
 					<< "unhandled append message :(";
+			return false;
+		}
+
+		++RenderedMessages_;
+		return true;
+	}
+
+	void ChatTab::EnqueueMessage (IMessage *msg)
+	{
+		PendingMessages_ << msg->GetQObject ();
+
+		if (IsFlushScheduled_)
+			return;
+
+		IsFlushScheduled_ = true;
+		QTimer::singleShot (0,
+				this,
+				SLOT (flushPendingMessages ()));
+	}
+
+	void ChatTab::TrimRenderedMessages ()
+	{
+		if (RenderedMessages_ <= RenderLimit_)
+			return;
+
+		// Nothing can be trimmed until the page has its messages container.
+		const auto& trimmed = Ui_.View_->page ()->mainFrame ()->
+				evaluateJavaScript (QString ("TrimMessages(%1);").arg (RenderLimit_));
+		if (!trimmed.toBool ())
+			return;
+
+		NotRenderedMessages_ += RenderedMessages_ - RenderLimit_;
+		RenderedMessages_ = RenderLimit_;
+	}
+
+	void ChatTab::ResetRenderWindow ()
+	{
+		RenderLimit_ = std::min (ScrollbackPageSize, GetMaxRenderedMessages ());
+		RenderedMessages_ = 0;
+		NotRenderedMessages_ = 0;
+		PendingMessages_.clear ();
+
+		ScrollbackLoadedCount_ = 0;
+		ScrollbackTimer_->stop ();
 	}
 
 	QString ChatTab::ReformatTitle ()
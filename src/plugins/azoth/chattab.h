@@ -105,6 +105,23 @@ namespace Azoth
 		QDateTime LastDateTime_;
 		QList<CoreMessage*> CoreMessages_;
 
+		QList<QPointer<QObject>> PendingMessages_;
+		bool IsFlushScheduled_ = false;
+
+		/* The view only renders the last RenderLimit_ messages, older
+		 * ones are loaded on scrolling up until the hard limit is hit.
+		 */
+		int RenderLimit_ = 0;
+		int RenderedMessages_ = 0;
+		int NotRenderedMessages_ = 0;
+		bool IsViewLoaded_ = false;
+
+		/* Non-zero while the view is being reloaded to show older
+		 * messages after scrolling to the top.
+		 */
+		int ScrollbackLoadedCount_ = 0;
+		int ScrollbackPrevLimit_ = 0;
+
 		QIcon TabIcon_;
 		bool IsMUC_ = false;
 		int PreviousTextHeight_ = 0;
@@ -115,6 +132,7 @@ namespace Azoth
 		ITransferManager *XferManager_;
 
 		QTimer *TypeTimer_;
+		QTimer * const ScrollbackTimer_;
 
 		ChatPartState PreviousState_ = CPSNone;
 		QString LastLink_;
@@ -201,6 +219,9 @@ namespace Azoth
 		void on_SubjectButton__toggled (bool);
 		void on_SubjChange__released ();
 		void on_View__loadFinished (bool);
+		void flushPendingMessages ();
+		void handleViewScrolled ();
+		void handleScrollbackTimeout ();
 		void handleHistoryBack ();
 		void handleRichTextToggled ();
 		void handleQuoteSelection ();
@@ -256,7 +277,10 @@ namespace Azoth
 
 		/** Appends the message to the message view area.
 		 */
-		void AppendMessage (IMessage*);
+		void EnqueueMessage (IMessage*);
+		bool AppendMessage (IMessage*);
+		void TrimRenderedMessages ();
+		void ResetRenderWindow ();
 
 		/** Updates the tab icon and other usages of state icon from the
 		 * TabIcon_.
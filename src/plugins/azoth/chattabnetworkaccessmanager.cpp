@@ -32,6 +32,7 @@
 #include <QNetworkReply>
 #include <QtDebug>
 #include <QBuffer>
+#include <QImageReader>
 #include <util/sll/delayedexecutor.h>
 #include <util/threads/futures.h>
 #include "avatarsmanager.h"
@@ -113,6 +114,55 @@ namespace Azoth
 
 			emit finished ();
 		}
+
+		class SmileReply : public QNetworkReply
+		{
+			QBuffer Buffer_;
+		public:
+			SmileReply (const QByteArray&);
+
+			qint64 bytesAvailable () const override;
+			qint64 readData (char* data, qint64 maxlen) override;
+			void abort () override;
+		};
+
+		SmileReply::SmileReply (const QByteArray& data)
+		{
+			open (QIODevice::ReadOnly);
+
+			Buffer_.setData (data);
+			Buffer_.open (QIODevice::ReadOnly);
+
+			const auto& format = QImageReader::imageFormat (&Buffer_);
+			Buffer_.seek (0);
+			setHeader (QNetworkRequest::ContentTypeHeader,
+					"image/" + (format.isEmpty () ? QByteArray { "png" } : format));
+			setHeader (QNetworkRequest::ContentLengthHeader, Buffer_.size ());
+			setAttribute (QNetworkRequest::HttpStatusCodeAttribute, 200);
+			setAttribute (QNetworkRequest::HttpReasonPhraseAttribute, QByteArray { "OK" });
+
+			Util::ExecuteLater ([this]
+					{
+						emit metaDataChanged ();
+						emit downloadProgress (Buffer_.size (), Buffer_.size ());
+						emit readyRead ();
+						emit finished ();
+					});
+		}
+
+		qint64 SmileReply::bytesAvailable () const
+		{
+			return QNetworkReply::bytesAvailable () + Buffer_.bytesAvailable ();
+		}
+
+		qint64 SmileReply::readData (char *data, qint64 maxlen)
+		{
+			return Buffer_.read (data, maxlen);
+		}
+
+		void SmileReply::abort ()
+		{
+		}
 	}
 
 	ChatTabNetworkAccessManager::ChatTabNetworkAccessManager (AvatarsManager *am, QObject *parent)
@@ -127,8 +177,28 @@ namespace Azoth
 		const auto& url = request.url ();
 		if (url.scheme () == "azoth" && url.host () == "avatar")
 			return new AvatarReply { request, AvatarsMgr_ };
+		if (url.scheme () == "azoth" && url.host () == "smile")
+			return new SmileReply { GetSmileImage (url) };
 
 		return QNetworkAccessManager::createRequest (op, request, outgoingData);
 	}
+
+	QByteArray ChatTabNetworkAccessManager::GetSmileImage (const QUrl& url)
+	{
+		const auto& path = url.path ();
+		const auto& pack = QString::fromUtf8 (QByteArray::fromHex (path.section ('/', 1, 1).toLatin1 ()));
+		const auto& smile = QString::fromUtf8 (QByteArray::fromHex (path.section ('/', 2, 2).toLatin1 ()));
+
+		if (pack != SmilesCachePack_)
+		{
+			SmilesCache_.clear ();
+			SmilesCachePack_ = pack;
+		}
+
+		auto pos = SmilesCache_.find (smile);
+		if (pos == SmilesCache_.end ())
+			pos = SmilesCache_.insert (smile, Core::Instance ().GetSmileImage (pack, smile));
+		return *pos;
+	}
 }
 }
@@ -30,6 +30,7 @@
 #pragma once
 
 #include <QNetworkAccessManager>
+#include <QHash>
 
 namespace LeechCraft
 {
@@ -40,10 +41,15 @@ namespace Azoth
 	class ChatTabNetworkAccessManager : public QNetworkAccessManager
 	{
 		AvatarsManager * const AvatarsMgr_;
+
+		QString SmilesCachePack_;
+		QHash<QString, QByteArray> SmilesCache_;
 	public:
 		ChatTabNetworkAccessManager (AvatarsManager*, QObject* = nullptr);
 	protected:
 		QNetworkReply* createRequest (Operation, const QNetworkRequest&, QIODevice*) override;
+	private:
+		QByteArray GetSmileImage (const QUrl&);
 	};
 }
 }
@@ -184,6 +184,11 @@ namespace Azoth
 		return Entry2Tab_ [entryId];
 	}
 
+	QNetworkAccessManager* ChatTabsManager::GetNetworkAccessManager () const
+	{
+		return NAM_;
+	}
+
 	void ChatTabsManager::UpdateEntryMapping (const QString& id)
 	{
 		if (!Entry2Tab_.contains (id))
@@ -36,6 +36,8 @@
 
 class QWidget;
 
+class QNetworkAccessManager;
+
 namespace LeechCraft
 {
 namespace Azoth
@@ -80,6 +82,11 @@ namespace Azoth
 		ChatTab* GetActiveChatTab () const;
 		ChatTab* GetChatTab (const QString& entryId) const;
 
+		/** Returns the network access manager serving the azoth://
+		 * URLs (avatars and smiles) used in the chat views.
+		 */
+		QNetworkAccessManager* GetNetworkAccessManager () const;
+
 		void UpdateEntryMapping (const QString&);
 
 		void HandleEntryAdded (ICLEntry*);
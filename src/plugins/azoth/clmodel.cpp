@@ -32,9 +32,11 @@
 #include <QUrl>
 #include <QFileInfo>
 #include <QMessageBox>
+#include <util/util.h>
 #include <util/xpc/defaulthookproxy.h>
 #include "interfaces/azoth/iclentry.h"
 #include "interfaces/azoth/iaccount.h"
+#include "interfaces/azoth/ihavemessagesbuffer.h"
 #include "core.h"
 #include "transferjobmanager.h"
 #include "mucinvitedialog.h"
@@ -57,6 +59,10 @@ namespace Azoth
 
 	QVariant CLModel::data (const QModelIndex& index, int role) const
 	{
+		if (role == Qt::ToolTipRole &&
+				index.data (Core::CLREntryType).value<Core::CLEntryType> () == Core::CLETAccount)
+			return GetAccountTooltip (index);
+
 		CheckRequestUpdateTooltip (index, role);
 		return QStandardItemModel::data (index, role);
 	}
@@ -141,6 +147,29 @@ namespace Azoth
 		TooltipManager_->RebuildTooltip (entry);
 	}
 
+	QString CLModel::GetAccountTooltip (const QModelIndex& index) const
+	{
+		const auto account = index.data (Core::CLRAccountObject).value<IAccount*> ();
+		if (!account)
+			return {};
+
+		int count = 0;
+		qint64 memory = 0;
+		for (const auto entryObj : account->GetCLEntries ())
+		{
+			const auto buffer = qobject_cast<IHaveMessagesBuffer*> (entryObj);
+			if (!buffer)
+				continue;
+
+			count += buffer->GetMessagesCount ();
+			memory += buffer->GetMessagesMemoryUsage ();
+		}
+
+		return "<strong>" + account->GetAccountName ().toHtmlEscaped () + "</strong><br/>" +
+				tr ("%n message(s) in memory, about %1.", 0, count)
+					.arg (Util::MakePrettySize (memory));
+	}
+
 	bool CLModel::PerformHooks (const QMimeData *mime, int row, const QModelIndex& parent)
 	{
 		if (CheckHookDnDEntry2Entry (mime, row, parent))
@@ -55,6 +55,7 @@ namespace Azoth
 		Qt::DropActions supportedDropActions () const;
 	private:
 		void CheckRequestUpdateTooltip (const QModelIndex&, int) const;
+		QString GetAccountTooltip (const QModelIndex&) const;
 
 		bool PerformHooks (const QMimeData*, int, const QModelIndex&);
 		bool CheckHookDnDEntry2Entry (const QMimeData*, int, const QModelIndex&);
@@ -40,6 +40,8 @@
 #include <QStringListModel>
 #include <QMessageBox>
 #include <QClipboard>
+#include <QWebFrame>
+#include <QWebPage>
 #include <QtDebug>
 #include <util/util.h>
 #include <util/xpc/util.h>
@@ -104,6 +106,7 @@
 #include "avatarsmanager.h"
 #include "historysyncer.h"
 #include "sslerrorshandler.h"
+#include "smilesmatcher.h"
 
 Q_DECLARE_METATYPE (QPointer<QObject>);
 
@@ -329,8 +332,7 @@ namespace Azoth
 
 	IEmoticonResourceSource* Core::GetCurrentEmoSource () const
 	{
-		const QString& pack = XmlSettingsManager::Instance ()
-				.property ("SmileIcons").toString ();
+		const auto& pack = XmlSettingsManager::Instance ().SmileIcons_.Get ();
 		return SmilesOptionsModel_->GetSourceForOption (pack);
 	}
 
@@ -738,6 +740,7 @@ namespace Azoth
 	void Core::AddSmileResourceSource (IEmoticonResourceSource *src)
 	{
 		SmilesOptionsModel_->AddSource (src);
+		SmilesMatcher_.reset ();
 	}
 
 	void Core::AddChatStyleResourceSource (IChatStyleResourceSource *src)
@@ -754,6 +757,8 @@ namespace Azoth
 		if (!src)
 			return QString ();
 
+		InstallChatNAM (frame);
+
 		const auto& pair = CustomChatStyleManager_->GetForEntry (qobject_cast<ICLEntry*> (entry));
 		if (!pair.first.isEmpty ())
 			return src->GetHTMLTemplate (pair.first, pair.second, entry, frame);
@@ -965,8 +970,7 @@ namespace Azoth
 
 	QString Core::HandleSmiles (QString body)
 	{
-		const QString& pack = XmlSettingsManager::Instance ()
-				.property ("SmileIcons").toString ();
+		const auto& pack = XmlSettingsManager::Instance ().SmileIcons_.Get ();
 
 		Util::DefaultHookProxy_ptr proxy (new Util::DefaultHookProxy);
 		emit hookGonnaHandleSmiles (proxy, body, pack);
@@ -986,66 +990,69 @@ namespace Azoth
 		const bool requireSpace = XmlSettingsManager::Instance ()
 				.property ("RequireSpaceBeforeSmiles").toBool ();
 
-		const QString& img = QString ("<img src=\"%2\" title=\"%1\" />");
-		QMap<int, QString> pos2smile;
-		for (const auto& str : src->GetEmoticonStrings (pack))
-		{
-#if QT_VERSION < 0x050000
-			const auto& escaped = Qt::escape (str);
-#else
-			const auto& escaped = str.toHtmlEscaped ();
-#endif
-			int pos = 0;
-			while ((pos = body.indexOf (escaped, pos)) != -1)
-			{
-				const bool isOk = !pos ||
-						!requireSpace ||
-						(requireSpace && pos && body [pos - 1].isSpace ());
-				if (isOk)
-					pos2smile [pos] = str;
+		const auto& matches = GetSmilesMatcher (src, pack)->FindAll (body, requireSpace);
+		if (matches.isEmpty ())
+			return body;
 
-				pos += escaped.size ();
-			}
-		}
+		const auto& packHex = pack.toUtf8 ().toHex ();
+		const QString img { "<img src=\"azoth://smile/%1/%2\" title=\"%3\" />" };
 
-		if (pos2smile.isEmpty ())
-			return body;
+		QString result;
+		result.reserve (body.size () + matches.size () * img.size ());
 
-		for (auto i = pos2smile.begin (); i != pos2smile.end (); ++i)
+		int lastPos = 0;
+		for (const auto& match : matches)
 		{
-#if QT_VERSION < 0x050000
-			const auto& escapedSmile = Qt::escape (i.value ());
-#else
-			const auto& escapedSmile = i.value ().toHtmlEscaped ();
-#endif
-			for (int j = 1; j < escapedSmile.size (); ++j)
-				pos2smile.remove (i.key () + j);
+			result += body.midRef (lastPos, match.Pos_ - lastPos);
+			result += img
+					.arg (QString::fromLatin1 (packHex))
+					.arg (QString::fromLatin1 (match.Smile_.toUtf8 ().toHex ()))
+					.arg (body.mid (match.Pos_, match.Length_));
+			lastPos = match.Pos_ + match.Length_;
 		}
+		result += body.midRef (lastPos);
 
-		QList<QPair<int, QString>> reversed;
-		reversed.reserve (pos2smile.size ());
-		for (auto i = pos2smile.begin (); i != pos2smile.end (); ++i)
-			reversed.push_front ({ i.key (), i.value () });
+		return result;
+	}
 
-		for (const auto& pair : reversed)
-		{
-			const auto& str = pair.second;
-#if QT_VERSION < 0x050000
-			const auto& escaped = Qt::escape (str);
-#else
-			const auto& escaped = str.toHtmlEscaped ();
-#endif
+	QByteArray Core::GetSmileImage (const QString& pack, const QString& smile) const
+	{
+		const auto src = SmilesOptionsModel_->GetSourceForOption (pack);
+		return src ? src->GetImage (pack, smile) : QByteArray {};
+	}
 
-			const auto& rawData = src->GetImage (pack, str).toBase64 ();
+	void Core::InstallChatNAM (QWebFrame *frame) const
+	{
+		if (!frame)
+			return;
 
-			const auto& smileStr = img
-					.arg (str)
-					.arg (QString ("data:image/png;base64," + rawData));
+		const auto page = frame->page ();
+		const auto nam = ChatTabsManager_->GetNetworkAccessManager ();
+		if (page->networkAccessManager () == nam)
+			return;
 
-			body.replace (pair.first, escaped.size (), smileStr);
+		if (!frame->url ().isEmpty ())
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "the frame has already loaded"
+					<< frame->url ()
+					<< "with another network access manager, not replacing it";
+			return;
+		}
+
+		page->setNetworkAccessManager (nam);
+	}
+
+	std::shared_ptr<SmilesMatcher> Core::GetSmilesMatcher (IEmoticonResourceSource *src, const QString& pack)
+	{
+		if (!SmilesMatcher_ || SmilesMatcherSource_ != src || SmilesMatcherPack_ != pack)
+		{
+			SmilesMatcher_ = std::make_shared<SmilesMatcher> (src->GetEmoticonStrings (pack));
+			SmilesMatcherSource_ = src;
+			SmilesMatcherPack_ = pack;
 		}
 
-		return body;
+		return SmilesMatcher_;
 	}
 
 	namespace
@@ -80,6 +80,7 @@ namespace Azoth
 	class ChatStyleOptionManager;
 	class CustomChatStyleManager;
 	class CLTooltipManager;
+	class SmilesMatcher;
 	class CoreCommandsManager;
 	class NotificationsManager;
 	class AvatarsManager;
@@ -126,6 +127,10 @@ namespace Azoth
 		std::shared_ptr<SourceTrackingModel<IEmoticonResourceSource>> SmilesOptionsModel_;
 		std::shared_ptr<SourceTrackingModel<IChatStyleResourceSource>> ChatStylesOptionsModel_;
 
+		IEmoticonResourceSource *SmilesMatcherSource_ = nullptr;
+		QString SmilesMatcherPack_;
+		std::shared_ptr<SmilesMatcher> SmilesMatcher_;
+
 		std::shared_ptr<PluginManager> PluginManager_;
 		std::shared_ptr<ProxyObject> PluginProxyObject_;
 		std::shared_ptr<TransferJobManager> XferJobManager_;
@@ -268,6 +273,23 @@ namespace Azoth
 		QString FormatBody (QString body, IMessage *msg, const QList<QColor>& coloring);
 		QString HandleSmiles (QString body);
 
+		/** Returns the image data for the given \em smile from the
+		 * given smile \em pack, as served via the azoth://smile/ URLs
+		 * produced by HandleSmiles().
+		 */
+		QByteArray GetSmileImage (const QString& pack, const QString& smile) const;
+
+		/** Makes the page of the given frame use the network access
+		 * manager serving the azoth:// URLs, so that the smiles and
+		 * avatars in the formatted messages are resolved in any view
+		 * rendering them, not just in the chat tabs.
+		 *
+		 * The manager is only installed if the frame hasn't loaded
+		 * anything yet, so this is done when the chat template is
+		 * requested, before the first setContent() on the frame.
+		 */
+		void InstallChatNAM (QWebFrame*) const;
+
 		/** This function increases the number of unread messages by
 		 * the given amount, which may be negative.
 		 */
@@ -291,6 +313,7 @@ namespace Azoth
 		 */
 		void AddResourceSourcePlugin (QObject *object);
 		void AddSmileResourceSource (IEmoticonResourceSource*);
+		std::shared_ptr<SmilesMatcher> GetSmilesMatcher (IEmoticonResourceSource*, const QString&);
 		void AddChatStyleResourceSource (IChatStyleResourceSource*);
 
 		/** Adds the given contact list entry to the given account and
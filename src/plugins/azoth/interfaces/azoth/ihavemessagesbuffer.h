@@ -0,0 +1,81 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+
+#pragma once
+
+#include <QtPlugin>
+
+namespace LeechCraft
+{
+namespace Azoth
+{
+	class IMessage;
+
+	/** @brief Interface for entries keeping a bounded messages buffer.
+	 *
+	 * Entries implementing this interface keep only a limited number
+	 * of last messages in memory (see MessagesBuffer), so the full
+	 * message list returned by ICLEntry::GetAllMessages() may be
+	 * incomplete, and copying it may be expensive. This interface
+	 * allows accessing the buffered messages without copying them and
+	 * querying the memory they use.
+	 *
+	 * @sa MessagesBuffer
+	 */
+	class IHaveMessagesBuffer
+	{
+	public:
+		virtual ~IHaveMessagesBuffer () {}
+
+		/** @brief Returns the number of messages in the buffer.
+		 */
+		virtual int GetMessagesCount () const = 0;
+
+		/** @brief Returns the message at the given position.
+		 *
+		 * The messages are numbered from the oldest one, which is at
+		 * position 0, to GetMessagesCount() - 1.
+		 *
+		 * @param[in] pos The position of the message.
+		 * @return The message at \em pos.
+		 */
+		virtual IMessage* GetMessageAt (int pos) const = 0;
+
+		/** @brief Returns the approximate memory used by the messages.
+		 *
+		 * @return The approximate memory usage in bytes.
+		 */
+		virtual qint64 GetMessagesMemoryUsage () const = 0;
+	};
+}
+}
+
+Q_DECLARE_INTERFACE (LeechCraft::Azoth::IHaveMessagesBuffer,
+		"org.LeechCraft.Azoth.IHaveMessagesBuffer/1.0")
@@ -363,6 +363,18 @@ namespace Azoth
 		virtual IFormatterProxyObject& GetFormatterProxy () = 0;
 
 		virtual IAvatarsManager* GetAvatarsManager () = 0;
+
+		/** @brief Returns the number of messages to keep per entry.
+		 *
+		 * This is the cached value of the MessagesBufferSize setting,
+		 * so it is cheap enough to be queried for each message.
+		 *
+		 * @return The capacity for the MessagesBuffer, with a
+		 * non-positive value meaning no limit.
+		 *
+		 * @sa MessagesBuffer
+		 */
+		virtual int GetMessagesBufferSize () const = 0;
 	};
 }
 }
@@ -0,0 +1,361 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+
+#pragma once
+
+#include <vector>
+#include <algorithm>
+#include <iterator>
+#include <cstddef>
+#include <QList>
+#include <QDateTime>
+#include <QtDebug>
+#include <interfaces/azoth/imessage.h>
+#include <interfaces/azoth/azothutil.h>
+
+namespace LeechCraft
+{
+namespace Azoth
+{
+	/** @brief A bounded in-memory buffer of the messages of an entry.
+	 *
+	 * This class keeps at most GetCapacity() last messages of an entry
+	 * in a ring buffer. When a new message is appended to the full
+	 * buffer, the oldest message is evicted and scheduled for deletion
+	 * via QObject::deleteLater(). The evicted messages are still
+	 * available via the history plugins, which log all the messages as
+	 * they arrive.
+	 *
+	 * A non-positive capacity means the buffer is unbounded.
+	 *
+	 * The buffer owns the messages appended to it: they are deleted
+	 * when evicted, purged or when the buffer itself is destroyed,
+	 * unless they are taken back via TakeAll().
+	 *
+	 * The buffer also keeps a rough estimate of the memory used by the
+	 * messages, see GetMemoryUsage().
+	 *
+	 * @tparam T The type of the message object, which should be
+	 * implementing the IMessage interface.
+	 *
+	 * @sa IHaveMessagesBuffer
+	 */
+	template<typename T>
+	class MessagesBuffer
+	{
+		std::vector<T*> Ring_;
+		std::vector<qint64> Sizes_;
+
+		/* If the buffer isn't full, Head_ is always 0 and Ring_ holds
+		 * exactly Size () elements.
+		 */
+		size_t Head_ = 0;
+		int Capacity_;
+		qint64 MemoryUsage_ = 0;
+	public:
+		class const_iterator
+		{
+			const MessagesBuffer *Buffer_;
+			int Pos_;
+		public:
+			using iterator_category = std::forward_iterator_tag;
+			using value_type = T*;
+			using difference_type = std::ptrdiff_t;
+			using pointer = T* const*;
+			using reference = T*;
+
+			const_iterator (const MessagesBuffer *buffer, int pos)
+			: Buffer_ { buffer }
+			, Pos_ { pos }
+			{
+			}
+
+			T* operator* () const
+			{
+				return Buffer_->At (Pos_);
+			}
+
+			const_iterator& operator++ ()
+			{
+				++Pos_;
+				return *this;
+			}
+
+			const_iterator operator++ (int)
+			{
+				auto copy = *this;
+				++Pos_;
+				return copy;
+			}
+
+			bool operator== (const const_iterator& other) const
+			{
+				return Buffer_ == other.Buffer_ && Pos_ == other.Pos_;
+			}
+
+			bool operator!= (const const_iterator& other) const
+			{
+				return !(*this == other);
+			}
+		};
+
+		/** @brief The default number of messages kept in memory.
+		 */
+		static const int DefaultCapacity = 1000;
+
+		explicit MessagesBuffer (int capacity = DefaultCapacity)
+		: Capacity_ { capacity }
+		{
+		}
+
+		MessagesBuffer (const MessagesBuffer&) = delete;
+		MessagesBuffer& operator= (const MessagesBuffer&) = delete;
+
+		~MessagesBuffer ()
+		{
+			for (const auto msg : Ring_)
+				delete msg;
+		}
+
+		int GetCapacity () const
+		{
+			return Capacity_;
+		}
+
+		/** @brief Changes the capacity of the buffer.
+		 *
+		 * If the buffer holds more messages than the new \em capacity,
+		 * the oldest ones are evicted.
+		 *
+		 * @param[in] capacity The new capacity, or a non-positive value
+		 * for an unbounded buffer.
+		 * @return The list of evicted messages, already scheduled for
+		 * deletion.
+		 */
+		QList<T*> SetCapacity (int capacity)
+		{
+			if (capacity == Capacity_)
+				return {};
+
+			Linearize ();
+			Capacity_ = capacity;
+
+			QList<T*> evicted;
+			if (Capacity_ > 0 && Size () > Capacity_)
+			{
+				const auto count = Size () - Capacity_;
+				for (int i = 0; i < count; ++i)
+				{
+					evicted << Ring_ [i];
+					ScheduleDeletion (Ring_ [i]);
+					MemoryUsage_ -= Sizes_ [i];
+				}
+				Ring_.erase (Ring_.begin (), Ring_.begin () + count);
+				Sizes_.erase (Sizes_.begin (), Sizes_.begin () + count);
+			}
+			return evicted;
+		}
+
+		/** @brief Appends the message to the end of the buffer.
+		 *
+		 * If the buffer is full, the oldest message is evicted.
+		 *
+		 * @param[in] msg The message to append.
+		 * @return The list of evicted messages, already scheduled for
+		 * deletion. The caller should forget about them, for example,
+		 * by removing them from the list of unread messages.
+		 */
+		QList<T*> Append (T *msg)
+		{
+			const auto size = EstimateSize (msg);
+			MemoryUsage_ += size;
+
+			if (Capacity_ <= 0 || static_cast<int> (Ring_.size ()) < Capacity_)
+			{
+				Ring_.push_back (msg);
+				Sizes_.push_back (size);
+				return {};
+			}
+
+			const auto evicted = Ring_ [Head_];
+			ScheduleDeletion (evicted);
+			MemoryUsage_ -= Sizes_ [Head_];
+
+			Ring_ [Head_] = msg;
+			Sizes_ [Head_] = size;
+			Head_ = (Head_ + 1) % Ring_.size ();
+			return { evicted };
+		}
+
+		MessagesBuffer& operator<< (T *msg)
+		{
+			Append (msg);
+			return *this;
+		}
+
+		int Size () const
+		{
+			return Ring_.size ();
+		}
+
+		bool IsEmpty () const
+		{
+			return Ring_.empty ();
+		}
+
+		/** @brief Returns the message at the given position.
+		 *
+		 * The messages are numbered from the oldest one, which is at
+		 * position 0.
+		 */
+		T* At (int pos) const
+		{
+			return Ring_ [(Head_ + pos) % Ring_.size ()];
+		}
+
+		const_iterator begin () const
+		{
+			return { this, 0 };
+		}
+
+		const_iterator end () const
+		{
+			return { this, Size () };
+		}
+
+		/** @brief Returns the approximate memory used by the messages.
+		 *
+		 * The estimate is based on the length of the message bodies at
+		 * the moment of appending plus a constant per-message overhead.
+		 *
+		 * @return The approximate memory usage in bytes.
+		 */
+		qint64 GetMemoryUsage () const
+		{
+			return MemoryUsage_;
+		}
+
+		/** @brief Returns the messages in the buffer as a list.
+		 *
+		 * @tparam U The type of the list element, T by default. Pass
+		 * IMessage to get a list suitable for
+		 * ICLEntry::GetAllMessages().
+		 */
+		template<typename U = T>
+		QList<U*> ToList () const
+		{
+			QList<U*> result;
+			result.reserve (Size ());
+			for (const auto msg : *this)
+				result << msg;
+			return result;
+		}
+
+		/** @brief Removes all the messages from the buffer without
+		 * deleting them.
+		 *
+		 * @return The messages, ordered from the oldest one.
+		 */
+		QList<T*> TakeAll ()
+		{
+			const auto& result = ToList ();
+			Ring_.clear ();
+			Sizes_.clear ();
+			Head_ = 0;
+			MemoryUsage_ = 0;
+			return result;
+		}
+
+		/** @brief Deletes the messages older than the given date.
+		 *
+		 * This function mirrors AzothUtil::StandardPurgeMessages(): if
+		 * \em before is invalid, all the messages are deleted.
+		 *
+		 * @param[in] before Messages with timestamp earlier than this
+		 * parameter will be deleted.
+		 * @return The list of the deleted messages. The pointers are
+		 * dangling and are only good for removing the messages from
+		 * other containers.
+		 */
+		QList<T*> Purge (const QDateTime& before)
+		{
+			Linearize ();
+
+			QList<T*> purged;
+
+			size_t count = 0;
+			while (count < Ring_.size ())
+			{
+				const auto msg = AzothUtil::detail::GetIMessage (Ring_ [count]);
+				if (before.isValid () && msg && msg->GetDateTime () >= before)
+					break;
+
+				purged << Ring_ [count];
+				delete Ring_ [count];
+				MemoryUsage_ -= Sizes_ [count];
+				++count;
+			}
+
+			Ring_.erase (Ring_.begin (), Ring_.begin () + count);
+			Sizes_.erase (Sizes_.begin (), Sizes_.begin () + count);
+			return purged;
+		}
+	private:
+		void Linearize ()
+		{
+			if (!Head_)
+				return;
+
+			std::rotate (Ring_.begin (), Ring_.begin () + Head_, Ring_.end ());
+			std::rotate (Sizes_.begin (), Sizes_.begin () + Head_, Sizes_.end ());
+			Head_ = 0;
+		}
+
+		static void ScheduleDeletion (T *msgObj)
+		{
+			if (const auto msg = AzothUtil::detail::GetIMessage (msgObj))
+				msg->GetQObject ()->deleteLater ();
+			else
+				delete msgObj;
+		}
+
+		static qint64 EstimateSize (T *msgObj)
+		{
+			const qint64 overhead = 512;
+
+			const auto msg = AzothUtil::detail::GetIMessage (msgObj);
+			if (!msg)
+				return overhead;
+
+			return overhead + msg->GetBody ().size () * sizeof (QChar);
+		}
+	};
+}
+}
@@ -29,7 +29,6 @@
 
 #include "channelclentry.h"
 #include <interfaces/azoth/iproxyobject.h>
-#include <interfaces/azoth/azothutil.h>
 #include "channelhandler.h"
 #include "channelpublicmessage.h"
 #include "ircmessage.h"
@@ -187,12 +186,12 @@ namespace Acetamide
 
 	QList<IMessage*> ChannelCLEntry::GetAllMessages () const
 	{
-		return AllMessages_;
+		return AllMessages_.ToList ();
 	}
 
 	void ChannelCLEntry::PurgeMessages (const QDateTime& before)
 	{
-		AzothUtil::StandardPurgeMessages (AllMessages_, before);
+		AllMessages_.Purge (before);
 	}
 
 	void ChannelCLEntry::SetChatPartState (ChatPartState, const QString&)
@@ -315,8 +314,24 @@ namespace Acetamide
 	{
 	}
 
+	int ChannelCLEntry::GetMessagesCount () const
+	{
+		return AllMessages_.Size ();
+	}
+
+	IMessage* ChannelCLEntry::GetMessageAt (int pos) const
+	{
+		return AllMessages_.At (pos);
+	}
+
+	qint64 ChannelCLEntry::GetMessagesMemoryUsage () const
+	{
+		return AllMessages_.GetMemoryUsage ();
+	}
+
 	void ChannelCLEntry::HandleMessage (ChannelPublicMessage *msg)
 	{
+		AllMessages_.SetCapacity (Core::Instance ().GetPluginProxy ()->GetMessagesBufferSize ());
 		AllMessages_ << msg;
 		emit gotMessage (msg);
 	}
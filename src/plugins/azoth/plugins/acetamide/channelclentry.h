@@ -35,6 +35,8 @@
 #include <interfaces/azoth/imucentry.h>
 #include <interfaces/azoth/imucperms.h>
 #include <interfaces/azoth/iconfigurablemuc.h>
+#include <interfaces/azoth/ihavemessagesbuffer.h>
+#include <interfaces/azoth/messagesbuffer.h>
 #include "localtypes.h"
 
 namespace LeechCraft
@@ -53,16 +55,18 @@ namespace Acetamide
 						 , public IMUCEntry
 						 , public IMUCPerms
 						 , public IConfigurableMUC
+						 , public IHaveMessagesBuffer
 
 	{
 		Q_OBJECT
 		Q_INTERFACES (LeechCraft::Azoth::IMUCEntry
 				LeechCraft::Azoth::ICLEntry
 				LeechCraft::Azoth::IMUCPerms
-				LeechCraft::Azoth::IConfigurableMUC)
+				LeechCraft::Azoth::IConfigurableMUC
+				LeechCraft::Azoth::IHaveMessagesBuffer)
 
 		ChannelHandler *ICH_;
-		QList<IMessage*> AllMessages_;
+		MessagesBuffer<IMessage> AllMessages_;
 		bool IsWidgetRequest_;
 
 		QMap<QByteArray, QList<QByteArray>> Perms_;
@@ -115,6 +119,11 @@ namespace Acetamide
 		QVariantMap GetIdentifyingData () const;
 		void InviteToMUC (const QString&, const QString&);
 
+		// IHaveMessagesBuffer
+		int GetMessagesCount () const;
+		IMessage* GetMessageAt (int) const;
+		qint64 GetMessagesMemoryUsage () const;
+
 		void HandleMessage (ChannelPublicMessage*);
 		void HandleNewParticipants (const QList<ICLEntry*>&);
 		void HandleSubjectChanged (const QString&);
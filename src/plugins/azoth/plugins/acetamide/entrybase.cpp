@@ -30,7 +30,6 @@
 #include "entrybase.h"
 #include <QAction>
 #include <interfaces/azoth/iproxyobject.h>
-#include <interfaces/azoth/azothutil.h>
 #include "clientconnection.h"
 #include "ircprotocol.h"
 #include "ircaccount.h"
@@ -53,7 +52,6 @@ namespace Acetamide
 
 	EntryBase::~EntryBase ()
 	{
-		qDeleteAll (AllMessages_);
 		qDeleteAll (Actions_);
 		delete VCardDialog_;
 	}
@@ -65,12 +63,12 @@ namespace Acetamide
 
 	QList<IMessage*> EntryBase::GetAllMessages () const
 	{
-		return AllMessages_;
+		return AllMessages_.ToList ();
 	}
 
 	void EntryBase::PurgeMessages (const QDateTime& before)
 	{
-		AzothUtil::StandardPurgeMessages (AllMessages_, before);
+		AllMessages_.Purge (before);
 	}
 
 	void EntryBase::SetChatPartState (ChatPartState, const QString&)
@@ -121,6 +119,21 @@ namespace Acetamide
 		emit chatTabClosed ();
 	}
 
+	int EntryBase::GetMessagesCount () const
+	{
+		return AllMessages_.Size ();
+	}
+
+	IMessage* EntryBase::GetMessageAt (int pos) const
+	{
+		return AllMessages_.At (pos);
+	}
+
+	qint64 EntryBase::GetMessagesMemoryUsage () const
+	{
+		return AllMessages_.GetMemoryUsage ();
+	}
+
 	void EntryBase::HandleMessage (IrcMessage *msg)
 	{
 		msg->SetOtherPart (this);
@@ -128,6 +141,7 @@ namespace Acetamide
 		const auto proxy = qobject_cast<IProxyObject*> (proto->GetProxyObject ());
 		proxy->GetFormatterProxy ().PreprocessMessage (msg);
 
+		AllMessages_.SetCapacity (proxy->GetMessagesBufferSize ());
 		AllMessages_ << msg;
 		emit gotMessage (msg);
 	}
@@ -34,6 +34,8 @@
 #include <QImage>
 #include <QVariant>
 #include <interfaces/azoth/iclentry.h>
+#include <interfaces/azoth/ihavemessagesbuffer.h>
+#include <interfaces/azoth/messagesbuffer.h>
 #include "localtypes.h"
 
 namespace LeechCraft
@@ -48,11 +50,13 @@ namespace Acetamide
 
 	class EntryBase : public QObject
 					, public ICLEntry
+					, public IHaveMessagesBuffer
 	{
 		Q_OBJECT
-		Q_INTERFACES (LeechCraft::Azoth::ICLEntry)
+		Q_INTERFACES (LeechCraft::Azoth::ICLEntry
+				LeechCraft::Azoth::IHaveMessagesBuffer)
 	protected:
-		QList<IMessage*> AllMessages_;
+		MessagesBuffer<IMessage> AllMessages_;
 		EntryStatus CurrentStatus_;
 		QList<QAction*> Actions_;
 
@@ -75,6 +79,11 @@ namespace Acetamide
 		void MarkMsgsRead ();
 		void ChatTabClosed ();
 
+		// IHaveMessagesBuffer
+		int GetMessagesCount () const;
+		IMessage* GetMessageAt (int) const;
+		qint64 GetMessagesMemoryUsage () const;
+
 		virtual QString GetEntryID () const = 0;
 
 		void HandleMessage (IrcMessage*);
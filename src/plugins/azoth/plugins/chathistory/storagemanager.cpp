@@ -152,12 +152,22 @@ namespace ChatHistory
 	void StorageManager::AddLogItems (const QString& accountId, const QString& entryId,
 			const QString& visibleName, const QList<LogItem>& items, bool fuzzy)
 	{
-		StorageThread_->Schedule (&Storage::AddMessages,
-				accountId,
-				entryId,
-				visibleName,
-				items,
-				fuzzy);
+		// Fuzzy additions come from history imports, which may be huge,
+		// while plain ones are the messages of the open chats.
+		if (fuzzy)
+			StorageThread_->ScheduleBackground (&Storage::AddMessages,
+					accountId,
+					entryId,
+					visibleName,
+					items,
+					fuzzy);
+		else
+			StorageThread_->Schedule (&Storage::AddMessages,
+					accountId,
+					entryId,
+					visibleName,
+					items,
+					fuzzy);
 	}
 
 	QFuture<IHistoryPlugin::MaxTimestampResult_t> StorageManager::GetMaxTimestamp (const QString& accId)
@@ -207,7 +217,7 @@ namespace ChatHistory
 
 	void StorageManager::RegenUsersCache ()
 	{
-		StorageThread_->Schedule (&Storage::RegenUsersCache);
+		StorageThread_->ScheduleBackground (&Storage::RegenUsersCache);
 	}
 
 	void StorageManager::StartStorage ()
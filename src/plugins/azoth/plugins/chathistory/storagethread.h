@@ -50,6 +50,12 @@ namespace ChatHistory
 		{
 			return ScheduleImpl (std::forward<Args> (args)...);
 		}
+
+		template<typename... Args>
+		auto ScheduleBackground (Args&&... args) -> decltype (ScheduleImpl (std::forward<Args> (args)...))
+		{
+			return ScheduleImplWith ({ Priority::Background }, std::forward<Args> (args)...);
+		}
 	};
 }
 }
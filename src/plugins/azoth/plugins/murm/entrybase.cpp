@@ -37,7 +37,6 @@
 #include <util/sll/qtutil.h>
 #include <util/sys/extensionsdata.h>
 #include <interfaces/core/iiconthememanager.h>
-#include <interfaces/azoth/azothutil.h>
 #include <interfaces/azoth/iproxyobject.h>
 #include "vkaccount.h"
 #include "vkmessage.h"
@@ -56,8 +55,14 @@ namespace Murm
 	{
 	}
 
+	// Out of line, since the messages buffer needs the complete VkMessage.
+	EntryBase::~EntryBase ()
+	{
+	}
+
 	void EntryBase::Store (VkMessage *msg)
 	{
+		Messages_.SetCapacity (Account_->GetParentProtocol ()->GetAzothProxy ()->GetMessagesBufferSize ());
 		Messages_ << msg;
 		emit gotMessage (msg);
 	}
@@ -81,15 +86,12 @@ namespace Murm
 
 	QList<IMessage*> EntryBase::GetAllMessages () const
 	{
-		QList<IMessage*> result;
-		for (auto obj : Messages_)
-			result << obj;
-		return result;
+		return Messages_.ToList<IMessage> ();
 	}
 
 	void EntryBase::PurgeMessages (const QDateTime& before)
 	{
-		AzothUtil::StandardPurgeMessages (Messages_, before);
+		Messages_.Purge (before);
 	}
 
 	void EntryBase::MarkMsgsRead ()
@@ -113,6 +115,21 @@ namespace Murm
 			Account_->GetConnection ()->MarkAsRead (ids);
 	}
 
+	int EntryBase::GetMessagesCount () const
+	{
+		return Messages_.Size ();
+	}
+
+	IMessage* EntryBase::GetMessageAt (int pos) const
+	{
+		return Messages_.At (pos);
+	}
+
+	qint64 EntryBase::GetMessagesMemoryUsage () const
+	{
+		return Messages_.GetMemoryUsage ();
+	}
+
 	namespace
 	{
 		const QString AudioDivStyle = "border-color: #CDCCCC; "
@@ -34,6 +34,8 @@
 #include <QPair>
 #include <interfaces/azoth/iclentry.h>
 #include <interfaces/azoth/iupdatablechatentry.h>
+#include <interfaces/azoth/ihavemessagesbuffer.h>
+#include <interfaces/azoth/messagesbuffer.h>
 
 namespace LeechCraft
 {
@@ -49,17 +51,20 @@ namespace Murm
 	class EntryBase : public QObject
 					, public ICLEntry
 					, public IUpdatableChatEntry
+					, public IHaveMessagesBuffer
 	{
 		Q_OBJECT
 		Q_INTERFACES (LeechCraft::Azoth::ICLEntry
-				LeechCraft::Azoth::IUpdatableChatEntry)
+				LeechCraft::Azoth::IUpdatableChatEntry
+				LeechCraft::Azoth::IHaveMessagesBuffer)
 	protected:
 		VkAccount * const Account_;
-		QList<VkMessage*> Messages_;
+		MessagesBuffer<VkMessage> Messages_;
 
 		bool HasUnread_ = false;
 	public:
 		EntryBase (VkAccount*);
+		~EntryBase ();
 
 		virtual void Send (VkMessage*) = 0;
 		void Store (VkMessage*);
@@ -72,6 +77,10 @@ namespace Murm
 		void PurgeMessages (const QDateTime& before) override;
 
 		void MarkMsgsRead () override;
+
+		int GetMessagesCount () const override;
+		IMessage* GetMessageAt (int) const override;
+		qint64 GetMessagesMemoryUsage () const override;
 	protected:
 		void HandleAttaches (VkMessage*, const MessageInfo&, const FullMessageInfo&);
 	private:
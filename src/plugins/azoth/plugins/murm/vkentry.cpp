@@ -340,9 +340,9 @@ namespace Murm
 
 		if (info.Flags_ & MessageFlag::Outbox)
 		{
-			for (int i = Messages_.size () - 1; i >= 0; --i)
+			for (int i = Messages_.Size () - 1; i >= 0; --i)
 			{
-				auto msg = Messages_.at (i);
+				auto msg = Messages_.At (i);
 				if (msg->GetID () == static_cast<qulonglong> (-1) &&
 						msg->GetDirection () == IMessage::Direction::Out &&
 						msg->GetBody () == info.Text_)
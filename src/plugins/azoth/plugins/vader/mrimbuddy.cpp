@@ -36,7 +36,6 @@
 #include <util/xpc/util.h>
 #include <util/threads/futures.h>
 #include <interfaces/core/ientitymanager.h>
-#include <interfaces/azoth/azothutil.h>
 #include <interfaces/azoth/iproxyobject.h>
 #include "proto/headers.h"
 #include "proto/connection.h"
@@ -93,8 +92,14 @@ namespace Vader
 		UpdateClientVersion ();
 	}
 
+	// Out of line, since the messages buffer needs the complete MRIMMessage.
+	MRIMBuddy::~MRIMBuddy ()
+	{
+	}
+
 	void MRIMBuddy::HandleMessage (MRIMMessage *msg)
 	{
+		AllMessages_.SetCapacity (A_->GetParentProtocol ()->GetAzothProxy ()->GetMessagesBufferSize ());
 		AllMessages_ << msg;
 		emit gotMessage (msg);
 	}
@@ -324,14 +329,12 @@ namespace Vader
 
 	QList<IMessage*> MRIMBuddy::GetAllMessages () const
 	{
-		QList<IMessage*> result;
-		std::copy (AllMessages_.begin (), AllMessages_.end (), std::back_inserter (result));
-		return result;
+		return AllMessages_.ToList<IMessage> ();
 	}
 
 	void MRIMBuddy::PurgeMessages (const QDateTime& before)
 	{
-		AzothUtil::StandardPurgeMessages (AllMessages_, before);
+		AllMessages_.Purge (before);
 	}
 
 	void MRIMBuddy::SetChatPartState (ChatPartState state, const QString&)
@@ -407,6 +410,21 @@ namespace Vader
 		return false;
 	}
 
+	int MRIMBuddy::GetMessagesCount () const
+	{
+		return AllMessages_.Size ();
+	}
+
+	IMessage* MRIMBuddy::GetMessageAt (int pos) const
+	{
+		return AllMessages_.At (pos);
+	}
+
+	qint64 MRIMBuddy::GetMessagesMemoryUsage () const
+	{
+		return AllMessages_.GetMemoryUsage ();
+	}
+
 	void MRIMBuddy::UpdateClientVersion ()
 	{
 		auto defClient = [this] ()
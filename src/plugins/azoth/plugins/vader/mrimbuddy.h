@@ -37,6 +37,8 @@
 #include <interfaces/azoth/iadvancedclentry.h>
 #include <interfaces/azoth/ihavecontacttune.h>
 #include <interfaces/azoth/ihaveavatars.h>
+#include <interfaces/azoth/ihavemessagesbuffer.h>
+#include <interfaces/azoth/messagesbuffer.h>
 #include "mrimaccount.h"
 #include "proto/contactinfo.h"
 
@@ -55,19 +57,21 @@ namespace Vader
 					, public IHaveAvatars
 					, public IHaveContactTune
 					, public IAdvancedCLEntry
+					, public IHaveMessagesBuffer
 	{
 		Q_OBJECT
 		Q_INTERFACES (LeechCraft::Azoth::ICLEntry
 				LeechCraft::Azoth::IHaveAvatars
 				LeechCraft::Azoth::IHaveContactTune
-				LeechCraft::Azoth::IAdvancedCLEntry)
+				LeechCraft::Azoth::IAdvancedCLEntry
+				LeechCraft::Azoth::IHaveMessagesBuffer)
 
 		MRIMAccount *A_;
 		Proto::ContactInfo Info_;
 		QString Group_;
 
 		EntryStatus Status_;
-		QList<MRIMMessage*> AllMessages_;
+		MessagesBuffer<MRIMMessage> AllMessages_;
 		bool IsAuthorized_ = true;
 		bool GaveSubscription_ = true;
 
@@ -83,6 +87,7 @@ namespace Vader
 		Media::AudioInfo TuneInfo_;
 	public:
 		MRIMBuddy (const Proto::ContactInfo&, MRIMAccount*);
+		~MRIMBuddy ();
 
 		void HandleMessage (MRIMMessage*);
 		void HandleAttention (const QString&);
@@ -151,6 +156,11 @@ namespace Vader
 		QFuture<QImage> RefreshAvatar (Size);
 		bool HasAvatar () const;
 		bool SupportsSize (Size) const;
+
+		// IHaveMessagesBuffer
+		int GetMessagesCount () const;
+		IMessage* GetMessageAt (int) const;
+		qint64 GetMessagesMemoryUsage () const;
 	private:
 		void UpdateClientVersion ();
 	private slots:
@@ -49,7 +49,6 @@
 #include <util/sll/delayedexecutor.h>
 #include <util/threads/futures.h>
 #include <interfaces/azoth/iproxyobject.h>
-#include <interfaces/azoth/azothutil.h>
 #include "glooxmessage.h"
 #include "glooxclentry.h"
 #include "glooxprotocol.h"
@@ -112,7 +111,6 @@ namespace Xoox
 
 	EntryBase::~EntryBase ()
 	{
-		qDeleteAll (AllMessages_);
 		qDeleteAll (Actions_);
 		delete VCardDialog_;
 	}
@@ -124,14 +122,12 @@ namespace Xoox
 
 	QList<IMessage*> EntryBase::GetAllMessages () const
 	{
-		QList<IMessage*> result;
-		std::copy (AllMessages_.begin (), AllMessages_.end (), std::back_inserter (result));
-		return result;
+		return AllMessages_.ToList<IMessage> ();
 	}
 
 	void EntryBase::PurgeMessages (const QDateTime& before)
 	{
-		AzothUtil::StandardPurgeMessages (AllMessages_, before);
+		ForgetUnread (AllMessages_.Purge (before));
 	}
 
 	namespace
@@ -539,6 +535,21 @@ namespace Xoox
 		return new PendingVersionQuery { vm, jid, this };
 	}
 
+	int EntryBase::GetMessagesCount () const
+	{
+		return AllMessages_.Size ();
+	}
+
+	IMessage* EntryBase::GetMessageAt (int pos) const
+	{
+		return AllMessages_.At (pos);
+	}
+
+	qint64 EntryBase::GetMessagesMemoryUsage () const
+	{
+		return AllMessages_.GetMemoryUsage ();
+	}
+
 	const QByteArray& EntryBase::GetVCardPhotoHash () const
 	{
 		return VCardPhotoHash_;
@@ -563,7 +574,7 @@ namespace Xoox
 		const auto proxy = Account_->GetParentProtocol ()->GetProxyObject ();
 		proxy->GetFormatterProxy ().PreprocessMessage (msg);
 
-		AllMessages_ << msg;
+		AppendMessage (msg);
 		emit gotMessage (msg);
 	}
 
@@ -869,6 +880,27 @@ namespace Xoox
 		return Variant2Version_ [var];
 	}
 
+	void EntryBase::AppendMessage (GlooxMessage *msg)
+	{
+		const auto capacity = Account_->GetParentProtocol ()->
+				GetProxyObject ()->GetMessagesBufferSize ();
+
+		auto evicted = AllMessages_.SetCapacity (capacity);
+		evicted += AllMessages_.Append (msg);
+		ForgetUnread (evicted);
+	}
+
+	void EntryBase::ForgetUnread (const QList<GlooxMessage*>& msgs)
+	{
+		if (msgs.isEmpty () || UnreadMessages_.isEmpty ())
+			return;
+
+		const auto& set = msgs.toSet ();
+		UnreadMessages_.erase (std::remove_if (UnreadMessages_.begin (), UnreadMessages_.end (),
+					[&set] (GlooxMessage *msg) { return set.contains (msg); }),
+				UnreadMessages_.end ());
+	}
+
 	void EntryBase::HandleUserActivity (const UserActivity *activity, const QString& variant)
 	{
 		if (activity->GetGeneral () == UserActivity::GeneralEmpty)
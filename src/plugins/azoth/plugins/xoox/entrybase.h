@@ -51,6 +51,8 @@
 #include <interfaces/azoth/ihavecontactmood.h>
 #include <interfaces/azoth/ihavecontactactivity.h>
 #include <interfaces/azoth/ihaveavatars.h>
+#include <interfaces/azoth/ihavemessagesbuffer.h>
+#include <interfaces/azoth/messagesbuffer.h>
 
 class QXmppPresence;
 class QXmppVersionIq;
@@ -91,6 +93,7 @@ namespace Xoox
 					, public IHaveEntityTime
 					, public IHavePings
 					, public IHaveQueriableVersion
+					, public IHaveMessagesBuffer
 	{
 		Q_OBJECT
 		Q_INTERFACES (LeechCraft::Azoth::ICLEntry
@@ -104,13 +107,14 @@ namespace Xoox
 				LeechCraft::Azoth::IHaveContactActivity
 				LeechCraft::Azoth::IHaveEntityTime
 				LeechCraft::Azoth::IHavePings
-				LeechCraft::Azoth::IHaveQueriableVersion)
+				LeechCraft::Azoth::IHaveQueriableVersion
+				LeechCraft::Azoth::IHaveMessagesBuffer)
 	protected:
 		GlooxAccount *Account_;
 
 		const QString HumanReadableId_;
 
-		QList<GlooxMessage*> AllMessages_;
+		MessagesBuffer<GlooxMessage> AllMessages_;
 		QList<GlooxMessage*> UnreadMessages_;
 		QMap<QString, EntryStatus> CurrentStatus_;
 		QList<QAction*> Actions_;
@@ -197,6 +201,11 @@ namespace Xoox
 		// IHaveQueriableVersion
 		QObject* QueryVersion (const QString& variant);
 
+		// IHaveMessagesBuffer
+		int GetMessagesCount () const;
+		IMessage* GetMessageAt (int) const;
+		qint64 GetMessagesMemoryUsage () const;
+
 		const QByteArray& GetVCardPhotoHash () const;
 
 		virtual QString GetJID () const = 0;
@@ -222,6 +231,9 @@ namespace Xoox
 
 		QByteArray GetVariantVerString (const QString&) const;
 		QXmppVersionIq GetClientVersion (const QString&) const;
+	protected:
+		void AppendMessage (GlooxMessage*);
+		void ForgetUnread (const QList<GlooxMessage*>&);
 	private:
 		void HandleUserActivity (const UserActivity*, const QString&);
 		void HandleUserMood (const UserMood*, const QString&);
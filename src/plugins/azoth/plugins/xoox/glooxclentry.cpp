@@ -334,7 +334,7 @@ namespace Xoox
 			return nullptr;
 
 		const auto msg = Account_->CreateMessage (type, variant, text, GetJID ());
-		AllMessages_ << msg;
+		AppendMessage (msg);
 		return msg;
 	}
 
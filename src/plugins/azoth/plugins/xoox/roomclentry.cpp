@@ -34,7 +34,6 @@
 #include <QXmppBookmarkManager.h>
 #include <QXmppDiscoveryManager.h>
 #include <interfaces/azoth/iproxyobject.h>
-#include <interfaces/azoth/azothutil.h>
 #include "glooxaccount.h"
 #include "glooxprotocol.h"
 #include "roompublicmessage.h"
@@ -174,12 +173,12 @@ namespace Xoox
 
 	QList<IMessage*> RoomCLEntry::GetAllMessages () const
 	{
-		return AllMessages_;
+		return AllMessages_.ToList ();
 	}
 
 	void RoomCLEntry::PurgeMessages (const QDateTime& before)
 	{
-		AzothUtil::StandardPurgeMessages (AllMessages_, before);
+		AllMessages_.Purge (before);
 	}
 
 	void RoomCLEntry::SetChatPartState (ChatPartState, const QString&)
@@ -566,6 +565,21 @@ namespace Xoox
 		conn->GetClient ()->sendPacket (pres);
 	}
 
+	int RoomCLEntry::GetMessagesCount () const
+	{
+		return AllMessages_.Size ();
+	}
+
+	IMessage* RoomCLEntry::GetMessageAt (int pos) const
+	{
+		return AllMessages_.At (pos);
+	}
+
+	qint64 RoomCLEntry::GetMessagesMemoryUsage () const
+	{
+		return AllMessages_.GetMemoryUsage ();
+	}
+
 	void RoomCLEntry::MoveMessages (const RoomParticipantEntry_ptr& from, const RoomParticipantEntry_ptr& to)
 	{
 		for (const auto msgFace : AllMessages_)
@@ -581,7 +595,10 @@ namespace Xoox
 		Account_->GetParentProtocol ()->GetProxyObject ()->
 				GetFormatterProxy ().PreprocessMessage (msg);
 
-		AllMessages_ << msg;
+		const auto capacity = Account_->GetParentProtocol ()->
+				GetProxyObject ()->GetMessagesBufferSize ();
+		AllMessages_.SetCapacity (capacity);
+		AllMessages_.Append (msg);
 		emit gotMessage (msg);
 	}
 
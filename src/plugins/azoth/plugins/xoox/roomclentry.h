@@ -37,6 +37,8 @@
 #include <interfaces/azoth/imucentry.h>
 #include <interfaces/azoth/imucperms.h>
 #include <interfaces/azoth/iconfigurablemuc.h>
+#include <interfaces/azoth/ihavemessagesbuffer.h>
+#include <interfaces/azoth/messagesbuffer.h>
 #include "roomparticipantentry.h"
 #include "glooxaccount.h"
 
@@ -57,19 +59,21 @@ namespace Xoox
 					  , public IMUCPerms
 					  , public IConfigurableMUC
 					  , public IHaveDirectedStatus
+					  , public IHaveMessagesBuffer
 	{
 		Q_OBJECT
 		Q_INTERFACES (LeechCraft::Azoth::ICLEntry
 						LeechCraft::Azoth::IMUCEntry
 						LeechCraft::Azoth::IMUCPerms
 						LeechCraft::Azoth::IConfigurableMUC
-						LeechCraft::Azoth::IHaveDirectedStatus)
+						LeechCraft::Azoth::IHaveDirectedStatus
+						LeechCraft::Azoth::IHaveMessagesBuffer)
 
 		friend class RoomHandler;
 
 		const bool IsAutojoined_;
 		GlooxAccount *Account_;
-		QList<IMessage*> AllMessages_;
+		MessagesBuffer<IMessage> AllMessages_;
 		RoomHandler *RH_;
 		QMap<QByteArray, QList<QByteArray>> Perms_;
 		QMap<QXmppMucItem::Role, QByteArray> Role2Str_;
@@ -143,6 +147,11 @@ namespace Xoox
 		bool CanSendDirectedStatusNow (const QString&);
 		void SendDirectedStatus (const EntryStatus&, const QString&);
 
+		// IHaveMessagesBuffer
+		int GetMessagesCount () const;
+		IMessage* GetMessageAt (int) const;
+		qint64 GetMessagesMemoryUsage () const;
+
 		void MoveMessages (const RoomParticipantEntry_ptr& from, const RoomParticipantEntry_ptr& to);
 
 		void HandleMessage (RoomPublicMessage*);
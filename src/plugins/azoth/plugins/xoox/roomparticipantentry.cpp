@@ -109,7 +109,7 @@ namespace Xoox
 			const QString&, const QString& body)
 	{
 		const auto msg = RoomHandler_->CreateMessage (type, Nick_, body);
-		AllMessages_ << msg;
+		AppendMessage (msg);
 		return msg;
 	}
 
@@ -145,22 +145,30 @@ namespace Xoox
 
 	void RoomParticipantEntry::StealMessagesFrom (RoomParticipantEntry *other)
 	{
-		if (other->AllMessages_.isEmpty ())
+		if (other->AllMessages_.IsEmpty ())
 			return;
 
-		for (auto msg : other->AllMessages_)
+		auto otherMessages = other->AllMessages_.TakeAll ();
+		for (auto msg : otherMessages)
 			msg->SetVariant (Nick_);
 
-		MergeMessages (AllMessages_, other->AllMessages_);
-		other->AllMessages_.clear ();
+		const auto& otherUnread = other->HasUnreadMsgs () ?
+				other->UnreadMessages_ :
+				QList<GlooxMessage*> {};
+		MergeMessages (UnreadMessages_, otherUnread);
 
-		if (other->HasUnreadMsgs ())
-		{
-			for (auto msg : other->UnreadMessages_)
-				emit gotMessage (msg);
+		auto allMessages = AllMessages_.TakeAll ();
+		MergeMessages (allMessages, otherMessages);
 
-			MergeMessages (UnreadMessages_, other->UnreadMessages_);
-		}
+		// Re-appending respects the buffer capacity and drops the evicted
+		// messages from the unread ones.
+		for (const auto msg : allMessages)
+			AppendMessage (msg);
+
+		const auto& stillUnread = UnreadMessages_.toSet ();
+		for (const auto msg : otherUnread)
+			if (stillUnread.contains (msg))
+				emit gotMessage (msg);
 	}
 
 	QXmppMucItem::Affiliation RoomParticipantEntry::GetAffiliation () const
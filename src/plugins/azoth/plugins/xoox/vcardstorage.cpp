@@ -62,8 +62,14 @@ namespace Xoox
 	{
 		PendingVCards_ [jid] = vcard;
 
-		Util::Sequence (this, Writer_->SetVCard (jid, vcard)) >>
-				[this, jid] { PendingVCards_.remove (jid); };
+		// A canceled write has been superseded by a newer one for the same JID.
+		const auto future = Writer_->SetVCard (jid, vcard);
+		Util::Sequence (this, future) >>
+				[this, jid, future]
+				{
+					if (!future.isCanceled ())
+						PendingVCards_.remove (jid);
+				};
 	}
 
 	void VCardStorage::SetVCard (const QString& jid, const QXmppVCardIq& vcard)
@@ -105,8 +111,14 @@ namespace Xoox
 	{
 		PendingHashes_ [jid] = hash;
 
-		Util::Sequence (this, Writer_->SetVCardPhotoHash (jid, hash)) >>
-				[this, jid] { PendingHashes_.remove (jid); };
+		// A canceled write has been superseded by a newer one for the same JID.
+		const auto future = Writer_->SetVCardPhotoHash (jid, hash);
+		Util::Sequence (this, future) >>
+				[this, jid, future]
+				{
+					if (!future.isCanceled ())
+						PendingHashes_.remove (jid);
+				};
 	}
 
 	boost::optional<QByteArray> VCardStorage::GetVCardPhotoHash (const QString& jid) const
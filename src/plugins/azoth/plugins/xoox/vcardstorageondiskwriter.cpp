@@ -38,13 +38,15 @@ namespace Xoox
 {
 	QFuture<void> VCardStorageOnDiskWriter::SetVCard (const QString& jid, const QString& vcard)
 	{
-		return ScheduleImpl ([=] { Storage_->SetVCard (jid, vcard); });
+		return ScheduleImplWith ({ Priority::Background, "vcard/" + jid.toUtf8 () },
+				[=] { Storage_->SetVCard (jid, vcard); });
 	}
 
 	QFuture<void> VCardStorageOnDiskWriter::SetVCardPhotoHash (const QString& jid,
 			const QByteArray& hash)
 	{
-		return ScheduleImpl ([=] { Storage_->SetVCardPhotoHash (jid, hash); });
+		return ScheduleImplWith ({ Priority::Background, "photohash/" + jid.toUtf8 () },
+				[=] { Storage_->SetVCardPhotoHash (jid, hash); });
 	}
 
 	void VCardStorageOnDiskWriter::Initialize ()
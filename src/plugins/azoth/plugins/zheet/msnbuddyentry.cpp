@@ -32,7 +32,6 @@
 #include <QImage>
 #include <msn/notificationserver.h>
 #include <interfaces/azoth/iproxyobject.h>
-#include <interfaces/azoth/azothutil.h>
 #include "msnaccount.h"
 #include "msnmessage.h"
 #include "zheetutil.h"
@@ -72,8 +71,14 @@ namespace Zheet
 		}
 	}
 
+	// Out of line, since the messages buffer needs the complete MSNMessage.
+	MSNBuddyEntry::~MSNBuddyEntry ()
+	{
+	}
+
 	void MSNBuddyEntry::HandleMessage (MSNMessage *msg)
 	{
+		AllMessages_.SetCapacity (Core::Instance ().GetPluginProxy ()->GetMessagesBufferSize ());
 		AllMessages_ << msg;
 		emit gotMessage (msg);
 	}
@@ -183,14 +188,12 @@ namespace Zheet
 
 	QList<IMessage*> MSNBuddyEntry::GetAllMessages () const
 	{
-		QList<IMessage*> result;
-		std::copy (AllMessages_.begin (), AllMessages_.end (), std::back_inserter (result));
-		return result;
+		return AllMessages_.ToList<IMessage> ();
 	}
 
 	void MSNBuddyEntry::PurgeMessages (const QDateTime& before)
 	{
-		AzothUtil::StandardPurgeMessages (AllMessages_, before);
+		AllMessages_.Purge (before);
 	}
 
 	void MSNBuddyEntry::SetChatPartState (ChatPartState, const QString&)
@@ -233,6 +236,21 @@ namespace Zheet
 	{
 		Account_->GetSBManager ()->SendNudge (text, this);
 	}
+
+	int MSNBuddyEntry::GetMessagesCount () const
+	{
+		return AllMessages_.Size ();
+	}
+
+	IMessage* MSNBuddyEntry::GetMessageAt (int pos) const
+	{
+		return AllMessages_.At (pos);
+	}
+
+	qint64 MSNBuddyEntry::GetMessagesMemoryUsage () const
+	{
+		return AllMessages_.GetMemoryUsage ();
+	}
 }
 }
 }
@@ -35,6 +35,8 @@
 #include <msn/buddy.h>
 #include <interfaces/azoth/iclentry.h>
 #include <interfaces/azoth/iadvancedclentry.h>
+#include <interfaces/azoth/ihavemessagesbuffer.h>
+#include <interfaces/azoth/messagesbuffer.h>
 #include "msnaccount.h"
 
 namespace MSN
@@ -54,9 +56,12 @@ namespace Zheet
 	class MSNBuddyEntry : public QObject
 						, public ICLEntry
 						, public IAdvancedCLEntry
+						, public IHaveMessagesBuffer
 	{
 		Q_OBJECT
-		Q_INTERFACES (LeechCraft::Azoth::ICLEntry LeechCraft::Azoth::IAdvancedCLEntry)
+		Q_INTERFACES (LeechCraft::Azoth::ICLEntry
+				LeechCraft::Azoth::IAdvancedCLEntry
+				LeechCraft::Azoth::IHaveMessagesBuffer)
 
 		MSNAccount *Account_;
 
@@ -64,11 +69,12 @@ namespace Zheet
 		QStringList Groups_;
 		QString ContactID_;
 
-		QList<MSNMessage*> AllMessages_;
+		MessagesBuffer<MSNMessage> AllMessages_;
 
 		EntryStatus Status_;
 	public:
 		MSNBuddyEntry (const MSN::Buddy&, MSNAccount*);
+		~MSNBuddyEntry ();
 
 		void HandleMessage (MSNMessage*);
 		void HandleNudge ();
@@ -105,6 +111,11 @@ namespace Zheet
 		// IAdvancedCLEntry
 		AdvancedFeatures GetAdvancedFeatures () const;
 		void DrawAttention (const QString&, const QString&);
+
+		// IHaveMessagesBuffer
+		int GetMessagesCount () const;
+		IMessage* GetMessageAt (int) const;
+		qint64 GetMessagesMemoryUsage () const;
 	signals:
 		void gotMessage (QObject*);
 		void statusChanged (const EntryStatus&, const QString&);
@@ -399,5 +399,10 @@ namespace Azoth
 	{
 		return AvatarsManager_;
 	}
+
+	int ProxyObject::GetMessagesBufferSize () const
+	{
+		return XmlSettingsManager::Instance ().MessagesBufferSize_.Get ();
+	}
 }
 }
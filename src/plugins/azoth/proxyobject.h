@@ -106,6 +106,8 @@ namespace Azoth
 
 		IFormatterProxyObject& GetFormatterProxy () override;
 		IAvatarsManager* GetAvatarsManager() override;
+
+		int GetMessagesBufferSize () const override;
 	};
 }
 }
@@ -14,3 +14,36 @@ function InstallEventListeners() {
 	window.addEventListener ("resize", function () { setTimeout (ScrollToBottom, 0); });
 	window.addEventListener ("scroll", TestScroll);
 }
+function GetMessagesContainer() {
+	// Adium-like styles keep the messages in #Chat, while the standard
+	// ones append them right to the body.
+	return document.getElementById ("Chat") || document.body;
+}
+function GetMessageNodes() {
+	var container = GetMessagesContainer();
+	var result = [];
+	if (!container)
+		return result;
+	for (var i = 0; i < container.children.length; ++i) {
+		var child = container.children [i];
+		if (child.tagName == "DIV" && child.id != "insert")
+			result.push (child);
+	}
+	return result;
+}
+function TrimMessages(maxCount) {
+	if (!GetMessagesContainer())
+		return false;
+	var nodes = GetMessageNodes();
+	for (var i = 0; i < nodes.length - maxCount; ++i)
+		nodes [i].parentNode.removeChild (nodes [i]);
+	return true;
+}
+function ScrollToMessage(idx) {
+	var nodes = GetMessageNodes();
+	window.ShouldScroll = false;
+	if (idx < nodes.length)
+		nodes [idx].scrollIntoView (true);
+	else
+		window.scrollTo (0, 0);
+}
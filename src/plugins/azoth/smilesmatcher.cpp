@@ -0,0 +1,172 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+
+#include "smilesmatcher.h"
+#include <algorithm>
+#include <QQueue>
+#include <QTextDocument>
+
+namespace LeechCraft
+{
+namespace Azoth
+{
+	SmilesMatcher::SmilesMatcher (const QSet<QString>& smiles)
+	: Nodes_ (1)
+	{
+		for (const auto& smile : smiles)
+		{
+#if QT_VERSION < 0x050000
+			const auto& escaped = Qt::escape (smile);
+#else
+			const auto& escaped = smile.toHtmlEscaped ();
+#endif
+			if (escaped.isEmpty ())
+				continue;
+
+			AddPattern (escaped, Smiles_.size ());
+			Smiles_ << smile;
+		}
+
+		BuildLinks ();
+	}
+
+	QList<SmilesMatcher::Match> SmilesMatcher::FindAll (const QString& body, bool requireSpace) const
+	{
+		// The longest pattern starting at the given position, if any.
+		std::vector<int> start2node;
+
+		int state = 0;
+		for (int i = 0; i < body.size (); ++i)
+		{
+			state = Step (state, body.at (i).unicode ());
+
+			for (auto out = Nodes_ [state].Output_; out >= 0; out = Nodes_ [Nodes_ [out].Fail_].Output_)
+			{
+				if (start2node.empty ())
+					start2node.resize (body.size (), -1);
+
+				const auto start = i - Nodes_ [out].Depth_ + 1;
+				auto& best = start2node [start];
+				if (best < 0 || Nodes_ [best].Depth_ < Nodes_ [out].Depth_)
+					best = out;
+			}
+		}
+
+		QList<Match> result;
+		if (start2node.empty ())
+			return result;
+
+		for (int start = 0; start < body.size (); ++start)
+		{
+			const auto node = start2node [start];
+			if (node < 0)
+				continue;
+
+			if (requireSpace && start && !body.at (start - 1).isSpace ())
+				continue;
+
+			const auto len = Nodes_ [node].Depth_;
+			result.append ({ start, len, Smiles_.at (Nodes_ [node].Pattern_) });
+			start += len - 1;
+		}
+		return result;
+	}
+
+	void SmilesMatcher::AddPattern (const QString& pattern, int idx)
+	{
+		int state = 0;
+		for (const auto& ch : pattern)
+		{
+			const auto code = ch.unicode ();
+			const auto pos = Nodes_ [state].Next_.find (code);
+			if (pos != Nodes_ [state].Next_.end ())
+			{
+				state = *pos;
+				continue;
+			}
+
+			Node node;
+			node.Depth_ = Nodes_ [state].Depth_ + 1;
+			Nodes_.push_back (node);
+
+			const int newState = Nodes_.size () - 1;
+			Nodes_ [state].Next_ [code] = newState;
+			state = newState;
+		}
+
+		Nodes_ [state].Pattern_ = idx;
+	}
+
+	void SmilesMatcher::BuildLinks ()
+	{
+		QQueue<int> queue;
+		for (const auto child : Nodes_ [0].Next_)
+			queue.enqueue (child);
+
+		while (!queue.isEmpty ())
+		{
+			const auto state = queue.dequeue ();
+			auto& node = Nodes_ [state];
+			node.Output_ = node.Pattern_ >= 0 ?
+					state :
+					Nodes_ [node.Fail_].Output_;
+
+			for (auto i = node.Next_.begin (); i != node.Next_.end (); ++i)
+			{
+				const auto child = *i;
+
+				auto fail = node.Fail_;
+				while (fail && !Nodes_ [fail].Next_.contains (i.key ()))
+					fail = Nodes_ [fail].Fail_;
+
+				Nodes_ [child].Fail_ = Nodes_ [fail].Next_.value (i.key (), 0);
+
+				queue.enqueue (child);
+			}
+		}
+	}
+
+	int SmilesMatcher::Step (int state, ushort code) const
+	{
+		while (true)
+		{
+			const auto& next = Nodes_ [state].Next_;
+			const auto pos = next.find (code);
+			if (pos != next.end ())
+				return *pos;
+
+			if (!state)
+				return 0;
+
+			state = Nodes_ [state].Fail_;
+		}
+	}
+}
+}
@@ -0,0 +1,94 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+
+#pragma once
+
+#include <vector>
+#include <QHash>
+#include <QStringList>
+#include <QSet>
+
+namespace LeechCraft
+{
+namespace Azoth
+{
+	/** @brief Finds all the emoticons of a smile pack in a single pass.
+	 *
+	 * The matcher is an Aho-Corasick automaton built over the
+	 * HTML-escaped emoticon strings, since it runs over already
+	 * formatted message bodies.
+	 *
+	 * Overlapping occurrences are resolved by preferring the leftmost
+	 * one, and the longest of the ones starting at the same position.
+	 */
+	class SmilesMatcher
+	{
+		struct Node
+		{
+			QHash<ushort, int> Next_;
+			int Fail_ = 0;
+
+			/* Index of the nearest node reachable via the fail links
+			 * (including this one) that terminates a pattern, or -1.
+			 */
+			int Output_ = -1;
+
+			int Depth_ = 0;
+			int Pattern_ = -1;
+		};
+		std::vector<Node> Nodes_;
+
+		QStringList Smiles_;
+	public:
+		struct Match
+		{
+			int Pos_;
+			int Length_;
+			QString Smile_;
+		};
+
+		SmilesMatcher (const QSet<QString>& smiles);
+
+		/** @brief Finds the emoticons in the given HTML \em body.
+		 *
+		 * @param[in] body The formatted message body.
+		 * @param[in] requireSpace Whether only the emoticons at the
+		 * beginning of the \em body or after a space character should
+		 * be considered.
+		 * @return The non-overlapping matches ordered by position.
+		 */
+		QList<Match> FindAll (const QString& body, bool requireSpace) const;
+	private:
+		void AddPattern (const QString&, int);
+		void BuildLinks ();
+		int Step (int, ushort) const;
+	};
+}
+}
@@ -30,6 +30,7 @@
 #ifndef PLUGINS_AZOTH_XMLSETTINGSMANAGER_H
 #define PLUGINS_AZOTH_XMLSETTINGSMANAGER_H
 #include <xmlsettingsdialog/basesettingsmanager.h>
+#include <xmlsettingsdialog/settinghandle.h>
 
 namespace LeechCraft
 {
@@ -40,6 +41,9 @@ namespace Azoth
 		Q_OBJECT
 		XmlSettingsManager ();
 	public:
+		Util::SettingHandle<QString> SmileIcons_ { this, "SmileIcons", "None" };
+		Util::SettingHandle<int> MessagesBufferSize_ { this, "MessagesBufferSize", 1000 };
+
 		static XmlSettingsManager& Instance ();
 	protected:
 		virtual QSettings* BeginSettings () const;
@@ -117,6 +117,20 @@ namespace GActs
 		RegisterChildren (sh.get (), e);
 	}
 
+	QStringList Plugin::GetHandledMimes () const
+	{
+		return
+		{
+			"x-leechcraft/global-action-register",
+			"x-leechcraft/global-action-unregister"
+		};
+	}
+
+	QStringList Plugin::GetHandledUrlSchemes () const
+	{
+		return {};
+	}
+
 	void Plugin::RegisterChildren (QxtGlobalShortcut *sh, const Entity& e)
 	{
 		for (const auto& seqVar : e.Additional_ ["AltShortcuts"].toList ())
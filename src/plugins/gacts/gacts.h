@@ -33,6 +33,7 @@
 #include <QObject>
 #include <interfaces/iinfo.h>
 #include <interfaces/ientityhandler.h>
+#include <interfaces/ientitydispatchhints.h>
 
 class QxtGlobalShortcut;
 
@@ -43,11 +44,12 @@ namespace GActs
 	class Plugin : public QObject
 				 , public IInfo
 				 , public IEntityHandler
+				 , public IEntityDispatchHints
 	{
 		Q_OBJECT
-		Q_INTERFACES (IInfo IEntityHandler)
+		Q_INTERFACES (IInfo IEntityHandler IEntityDispatchHints)
 
-		LC_PLUGIN_METADATA ("org.LeechCraft.GActs")
+		LC_PLUGIN_METADATA_FILE ("org.LeechCraft.GActs", "manifest.json")
 
 		QHash<QByteArray, std::shared_ptr<QxtGlobalShortcut>> RegisteredShortcuts_;
 	public:
@@ -61,6 +63,9 @@ namespace GActs
 
 		EntityTestHandleResult CouldHandle (const Entity&) const;
 		void Handle (Entity);
+
+		QStringList GetHandledMimes () const;
+		QStringList GetHandledUrlSchemes () const;
 	private:
 		void RegisterChildren (QxtGlobalShortcut*, const Entity&);
 	private slots:
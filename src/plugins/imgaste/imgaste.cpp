@@ -46,7 +46,6 @@ namespace Imgaste
 {
 	void Plugin::Init (ICoreProxy_ptr proxy)
 	{
-		Util::InstallTranslator ("imgaste");
 		Proxy_ = proxy;
 
 		ReprModel_ = new QStandardItemModel { this };
@@ -54,6 +53,8 @@ namespace Imgaste
 
 	void Plugin::SecondInit ()
 	{
+		// Init() may run outside of the main thread, see the manifest.
+		Util::InstallTranslator ("imgaste");
 	}
 
 	QByteArray Plugin::GetUniqueID () const
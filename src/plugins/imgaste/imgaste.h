@@ -51,7 +51,7 @@ namespace Imgaste
 		Q_OBJECT
 		Q_INTERFACES (IInfo IEntityHandler IDataFilter IJobHolder)
 
-		LC_PLUGIN_METADATA ("org.LeechCraft.Imgaste")
+		LC_PLUGIN_METADATA_FILE ("org.LeechCraft.Imgaste", "manifest.json")
 
 		ICoreProxy_ptr Proxy_;
 
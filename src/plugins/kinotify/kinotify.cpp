@@ -233,6 +233,16 @@ namespace Kinotify
 		}
 	}
 
+	QStringList Plugin::GetHandledMimes () const
+	{
+		return { "x-leechcraft/notification" };
+	}
+
+	QStringList Plugin::GetHandledUrlSchemes () const
+	{
+		return {};
+	}
+
 	Util::XmlSettingsDialog_ptr Plugin::GetSettingsDialog () const
 	{
 		return SettingsDialog_;
@@ -580,67 +580,16 @@ namespace LackMan
 		}
 	}
 
-	void Core::HandleNewPackages (const PackageShortInfoList& shortInfos,
-			int componentId, const QString& component, const QUrl& repoUrl)
+	void Core::HandleNewPackages (const QMap<QString, QStringList>& newVersions,
+			const QString& component, const QUrl& repoUrl, int componentId)
 	{
-		QMap<QString, QList<QString>> PackageName2NewVersions_;
-
 		int newPackages = 0;
-		for (const auto& info : shortInfos)
-			for (const QString& version : info.Versions_)
-			{
-				int packageId = -1;
-				try
-				{
-					packageId = Storage_->FindPackage (info.Name_, version);
-				}
-				catch (const std::exception& e)
-				{
-					qWarning () << Q_FUNC_INFO
-							<< "unable to get package ID for"
-							<< info.Name_
-							<< version
-							<< e.what ();
-					emit gotEntity (Util::MakeNotification (tr ("Error parsing component"),
-							tr ("Unable to load package ID for package `%1`-%2")
-								.arg (info.Name_)
-								.arg (version),
-							PCritical_));
-					return;
-				}
+		for (const auto& versions : newVersions)
+			newPackages += versions.size ();
 
-				if (packageId == -1)
-				{
-					PackageName2NewVersions_ [info.Name_] << version;
-					++newPackages;
-				}
-
-				try
-				{
-					if (packageId != -1 &&
-							!Storage_->HasLocation (packageId, componentId))
-						Storage_->AddLocation (packageId, componentId);
-				}
-				catch (const std::exception& e)
-				{
-					qWarning () << Q_FUNC_INFO
-							<< "unable to add package location"
-							<< info.Name_
-							<< version
-							<< e.what ();
-					emit gotEntity (Util::MakeNotification (tr ("Error parsing component"),
-							tr ("Unable to save package location for "
-								"package `%1`-%2 and component %3")
-								.arg (info.Name_)
-								.arg (version)
-								.arg (component),
-							PCritical_));
-					return;
-				}
-			}
-
-		for (const QString& packageName : PackageName2NewVersions_.keys ())
+		for (auto i = newVersions.begin (), end = newVersions.end (); i != end; ++i)
 		{
+			const auto& packageName = i.key ();
 			auto packageUrl = repoUrl;
 			const auto& normalized = LackManUtil::NormalizePackageName (packageName);
 			packageUrl.setPath (packageUrl.path () +
@@ -649,7 +598,7 @@ namespace LackMan
 					'/');
 			RepoInfoFetcher_->ScheduleFetchPackageInfo (packageUrl,
 					packageName,
-					PackageName2NewVersions_ [packageName],
+					i.value (),
 					componentId);
 		}
 
@@ -1000,82 +949,25 @@ namespace LackMan
 			return;
 		}
 
-		QList<int> presentPackages;
-		QSet<int> installedPackages;
+		QMap<QString, QStringList> newVersions;
 		try
 		{
-			presentPackages = Storage_->GetPackagesInComponent (componentId);
-			installedPackages = Storage_->GetInstalledPackagesIDs ();
+			newVersions = Storage_->SyncComponent (componentId, shortInfos);
 		}
 		catch (const std::exception& e)
 		{
 			qWarning () << Q_FUNC_INFO
-					<< "unable to get installed or present packages in component:"
+					<< "unable to sync packages for:"
+					<< component
 					<< e.what ();
 			emit gotEntity (Util::MakeNotification (tr ("Error handling component"),
-					tr ("Unable to load packages already present in the component %1.")
+					tr ("Unable to update packages in the component %1.")
 						.arg (component),
 					PCritical_));
 			return;
 		}
 
-		for (int presentPId : presentPackages)
-		{
-			PackageShortInfo psi;
-			try
-			{
-				psi = Storage_->GetPackage (presentPId);
-			}
-			catch (const std::exception& e)
-			{
-				qWarning () << Q_FUNC_INFO
-						<< "unable to get present package:"
-						<< e.what ();
-				emit gotEntity (Util::MakeNotification (tr ("Error handling component"),
-						tr ("Unable to load package already present in the component %1.")
-							.arg (component),
-						PCritical_));
-				return;
-			}
-
-			const QString& ourVersion = psi.Versions_.at (0);
-			bool found = false;
-			for (const auto& candidate : shortInfos)
-			{
-				if (candidate.Name_ == psi.Name_ &&
-						candidate.Versions_.contains (ourVersion))
-				{
-					found = true;
-					break;
-				}
-			}
-
-			if (!found)
-			{
-				try
-				{
-					Storage_->RemoveLocation (presentPId, componentId);
-
-					if (!installedPackages.contains (presentPId))
-						Storage_->RemovePackage (presentPId);
-				}
-				catch (const std::exception& e)
-				{
-					qWarning () << Q_FUNC_INFO
-							<< "unable to remove package for:"
-							<< component
-							<< presentPId
-							<< e.what ();
-					emit gotEntity (Util::MakeNotification (tr ("Error handling component"),
-							tr ("Unable to remove package which has been removed upstream from %1.")
-								.arg (component),
-							PCritical_));
-					return;
-				}
-			}
-		}
-
-		HandleNewPackages (shortInfos, componentId, component, repoUrl);
+		HandleNewPackages (newVersions, component, repoUrl, componentId);
 	}
 
 	void Core::handlePackageFetched (const PackageInfo& pInfo,
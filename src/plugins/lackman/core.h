@@ -104,8 +104,8 @@ namespace LackMan
 		InstalledDependencyInfoList GetLackManInstalledPackages () const;
 		InstalledDependencyInfoList GetAllInstalledPackages () const;
 		void PopulatePluginsModel ();
-		void HandleNewPackages (const PackageShortInfoList& shorts,
-				int componentId, const QString& component, const QUrl& repoUrl);
+		void HandleNewPackages (const QMap<QString, QStringList>& newVersions,
+				const QString& component, const QUrl& repoUrl, int componentId);
 		void PerformRemoval (int);
 		void UpdateRowFor (int);
 		bool RecordInstalled (int);
@@ -0,0 +1,169 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+
+#include "gzipdevice.h"
+#include <algorithm>
+#include <limits>
+#include <QtDebug>
+#include <zlib.h>
+
+namespace LeechCraft
+{
+namespace LackMan
+{
+	namespace
+	{
+		const qint64 ChunkSize = 64 * 1024;
+	}
+
+	GzipDevice::GzipDevice (QIODevice *source, QObject *parent)
+	: QIODevice { parent }
+	, Source_ { source }
+	{
+	}
+
+	GzipDevice::~GzipDevice ()
+	{
+		close ();
+	}
+
+	bool GzipDevice::open (OpenMode mode)
+	{
+		if (mode != ReadOnly)
+		{
+			setErrorString (tr ("Only read-only mode is supported."));
+			return false;
+		}
+
+		if (!Source_->isOpen () && !Source_->open (ReadOnly))
+		{
+			setErrorString (Source_->errorString ());
+			return false;
+		}
+
+		Stream_.reset (new z_stream_s {});
+		// 32 asks zlib to detect the gzip or zlib header automatically.
+		if (inflateInit2 (Stream_.get (), 32 + MAX_WBITS) != Z_OK)
+		{
+			setErrorString (tr ("Unable to initialize decompressor: %1.")
+					.arg (Stream_->msg ? Stream_->msg : "unknown error"));
+			Stream_.reset ();
+			return false;
+		}
+
+		Finished_ = false;
+		Failed_ = false;
+		return QIODevice::open (mode);
+	}
+
+	void GzipDevice::close ()
+	{
+		if (Stream_)
+		{
+			inflateEnd (Stream_.get ());
+			Stream_.reset ();
+		}
+		InBuf_.clear ();
+
+		QIODevice::close ();
+	}
+
+	bool GzipDevice::isSequential () const
+	{
+		return true;
+	}
+
+	bool GzipDevice::atEnd () const
+	{
+		return Finished_ && QIODevice::bytesAvailable () <= 0;
+	}
+
+	bool GzipDevice::HasError () const
+	{
+		return Failed_;
+	}
+
+	qint64 GzipDevice::readData (char *data, qint64 maxlen)
+	{
+		if (Finished_ || !Stream_)
+			return 0;
+
+		const auto outSize = static_cast<uInt> (std::min<qint64> (maxlen, std::numeric_limits<uInt>::max ()));
+		Stream_->next_out = reinterpret_cast<Bytef*> (data);
+		Stream_->avail_out = outSize;
+
+		while (Stream_->avail_out)
+		{
+			if (!Stream_->avail_in)
+			{
+				InBuf_ = Source_->read (ChunkSize);
+				if (InBuf_.isEmpty ())
+				{
+					qWarning () << Q_FUNC_INFO
+							<< "premature end of compressed data";
+					setErrorString (tr ("Unexpected end of compressed data."));
+					Finished_ = true;
+					Failed_ = true;
+					return -1;
+				}
+
+				Stream_->next_in = reinterpret_cast<Bytef*> (InBuf_.data ());
+				Stream_->avail_in = InBuf_.size ();
+			}
+
+			const auto res = inflate (Stream_.get (), Z_NO_FLUSH);
+			if (res == Z_STREAM_END)
+			{
+				Finished_ = true;
+				break;
+			}
+
+			if (res != Z_OK && !(res == Z_BUF_ERROR && !Stream_->avail_in))
+			{
+				qWarning () << Q_FUNC_INFO
+						<< "inflate failed:"
+						<< res
+						<< (Stream_->msg ? Stream_->msg : "");
+				setErrorString (tr ("Corrupted compressed data."));
+				Finished_ = true;
+				Failed_ = true;
+				return -1;
+			}
+		}
+
+		return outSize - Stream_->avail_out;
+	}
+
+	qint64 GzipDevice::writeData (const char*, qint64)
+	{
+		return -1;
+	}
+}
+}
@@ -0,0 +1,82 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+
+#pragma once
+
+#include <memory>
+#include <QIODevice>
+
+struct z_stream_s;
+
+namespace LeechCraft
+{
+namespace LackMan
+{
+	/** @brief Read-only sequential device inflating gzip data on the fly.
+	 *
+	 * The device pulls compressed data from the source device in small
+	 * chunks as it is read, so consumers like QXmlStreamReader can parse
+	 * the unpacked data without ever holding it in memory as a whole.
+	 *
+	 * Both gzip and zlib streams are accepted.
+	 */
+	class GzipDevice : public QIODevice
+	{
+		Q_OBJECT
+
+		QIODevice * const Source_;
+
+		std::unique_ptr<z_stream_s> Stream_;
+		QByteArray InBuf_;
+		bool Finished_ = false;
+		bool Failed_ = false;
+	public:
+		GzipDevice (QIODevice *source, QObject *parent = nullptr);
+		~GzipDevice ();
+
+		bool open (OpenMode) override;
+		void close () override;
+
+		bool isSequential () const override;
+		bool atEnd () const override;
+
+		/** @brief Whether the compressed data was found to be broken.
+		 *
+		 * Readers (like QXmlStreamReader) usually see a broken stream
+		 * just as a premature end of data, so this allows telling
+		 * unpacking errors from parsing ones.
+		 */
+		bool HasError () const;
+	protected:
+		qint64 readData (char*, qint64) override;
+		qint64 writeData (const char*, qint64) override;
+	};
+}
+}
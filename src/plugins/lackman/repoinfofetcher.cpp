@@ -28,6 +28,7 @@
  **********************************************************************/
 
 #include "repoinfofetcher.h"
+#include <QFile>
 #include <QTimer>
 #include <util/sys/paths.h>
 #include <util/xpc/util.h>
@@ -36,6 +37,7 @@
 #include "core.h"
 #include "xmlparsers.h"
 #include "lackmanutil.h"
+#include "gzipdevice.h"
 
 namespace LeechCraft
 {
@@ -49,6 +51,11 @@ namespace LackMan
 
 	namespace
 	{
+		/** Maximum number of package descriptions being downloaded
+		 * simultaneously.
+		 */
+		const int MaxParallelPackageFetches = 4;
+
 		template<typename PendingF>
 		void FetchImpl (QHash<int, Util::ResultOf_t<PendingF (QString)>>& map,
 				PendingF&& factory,
@@ -150,12 +157,15 @@ namespace LackMan
 			componentId
 		};
 
-		if (ScheduledPackages_.isEmpty ())
+		ScheduledPackages_ << f;
+
+		if (!PackageRotationScheduled_)
+		{
+			PackageRotationScheduled_ = true;
 			QTimer::singleShot (0,
 					this,
 					SLOT (rotatePackageFetchQueue ()));
-
-		ScheduledPackages_ << f;
+		}
 	}
 
 	void RepoInfoFetcher::FetchPackageInfo (const QUrl& baseUrl,
@@ -177,16 +187,25 @@ namespace LackMan
 				SLOT (handlePackageError (int, IDownload::Error)));
 	}
 
-	void RepoInfoFetcher::rotatePackageFetchQueue ()
+	void RepoInfoFetcher::HandleUnpackError (const QString& file)
 	{
-		if (ScheduledPackages_.isEmpty ())
-			return;
+		Proxy_->GetEntityManager ()->HandleEntity (Util::MakeNotification (tr ("Unpack error"),
+				tr ("Unable to unpack the downloaded file. "
+					"Problematic file is at %1.")
+					.arg (file),
+				PCritical_));
+	}
 
-		const auto& f = ScheduledPackages_.takeFirst ();
-		FetchPackageInfo (f.BaseUrl_, f.PackageName_, f.NewVersions_, f.ComponentId_);
+	void RepoInfoFetcher::rotatePackageFetchQueue ()
+	{
+		PackageRotationScheduled_ = false;
 
-		if (!ScheduledPackages_.isEmpty ())
-			QTimer::singleShot (50, this, SLOT (rotatePackageFetchQueue ()));
+		while (!ScheduledPackages_.isEmpty () &&
+				PendingPackages_.size () < MaxParallelPackageFetches)
+		{
+			const auto f = ScheduledPackages_.takeFirst ();
+			FetchPackageInfo (f.BaseUrl_, f.PackageName_, f.NewVersions_, f.ComponentId_);
+		}
 	}
 
 	void RepoInfoFetcher::handleRIFinished (int id)
@@ -194,25 +213,48 @@ namespace LackMan
 		if (!PendingRIs_.contains (id))
 			return;
 
-		PendingRI pri = PendingRIs_.take (id);
+		const auto& pri = PendingRIs_.take (id);
 
-		QString name = pri.Location_;
-		QProcess *unarch = new QProcess (this);
-		unarch->setProperty ("URL", pri.URL_);
-		unarch->setProperty ("Filename", name);
-		connect (unarch,
-				SIGNAL (finished (int, QProcess::ExitStatus)),
-				this,
-				SLOT (handleRepoUnarchFinished (int, QProcess::ExitStatus)));
-		connect (unarch,
-				SIGNAL (error (QProcess::ProcessError)),
-				this,
-				SLOT (handleUnarchError (QProcess::ProcessError)));
-#ifdef Q_OS_WIN32
-		unarch->start ("7za", { "e", "-so", name });
-#else
-		unarch->start ("gunzip", { "-c", name });
-#endif
+		QFile file { pri.Location_ };
+		GzipDevice unpacked { &file };
+		if (!unpacked.open (QIODevice::ReadOnly))
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unable to open"
+					<< pri.Location_
+					<< unpacked.errorString ();
+			HandleUnpackError (pri.Location_);
+			return;
+		}
+
+		const auto& data = unpacked.readAll ();
+		if (unpacked.HasError ())
+		{
+			HandleUnpackError (pri.Location_);
+			return;
+		}
+
+		unpacked.close ();
+		file.close ();
+		QFile::remove (pri.Location_);
+
+		RepoInfo info;
+		try
+		{
+			info = ParseRepoInfo (pri.URL_, QString::fromUtf8 (data));
+		}
+		catch (const QString& error)
+		{
+			qWarning () << Q_FUNC_INFO
+					<< error;
+			Proxy_->GetEntityManager ()->HandleEntity (Util::MakeNotification (tr ("Repository parse error"),
+					tr ("Unable to parse repository description: %1.")
+						.arg (error),
+					PCritical_));
+			return;
+		}
+
+		emit infoFetched (info);
 	}
 
 	void RepoInfoFetcher::handleRIRemoved (int id)
@@ -243,26 +285,48 @@ namespace LackMan
 		if (!PendingComponents_.contains (id))
 			return;
 
-		PendingComponent pc = PendingComponents_.take (id);
+		const auto& pc = PendingComponents_.take (id);
 
-		QProcess *unarch = new QProcess (this);
-		unarch->setProperty ("Component", pc.Component_);
-		unarch->setProperty ("Filename", pc.Location_);
-		unarch->setProperty ("URL", pc.URL_);
-		unarch->setProperty ("RepoID", pc.RepoID_);
-		connect (unarch,
-				SIGNAL (finished (int, QProcess::ExitStatus)),
-				this,
-				SLOT (handleComponentUnarchFinished (int, QProcess::ExitStatus)));
-		connect (unarch,
-				SIGNAL (error (QProcess::ProcessError)),
-				this,
-				SLOT (handleUnarchError (QProcess::ProcessError)));
-#ifdef Q_OS_WIN32
-		unarch->start ("7za", { "e", "-so", pc.Location_ });
-#else
-		unarch->start ("gunzip", { "-c", pc.Location_ });
-#endif
+		QFile file { pc.Location_ };
+		GzipDevice unpacked { &file };
+		if (!unpacked.open (QIODevice::ReadOnly))
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unable to open"
+					<< pc.Location_
+					<< unpacked.errorString ();
+			HandleUnpackError (pc.Location_);
+			return;
+		}
+
+		PackageShortInfoList infos;
+		try
+		{
+			infos = ParseComponent (&unpacked);
+		}
+		catch (const std::exception& e)
+		{
+			if (unpacked.HasError ())
+			{
+				HandleUnpackError (pc.Location_);
+				return;
+			}
+
+			qWarning () << Q_FUNC_INFO
+					<< e.what ();
+			Proxy_->GetEntityManager ()->HandleEntity (Util::MakeNotification (tr ("Component parse error"),
+					tr ("Unable to parse component %1 description file. "
+						"More information is available in logs.")
+						.arg (pc.Component_),
+					PCritical_));
+			return;
+		}
+
+		unpacked.close ();
+		file.close ();
+		QFile::remove (pc.Location_);
+
+		emit componentFetched (infos, pc.Component_, pc.RepoID_);
 	}
 
 	void RepoInfoFetcher::handleComponentRemoved (int id)
@@ -293,187 +357,73 @@ namespace LackMan
 		if (!PendingPackages_.contains (id))
 			return;
 
-		PendingPackage pp = PendingPackages_ [id];
-
-		QProcess *unarch = new QProcess (this);
-		unarch->setProperty ("Filename", pp.Location_);
-		unarch->setProperty ("URL", pp.URL_);
-		unarch->setProperty ("TaskID", id);
-		connect (unarch,
-				SIGNAL (finished (int, QProcess::ExitStatus)),
-				this,
-				SLOT (handlePackageUnarchFinished (int, QProcess::ExitStatus)));
-		connect (unarch,
-				SIGNAL (error (QProcess::ProcessError)),
-				this,
-				SLOT (handleUnarchError (QProcess::ProcessError)));
-#ifdef Q_OS_WIN32
-		unarch->start ("7za", { "e", "-so", pp.Location_ });
-#else
-		unarch->start ("gunzip", { "-c", pp.Location_ });
-#endif
-	}
-
-	void RepoInfoFetcher::handlePackageRemoved (int id)
-	{
-		if (!PendingPackages_.contains (id))
-			return;
-
-		PendingPackages_.remove (id);
-	}
-
-	void RepoInfoFetcher::handlePackageError (int id, IDownload::Error)
-	{
-		if (!PendingPackages_.contains (id))
-			return;
-
-		PendingPackage pp = PendingPackages_.take (id);
-
-		QFile::remove (pp.Location_);
-
-		Proxy_->GetEntityManager ()->HandleEntity (Util::MakeNotification (tr ("Error fetching package"),
-				tr ("Error fetching package from %1.")
-					.arg (pp.URL_.toString ()),
-				PCritical_));
-	}
-
-	void RepoInfoFetcher::handleRepoUnarchFinished (int exitCode,
-			QProcess::ExitStatus)
-	{
-		sender ()->deleteLater ();
+		const auto& pp = PendingPackages_.take (id);
+		rotatePackageFetchQueue ();
 
-		if (exitCode)
-		{
-			Proxy_->GetEntityManager ()->HandleEntity (Util::MakeNotification (tr ("Repository unpack error"),
-					tr ("Unable to unpack the repository file. gunzip error: %1. "
-						"Problematic file is at %2.")
-						.arg (exitCode)
-						.arg (sender ()->property ("Filename").toString ()),
-					PCritical_));
-			return;
-		}
-
-		QByteArray data = qobject_cast<QProcess*> (sender ())->readAllStandardOutput ();
-		QFile::remove (sender ()->property ("Filename").toString ());
-
-		RepoInfo info;
-		try
-		{
-			info = ParseRepoInfo (sender ()->property ("URL").toUrl (), QString (data));
-		}
-		catch (const QString& error)
+		QFile file { pp.Location_ };
+		GzipDevice unpacked { &file };
+		if (!unpacked.open (QIODevice::ReadOnly))
 		{
 			qWarning () << Q_FUNC_INFO
-					<< error;
-			Proxy_->GetEntityManager ()->HandleEntity (Util::MakeNotification (tr ("Repository parse error"),
-					tr ("Unable to parse repository description: %1.")
-						.arg (error),
-					PCritical_));
+					<< "unable to open"
+					<< pp.Location_
+					<< unpacked.errorString ();
+			HandleUnpackError (pp.Location_);
 			return;
 		}
 
-		emit infoFetched (info);
-	}
-
-	void RepoInfoFetcher::handleComponentUnarchFinished (int exitCode,
-			QProcess::ExitStatus)
-	{
-		sender ()->deleteLater ();
-
-		if (exitCode)
-		{
-			Proxy_->GetEntityManager ()->HandleEntity (Util::MakeNotification (tr ("Component unpack error"),
-					tr ("Unable to unpack the component file. gunzip error: %1. "
-						"Problematic file is at %2.")
-						.arg (exitCode)
-						.arg (sender ()->property ("Filename").toString ()),
-					PCritical_));
-			return;
-		}
-
-		QByteArray data = qobject_cast<QProcess*> (sender ())->readAllStandardOutput ();
-		QFile::remove (sender ()->property ("Filename").toString ());
-
-		PackageShortInfoList infos;
+		PackageInfo packageInfo;
 		try
 		{
-			infos = ParseComponent (data);
+			packageInfo = ParsePackage (&unpacked, pp.BaseURL_, pp.PackageName_, pp.NewVersions_);
 		}
 		catch (const std::exception& e)
 		{
+			if (unpacked.HasError ())
+			{
+				HandleUnpackError (pp.Location_);
+				return;
+			}
+
 			qWarning () << Q_FUNC_INFO
 					<< e.what ();
-			Proxy_->GetEntityManager ()->HandleEntity (Util::MakeNotification (tr ("Component parse error"),
-					tr ("Unable to parse component %1 description file. "
-						"More information is available in logs.")
-						.arg (sender ()->property ("Component").toString ()),
+			Proxy_->GetEntityManager ()->HandleEntity (Util::MakeNotification (tr ("Package parse error"),
+					tr ("Unable to parse package description file. "
+						"More information is available in logs."),
 					PCritical_));
 			return;
 		}
 
-		emit componentFetched (infos,
-				sender ()->property ("Component").toString (),
-				sender ()->property ("RepoID").toInt ());
+		unpacked.close ();
+		file.close ();
+		QFile::remove (pp.Location_);
+
+		emit packageFetched (packageInfo, pp.ComponentId_);
 	}
 
-	void RepoInfoFetcher::handlePackageUnarchFinished (int exitCode,
-			QProcess::ExitStatus)
+	void RepoInfoFetcher::handlePackageRemoved (int id)
 	{
-		sender ()->deleteLater ();
-
-		int id = sender ()->property ("TaskID").toInt ();
-		PendingPackage pp = PendingPackages_.take (id);
-
-		if (exitCode)
-		{
-			Proxy_->GetEntityManager ()->HandleEntity (Util::MakeNotification (tr ("Component unpack error"),
-					tr ("Unable to unpack the component file. gunzip error: %1. "
-						"Problematic file is at %2.")
-						.arg (exitCode)
-						.arg (sender ()->property ("Filename").toString ()),
-					PCritical_));
+		if (!PendingPackages_.contains (id))
 			return;
-		}
 
-		QByteArray data = qobject_cast<QProcess*> (sender ())->readAllStandardOutput ();
-		QFile::remove (sender ()->property ("Filename").toString ());
+		PendingPackages_.remove (id);
+		rotatePackageFetchQueue ();
+	}
 
-		PackageInfo packageInfo;
-		try
-		{
-			packageInfo = ParsePackage (data, pp.BaseURL_, pp.PackageName_, pp.NewVersions_);
-		}
-		catch (const std::exception& e)
-		{
-			qWarning () << Q_FUNC_INFO
-					<< e.what ();
-			Proxy_->GetEntityManager ()->HandleEntity (Util::MakeNotification (tr ("Package parse error"),
-					tr ("Unable to parse package description file. "
-						"More information is available in logs."),
-					PCritical_));
+	void RepoInfoFetcher::handlePackageError (int id, IDownload::Error)
+	{
+		if (!PendingPackages_.contains (id))
 			return;
-		}
 
-		emit packageFetched (packageInfo, pp.ComponentId_);
-	}
+		PendingPackage pp = PendingPackages_.take (id);
+		rotatePackageFetchQueue ();
 
-	void RepoInfoFetcher::handleUnarchError (QProcess::ProcessError error)
-	{
-		sender ()->deleteLater ();
-
-		qWarning () << Q_FUNC_INFO
-				<< "unable to unpack for"
-				<< sender ()->property ("URL").toUrl ()
-				<< sender ()->property ("Filename").toString ()
-				<< "with"
-				<< error
-				<< qobject_cast<QProcess*> (sender ())->readAllStandardError ();
-		Proxy_->GetEntityManager ()->HandleEntity (Util::MakeNotification (tr ("Component unpack error"),
-					tr ("Unable to unpack file. Exit code: %1. "
-						"Problematic file is at %2.")
-						.arg (error)
-						.arg (sender ()->property ("Filename").toString ()),
-					PCritical_));
+		QFile::remove (pp.Location_);
+
+		Proxy_->GetEntityManager ()->HandleEntity (Util::MakeNotification (tr ("Error fetching package"),
+				tr ("Error fetching package from %1.")
+					.arg (pp.URL_.toString ()),
+				PCritical_));
 	}
 }
 }
@@ -31,7 +31,6 @@
 #define PLUGINS_LACKMAN_REPOINFOFETCHER_H
 #include <QObject>
 #include <QUrl>
-#include <QProcess>
 #include <QHash>
 #include <interfaces/idownload.h>
 #include <interfaces/core/icoreproxyfwd.h>
@@ -71,6 +70,7 @@ namespace LackMan
 			int ComponentId_;
 		};
 		QList<ScheduledPackageFetch> ScheduledPackages_;
+		bool PackageRotationScheduled_ = false;
 
 		struct PendingPackage
 		{
@@ -96,6 +96,7 @@ namespace LackMan
 				const QString& name,
 				const QList<QString>& newVers,
 				int componentId);
+		void HandleUnpackError (const QString& file);
 	private slots:
 		void rotatePackageFetchQueue ();
 
@@ -108,11 +109,6 @@ namespace LackMan
 		void handlePackageFinished (int);
 		void handlePackageRemoved (int);
 		void handlePackageError (int, IDownload::Error);
-
-		void handleRepoUnarchFinished (int, QProcess::ExitStatus);
-		void handleComponentUnarchFinished (int, QProcess::ExitStatus);
-		void handlePackageUnarchFinished (int, QProcess::ExitStatus);
-		void handleUnarchError (QProcess::ProcessError);
 	signals:
 		void infoFetched (const RepoInfo&);
 		void componentFetched (const PackageShortInfoList& packages,
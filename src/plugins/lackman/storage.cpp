@@ -745,6 +745,109 @@ namespace LackMan
 		lock.Good ();
 	}
 
+	QMap<QString, QStringList> Storage::SyncComponent (int componentId,
+			const PackageShortInfoList& packages)
+	{
+		Util::DBLock lock (DB_);
+		try
+		{
+			lock.Init ();
+		}
+		catch (const std::exception& e)
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unable to begin transaction:"
+					<< e.what ();
+			throw;
+		}
+
+		QSqlQuery query (DB_);
+		if (!query.exec ("CREATE TEMP TABLE IF NOT EXISTS incoming (name TEXT NOT NULL, version TEXT NOT NULL);") ||
+				!query.exec ("DELETE FROM incoming;"))
+		{
+			Util::DBLock::DumpError (query);
+			throw std::runtime_error ("Unable to prepare incoming packages table.");
+		}
+
+		QVariantList names;
+		QVariantList versions;
+		for (const auto& info : packages)
+			for (const auto& version : info.Versions_)
+			{
+				names << info.Name_;
+				versions << version;
+			}
+
+		if (!names.isEmpty ())
+		{
+			QSqlQuery inserter (DB_);
+			inserter.prepare ("INSERT INTO incoming (name, version) VALUES (?, ?);");
+			inserter.addBindValue (names);
+			inserter.addBindValue (versions);
+			if (!inserter.execBatch ())
+			{
+				Util::DBLock::DumpError (inserter);
+				throw std::runtime_error ("Unable to fill incoming packages table.");
+			}
+		}
+
+		const QString staleCond = "NOT EXISTS (SELECT 1 FROM incoming "
+				"WHERE incoming.name = packages.name AND incoming.version = packages.version)";
+
+		QSqlQuery stale (DB_);
+		stale.prepare ("SELECT DISTINCT packages.package_id FROM locations, packages "
+				"WHERE locations.component_id = :component_id "
+				"AND locations.package_id = packages.package_id AND " + staleCond + ";");
+		stale.bindValue (":component_id", componentId);
+		Util::DBLock::Execute (stale);
+
+		QList<int> staleIds;
+		while (stale.next ())
+			staleIds << stale.value (0).toInt ();
+		stale.finish ();
+
+		QSqlQuery unlocate (DB_);
+		unlocate.prepare ("DELETE FROM locations WHERE component_id = :component_id "
+				"AND package_id IN (SELECT package_id FROM packages WHERE " + staleCond + ");");
+		unlocate.bindValue (":component_id", componentId);
+		Util::DBLock::Execute (unlocate);
+
+		const auto& installed = GetInstalledPackagesIDs ();
+		for (const auto id : staleIds)
+			if (!installed.contains (id))
+				RemovePackage (id);
+
+		QSqlQuery locate (DB_);
+		locate.prepare ("INSERT INTO locations (package_id, component_id) "
+				"SELECT DISTINCT packages.package_id, :component_id FROM packages, incoming "
+				"WHERE packages.name = incoming.name AND packages.version = incoming.version "
+				"AND NOT EXISTS (SELECT 1 FROM locations "
+					"WHERE locations.package_id = packages.package_id "
+					"AND locations.component_id = :check_component_id);");
+		locate.bindValue (":component_id", componentId);
+		locate.bindValue (":check_component_id", componentId);
+		Util::DBLock::Execute (locate);
+
+		QSqlQuery fresh (DB_);
+		fresh.prepare ("SELECT name, version FROM incoming "
+				"WHERE NOT EXISTS (SELECT 1 FROM packages "
+					"WHERE packages.name = incoming.name AND packages.version = incoming.version) "
+				"ORDER BY rowid;");
+		Util::DBLock::Execute (fresh);
+
+		QMap<QString, QStringList> result;
+		while (fresh.next ())
+			result [fresh.value (0).toString ()] << fresh.value (1).toString ();
+		fresh.finish ();
+
+		if (!query.exec ("DELETE FROM incoming;"))
+			Util::DBLock::DumpError (query);
+
+		lock.Good ();
+
+		return result;
+	}
+
 	QMap<int, QList<QString>> Storage::GetPackageLocations (int packageId)
 	{
 		QueryGetPackageLocations_.bindValue (":package_id", packageId);
@@ -1112,6 +1215,18 @@ namespace LackMan
 					Util::DBLock::DumpError (query);
 					throw std::runtime_error ("Query execution failed.");
 				}
+
+		const QStringList indices
+		{
+			"CREATE INDEX IF NOT EXISTS idx_packages_name_version ON packages (name, version);",
+			"CREATE INDEX IF NOT EXISTS idx_locations_component_id ON locations (component_id);"
+		};
+		for (const auto& index : indices)
+			if (!query.exec (index))
+			{
+				Util::DBLock::DumpError (query);
+				throw std::runtime_error ("Query execution failed.");
+			}
 	}
 
 	void Storage::InitQueries ()
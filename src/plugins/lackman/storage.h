@@ -118,6 +118,17 @@ namespace LackMan
 		void RemovePackage (int packageId);
 		void AddPackages (const PackageInfo&);
 
+		/** @brief Applies the package list of a component in one transaction.
+		 *
+		 * Packages that are no longer listed in the component are
+		 * unlinked from it (and removed unless installed), already known
+		 * packages are linked to the component.
+		 *
+		 * @return The versions not known yet, keyed by package name.
+		 */
+		QMap<QString, QStringList> SyncComponent (int componentId,
+				const PackageShortInfoList& packages);
+
 		QMap<int, QList<QString>> GetPackageLocations (int);
 		QList<int> GetPackagesInComponent (int);
 		QMap<QString, QList<ListPackageInfo>> GetListPackageInfos ();
@@ -32,6 +32,7 @@
 #include <QUrl>
 #include <QString>
 #include <QXmlQuery>
+#include <QXmlStreamReader>
 #include <QDomDocument>
 #include <QDomElement>
 #include <QtDebug>
@@ -88,52 +89,58 @@ namespace LackMan
 		return info;
 	}
 
-	PackageShortInfoList ParseComponent (const QByteArray& data)
+	PackageShortInfoList ParseComponent (QIODevice *device)
 	{
-		QDomDocument doc;
-		QString msg;
-		int line = 0;
-		int column = 0;
-		if (!doc.setContent (data, &msg, &line, &column))
-		{
-			qWarning () << Q_FUNC_INFO
-					<< "erroneous document with msg"
-					<< msg
-					<< line
-					<< column
-					<< data;
-			throw std::runtime_error ("Unable to parse component description.");
-		}
+		QXmlStreamReader reader { device };
 
 		PackageShortInfoList infos;
 
-		QDomElement root = doc.documentElement ();
-		QDomElement package = root.firstChildElement ("package");
-		while (!package.isNull ())
-		{
-			QStringList versionsList;
-			QMap<QString, QString> archivers;
-
-			QDomElement versions = package.firstChildElement ("versions");
-			QDomElement version = versions.firstChildElement ("version");
-			while (!version.isNull ())
+		if (reader.readNextStartElement ())
+			while (reader.readNextStartElement ())
 			{
-				const QString& txt = version.text ();
-				versionsList << txt;
-				archivers [txt] = version.attribute ("archiver", "gz");
-
-				version = version.nextSiblingElement ("version");
+				if (reader.name () != "package")
+				{
+					reader.skipCurrentElement ();
+					continue;
+				}
+
+				PackageShortInfo psi;
+				while (reader.readNextStartElement ())
+				{
+					if (reader.name () == "name")
+						psi.Name_ = reader.readElementText (QXmlStreamReader::IncludeChildElements);
+					else if (reader.name () == "versions")
+						while (reader.readNextStartElement ())
+						{
+							if (reader.name () != "version")
+							{
+								reader.skipCurrentElement ();
+								continue;
+							}
+
+							const auto& attrs = reader.attributes ();
+							const auto& archiver = attrs.hasAttribute ("archiver") ?
+									attrs.value ("archiver").toString () :
+									QString { "gz" };
+							const auto& txt = reader.readElementText (QXmlStreamReader::IncludeChildElements);
+							psi.Versions_ << txt;
+							psi.VersionArchivers_ [txt] = archiver;
+						}
+					else
+						reader.skipCurrentElement ();
+				}
+
+				infos << psi;
 			}
 
-			PackageShortInfo psi =
-			{
-				package.firstChildElement ("name").text (),
-				versionsList,
-				archivers
-			};
-			infos << psi;
-
-			package = package.nextSiblingElement ("package");
+		if (reader.hasError ())
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "erroneous document with msg"
+					<< reader.errorString ()
+					<< reader.lineNumber ()
+					<< reader.columnNumber ();
+			throw std::runtime_error ("Unable to parse component description.");
 		}
 
 		return infos;
@@ -153,7 +160,7 @@ namespace LackMan
 		}
 	}
 
-	PackageInfo ParsePackage (const QByteArray& data,
+	PackageInfo ParsePackage (QIODevice *device,
 			const QUrl& baseUrl,
 			const QString& packageName,
 			const QStringList& packageVersions)
@@ -162,14 +169,13 @@ namespace LackMan
 		QString msg;
 		int line = 0;
 		int column = 0;
-		if (!doc.setContent (data, &msg, &line, &column))
+		if (!doc.setContent (device, &msg, &line, &column))
 		{
 			qWarning () << Q_FUNC_INFO
 					<< "erroneous document with msg"
 					<< msg
 					<< line
-					<< column
-					<< data;
+					<< column;
 			throw std::runtime_error ("Unagle to parse package description.");
 		}
 
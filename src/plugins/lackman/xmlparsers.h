@@ -33,14 +33,15 @@
 
 class QUrl;
 class QString;
+class QIODevice;
 
 namespace LeechCraft
 {
 namespace LackMan
 {
 	RepoInfo ParseRepoInfo (const QUrl& url, const QString& data);
-	PackageShortInfoList ParseComponent (const QByteArray& data);
-	PackageInfo ParsePackage (const QByteArray& data,
+	PackageShortInfoList ParseComponent (QIODevice *device);
+	PackageInfo ParsePackage (QIODevice *device,
 			const QUrl& baseUrl,
 			const QString& packageName,
 			const QStringList& packageVersions);
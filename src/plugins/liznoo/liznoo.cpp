@@ -157,6 +157,16 @@ namespace Liznoo
 					entity.Additional_ ["ContextID"].toString ());
 	}
 
+	QStringList Plugin::GetHandledMimes () const
+	{
+		return { "x-leechcraft/power-management" };
+	}
+
+	QStringList Plugin::GetHandledUrlSchemes () const
+	{
+		return {};
+	}
+
 	QList<QAction*> Plugin::GetActions (ActionsEmbedPlace place) const
 	{
 #if QT_VERSION >= 0x050000
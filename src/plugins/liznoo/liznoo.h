@@ -34,6 +34,7 @@
 #include <interfaces/iinfo.h>
 #include <interfaces/ihavesettings.h>
 #include <interfaces/ientityhandler.h>
+#include <interfaces/ientitydispatchhints.h>
 #include <interfaces/iactionsexporter.h>
 #include <interfaces/iquarkcomponentprovider.h>
 #include "batteryhistory.h"
@@ -50,11 +51,12 @@ namespace Liznoo
 				 , public IInfo
 				 , public IHaveSettings
 				 , public IEntityHandler
+				 , public IEntityDispatchHints
 				 , public IActionsExporter
 				 , public IQuarkComponentProvider
 	{
 		Q_OBJECT
-		Q_INTERFACES (IInfo IHaveSettings IEntityHandler IActionsExporter IQuarkComponentProvider)
+		Q_INTERFACES (IInfo IHaveSettings IEntityHandler IEntityDispatchHints IActionsExporter IQuarkComponentProvider)
 
 		LC_PLUGIN_METADATA ("org.LeechCraft.Liznoo")
 
@@ -90,6 +92,9 @@ namespace Liznoo
 		EntityTestHandleResult CouldHandle (const Entity& entity) const;
 		void Handle (Entity entity);
 
+		QStringList GetHandledMimes () const;
+		QStringList GetHandledUrlSchemes () const;
+
 		QList<QAction*> GetActions (ActionsEmbedPlace) const;
 		QMap<QString, QList<QAction*>> GetMenuActions () const;
 
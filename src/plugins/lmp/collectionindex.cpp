@@ -0,0 +1,238 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+
+#include "collectionindex.h"
+#include <numeric>
+#include <QSet>
+
+namespace LeechCraft
+{
+namespace LMP
+{
+	namespace
+	{
+		void SortUnique (QVector<int>& vec)
+		{
+			std::sort (vec.begin (), vec.end ());
+			vec.erase (std::unique (vec.begin (), vec.end ()), vec.end ());
+		}
+
+		bool IsNonSpacedScript (QChar c)
+		{
+			const auto code = c.unicode ();
+			return (code >= 0x0e00 && code <= 0x0eff) ||		// Thai, Lao
+					(code >= 0x1000 && code <= 0x109f) ||		// Myanmar
+					(code >= 0x1780 && code <= 0x17ff) ||		// Khmer
+					(code >= 0x3040 && code <= 0x30ff) ||		// Hiragana, Katakana
+					(code >= 0x3400 && code <= 0x4dbf) ||		// CJK Extension A
+					(code >= 0x4e00 && code <= 0x9fff) ||		// CJK Unified Ideographs
+					(code >= 0xac00 && code <= 0xd7af) ||		// Hangul Syllables
+					(code >= 0xf900 && code <= 0xfaff) ||		// CJK Compatibility Ideographs
+					(code >= 0xff66 && code <= 0xff9f);			// Halfwidth Katakana
+		}
+
+		bool NeedsSubstringMatch (const QString& query, const QStringList& tokens)
+		{
+			return tokens.isEmpty () ||
+					std::any_of (query.begin (), query.end (), IsNonSpacedScript);
+		}
+	}
+
+	void CollectionIndex::AddTracks (const QList<TrackInfo>& infos)
+	{
+		for (const auto& info : infos)
+			if (Tracks_.contains (info.TrackID_))
+				RemoveTrack (info.TrackID_);
+
+		QSet<QString> dirtyTokens;
+		for (const auto& info : infos)
+		{
+			auto tokens = std::accumulate (info.Strings_.begin (), info.Strings_.end (), QStringList {},
+					[] (QStringList tokens, const QString& string) { return tokens + Tokenize (string); });
+			tokens.removeDuplicates ();
+
+			Entry entry { info.AlbumID_, info.ArtistID_, {}, info.Strings_.join ("\n").toLower () };
+			entry.Tokens_.reserve (tokens.size ());
+			for (const auto& token : tokens)
+			{
+				auto pos = Token2Tracks_.find (token);
+				if (pos == Token2Tracks_.end ())
+					pos = Token2Tracks_.insert (token, {});
+
+				pos->push_back (info.TrackID_);
+				dirtyTokens << pos.key ();
+
+				// Share the string data with the map key.
+				entry.Tokens_ << pos.key ();
+			}
+
+			Tracks_ [info.TrackID_] = entry;
+		}
+
+		for (const auto& token : dirtyTokens)
+			SortUnique (Token2Tracks_ [token]);
+
+		++Generation_;
+	}
+
+	void CollectionIndex::RemoveTrack (int trackId)
+	{
+		const auto pos = Tracks_.find (trackId);
+		if (pos == Tracks_.end ())
+			return;
+
+		for (const auto& token : pos->Tokens_)
+		{
+			const auto tokenPos = Token2Tracks_.find (token);
+			if (tokenPos == Token2Tracks_.end ())
+				continue;
+
+			auto& postings = *tokenPos;
+			const auto postingPos = std::lower_bound (postings.begin (), postings.end (), trackId);
+			if (postingPos != postings.end () && *postingPos == trackId)
+				postings.erase (postingPos);
+
+			if (postings.isEmpty ())
+				Token2Tracks_.erase (tokenPos);
+		}
+
+		Tracks_.erase (pos);
+
+		++Generation_;
+	}
+
+	void CollectionIndex::Clear ()
+	{
+		Tracks_.clear ();
+		Token2Tracks_.clear ();
+
+		++Generation_;
+	}
+
+	CollectionIndex::Matches CollectionIndex::Find (const QString& query) const
+	{
+		auto queryTokens = Tokenize (query);
+		queryTokens.removeDuplicates ();
+
+		const auto& trimmed = query.trimmed ();
+		if (trimmed.isEmpty ())
+			return {};
+
+		const auto& tracks = NeedsSubstringMatch (trimmed, queryTokens) ?
+				FindSubstring (trimmed.toLower ()) :
+				FindTokens (queryTokens);
+		if (tracks.isEmpty ())
+			return {};
+
+		Matches result;
+		result.Tracks_ = tracks;
+		result.Albums_.reserve (tracks.size ());
+		result.Artists_.reserve (tracks.size ());
+		for (const auto trackId : tracks)
+		{
+			const auto& entry = *Tracks_.constFind (trackId);
+			result.Albums_ << entry.AlbumID_;
+			result.Artists_ << entry.ArtistID_;
+		}
+		SortUnique (result.Albums_);
+		SortUnique (result.Artists_);
+		return result;
+	}
+
+	quint64 CollectionIndex::GetGeneration () const
+	{
+		return Generation_;
+	}
+
+	QStringList CollectionIndex::Tokenize (const QString& string)
+	{
+		QStringList result;
+
+		const auto& lower = string.toLower ();
+		int start = -1;
+		for (int i = 0, size = lower.size (); i <= size; ++i)
+		{
+			const bool isWordChar = i < size && lower.at (i).isLetterOrNumber ();
+			if (isWordChar && start < 0)
+				start = i;
+			else if (!isWordChar && start >= 0)
+			{
+				result << lower.mid (start, i - start);
+				start = -1;
+			}
+		}
+
+		return result;
+	}
+
+	QVector<int> CollectionIndex::FindTokens (const QStringList& queryTokens) const
+	{
+		QVector<int> tracks;
+		bool first = true;
+		for (const auto& queryToken : queryTokens)
+		{
+			QVector<int> matching;
+			for (auto i = Token2Tracks_.lowerBound (queryToken);
+					i != Token2Tracks_.end () && i.key ().startsWith (queryToken);
+					++i)
+				matching += *i;
+			SortUnique (matching);
+
+			if (first)
+			{
+				tracks = matching;
+				first = false;
+			}
+			else
+			{
+				QVector<int> intersection;
+				std::set_intersection (tracks.begin (), tracks.end (),
+						matching.begin (), matching.end (),
+						std::back_inserter (intersection));
+				tracks = intersection;
+			}
+
+			if (tracks.isEmpty ())
+				break;
+		}
+		return tracks;
+	}
+
+	QVector<int> CollectionIndex::FindSubstring (const QString& lowerQuery) const
+	{
+		QVector<int> tracks;
+		for (auto i = Tracks_.begin (), end = Tracks_.end (); i != end; ++i)
+			if (i->Text_.contains (lowerQuery))
+				tracks << i.key ();
+		std::sort (tracks.begin (), tracks.end ());
+		return tracks;
+	}
+}
+}
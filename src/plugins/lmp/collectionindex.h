@@ -0,0 +1,122 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+
+#pragma once
+
+#include <algorithm>
+#include <QHash>
+#include <QMap>
+#include <QStringList>
+#include <QVector>
+
+namespace LeechCraft
+{
+namespace LMP
+{
+	/** @brief Inverted index over the tokens of the local collection.
+	 *
+	 * Each track is indexed by the words of its artist, album, title,
+	 * year and genres. A query matches a track if each of its words is a
+	 * prefix of some of the track's words, case-insensitively.
+	 *
+	 * Queries that have no words at all (like punctuation-only ones) or
+	 * that are written in scripts not separating words by spaces (like
+	 * CJK or Thai) are matched as substrings of the track's strings
+	 * instead.
+	 */
+	class CollectionIndex
+	{
+	public:
+		struct TrackInfo
+		{
+			int TrackID_;
+			int AlbumID_;
+			int ArtistID_;
+			QStringList Strings_;
+		};
+
+		struct Matches
+		{
+			QVector<int> Artists_;
+			QVector<int> Albums_;
+			QVector<int> Tracks_;
+
+			bool HasArtist (int id) const
+			{
+				return std::binary_search (Artists_.begin (), Artists_.end (), id);
+			}
+
+			bool HasAlbum (int id) const
+			{
+				return std::binary_search (Albums_.begin (), Albums_.end (), id);
+			}
+
+			bool HasTrack (int id) const
+			{
+				return std::binary_search (Tracks_.begin (), Tracks_.end (), id);
+			}
+		};
+	private:
+		struct Entry
+		{
+			int AlbumID_;
+			int ArtistID_;
+			QStringList Tokens_;
+
+			// Lowercased strings of the track for the substring fallback.
+			QString Text_;
+		};
+		QHash<int, Entry> Tracks_;
+
+		// Posting lists are kept sorted.
+		QMap<QString, QVector<int>> Token2Tracks_;
+
+		quint64 Generation_ = 0;
+	public:
+		void AddTracks (const QList<TrackInfo>&);
+		void RemoveTrack (int);
+		void Clear ();
+
+		Matches Find (const QString& query) const;
+
+		/** @brief Returns the number of the index modification.
+		 *
+		 * The generation is changed each time the index is modified, so
+		 * cached query results may be compared against it.
+		 */
+		quint64 GetGeneration () const;
+
+		static QStringList Tokenize (const QString&);
+	private:
+		QVector<int> FindTokens (const QStringList&) const;
+		QVector<int> FindSubstring (const QString&) const;
+	};
+}
+}
@@ -54,23 +54,64 @@ namespace LMP
 	{
 		class CollectionFilterModel : public QSortFilterProxyModel
 		{
+			const CollectionIndex& Index_;
+
+			mutable QString CachedPattern_;
+			mutable quint64 CachedGeneration_ = 0;
+			mutable CollectionIndex::Matches CachedMatches_;
 		public:
-			CollectionFilterModel (QObject *parent = nullptr)
+			CollectionFilterModel (const CollectionIndex& index, QObject *parent = nullptr)
 			: QSortFilterProxyModel { parent }
+			, Index_ (index)
 			{
 				setDynamicSortFilter (true);
 			}
 		protected:
 			bool filterAcceptsRow (int sourceRow, const QModelIndex& sourceParent) const
 			{
+				const auto& pattern = filterRegExp ().pattern ();
+				if (pattern.trimmed ().isEmpty ())
+					return true;
+
 				const auto& source = sourceModel ()->index (sourceRow, 0, sourceParent);
-				const auto type = source.data (LocalCollectionModel::Role::Node).toInt ();
 
-				const auto& pattern = filterRegExp ().pattern ();
+				const auto& idVar = source.data (LocalCollectionModel::Role::NodeID);
+				if (!idVar.isValid ())
+					return AcceptsUnindexed (source, pattern);
 
+				const auto& matches = GetMatches (pattern);
+				const auto id = idVar.toInt ();
+				switch (source.data (LocalCollectionModel::Role::Node).toInt ())
+				{
+				case LocalCollectionModel::NodeType::Artist:
+					return matches.HasArtist (id);
+				case LocalCollectionModel::NodeType::Album:
+					return matches.HasAlbum (id);
+				case LocalCollectionModel::NodeType::Track:
+					return matches.HasTrack (id);
+				}
+
+				return false;
+			}
+		private:
+			const CollectionIndex::Matches& GetMatches (const QString& pattern) const
+			{
+				if (pattern != CachedPattern_ || Index_.GetGeneration () != CachedGeneration_)
+				{
+					CachedMatches_ = Index_.Find (pattern);
+					CachedPattern_ = pattern;
+					CachedGeneration_ = Index_.GetGeneration ();
+				}
+				return CachedMatches_;
+			}
+
+			// Nodes not coming from the local collection aren't indexed.
+			bool AcceptsUnindexed (const QModelIndex& source, const QString& pattern) const
+			{
+				const auto type = source.data (LocalCollectionModel::Role::Node).toInt ();
 				if (type != LocalCollectionModel::NodeType::Track)
 					for (int i = 0, rc = sourceModel ()->rowCount (source); i < rc; ++i)
-						if (filterAcceptsRow (i, source))
+						if (AcceptsUnindexed (sourceModel ()->index (i, 0, source), pattern))
 							return true;
 
 				auto check = [&source, &pattern] (int role)
@@ -89,7 +130,10 @@ namespace LMP
 	CollectionWidget::CollectionWidget (QWidget *parent)
 	: QWidget { parent }
 	, Player_ { Core::Instance ().GetPlayer () }
-	, CollectionFilterModel_ { new CollectionFilterModel { this } }
+	, CollectionFilterModel_
+	{
+		new CollectionFilterModel { Core::Instance ().GetLocalCollection ()->GetCollectionIndex (), this }
+	}
 	{
 		Ui_.setupUi (this);
 
@@ -117,6 +117,11 @@ namespace LMP
 		return CollectionModel_->GetTrackData (trackId, role);
 	}
 
+	const CollectionIndex& LocalCollection::GetCollectionIndex () const
+	{
+		return CollectionModel_->GetIndex ();
+	}
+
 	void LocalCollection::Clear ()
 	{
 		Storage_->Clear ();
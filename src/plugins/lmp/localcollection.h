@@ -117,6 +117,7 @@ namespace LMP
 		QAbstractItemModel* GetCollectionModel () const;
 
 		QVariant GetTrackData (int trackId, LocalCollectionModel::Role) const;
+		const CollectionIndex& GetCollectionIndex () const;
 
 		void Clear ();
 
@@ -115,6 +115,20 @@ namespace LMP
 
 	void LocalCollectionModel::AddArtists (const Collection::Artists_t& artists)
 	{
+		// The index is updated before the items are added, so that the
+		// filters reacting to the new rows already see the new tracks.
+		QList<CollectionIndex::TrackInfo> indexInfos;
+		for (const auto& artist : artists)
+			for (const auto& album : artist.Albums_)
+				for (const auto& track : album->Tracks_)
+				{
+					QStringList strings { artist.Name_, album->Name_, track.Name_ };
+					if (album->Year_ > 0)
+						strings << QString::number (album->Year_);
+					indexInfos.append ({ track.ID_, album->ID_, artist.ID_, strings + track.Genres_ });
+				}
+		Index_.AddTracks (indexInfos);
+
 		for (const auto& artist : artists)
 		{
 			auto artistItem = GetItem (Artist2Item_,
@@ -125,6 +139,7 @@ namespace LMP
 						item->setText (artist.Name_);
 						item->setData (artist.Name_, Role::ArtistName);
 						item->setData (NodeType::Artist, Role::Node);
+						item->setData (artist.ID_, Role::NodeID);
 					},
 					this);
 			for (auto album : artist.Albums_)
@@ -140,6 +155,7 @@ namespace LMP
 							item->setData (album->Name_, Role::AlbumName);
 							item->setData (artist.Name_, Role::ArtistName);
 							item->setData (NodeType::Album, Role::Node);
+							item->setData (album->ID_, Role::NodeID);
 							if (!album->CoverPath_.isEmpty ())
 								item->setData (album->CoverPath_, Role::AlbumArt);
 						},
@@ -161,6 +177,7 @@ namespace LMP
 					item->setData (track.Genres_, Role::TrackGenres);
 					item->setData (track.Length_, Role::TrackLength);
 					item->setData (NodeType::Track, Role::Node);
+					item->setData (track.ID_, Role::NodeID);
 					albumItem->appendRow (item);
 
 					Track2Item_ [track.ID_] = item;
@@ -176,10 +193,30 @@ namespace LMP
 		Artist2Item_.clear ();
 		Album2Item_.clear ();
 		Track2Item_.clear ();
+
+		Index_.Clear ();
+	}
+
+	namespace
+	{
+		template<typename F>
+		void ForEachTrack (QStandardItem *item, F f)
+		{
+			if (item->data (LocalCollectionModel::Role::Node).toInt () == LocalCollectionModel::NodeType::Track)
+			{
+				f (item->data (LocalCollectionModel::Role::NodeID).toInt ());
+				return;
+			}
+
+			for (int i = 0, rc = item->rowCount (); i < rc; ++i)
+				ForEachTrack (item->child (i), f);
+		}
 	}
 
 	void LocalCollectionModel::RemoveTrack (int id)
 	{
+		Index_.RemoveTrack (id);
+
 		auto item = Track2Item_.take (id);
 		item->parent ()->removeRow (item->row ());
 	}
@@ -187,6 +224,7 @@ namespace LMP
 	void LocalCollectionModel::RemoveAlbum (int id)
 	{
 		auto item = Album2Item_.take (id);
+		ForEachTrack (item, [this] (int trackId) { Index_.RemoveTrack (trackId); });
 		item->parent ()->removeRow (item->row ());
 	}
 
@@ -196,9 +234,16 @@ namespace LMP
 		return item ? item->data (role) : QVariant ();
 	}
 
+	const CollectionIndex& LocalCollectionModel::GetIndex () const
+	{
+		return Index_;
+	}
+
 	void LocalCollectionModel::RemoveArtist (int id)
 	{
-		removeRow (Artist2Item_.take (id)->row ());
+		auto item = Artist2Item_.take (id);
+		ForEachTrack (item, [this] (int trackId) { Index_.RemoveTrack (trackId); });
+		removeRow (item->row ());
 	}
 
 	void LocalCollectionModel::SetAlbumArt (int id, const QString& path)
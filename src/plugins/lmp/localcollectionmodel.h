@@ -34,6 +34,7 @@
 #include <util/models/dndactionsmixin.h>
 #include "interfaces/lmp/icollectionmodel.h"
 #include "interfaces/lmp/collectiontypes.h"
+#include "collectionindex.h"
 
 namespace LeechCraft
 {
@@ -49,6 +50,8 @@ namespace LMP
 		QHash<int, QStandardItem*> Artist2Item_;
 		QHash<int, QStandardItem*> Album2Item_;
 		QHash<int, QStandardItem*> Track2Item_;
+
+		CollectionIndex Index_;
 	public:
 		enum NodeType
 		{
@@ -68,7 +71,8 @@ namespace LMP
 			TrackTitle,
 			TrackPath,
 			TrackGenres,
-			TrackLength
+			TrackLength,
+			NodeID
 		};
 
 		LocalCollectionModel (QObject*);
@@ -86,6 +90,8 @@ namespace LMP
 
 		void SetAlbumArt (int, const QString&);
 		QVariant GetTrackData (int trackId, Role) const;
+
+		const CollectionIndex& GetIndex () const;
 	};
 }
 }
@@ -74,8 +74,8 @@ namespace LMP
 		auto audio = r.audioProperties ();
 
 		auto& xsm = XmlSettingsManager::Instance ();
-		const auto& region = xsm.property ("EnableLocalTagsRecoding").toBool () ?
-				xsm.property ("TagsRecodingRegion").toString () :
+		const auto& region = xsm.EnableLocalTagsRecoding_.Get () ?
+				xsm.TagsRecodingRegion_.Get () :
 				QString {};
 		auto ftl = [&region] (const TagLib::String& str)
 		{
@@ -33,6 +33,7 @@
 #include <QFileInfo>
 #include <QDir>
 #include <QUrl>
+#include <QSet>
 #include <QtConcurrentRun>
 #include <QFutureSynchronizer>
 #include <QApplication>
@@ -131,6 +132,7 @@ namespace LMP
 	{
 		ResolveResult_t Resolved_;
 		bool ShouldClear_;
+		bool Sorted_;
 	};
 
 	Player::Player (QObject *parent)
@@ -142,6 +144,7 @@ namespace LMP
 	, PRG_ { QDateTime::currentDateTime ().toTime_t () }
 	, RulesManager_ (new PlayerRulesManager (PlaylistModel_, this))
 	, FirstPlaylistRestore_ (true)
+	, QueueSorted_ (false)
 	, PlayMode_ (PlayMode::Sequential)
 	{
 		qRegisterMetaType<QList<AudioSource>> ("QList<AudioSource>");
@@ -247,6 +250,7 @@ namespace LMP
 	void Player::SetSortingCriteria (const QList<SortingCriteria>& criteria)
 	{
 		Sorter_.Criteria_ = criteria;
+		QueueSorted_ = false;
 
 		AddToPlaylistModel ({}, true, false);
 
@@ -374,35 +378,28 @@ namespace LMP
 			UnsetRadio ();
 
 		for (const auto& source : sources)
-		{
 			Url2Info_.remove (source.ToUrl ());
 
-			if (!CurrentQueue_.removeAll (source))
+		const auto& toRemove = sources.toSet ();
+		const auto queueEnd = std::remove_if (CurrentQueue_.begin (), CurrentQueue_.end (),
+				[&toRemove] (const AudioSource& source) { return toRemove.contains (source); });
+		CurrentQueue_.erase (queueEnd, CurrentQueue_.end ());
+
+		for (const auto& source : toRemove)
+		{
+			if (!Items_.contains (source))
 				continue;
 
 			RemoveFromOneShotQueue (source);
 
-			auto item = Items_.take (source);
-			auto parent = item->parent ();
-			if (parent)
+			const auto item = Items_.take (source);
+			const auto& info = Infos_.take (source);
+			if (const auto parent = item->parent ())
 			{
 				if (parent->rowCount () == 1)
-				{
-					for (const auto& key : AlbumRoots_.keys ())
-					{
-						auto& items = AlbumRoots_ [key];
-						if (!items.contains (parent))
-							continue;
-
-						items.removeAll (parent);
-						if (items.isEmpty ())
-							AlbumRoots_.remove (key);
-					}
 					PlaylistModel_->removeRow (parent->row ());
-				}
 				else
 				{
-					const auto& info = item->data (Role::Info).value<MediaInfo> ();
 					if (!info.LocalPath_.isEmpty ())
 						IncAlbumLength (parent, -info.Length_);
 					parent->removeRow (item->row ());
@@ -594,9 +591,7 @@ namespace LMP
 
 	MediaInfo Player::GetMediaInfo (const AudioSource& source) const
 	{
-		return Items_.contains (source) ?
-				Items_ [source]->data (Role::Info).value<MediaInfo> () :
-				MediaInfo ();
+		return Infos_.value (source);
 	}
 
 	NativePlaylist_t Player::GetAsNativePlaylist () const
@@ -952,6 +947,24 @@ namespace LMP
 					[&] (const AudioSource& source) { return PairResolve (getter, source); });
 		}
 
+		template<typename Sorter>
+		bool CompareResolved (const Sorter& sorter,
+				const AudioSource& src1, const MediaInfo& info1,
+				const AudioSource& src2, const MediaInfo& info2)
+		{
+			const auto leftUseful = !info1.IsUseless ();
+			const auto rightUseful = !info2.IsUseless ();
+
+			if (leftUseful && !rightUseful)
+				return true;
+			else if (!leftUseful && rightUseful)
+				return false;
+			else if (!leftUseful || !rightUseful)
+				return src1.ToUrl () < src2.ToUrl ();
+			else
+				return sorter (info1, info2);
+		}
+
 		template<typename Sorter, typename NonLocalGetter>
 		ResolveResult_t PairResolveSort (const QList<AudioSource>& sources,
 				Sorter sorter, NonLocalGetter nonLocalGetter, bool sort)
@@ -964,17 +977,7 @@ namespace LMP
 			std::sort (result.begin (), result.end (),
 					[sorter] (const ResolvedSource_t& s1, const ResolvedSource_t& s2)
 					{
-						const auto leftUseful = !s1.second.IsUseless ();
-						const auto rightUseful = !s2.second.IsUseless ();
-
-						if (leftUseful && !rightUseful)
-							return true;
-						else if (!leftUseful && rightUseful)
-							return false;
-						else if (!leftUseful || !rightUseful)
-							return s1.first.ToUrl () < s2.first.ToUrl ();
-						else
-							return sorter (s1.second, s2.second);
+						return CompareResolved (sorter, s1.first, s1.second, s2.first, s2.second);
 					});
 
 			return result;
@@ -983,7 +986,12 @@ namespace LMP
 
 	void Player::AddToPlaylistModel (QList<AudioSource> sources, bool sort, bool clear)
 	{
-		if (!CurrentQueue_.isEmpty () && !clear)
+		const bool sorted = sort && !Sorter_.Criteria_.isEmpty ();
+
+		// Only the new sources are resolved and merged into the existing
+		// queue, unless the whole queue has to be re-sorted.
+		const bool merge = !CurrentQueue_.isEmpty () && !clear;
+		if (merge && (sources.isEmpty () || (sorted && !QueueSorted_)))
 		{
 			EnqueueFlags flags { EnqueueReplace };
 			if (sort)
@@ -1005,13 +1013,17 @@ namespace LMP
 									return Url2Info_.value (source.ToUrl ());
 								},
 								sort),
-						clear
+						clear,
+						sorted
 					};
 				});
 		Util::Sequence (this, future) >>
-				[this] (const ResolveJobResult& result)
+				[this, merge] (const ResolveJobResult& result)
 				{
-					ContinueAfterSorted (result);
+					if (merge)
+						MergeResolved (result);
+					else
+						ContinueAfterSorted (result);
 					emit playerAvailable (true);
 				};
 	}
@@ -1373,7 +1385,7 @@ namespace LMP
 			PlaylistModel_->removeRows (0, rc);
 
 		Items_.clear ();
-		AlbumRoots_.clear ();
+		Infos_.clear ();
 		CurrentQueue_.clear ();
 		Url2Info_.clear ();
 		CurrentOneShotQueue_.clear ();
@@ -1396,16 +1408,55 @@ namespace LMP
 		Enqueue (queue, EnqueueReplace);
 	}
 
-	namespace
+	void Player::FillItem (QStandardItem *item, const AudioSource& source, const MediaInfo& info)
+	{
+		Infos_ [source] = info;
+
+		const auto& text = !info.IsUseless () ?
+				PerformSubstitutionsPlaylist (info) :
+				QFileInfo (info.LocalPath_).fileName ();
+		item->setText (text);
+	}
+
+	QStandardItem* Player::MakeTrackItem (const AudioSource& source, const MediaInfo& resolved)
 	{
-		void FillItem (QStandardItem *item, const MediaInfo& info)
+		auto item = new QStandardItem ();
+		item->setEditable (false);
+		item->setData (QVariant::fromValue (source), Role::Source);
+		item->setData (source == CurrentStopSource_, Role::IsStop);
+
+		const auto oneShotPos = CurrentOneShotQueue_.indexOf (source);
+		if (oneShotPos >= 0)
+			item->setData (oneShotPos, Role::OneShotPos);
+
+		switch (source.GetType ())
 		{
-			const auto& text = !info.IsUseless () ?
-					PerformSubstitutionsPlaylist (info) :
-					QFileInfo (info.LocalPath_).fileName ();
-			item->setText (text);
-			item->setData (QVariant::fromValue (info), Player::Role::Info);
+		case AudioSource::Type::Stream:
+			item->setText (tr ("Stream"));
+			break;
+		case AudioSource::Type::Url:
+		{
+			const auto& url = source.ToUrl ();
+
+			auto info = Core::Instance ().TryURLResolve (url);
+			if (!info && Url2Info_.contains (url))
+				info = Url2Info_ [url];
+
+			if (info)
+				FillItem (item, source, *info);
+			else
+				item->setText (url.toString ());
+			break;
+		}
+		case AudioSource::Type::File:
+			FillItem (item, source, resolved);
+			break;
+		default:
+			item->setText ("unknown");
+			break;
 		}
+
+		return item;
 	}
 
 	void Player::ContinueAfterSorted (const ResolveJobResult& result)
@@ -1421,108 +1472,58 @@ namespace LMP
 			if (const auto rc = PlaylistModel_->rowCount ())
 				PlaylistModel_->removeRows (0, rc);
 			Items_.clear ();
-			AlbumRoots_.clear ();
+			Infos_.clear ();
 		}
 
 		PlaylistModel_->blockSignals (true);
 
+		QHash<QString, QList<QStandardItem*>> albumRoots;
 		QString prevAlbumRoot;
 
-		QList<QStandardItem*> managedRulesItems;
-
 		for (const auto& sourcePair : sources)
 		{
 			const auto& source = sourcePair.first;
 			CurrentQueue_ << source;
 
-			auto item = new QStandardItem ();
-			item->setEditable (false);
-			item->setData (QVariant::fromValue (source), Role::Source);
-			item->setData (source == CurrentStopSource_, Role::IsStop);
-
-			const auto oneShotPos = CurrentOneShotQueue_.indexOf (source);
-			if (oneShotPos >= 0)
-				item->setData (oneShotPos, Role::OneShotPos);
+			const auto item = MakeTrackItem (source, sourcePair.second);
+			Items_ [source] = item;
 
-			switch (source.GetType ())
+			if (source.GetType () != AudioSource::Type::File)
 			{
-			case AudioSource::Type::Stream:
-				item->setText (tr ("Stream"));
 				PlaylistModel_->appendRow (item);
-				break;
-			case AudioSource::Type::Url:
-			{
-				const auto& url = source.ToUrl ();
-
-				auto info = Core::Instance ().TryURLResolve (url);
-				if (!info && Url2Info_.contains (url))
-					info = Url2Info_ [url];
-
-				if (info)
-					FillItem (item, *info);
-				else
-					item->setText (url.toString ());
+				continue;
+			}
 
+			const auto& info = sourcePair.second;
+			const auto& albumID = info.Album_;
+			if (albumID != prevAlbumRoot ||
+					albumRoots [albumID].isEmpty ())
+			{
 				PlaylistModel_->appendRow (item);
-				break;
+
+				if (!info.Album_.simplified ().isEmpty ())
+					albumRoots [albumID] << item;
 			}
-			case AudioSource::Type::File:
+			else if (albumRoots [albumID].last ()->data (Role::IsAlbum).toBool ())
 			{
-				const auto& info = sourcePair.second;
-
-				managedRulesItems << item;
-
-				const auto& albumID = info.Album_;
-				FillItem (item, info);
-				if (albumID != prevAlbumRoot ||
-						AlbumRoots_ [albumID].isEmpty ())
-				{
-					PlaylistModel_->appendRow (item);
-
-					if (!info.Album_.simplified ().isEmpty ())
-						AlbumRoots_ [albumID] << item;
-				}
-				else if (AlbumRoots_ [albumID].last ()->data (Role::IsAlbum).toBool ())
-				{
-					IncAlbumLength (AlbumRoots_ [albumID].last (), info.Length_);
-					AlbumRoots_ [albumID].last ()->appendRow (item);
-				}
-				else
-				{
-					auto albumItem = MakeAlbumItem (info);
-
-					const int row = AlbumRoots_ [albumID].last ()->row ();
-					const auto& existing = PlaylistModel_->takeRow (row);
-					albumItem->appendRow (existing);
-					albumItem->appendRow (item);
-					PlaylistModel_->insertRow (row, albumItem);
-
-					LoadAlbumArt (albumItem, info);
-
-					const auto& existingInfo = existing.at (0)->data (Role::Info).value<MediaInfo> ();
-					albumItem->setData (existingInfo.Length_, Role::AlbumLength);
-					IncAlbumLength (albumItem, info.Length_);
-
-					emit insertedAlbum (albumItem->index ());
-
-					AlbumRoots_ [albumID].last () = albumItem;
-				}
-				prevAlbumRoot = albumID;
-				break;
+				IncAlbumLength (albumRoots [albumID].last (), info.Length_);
+				albumRoots [albumID].last ()->appendRow (item);
 			}
-			default:
-				item->setText ("unknown");
-				PlaylistModel_->appendRow (item);
-				break;
+			else
+			{
+				const int row = albumRoots [albumID].last ()->row ();
+				const auto& existing = PlaylistModel_->takeRow (row);
+				albumRoots [albumID].last () = MakeAlbum ({ existing.at (0), item }, row);
 			}
-
-			Items_ [source] = item;
+			prevAlbumRoot = albumID;
 		}
 
 		PlaylistModel_->blockSignals (false);
 
 		QMetaObject::invokeMethod (PlaylistModel_, "modelReset");
 
+		QueueSorted_ = result.Sorted_;
+
 		SaveOnLoadPlaylist ();
 
 		if (Source_->GetState () == SourceState::Stopped)
@@ -1549,6 +1550,159 @@ namespace LMP
 			Items_ [currentSource]->setData (true, Role::IsCurrent);
 	}
 
+	void Player::MergeResolved (const ResolveJobResult& result)
+	{
+		static const MediaInfo NoInfo;
+		const auto lessThan = [this] (const ResolvedSource_t& pair, const AudioSource& source)
+		{
+			const auto infoPos = Infos_.constFind (source);
+			const auto& info = infoPos == Infos_.constEnd () ? NoInfo : *infoPos;
+			return CompareResolved (Sorter_, pair.first, pair.second, source, info);
+		};
+
+		// The resolved sources are sorted themselves, so each one is
+		// looked up only after the previously inserted one.
+		int searchStart = 0;
+		for (const auto& pair : result.Resolved_)
+		{
+			if (Items_.contains (pair.first))
+				continue;
+
+			int pos = CurrentQueue_.size ();
+			if (result.Sorted_)
+			{
+				const auto it = std::upper_bound (CurrentQueue_.begin () + searchStart,
+						CurrentQueue_.end (), pair, lessThan);
+				pos = it - CurrentQueue_.begin ();
+				searchStart = pos + 1;
+			}
+
+			InsertTrack (pair.first, pair.second, pos);
+		}
+
+		if (!result.Sorted_)
+			QueueSorted_ = false;
+
+		SaveOnLoadPlaylist ();
+
+		if (const auto item = Items_.value (Source_->GetCurrentSource ()))
+			item->setData (true, Role::IsCurrent);
+	}
+
+	namespace
+	{
+		bool IsGroupable (const AudioSource& source, const MediaInfo& info)
+		{
+			return source.GetType () == AudioSource::Type::File &&
+					!info.Album_.simplified ().isEmpty ();
+		}
+	}
+
+	void Player::InsertTrack (const AudioSource& source, const MediaInfo& resolved, int queuePos)
+	{
+		const auto item = MakeTrackItem (source, resolved);
+		CurrentQueue_.insert (queuePos, source);
+		Items_ [source] = item;
+
+		const auto& info = GetMediaInfo (source);
+
+		const auto sameAlbumItem = [&] (int pos) -> QStandardItem*
+		{
+			if (pos < 0 || pos >= CurrentQueue_.size () || !IsGroupable (source, info))
+				return nullptr;
+
+			const auto& other = CurrentQueue_.at (pos);
+			const auto& otherInfo = GetMediaInfo (other);
+			if (!IsGroupable (other, otherInfo) || otherInfo.Album_ != info.Album_)
+				return nullptr;
+
+			return Items_.value (other);
+		};
+
+		if (const auto prev = sameAlbumItem (queuePos - 1))
+		{
+			if (const auto album = prev->parent ())
+			{
+				IncAlbumLength (album, info.Length_);
+				album->insertRow (prev->row () + 1, item);
+			}
+			else
+			{
+				const int row = prev->row ();
+				MakeAlbum ({ PlaylistModel_->takeRow (row).at (0), item }, row);
+			}
+			return;
+		}
+
+		if (const auto next = sameAlbumItem (queuePos + 1))
+		{
+			if (const auto album = next->parent ())
+			{
+				IncAlbumLength (album, info.Length_);
+				album->insertRow (next->row (), item);
+			}
+			else
+			{
+				const int row = next->row ();
+				MakeAlbum ({ item, PlaylistModel_->takeRow (row).at (0) }, row);
+			}
+			return;
+		}
+
+		int row = 0;
+		if (const auto prev = Items_.value (CurrentQueue_.value (queuePos - 1)))
+		{
+			if (const auto album = prev->parent ())
+			{
+				row = album->row () + 1;
+				SplitAlbum (album, prev->row () + 1, row);
+			}
+			else
+				row = prev->row () + 1;
+		}
+		PlaylistModel_->insertRow (row, item);
+	}
+
+	QStandardItem* Player::MakeAlbum (const QList<QStandardItem*>& tracks, int row)
+	{
+		const auto sourceOf = [] (QStandardItem *item)
+		{
+			return item->data (Role::Source).value<AudioSource> ();
+		};
+
+		const auto& info = GetMediaInfo (sourceOf (tracks.first ()));
+		const auto albumItem = MakeAlbumItem (info);
+		for (const auto track : tracks)
+		{
+			albumItem->appendRow (track);
+			IncAlbumLength (albumItem, GetMediaInfo (sourceOf (track)).Length_);
+		}
+
+		PlaylistModel_->insertRow (row, albumItem);
+
+		LoadAlbumArt (albumItem, info);
+
+		emit insertedAlbum (albumItem->index ());
+
+		return albumItem;
+	}
+
+	void Player::SplitAlbum (QStandardItem *album, int fromRow, int row)
+	{
+		QList<QStandardItem*> tail;
+		while (album->rowCount () > fromRow)
+		{
+			const auto track = album->takeRow (fromRow).at (0);
+			IncAlbumLength (album, -GetMediaInfo (track->data (Role::Source).value<AudioSource> ()).Length_);
+			tail << track;
+		}
+
+		if (tail.size () == 1)
+			PlaylistModel_->insertRow (row, tail.first ());
+		else if (!tail.isEmpty ())
+			MakeAlbum (tail, row);
+	}
+
 	void Player::SaveOnLoadPlaylist () const
 	{
 		Core::Instance ().GetPlaylistManager ()->
@@ -1729,7 +1883,7 @@ namespace LMP
 			emit songChanged (info);
 		}
 		else if (curItem)
-			emit songChanged (curItem->data (Role::Info).value<MediaInfo> ());
+			emit songChanged (GetMediaInfo (source));
 		else
 			emit songChanged (MediaInfo ());
 
@@ -1763,7 +1917,7 @@ namespace LMP
 			emit songInfoUpdated (info);
 		else
 		{
-			FillItem (curItem, info);
+			FillItem (curItem, source, info);
 			emit songChanged (info);
 		}
 
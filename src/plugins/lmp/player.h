@@ -80,7 +80,7 @@ namespace LMP
 
 		QList<AudioSource> CurrentQueue_;
 		QHash<AudioSource, QStandardItem*> Items_;
-		QHash<QString, QList<QStandardItem*>> AlbumRoots_;
+		QHash<AudioSource, MediaInfo> Infos_;
 
 		AudioSource CurrentStopSource_;
 		QList<AudioSource> CurrentOneShotQueue_;
@@ -94,6 +94,8 @@ namespace LMP
 
 		bool FirstPlaylistRestore_;
 		bool IgnoreNextSaves_;
+
+		bool QueueSorted_;
 	public:
 		enum class PlayMode
 		{
@@ -213,7 +215,15 @@ namespace LMP
 
 		void MarkAsCurrent (QStandardItem*);
 
+		QStandardItem* MakeTrackItem (const AudioSource&, const MediaInfo&);
+		void FillItem (QStandardItem*, const AudioSource&, const MediaInfo&);
+
 		void ContinueAfterSorted (const ResolveJobResult&);
+		void MergeResolved (const ResolveJobResult&);
+
+		void InsertTrack (const AudioSource&, const MediaInfo&, int queuePos);
+		QStandardItem* MakeAlbum (const QList<QStandardItem*>& tracks, int row);
+		void SplitAlbum (QStandardItem *album, int fromRow, int row);
 
 		void SaveOnLoadPlaylist () const;
 	public slots:
@@ -180,7 +180,7 @@ namespace LMP
 				const auto& infoCache = Util::Map (items,
 						[] (QStandardItem *item)
 						{
-							return qMakePair (item, item->data (Player::Role::Info).value<MediaInfo> ());
+							return qMakePair (item, item->index ().data (Player::Role::Info).value<MediaInfo> ());
 						});
 
 				for (const auto& rule : rules)
@@ -48,6 +48,24 @@ namespace LMP
 		setSupportedDragActions (Qt::CopyAction | Qt::MoveAction);
 	}
 
+	QVariant PlaylistModel::data (const QModelIndex& index, int role) const
+	{
+		if (role != Player::Role::Info)
+			return QStandardItemModel::data (index, role);
+
+		// Track infos are kept by the Player itself, only album items
+		// store theirs in the model.
+		const auto& info = QStandardItemModel::data (index, role);
+		if (info.isValid ())
+			return info;
+
+		const auto& source = QStandardItemModel::data (index, Player::Role::Source);
+		if (!source.isValid ())
+			return {};
+
+		return QVariant::fromValue (Player_->GetMediaInfo (source.value<AudioSource> ()));
+	}
+
 	QStringList PlaylistModel::mimeTypes () const
 	{
 		return { "text/uri-list" };
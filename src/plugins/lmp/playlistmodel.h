@@ -44,6 +44,8 @@ namespace LMP
 	public:
 		PlaylistModel (Player*);
 
+		QVariant data (const QModelIndex&, int role = Qt::DisplayRole) const;
+
 		QStringList mimeTypes () const;
 		QMimeData* mimeData (const QModelIndexList&) const;
 		bool dropMimeData (const QMimeData*, Qt::DropAction, int, int, const QModelIndex&);
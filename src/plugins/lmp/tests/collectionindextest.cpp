@@ -0,0 +1,122 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+
+#include "collectionindextest.h"
+#include <QtTest>
+#include <collectionindex.h>
+
+QTEST_MAIN (LeechCraft::LMP::CollectionIndexTest)
+
+namespace LeechCraft
+{
+namespace LMP
+{
+	namespace
+	{
+		CollectionIndex MakeIndex ()
+		{
+			CollectionIndex index;
+			index.AddTracks ({
+					{ 1, 10, 100, { "Pink Floyd", "The Wall", "Another Brick in the Wall", "1979" } },
+					{ 2, 10, 100, { "Pink Floyd", "The Wall", "Comfortably Numb", "1979" } },
+					{ 3, 20, 200, { "AC/DC", "Back in Black", "Hells Bells", "1980" } },
+					{ 4, 30, 300, { "坂本龍一", "音楽図鑑", "羽の林で", "1984" } },
+					{ 5, 40, 400, { "...And You Will Know Us by the Trail of Dead", "Source Tags & Codes", "Homage" } }
+				});
+			return index;
+		}
+	}
+
+	void CollectionIndexTest::testPrefixIntersection ()
+	{
+		const auto& index = MakeIndex ();
+
+		const auto& wall = index.Find ("wal");
+		QCOMPARE (wall.Tracks_, (QVector<int> { 1, 2 }));
+		QCOMPARE (wall.Albums_, (QVector<int> { 10 }));
+		QCOMPARE (wall.Artists_, (QVector<int> { 100 }));
+
+		QCOMPARE (index.Find ("PINK numb").Tracks_, (QVector<int> { 2 }));
+		QCOMPARE (index.Find ("numb bells").Tracks_, QVector<int> {});
+		QCOMPARE (index.Find ("ac dc").Tracks_, (QVector<int> { 3 }));
+		QCOMPARE (index.Find ("in").Tracks_, (QVector<int> { 1, 3 }));
+		QCOMPARE (index.Find ("  ").Tracks_, QVector<int> {});
+	}
+
+	void CollectionIndexTest::testRemove ()
+	{
+		auto index = MakeIndex ();
+		const auto generation = index.GetGeneration ();
+
+		index.RemoveTrack (1);
+		QVERIFY (index.GetGeneration () != generation);
+		QCOMPARE (index.Find ("wall").Tracks_, (QVector<int> { 2 }));
+		QCOMPARE (index.Find ("brick").Tracks_, QVector<int> {});
+
+		index.RemoveTrack (2);
+		QCOMPARE (index.Find ("wall").Artists_, QVector<int> {});
+
+		index.RemoveTrack (42);
+		QCOMPARE (index.Find ("bells").Tracks_, (QVector<int> { 3 }));
+	}
+
+	void CollectionIndexTest::testReAdd ()
+	{
+		auto index = MakeIndex ();
+		index.AddTracks ({ { 2, 10, 100, { "Pink Floyd", "The Wall", "Hey You", "1979" } } });
+
+		QCOMPARE (index.Find ("numb").Tracks_, QVector<int> {});
+		QCOMPARE (index.Find ("hey").Tracks_, (QVector<int> { 2 }));
+		QCOMPARE (index.Find ("wall").Tracks_, (QVector<int> { 1, 2 }));
+	}
+
+	void CollectionIndexTest::testPunctuationQuery ()
+	{
+		const auto& index = MakeIndex ();
+
+		QCOMPARE (index.Find ("...").Tracks_, (QVector<int> { 5 }));
+		QCOMPARE (index.Find ("&").Tracks_, (QVector<int> { 5 }));
+		QCOMPARE (index.Find ("/").Tracks_, (QVector<int> { 3 }));
+		QCOMPARE (index.Find ("#").Tracks_, QVector<int> {});
+	}
+
+	void CollectionIndexTest::testNonSpacedScript ()
+	{
+		const auto& index = MakeIndex ();
+
+		// Words in the middle of a CJK string aren't token prefixes.
+		QCOMPARE (index.Find ("龍一").Tracks_, (QVector<int> { 4 }));
+		QCOMPARE (index.Find ("図鑑").Albums_, (QVector<int> { 30 }));
+		QCOMPARE (index.Find ("林").Artists_, (QVector<int> { 300 }));
+		QCOMPARE (index.Find ("坂本").Tracks_, (QVector<int> { 4 }));
+		QCOMPARE (index.Find ("細野").Tracks_, QVector<int> {});
+	}
+}
+}
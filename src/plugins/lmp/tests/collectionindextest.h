@@ -1,6 +1,6 @@
 /**********************************************************************
  * LeechCraft - modular cross-platform feature rich internet client.
- * Copyright (C) 2010-2013  Oleg Linkin <MaledictusDeMagog@gmail.com>
+ * Copyright (C) 2006-2014  Georg Rudoy
  *
  * Boost Software License - Version 1.0 - August 17th, 2003
  *
@@ -27,36 +27,24 @@
  * DEALINGS IN THE SOFTWARE.
  **********************************************************************/
 
+
 #pragma once
 
-#include <QIODevice>
-#include <QFile>
+#include <QObject>
 
 namespace LeechCraft
 {
-namespace NetStoreManager
-{
-namespace DBox
+namespace LMP
 {
-	class ChunkIODevice : public QIODevice
+	class CollectionIndexTest : public QObject
 	{
 		Q_OBJECT
-
-		QFile File_;
-		const int ChunkSize_;
-
-	public:
-		ChunkIODevice (const QString& path, QObject *parent = 0);
-
-		bool atEnd () const override;
-		bool open (OpenMode mode) override;
-		void close () override;
-
-		QByteArray GetNextChunk ();
-	protected:
-		qint64 readData (char *data, qint64 maxlen) override;
-		qint64 writeData (const char *data, qint64 len) override;
+	private slots:
+		void testPrefixIntersection ();
+		void testRemove ();
+		void testReAdd ();
+		void testPunctuationQuery ();
+		void testNonSpacedScript ();
 	};
 }
 }
-}
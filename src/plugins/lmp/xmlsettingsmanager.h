@@ -30,6 +30,7 @@
 #pragma once
 
 #include <xmlsettingsdialog/basesettingsmanager.h>
+#include <xmlsettingsdialog/settinghandle.h>
 
 namespace LeechCraft
 {
@@ -41,6 +42,9 @@ namespace LMP
 
 		XmlSettingsManager ();
 	public:
+		Util::SettingHandle<bool> EnableLocalTagsRecoding_ { this, "EnableLocalTagsRecoding", false };
+		Util::SettingHandle<QString> TagsRecodingRegion_ { this, "TagsRecodingRegion" };
+
 		static XmlSettingsManager& Instance ();
 	protected:
 		virtual QSettings* BeginSettings () const;
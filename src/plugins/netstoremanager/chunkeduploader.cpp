@@ -0,0 +1,359 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+
+#include "chunkeduploader.h"
+#include <algorithm>
+#include <QFile>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+#include <QtDebug>
+#include <util/sll/slotclosure.h>
+#include <util/sll/delayedexecutor.h>
+
+namespace LeechCraft
+{
+namespace NetStoreManager
+{
+	ChunkedUploader::ChunkedUploader (QNetworkAccessManager *nam, int maxParallel, QObject *parent)
+	: QObject { parent }
+	, NAM_ { nam }
+	, MaxParallel_ { std::max (maxParallel, 1) }
+	{
+	}
+
+	ChunkedUploader::~ChunkedUploader ()
+	{
+		for (auto& job : Jobs_)
+			DropReply (job);
+	}
+
+	void ChunkedUploader::SetRetryPolicy (int maxRetries, int delay)
+	{
+		MaxRetries_ = maxRetries;
+		RetryDelay_ = delay;
+	}
+
+	void ChunkedUploader::Schedule (const QString& path, const Starter_f& starter)
+	{
+		if (IsScheduled (path))
+		{
+			qWarning () << Q_FUNC_INFO
+					<< path
+					<< "is already being uploaded";
+			return;
+		}
+
+		Scheduled_.append ({ path, starter });
+		RotateQueue ();
+	}
+
+	void ChunkedUploader::Run (const QString& path, const std::shared_ptr<ChunkedUploadProtocol>& protocol)
+	{
+		if (!Starting_.removeOne (path))
+		{
+			qWarning () << Q_FUNC_INFO
+					<< path
+					<< "hasn't been started";
+			return;
+		}
+
+		const auto file = std::make_shared<QFile> (path);
+		if (!file->open (QIODevice::ReadOnly))
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unable to open"
+					<< path
+					<< file->errorString ();
+			emit uploadError (tr ("Unable to open file: %1.")
+						.arg (file->errorString ()),
+					path);
+			RotateQueue ();
+			return;
+		}
+
+		const auto total = file->size ();
+		Jobs_ [path] = Job
+		{
+			++LastJobID_,
+			protocol,
+			file,
+			total,
+			0,
+			std::max<qint64> (protocol->GetChunkSize (total), 1),
+			false,
+			0,
+			nullptr
+		};
+
+		SendNext (path);
+	}
+
+	void ChunkedUploader::Abort (const QString& path, const QString& error)
+	{
+		bool found = Starting_.removeOne (path);
+
+		for (auto i = Scheduled_.begin (); i != Scheduled_.end (); )
+			if (i->first == path)
+			{
+				i = Scheduled_.erase (i);
+				found = true;
+			}
+			else
+				++i;
+
+		const auto pos = Jobs_.find (path);
+		if (pos != Jobs_.end ())
+		{
+			DropReply (*pos);
+			Jobs_.erase (pos);
+			found = true;
+		}
+
+		if (!found)
+			return;
+
+		emit uploadError (error, path);
+		RotateQueue ();
+	}
+
+	bool ChunkedUploader::IsScheduled (const QString& path) const
+	{
+		return Jobs_.contains (path) ||
+				Starting_.contains (path) ||
+				std::any_of (Scheduled_.begin (), Scheduled_.end (),
+						[&path] (const QPair<QString, Starter_f>& pair) { return pair.first == path; });
+	}
+
+	void ChunkedUploader::RotateQueue ()
+	{
+		while (!Scheduled_.isEmpty () &&
+				Jobs_.size () + Starting_.size () < MaxParallel_)
+		{
+			const auto pair = Scheduled_.takeFirst ();
+			Starting_ << pair.first;
+			pair.second ();
+		}
+	}
+
+	void ChunkedUploader::Resume (const QString& path)
+	{
+		const auto pos = Jobs_.find (path);
+		if (pos == Jobs_.end ())
+			return;
+
+		const auto protocol = pos->Protocol_;
+		const auto total = pos->Total_;
+		if (const auto status = protocol->MakeStatusRequest (total))
+			Send (path, *status, {}, false,
+					[protocol, total] (QNetworkReply *reply)
+						{ return protocol->HandleStatusReply (reply, total); });
+		else
+			SendNext (path);
+	}
+
+	void ChunkedUploader::SendNext (const QString& path)
+	{
+		auto& job = Jobs_ [path];
+		if (job.Acked_ < job.Total_ || !job.SentAny_)
+		{
+			SendChunk (path);
+			return;
+		}
+
+		const auto protocol = job.Protocol_;
+		if (const auto commit = protocol->MakeCommitRequest (job.Total_))
+			Send (path, *commit, {}, false,
+					[protocol] (QNetworkReply *reply) { return protocol->HandleCommitReply (reply); });
+		else
+			Abort (path, tr ("The server has received the whole file but hasn't completed the upload."));
+	}
+
+	void ChunkedUploader::SendChunk (const QString& path)
+	{
+		auto& job = Jobs_ [path];
+
+		const auto offset = job.Acked_;
+		const auto size = std::min (job.ChunkSize_, job.Total_ - offset);
+		const auto total = job.Total_;
+
+		if (!job.File_->seek (offset))
+		{
+			Abort (path, tr ("Unable to read file: %1.").arg (job.File_->errorString ()));
+			return;
+		}
+
+		const auto& data = job.File_->read (size);
+		if (data.size () != size)
+		{
+			Abort (path, tr ("Unable to read file: %1.").arg (job.File_->errorString ()));
+			return;
+		}
+
+		job.SentAny_ = true;
+
+		const auto protocol = job.Protocol_;
+		Send (path, protocol->MakeChunkRequest (offset, size, total), data, size > 0,
+				[protocol, offset, size, total] (QNetworkReply *reply)
+					{ return protocol->HandleChunkReply (reply, offset, size, total); });
+	}
+
+	void ChunkedUploader::Send (const QString& path,
+			const ChunkedUploadProtocol::Request& request,
+			const QByteArray& data, bool expectsProgress, const Handler_f& handler)
+	{
+		const auto reply = request.Method_ == ChunkedUploadProtocol::Method::Put ?
+				NAM_->put (request.Request_, data) :
+				NAM_->post (request.Request_, data);
+		Jobs_ [path].Reply_ = reply;
+		Reply2Path_ [reply] = path;
+
+		connect (reply,
+				SIGNAL (uploadProgress (qint64, qint64)),
+				this,
+				SLOT (handleUploadProgress (qint64, qint64)));
+
+		new Util::SlotClosure<Util::DeleteLaterPolicy>
+		{
+			[this, reply, path, expectsProgress, handler]
+			{
+				reply->deleteLater ();
+				Reply2Path_.remove (reply);
+
+				const auto pos = Jobs_.find (path);
+				if (pos == Jobs_.end () || pos->Reply_ != reply)
+					return;
+
+				pos->Reply_ = nullptr;
+				HandleResult (path, handler (reply), expectsProgress);
+			},
+			reply,
+			SIGNAL (finished ()),
+			reply
+		};
+	}
+
+	void ChunkedUploader::HandleResult (const QString& path,
+			const ChunkedUploadProtocol::Result& result, bool expectsProgress)
+	{
+		using Status = ChunkedUploadProtocol::Result::Status;
+
+		auto& job = Jobs_ [path];
+		switch (result.Status_)
+		{
+		case Status::Acknowledged:
+			if (result.Offset_ > job.Acked_)
+				job.Retries_ = 0;
+			else if (expectsProgress && ++job.Retries_ > MaxRetries_)
+			{
+				Abort (path, tr ("The server doesn't accept the uploaded data."));
+				return;
+			}
+			job.Acked_ = std::min (result.Offset_, job.Total_);
+			SendNext (path);
+			break;
+		case Status::Finished:
+			Finish (path, result.Body_);
+			break;
+		case Status::Retry:
+			ScheduleRetry (path);
+			break;
+		case Status::Failed:
+			Abort (path, result.Error_);
+			break;
+		}
+	}
+
+	void ChunkedUploader::ScheduleRetry (const QString& path)
+	{
+		const auto pos = Jobs_.find (path);
+		if (pos == Jobs_.end ())
+			return;
+
+		auto& job = *pos;
+		if (++job.Retries_ > MaxRetries_)
+		{
+			Abort (path, tr ("Upload has failed after %n retries.", 0, MaxRetries_));
+			return;
+		}
+
+		const auto delay = RetryDelay_ << (job.Retries_ - 1);
+		qDebug () << Q_FUNC_INFO
+				<< "resuming"
+				<< path
+				<< "from"
+				<< job.Acked_
+				<< "in"
+				<< delay
+				<< "ms";
+		new Util::DelayedExecutor
+		{
+			[this, path, id = job.ID_]
+			{
+				const auto pos = Jobs_.find (path);
+				if (pos != Jobs_.end () && pos->ID_ == id)
+					Resume (path);
+			},
+			delay,
+			this
+		};
+	}
+
+	void ChunkedUploader::Finish (const QString& path, const QByteArray& body)
+	{
+		Jobs_.remove (path);
+
+		emit finished (body, path);
+		RotateQueue ();
+	}
+
+	void ChunkedUploader::DropReply (Job& job)
+	{
+		const auto reply = job.Reply_;
+		if (!reply)
+			return;
+
+		job.Reply_ = nullptr;
+		Reply2Path_.remove (reply);
+		reply->disconnect ();
+		reply->abort ();
+		reply->deleteLater ();
+	}
+
+	void ChunkedUploader::handleUploadProgress (qint64 sent, qint64)
+	{
+		const auto reply = qobject_cast<QNetworkReply*> (sender ());
+		const auto pos = Jobs_.find (Reply2Path_.value (reply));
+		if (pos == Jobs_.end () || pos->Reply_ != reply)
+			return;
+
+		emit uploadProgress (pos->Acked_ + sent, pos->Total_, pos.key ());
+	}
+}
+}
@@ -0,0 +1,140 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+
+#pragma once
+
+#include <functional>
+#include <memory>
+#include <QObject>
+#include <QHash>
+#include <QList>
+#include <QPair>
+#include "chunkeduploadprotocol.h"
+
+class QFile;
+class QNetworkAccessManager;
+class QNetworkReply;
+
+namespace LeechCraft
+{
+namespace NetStoreManager
+{
+	/** @brief Uploads files in chunks with resuming and a parallelism
+	 * limit.
+	 *
+	 * The uploads are identified by the local file path, just like in
+	 * the rest of NetStoreManager.
+	 *
+	 * An upload is first scheduled via Schedule(). Once there is a free
+	 * slot, the starter function is invoked, which is expected to set up
+	 * the upload session (if the backend needs one) and then call Run()
+	 * with the protocol object, or Abort() if that fails.
+	 *
+	 * The file is read from disk one chunk at a time. If a chunk fails
+	 * transiently, the upload is resumed after a delay from the offset
+	 * acknowledged by the server.
+	 */
+	class ChunkedUploader : public QObject
+	{
+		Q_OBJECT
+
+		QNetworkAccessManager * const NAM_;
+		const int MaxParallel_;
+
+		int MaxRetries_ = 5;
+		int RetryDelay_ = 1000;
+
+		using Starter_f = std::function<void ()>;
+		QList<QPair<QString, Starter_f>> Scheduled_;
+		QList<QString> Starting_;
+
+		/* Identifies the job across the delayed retries, since the
+		 * upload of the same path may be aborted and started anew in
+		 * the meanwhile.
+		 */
+		quint64 LastJobID_ = 0;
+
+		struct Job
+		{
+			quint64 ID_;
+			std::shared_ptr<ChunkedUploadProtocol> Protocol_;
+			std::shared_ptr<QFile> File_;
+			qint64 Total_;
+			qint64 Acked_;
+			qint64 ChunkSize_;
+			bool SentAny_;
+			int Retries_;
+			QNetworkReply *Reply_;
+		};
+		QHash<QString, Job> Jobs_;
+		QHash<QNetworkReply*, QString> Reply2Path_;
+	public:
+		ChunkedUploader (QNetworkAccessManager *nam, int maxParallel, QObject *parent = nullptr);
+		~ChunkedUploader ();
+
+		/** @brief Sets the retries policy for transient errors.
+		 *
+		 * @param[in] maxRetries The number of retries in a row for an
+		 * upload before giving up.
+		 * @param[in] delay The delay before the first retry in
+		 * milliseconds. It is doubled for every subsequent retry.
+		 */
+		void SetRetryPolicy (int maxRetries, int delay);
+
+		void Schedule (const QString& path, const Starter_f& starter);
+		void Run (const QString& path, const std::shared_ptr<ChunkedUploadProtocol>& protocol);
+		void Abort (const QString& path, const QString& error);
+
+		bool IsScheduled (const QString& path) const;
+	private:
+		void RotateQueue ();
+
+		void Resume (const QString&);
+		void SendNext (const QString&);
+		void SendChunk (const QString&);
+
+		using Handler_f = std::function<ChunkedUploadProtocol::Result (QNetworkReply*)>;
+		void Send (const QString&, const ChunkedUploadProtocol::Request&,
+				const QByteArray& data, bool expectsProgress, const Handler_f&);
+
+		void HandleResult (const QString&, const ChunkedUploadProtocol::Result&,
+				bool expectsProgress);
+		void ScheduleRetry (const QString&);
+		void Finish (const QString&, const QByteArray&);
+		void DropReply (Job&);
+	private slots:
+		void handleUploadProgress (qint64, qint64);
+	signals:
+		void uploadProgress (qint64 sent, qint64 total, const QString& filePath);
+		void uploadError (const QString& error, const QString& filePath);
+		void finished (const QByteArray& reply, const QString& filePath);
+	};
+}
+}
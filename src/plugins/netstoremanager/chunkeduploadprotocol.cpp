@@ -0,0 +1,180 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+
+#include "chunkeduploadprotocol.h"
+#include <algorithm>
+#include <QNetworkReply>
+#include <QtDebug>
+
+namespace LeechCraft
+{
+namespace NetStoreManager
+{
+	ChunkedUploadProtocol::Result ChunkedUploadProtocol::Result::Acknowledged (qint64 offset)
+	{
+		return { Status::Acknowledged, offset, {}, {} };
+	}
+
+	ChunkedUploadProtocol::Result ChunkedUploadProtocol::Result::Finished (const QByteArray& body)
+	{
+		return { Status::Finished, 0, body, {} };
+	}
+
+	ChunkedUploadProtocol::Result ChunkedUploadProtocol::Result::Retry ()
+	{
+		return { Status::Retry, 0, {}, {} };
+	}
+
+	ChunkedUploadProtocol::Result ChunkedUploadProtocol::Result::Failed (const QString& error)
+	{
+		return { Status::Failed, 0, {}, error };
+	}
+
+	boost::optional<ChunkedUploadProtocol::Request> ChunkedUploadProtocol::MakeStatusRequest (qint64)
+	{
+		return {};
+	}
+
+	ChunkedUploadProtocol::Result ChunkedUploadProtocol::HandleStatusReply (QNetworkReply*, qint64)
+	{
+		return Result::Failed ("status requests are not supported");
+	}
+
+	boost::optional<ChunkedUploadProtocol::Request> ChunkedUploadProtocol::MakeCommitRequest (qint64)
+	{
+		return {};
+	}
+
+	ChunkedUploadProtocol::Result ChunkedUploadProtocol::HandleCommitReply (QNetworkReply*)
+	{
+		return Result::Failed ("commit requests are not supported");
+	}
+
+	bool ChunkedUploadProtocol::IsTransientError (QNetworkReply *reply)
+	{
+		const auto& codeVar = reply->attribute (QNetworkRequest::HttpStatusCodeAttribute);
+		if (!codeVar.isValid ())
+			return reply->error () != QNetworkReply::NoError;
+
+		const auto code = codeVar.toInt ();
+		return code >= 500 || code == 429;
+	}
+
+	const qint64 ContentRangeUploadProtocol::Granularity;
+
+	ContentRangeUploadProtocol::ContentRangeUploadProtocol (const QUrl& sessionUrl,
+			const QByteArray& contentType, qint64 chunkSize)
+	: SessionUrl_ { sessionUrl }
+	, ContentType_ { contentType }
+	, ChunkSize_ { std::max (Granularity, chunkSize / Granularity * Granularity) }
+	{
+	}
+
+	qint64 ContentRangeUploadProtocol::GetChunkSize (qint64) const
+	{
+		return ChunkSize_;
+	}
+
+	ChunkedUploadProtocol::Request ContentRangeUploadProtocol::MakeChunkRequest (qint64 offset,
+			qint64 size, qint64 total)
+	{
+		QNetworkRequest request { SessionUrl_ };
+		request.setPriority (QNetworkRequest::LowPriority);
+		request.setHeader (QNetworkRequest::ContentTypeHeader, ContentType_);
+		request.setHeader (QNetworkRequest::ContentLengthHeader, size);
+		request.setRawHeader ("Content-Range", size ?
+				QString ("bytes %1-%2/%3")
+					.arg (offset)
+					.arg (offset + size - 1)
+					.arg (total).toLatin1 () :
+				QString ("bytes */%1").arg (total).toLatin1 ());
+		return { request, Method::Put };
+	}
+
+	ChunkedUploadProtocol::Result ContentRangeUploadProtocol::HandleChunkReply (QNetworkReply *reply,
+			qint64, qint64, qint64)
+	{
+		return HandleRangeReply (reply);
+	}
+
+	boost::optional<ChunkedUploadProtocol::Request> ContentRangeUploadProtocol::MakeStatusRequest (qint64 total)
+	{
+		QNetworkRequest request { SessionUrl_ };
+		request.setHeader (QNetworkRequest::ContentLengthHeader, 0);
+		request.setRawHeader ("Content-Range", QString ("bytes */%1").arg (total).toLatin1 ());
+		return Request { request, Method::Put };
+	}
+
+	ChunkedUploadProtocol::Result ContentRangeUploadProtocol::HandleStatusReply (QNetworkReply *reply, qint64)
+	{
+		return HandleRangeReply (reply);
+	}
+
+	ChunkedUploadProtocol::Result ContentRangeUploadProtocol::HandleRangeReply (QNetworkReply *reply)
+	{
+		if (IsTransientError (reply))
+			return Result::Retry ();
+
+		const auto code = reply->attribute (QNetworkRequest::HttpStatusCodeAttribute).toInt ();
+		switch (code)
+		{
+		case 200:
+		case 201:
+			return Result::Finished (reply->readAll ());
+		case 308:
+		{
+			// The header looks like "bytes=0-12345" and is absent if nothing is received.
+			const auto& range = reply->rawHeader ("Range");
+			const auto dashPos = range.lastIndexOf ('-');
+			if (dashPos == -1)
+				return Result::Acknowledged (0);
+
+			bool ok = false;
+			const auto last = range.mid (dashPos + 1).toLongLong (&ok);
+			if (!ok)
+			{
+				qWarning () << Q_FUNC_INFO
+						<< "unable to parse range"
+						<< range;
+				return Result::Retry ();
+			}
+			return Result::Acknowledged (last + 1);
+		}
+		case 404:
+		case 410:
+			return Result::Failed (QObject::tr ("Upload session has expired."));
+		default:
+			return Result::Failed (QObject::tr ("Unexpected server reply: %1 %2.")
+					.arg (code)
+					.arg (reply->errorString ()));
+		}
+	}
+}
+}
@@ -0,0 +1,171 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+
+#pragma once
+
+#include <boost/optional.hpp>
+#include <QNetworkRequest>
+#include <QUrl>
+
+class QNetworkReply;
+
+namespace LeechCraft
+{
+namespace NetStoreManager
+{
+	/** @brief Describes the wire protocol of a chunked upload.
+	 *
+	 * ChunkedUploader drives the upload and uses the instance of this
+	 * class to build the requests and to interpret the replies, so each
+	 * storage backend only needs to describe its own flavour of the
+	 * protocol.
+	 *
+	 * The protocol object belongs to a single upload and may keep the
+	 * state of that upload, like the session ID.
+	 */
+	class ChunkedUploadProtocol
+	{
+	public:
+		enum class Method
+		{
+			Put,
+			Post
+		};
+
+		struct Request
+		{
+			QNetworkRequest Request_;
+			Method Method_;
+		};
+
+		struct Result
+		{
+			enum class Status
+			{
+				/** The server has the data up to Offset_.
+				 */
+				Acknowledged,
+
+				/** The upload is complete, Body_ contains the reply.
+				 */
+				Finished,
+
+				/** A transient error has happened, the upload should
+				 * be resumed later.
+				 */
+				Retry,
+
+				/** A permanent error has happened, Error_ describes it.
+				 */
+				Failed
+			} Status_;
+
+			qint64 Offset_;
+			QByteArray Body_;
+			QString Error_;
+
+			static Result Acknowledged (qint64);
+			static Result Finished (const QByteArray&);
+			static Result Retry ();
+			static Result Failed (const QString&);
+		};
+
+		virtual ~ChunkedUploadProtocol () = default;
+
+		/** @brief Returns the size of chunks for a file of the given size.
+		 */
+		virtual qint64 GetChunkSize (qint64 total) const = 0;
+
+		/** @brief Builds the request sending size bytes at offset.
+		 */
+		virtual Request MakeChunkRequest (qint64 offset, qint64 size, qint64 total) = 0;
+		virtual Result HandleChunkReply (QNetworkReply*, qint64 offset, qint64 size, qint64 total) = 0;
+
+		/** @brief Builds the request querying the acknowledged offset.
+		 *
+		 * It is used to resume an interrupted upload. The default
+		 * implementation returns nothing, so the upload is resumed from
+		 * the last offset acknowledged by the server.
+		 */
+		virtual boost::optional<Request> MakeStatusRequest (qint64 total);
+		virtual Result HandleStatusReply (QNetworkReply*, qint64 total);
+
+		/** @brief Builds the request finalizing the upload, if any.
+		 *
+		 * It is issued once all the data is acknowledged by the server.
+		 * The default implementation returns nothing.
+		 */
+		virtual boost::optional<Request> MakeCommitRequest (qint64 total);
+		virtual Result HandleCommitReply (QNetworkReply*);
+	protected:
+		/** @brief Checks whether the reply has failed transiently.
+		 *
+		 * Network-level errors, 5xx and 429 responses are considered
+		 * transient.
+		 */
+		static bool IsTransientError (QNetworkReply*);
+	};
+
+	/** @brief The resumable upload protocol based on Content-Range.
+	 *
+	 * The data is PUT to the session URL in chunks marked with the
+	 * Content-Range header. The server responds with 308 and the Range
+	 * header for the data received so far, and with 200 or 201 once the
+	 * whole file is received. Sending an empty body with the
+	 * <code>bytes *&#47;total</code> range queries the received range.
+	 *
+	 * This is the protocol used by Google Drive.
+	 */
+	class ContentRangeUploadProtocol : public ChunkedUploadProtocol
+	{
+		const QUrl SessionUrl_;
+		const QByteArray ContentType_;
+		const qint64 ChunkSize_;
+	public:
+		/** @brief Chunk sizes must be multiples of this granularity.
+		 */
+		static const qint64 Granularity = 256 * 1024;
+
+		ContentRangeUploadProtocol (const QUrl& sessionUrl,
+				const QByteArray& contentType,
+				qint64 chunkSize = 32 * Granularity);
+
+		qint64 GetChunkSize (qint64 total) const override;
+
+		Request MakeChunkRequest (qint64 offset, qint64 size, qint64 total) override;
+		Result HandleChunkReply (QNetworkReply*, qint64 offset, qint64 size, qint64 total) override;
+
+		boost::optional<Request> MakeStatusRequest (qint64 total) override;
+		Result HandleStatusReply (QNetworkReply*, qint64 total) override;
+	private:
+		Result HandleRangeReply (QNetworkReply*);
+	};
+}
+}
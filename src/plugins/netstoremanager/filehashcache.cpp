@@ -0,0 +1,305 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+
+#include "filehashcache.h"
+#include <QDataStream>
+#include <QDateTime>
+#include <QFile>
+#include <QFileInfo>
+#include <QSet>
+#include <QtConcurrentMap>
+#include <QtDebug>
+#include <util/sys/savefile.h>
+
+#ifdef Q_OS_UNIX
+#include <sys/stat.h>
+#endif
+
+namespace LeechCraft
+{
+namespace NetStoreManager
+{
+	namespace
+	{
+		const quint8 CacheVersion = 1;
+
+		/** Files are hashed by chunks of this size, so memory usage
+		 * doesn't depend on file sizes.
+		 */
+		const qint64 ChunkSize = 256 * 1024;
+
+		/** Files modified less than this number of milliseconds before
+		 * they've been hashed aren't cached: they might be changed again
+		 * without their modification time changing.
+		 */
+		const qint64 RacyInterval = 2000;
+
+		bool operator== (const FileHashCache::FileStamp& s1, const FileHashCache::FileStamp& s2)
+		{
+			return s1.Inode_ == s2.Inode_ &&
+					s1.Size_ == s2.Size_ &&
+					s1.MTime_ == s2.MTime_;
+		}
+
+		struct HashResult
+		{
+			QString Path_;
+			FileHashCache::FileStamp Stamp_;
+			QByteArray Hash_;
+			qint64 HashedAt_;
+		};
+
+		HashResult HashFile (const QFileInfo& fi, QCryptographicHash::Algorithm algo)
+		{
+			HashResult result { fi.absoluteFilePath (), FileHashCache::GetStamp (fi), {}, 0 };
+			result.HashedAt_ = QDateTime::currentMSecsSinceEpoch ();
+
+			QFile file { result.Path_ };
+			if (!file.open (QIODevice::ReadOnly))
+			{
+				qWarning () << Q_FUNC_INFO
+						<< "unable to open file for hash calculation"
+						<< result.Path_
+						<< file.errorString ();
+				return result;
+			}
+
+			QCryptographicHash hash { algo };
+			QByteArray buffer;
+			buffer.resize (ChunkSize);
+			qint64 read = 0;
+			while ((read = file.read (buffer.data (), ChunkSize)) > 0)
+				hash.addData (buffer.constData (), read);
+
+			if (read < 0)
+			{
+				qWarning () << Q_FUNC_INFO
+						<< "error reading"
+						<< result.Path_
+						<< file.errorString ();
+				return result;
+			}
+
+			result.Hash_ = hash.result ();
+			return result;
+		}
+
+		QDataStream& operator<< (QDataStream& out, const FileHashCache::FileStamp& stamp)
+		{
+			return out << stamp.Inode_ << stamp.Size_ << stamp.MTime_;
+		}
+
+		QDataStream& operator>> (QDataStream& in, FileHashCache::FileStamp& stamp)
+		{
+			return in >> stamp.Inode_ >> stamp.Size_ >> stamp.MTime_;
+		}
+	}
+
+	FileHashCache::FileHashCache (const QString& path, QCryptographicHash::Algorithm algo)
+	: Path_ { path }
+	, Algo_ { algo }
+	{
+		Load ();
+	}
+
+	QHash<QString, QByteArray> FileHashCache::GetHashes (const QList<QFileInfo>& files)
+	{
+		QHash<QString, QByteArray> result;
+		QList<QFileInfo> toHash;
+
+		for (const auto& fi : files)
+		{
+			const auto& path = fi.absoluteFilePath ();
+			const auto& stamp = GetStamp (fi);
+
+			const auto pos = Entries_.find (path);
+			if (pos != Entries_.end () && pos->Stamp_ == stamp)
+			{
+				result [path] = pos->Hash_;
+				continue;
+			}
+
+			// Renamed or hard-linked files keep their inode.
+			const auto& otherPath = stamp.Inode_ ? Inode2Path_.value (stamp.Inode_) : QString {};
+			const auto otherPos = otherPath.isEmpty () ? Entries_.end () : Entries_.find (otherPath);
+			if (otherPos != Entries_.end () && otherPos->Stamp_ == stamp)
+			{
+				const auto entry = *otherPos;
+				result [path] = entry.Hash_;
+				Insert (path, entry);
+				continue;
+			}
+
+			toHash << fi;
+		}
+
+		if (toHash.isEmpty ())
+			return result;
+
+		const auto algo = Algo_;
+		const auto& hashed = QtConcurrent::blockingMapped<QList<HashResult>> (toHash,
+				std::function<HashResult (QFileInfo)> ([algo] (const QFileInfo& fi) { return HashFile (fi, algo); }));
+		for (const auto& item : hashed)
+		{
+			if (item.Hash_.isEmpty ())
+				continue;
+
+			result [item.Path_] = item.Hash_;
+			if (item.HashedAt_ - item.Stamp_.MTime_ > RacyInterval)
+				Insert (item.Path_, { item.Stamp_, item.Hash_ });
+		}
+
+		return result;
+	}
+
+	void FileHashCache::Prune (const QSet<QString>& alive)
+	{
+		for (auto i = Entries_.begin (); i != Entries_.end (); )
+		{
+			if (alive.contains (i.key ()))
+			{
+				++i;
+				continue;
+			}
+
+			const auto inode = i->Stamp_.Inode_;
+			if (inode && Inode2Path_.value (inode) == i.key ())
+				Inode2Path_.remove (inode);
+
+			i = Entries_.erase (i);
+			IsDirty_ = true;
+		}
+	}
+
+	void FileHashCache::Save ()
+	{
+		if (!IsDirty_)
+			return;
+
+		Util::SaveFile file { Path_ };
+		if (!file.open (QIODevice::WriteOnly))
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unable to open"
+					<< Path_
+					<< file.errorString ();
+			return;
+		}
+
+		QDataStream out { &file };
+		out.setVersion (QDataStream::Qt_4_8);
+		out << CacheVersion
+				<< static_cast<qint32> (Algo_)
+				<< static_cast<quint32> (Entries_.size ());
+		for (auto i = Entries_.begin (), end = Entries_.end (); i != end; ++i)
+			out << i.key () << i->Stamp_ << i->Hash_;
+
+		if (!file.commit ())
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unable to commit"
+					<< Path_
+					<< file.errorString ();
+			return;
+		}
+
+		IsDirty_ = false;
+	}
+
+	FileHashCache::FileStamp FileHashCache::GetStamp (const QFileInfo& fi)
+	{
+		FileStamp stamp;
+		stamp.Size_ = fi.size ();
+		stamp.MTime_ = fi.lastModified ().toMSecsSinceEpoch ();
+#ifdef Q_OS_UNIX
+		struct stat st;
+		if (!stat (QFile::encodeName (fi.absoluteFilePath ()).constData (), &st))
+			stamp.Inode_ = st.st_ino;
+#endif
+		return stamp;
+	}
+
+	void FileHashCache::Load ()
+	{
+		QFile file { Path_ };
+		if (!file.exists ())
+			return;
+
+		if (!file.open (QIODevice::ReadOnly))
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unable to open"
+					<< Path_
+					<< file.errorString ();
+			return;
+		}
+
+		QDataStream in { &file };
+		in.setVersion (QDataStream::Qt_4_8);
+
+		quint8 version = 0;
+		qint32 algo = 0;
+		quint32 count = 0;
+		in >> version >> algo >> count;
+		if (version != CacheVersion ||
+				algo != static_cast<qint32> (Algo_))
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "discarding cache"
+					<< Path_
+					<< "with version"
+					<< version
+					<< "and algorithm"
+					<< algo;
+			IsDirty_ = true;
+			return;
+		}
+
+		for (quint32 i = 0; i < count && in.status () == QDataStream::Ok; ++i)
+		{
+			QString path;
+			Entry entry;
+			in >> path >> entry.Stamp_ >> entry.Hash_;
+			if (in.status () == QDataStream::Ok)
+				Insert (path, entry);
+		}
+
+		IsDirty_ = in.status () != QDataStream::Ok;
+	}
+
+	void FileHashCache::Insert (const QString& path, const Entry& entry)
+	{
+		Entries_ [path] = entry;
+		if (entry.Stamp_.Inode_)
+			Inode2Path_ [entry.Stamp_.Inode_] = path;
+		IsDirty_ = true;
+	}
+}
+}
@@ -0,0 +1,105 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+
+#pragma once
+
+#include <QCryptographicHash>
+#include <QHash>
+#include <QSet>
+#include <QString>
+
+class QFileInfo;
+
+namespace LeechCraft
+{
+namespace NetStoreManager
+{
+	/** @brief Persistent cache of local file content hashes.
+	 *
+	 * Each cached hash is tagged with the inode, size and modification
+	 * time of the file it was computed for, so the file is read again
+	 * only if any of them changes. Files that need hashing are read in
+	 * bounded chunks and hashed in parallel on the global thread pool.
+	 *
+	 * The cache is not thread-safe and is expected to be used from the
+	 * owning Syncer's thread only.
+	 */
+	class FileHashCache
+	{
+	public:
+		struct FileStamp
+		{
+			quint64 Inode_ = 0;
+			qint64 Size_ = -1;
+			qint64 MTime_ = 0;
+		};
+	private:
+		struct Entry
+		{
+			FileStamp Stamp_;
+			QByteArray Hash_;
+		};
+
+		const QString Path_;
+		const QCryptographicHash::Algorithm Algo_;
+
+		QHash<QString, Entry> Entries_;
+		QHash<quint64, QString> Inode2Path_;
+
+		bool IsDirty_ = false;
+	public:
+		FileHashCache (const QString& path, QCryptographicHash::Algorithm algo);
+
+		/** @brief Returns the hashes of the given files.
+		 *
+		 * Files not in the cache or changed since they were hashed are
+		 * rehashed, and the cache is updated accordingly. Files that
+		 * couldn't be read are missing from the returned hash.
+		 *
+		 * @param[in] files The files to hash.
+		 * @return The hashes keyed by absolute file path.
+		 */
+		QHash<QString, QByteArray> GetHashes (const QList<QFileInfo>& files);
+
+		/** @brief Drops the entries for the files not listed in alive.
+		 */
+		void Prune (const QSet<QString>& alive);
+
+		/** @brief Writes the cache to disk if it has been changed.
+		 */
+		void Save ();
+
+		static FileStamp GetStamp (const QFileInfo&);
+	private:
+		void Load ();
+		void Insert (const QString&, const Entry&);
+	};
+}
+}
@@ -42,9 +42,10 @@
 #include <util/sll/either.h>
 #include <util/util.h>
 #include <util/threads/futures.h>
+#include <chunkeduploader.h>
 #include "account.h"
-#include "chunkiodevice.h"
 #include "core.h"
+#include "uploadprotocol.h"
 #include "xmlsettingsmanager.h"
 
 namespace LeechCraft
@@ -71,7 +72,7 @@ namespace DBox
 
 	namespace
 	{
-		const int ChunkUploadBound = 150 * 1024 * 1024;
+		const int MaxParallelUploads = 3;
 	}
 
 	DriveManager::DriveManager (Account *acc, QObject *parent)
@@ -79,7 +80,22 @@ namespace DBox
 	, DirectoryId_ ("application/vnd.google-apps.folder")
 	, Account_ (acc)
 	, SecondRequestIfNoItems_ (true)
+	, Uploader_ (new ChunkedUploader (Core::Instance ().GetProxy ()->GetNetworkAccessManager (),
+			MaxParallelUploads,
+			this))
 	{
+		connect (Uploader_,
+				SIGNAL (uploadProgress (qint64, qint64, QString)),
+				this,
+				SIGNAL (uploadProgress (qint64, qint64, QString)));
+		connect (Uploader_,
+				SIGNAL (uploadError (QString, QString)),
+				this,
+				SIGNAL (uploadError (QString, QString)));
+		connect (Uploader_,
+				SIGNAL (finished (QByteArray, QString)),
+				this,
+				SLOT (handleUploadFinished (QByteArray, QString)));
 	}
 
 	void DriveManager::RequestUserId ()
@@ -145,13 +161,14 @@ namespace DBox
 
 	void DriveManager::Upload (const QString& filePath, const QStringList& parentId)
 	{
-		QString parent = parentId.value (0);
-		auto guard = MakeRunnerGuard ();
-
-		if (QFileInfo (filePath).size () < ChunkUploadBound)
-			ApiCallQueue_ << [this, filePath, parent] () { RequestUpload (filePath, parent); };
-		else
-			ApiCallQueue_ << [this, filePath, parent] () { RequestChunkUpload (filePath, parent); };
+		const auto& parent = parentId.value (0);
+		const auto& target = (parent.isEmpty () ? "/" : parent) + "/" + QFileInfo (filePath).fileName ();
+		Uploader_->Schedule (filePath,
+				[this, filePath, target]
+				{
+					emit uploadStatusChanged (tr ("Uploading..."), filePath);
+					Uploader_->Run (filePath, std::make_shared<UploadProtocol> (Account_, target));
+				});
 	}
 
 	std::shared_ptr<void> DriveManager::MakeRunnerGuard ()
@@ -387,101 +404,6 @@ namespace DBox
 				SLOT (handleMoveItem ()));
 	}
 
-	void DriveManager::RequestUpload (const QString& filePath, const QString& parent)
-	{
-		QFile *file = new QFile (filePath);
-		if (!file->open (QIODevice::ReadOnly))
-		{
-			qWarning () << Q_FUNC_INFO
-					<< "unable to open file: "
-					<< file->errorString ();
-			return;
-		}
-		emit uploadStatusChanged (tr ("Uploading..."), filePath);
-		QFileInfo info (filePath);
-
-		const QUrl url (QString ("https://api-content.dropbox.com/1/files_put/%1/%2?access_token=%3")
-				.arg ("dropbox")
-				.arg ((parent.isEmpty () ? "/" : parent) + "/" + info.fileName ())
-				.arg (Account_->GetAccessToken ()));
-		QNetworkRequest request (url);
-		request.setPriority (QNetworkRequest::LowPriority);
-		request.setHeader (QNetworkRequest::ContentLengthHeader, info.size ());
-		request.setHeader (QNetworkRequest::ContentTypeHeader, "application/json");
-
-		QNetworkReply *reply = Core::Instance ().GetProxy ()->
-				GetNetworkAccessManager ()->put (request, file);
-		file->setParent (reply);
-		Reply2FilePath_ [reply] = filePath;
-		connect (reply,
-				SIGNAL (finished ()),
-				this,
-				SLOT (handleUploadFinished ()));
-		connect (reply,
-				SIGNAL (error (QNetworkReply::NetworkError)),
-				this,
-				SLOT (handleUploadError (QNetworkReply::NetworkError)));
-		connect (reply,
-				SIGNAL (uploadProgress (qint64, qint64)),
-				this,
-				SLOT (handleUploadProgress (qint64, qint64)));
-	}
-
-	void DriveManager::RequestChunkUpload (const QString& filePath, const QString& parent,
-			const QString& uploadId, quint64 offset)
-	{
-		ChunkIODevice *chunkFile = new ChunkIODevice (filePath, this);
-		if (!chunkFile->open (QIODevice::ReadOnly))
-		{
-			qWarning () << Q_FUNC_INFO
-					<< "unable to open file: "
-					<< chunkFile->errorString ();
-			return;
-		}
-		emit uploadStatusChanged (tr ("Uploading..."), filePath);
-
-		QFileInfo info (filePath);
-		QUrl url;
-		if (!chunkFile->atEnd () && uploadId.isEmpty ())
-			url = QString ("https://api-content.dropbox.com/1/chunked_upload?access_token=%1")
-					.arg (Account_->GetAccessToken ());
-		else if (!chunkFile->atEnd ())
-			url = QString ("https://api-content.dropbox.com/1/chunked_upload?access_token=%1&upload_id=%2&offset=%3")
-					.arg (Account_->GetAccessToken ())
-					.arg (uploadId)
-					.arg (offset);
-		else
-			url = QString ("https://api-content.dropbox.com/1/commit_chunked_upload/%1/%2?access_token=%3&upload_id=%4")
-					.arg ("dropbox")
-					.arg ((parent.isEmpty () ? "/" : parent) + "/" + info.fileName ())
-					.arg (Account_->GetAccessToken ())
-					.arg (uploadId);
-
-		QNetworkRequest request (url);
-		request.setPriority (QNetworkRequest::LowPriority);
-		request.setHeader (QNetworkRequest::ContentLengthHeader, info.size ());
-		request.setHeader (QNetworkRequest::ContentTypeHeader, "application/json");
-
-		QNetworkReply *reply = Core::Instance ().GetProxy ()->
-				GetNetworkAccessManager ()->put (request, chunkFile->GetNextChunk ());
-		Reply2FilePath_ [reply] = filePath;
-		Reply2ParentId_ [reply] = parent.isEmpty () ? "/" : parent;
-		if (offset)
-			Reply2Offset_ [reply] = offset;
-		connect (reply,
-				SIGNAL (finished ()),
-				this,
-				SLOT (handleChunkUploadFinished ()));
-		connect (reply,
-				SIGNAL (error (QNetworkReply::NetworkError)),
-				this,
-				SLOT (handleUploadError (QNetworkReply::NetworkError)));
-		connect (reply,
-				SIGNAL (uploadProgress (qint64, qint64)),
-				this,
-				SLOT (handleUploadProgress (qint64, qint64)));
-	}
-
 	QUrl DriveManager::GenerateDownloadUrl (const QString& id) const
 	{
 		return QUrl (QString ("https://api-content.dropbox.com/1/files/%1/%2?access_token=%3")
@@ -577,92 +499,20 @@ namespace DBox
 		RefreshListing (Reply2Id_.take (reply).toUtf8 ());
 	}
 
-	void DriveManager::handleUploadFinished ()
+	void DriveManager::handleUploadFinished (const QByteArray& data, const QString& path)
 	{
-		QNetworkReply *reply = qobject_cast<QNetworkReply*> (sender ());
-		if (!reply)
-			return;
-		reply->deleteLater ();
-
-		const auto& res = Util::ParseJson (reply, Q_FUNC_INFO);
+		const auto& res = Util::ParseJson (data, Q_FUNC_INFO);
 		if (res.isNull ())
-			return;
-
-		const auto& map = res.toMap ();
-		const auto& id = map ["id"].toString ();
-
-		if (map.contains ("error"))
 		{
-			ParseError (map);
+			emit uploadError (tr ("Unable to parse server reply."), path);
 			return;
 		}
 
 		qDebug () << Q_FUNC_INFO
 				<< "file uploaded successfully";
-		emit gotNewItem (CreateDBoxItem (res));
-		emit finished (id, Reply2FilePath_.take (reply));
-
-	}
-
-	void DriveManager::handleChunkUploadFinished ()
-	{
-		QNetworkReply *reply = qobject_cast<QNetworkReply*> (sender ());
-		if (!reply)
-			return;
-		reply->deleteLater ();
-
-		const auto& res = Util::ParseJson (reply, Q_FUNC_INFO);
-		if (res.isNull ())
-			return;
-
-		const auto& map = res.toMap ();
-		if (!map.contains ("error"))
-		{
-			if (map.contains ("offset"))
-			{
-				const quint64 offset = map ["offset"].toULongLong ();
-				const QString uploadId = map ["upload_id"].toString ();
-				RequestChunkUpload (Reply2FilePath_.take (reply),
-						Reply2ParentId_.take (reply),
-						uploadId,
-						offset);
-			}
-			else if (map.contains ("path"))
-			{
-				qDebug () << Q_FUNC_INFO
-						<< "file uploaded successfully";
-				emit gotNewItem (CreateDBoxItem (res));
-				emit finished (Reply2Id_.take (reply), Reply2FilePath_.take (reply));
-			}
-			return;
-		}
-
-		ParseError (map);
-	}
-
-	void DriveManager::handleUploadProgress (qint64 uploaded, qint64 total)
-	{
-		QNetworkReply *reply = qobject_cast<QNetworkReply*> (sender ());
-		if (!reply)
-			return;
-
-		const auto& path = Reply2FilePath_ [reply];
-		const quint64 offset = Reply2Offset_ [reply];
-		QFileInfo fi (path);
-		if (fi.size () < ChunkUploadBound)
-			emit uploadProgress (uploaded, total, path);
-		else
-			emit uploadProgress (uploaded + offset, fi.size (), path);
-	}
-
-	void DriveManager::handleUploadError (QNetworkReply::NetworkError)
-	{
-		QNetworkReply *reply = qobject_cast<QNetworkReply*> (sender ());
-		if (!reply)
-			return;
-		reply->deleteLater ();
-
-		emit uploadError ("Error", Reply2FilePath_.take (reply));
+		const auto& item = CreateDBoxItem (res);
+		emit gotNewItem (item);
+		emit finished (item.Id_, path);
 	}
 }
 }
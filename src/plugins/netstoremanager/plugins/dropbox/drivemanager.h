@@ -49,11 +49,11 @@ namespace LeechCraft
 namespace NetStoreManager
 {
 struct StorageItem;
+class ChunkedUploader;
 
 namespace DBox
 {
 	class Account;
-	class ChunkIODevice;
 
 	struct DBoxItem
 	{
@@ -94,9 +94,9 @@ namespace DBox
 		QQueue<std::function<void ()>> ApiCallQueue_;
 		QHash<QNetworkReply*, QString> Reply2Id_;
 		QHash<QNetworkReply*, QString> Reply2FilePath_;
-		QHash<QNetworkReply*, QString> Reply2ParentId_;
-		QHash<QNetworkReply*, quint64> Reply2Offset_;
 		bool SecondRequestIfNoItems_;
+
+		ChunkedUploader * const Uploader_;
 	public:
 		DriveManager (Account *acc, QObject *parent = 0);
 
@@ -127,10 +127,6 @@ namespace DBox
 		void RequestCopyItem (const QString& id, const QString& parentId);
 		void RequestMoveItem (const QString& id, const QString& parentId);
 
-		void RequestUpload (const QString& filePath, const QString& parent);
-		void RequestChunkUpload (const QString& filePath, const QString& parent,
-				const QString& uploadId = {}, quint64 offset = 0);
-
 		void ParseError (const QVariantMap& map);
 	private slots:
 		void handleGotAccountInfo ();
@@ -138,10 +134,7 @@ namespace DBox
 		void handleRequestEntryRemoving ();
 		void handleCopyItem ();
 		void handleMoveItem ();
-		void handleUploadFinished ();
-		void handleChunkUploadFinished ();
-		void handleUploadProgress (qint64 uploaded, qint64 total);
-		void handleUploadError (QNetworkReply::NetworkError error);
+		void handleUploadFinished (const QByteArray& reply, const QString& filePath);
 	signals:
 		void uploadProgress (qint64 sent, qint64 total, const QString& filePath);
 		void uploadStatusChanged (const QString& status, const QString& filePath);
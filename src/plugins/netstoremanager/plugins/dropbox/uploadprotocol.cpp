@@ -0,0 +1,144 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+
+#include "uploadprotocol.h"
+#include <algorithm>
+#include <QNetworkReply>
+#include <QtDebug>
+#include <util/sll/parsejson.h>
+#include "account.h"
+
+namespace LeechCraft
+{
+namespace NetStoreManager
+{
+namespace DBox
+{
+	namespace
+	{
+		const qint64 ChunkSize = 4 * 1024 * 1024;
+	}
+
+	UploadProtocol::UploadProtocol (Account *account, const QString& targetPath)
+	: Account_ { account }
+	, TargetPath_ { targetPath }
+	{
+	}
+
+	qint64 UploadProtocol::GetChunkSize (qint64 total) const
+	{
+		return IsSingleShot (total) ? std::max<qint64> (total, 1) : ChunkSize;
+	}
+
+	ChunkedUploadProtocol::Request UploadProtocol::MakeChunkRequest (qint64 offset, qint64 size, qint64 total)
+	{
+		QUrl url;
+		if (IsSingleShot (total))
+			url = QString ("https://api-content.dropbox.com/1/files_put/%1/%2?access_token=%3")
+					.arg ("dropbox")
+					.arg (TargetPath_)
+					.arg (Account_->GetAccessToken ());
+		else if (UploadId_.isEmpty ())
+			url = QString ("https://api-content.dropbox.com/1/chunked_upload?access_token=%1")
+					.arg (Account_->GetAccessToken ());
+		else
+			url = QString ("https://api-content.dropbox.com/1/chunked_upload?access_token=%1&upload_id=%2&offset=%3")
+					.arg (Account_->GetAccessToken ())
+					.arg (UploadId_)
+					.arg (offset);
+
+		QNetworkRequest request { url };
+		request.setPriority (QNetworkRequest::LowPriority);
+		request.setHeader (QNetworkRequest::ContentLengthHeader, size);
+		request.setHeader (QNetworkRequest::ContentTypeHeader, "application/octet-stream");
+		return { request, Method::Put };
+	}
+
+	ChunkedUploadProtocol::Result UploadProtocol::HandleChunkReply (QNetworkReply *reply, qint64, qint64, qint64 total)
+	{
+		if (IsSingleShot (total))
+			return HandleMetadataReply (reply);
+
+		if (IsTransientError (reply))
+			return Result::Retry ();
+
+		// Offset mismatches are reported with 400 and the same fields as a success.
+		const auto& map = Util::ParseJson (reply->readAll (), Q_FUNC_INFO).toMap ();
+		if (map.contains ("upload_id") && map.contains ("offset"))
+		{
+			UploadId_ = map ["upload_id"].toString ();
+			return Result::Acknowledged (map ["offset"].toLongLong ());
+		}
+
+		return Result::Failed (map.value ("error",
+					QObject::tr ("Unexpected server reply: %1.").arg (reply->errorString ())).toString ());
+	}
+
+	boost::optional<ChunkedUploadProtocol::Request> UploadProtocol::MakeCommitRequest (qint64 total)
+	{
+		if (IsSingleShot (total))
+			return {};
+
+		const QUrl url { QString ("https://api-content.dropbox.com/1/commit_chunked_upload/%1/%2?access_token=%3&upload_id=%4")
+				.arg ("dropbox")
+				.arg (TargetPath_)
+				.arg (Account_->GetAccessToken ())
+				.arg (UploadId_) };
+		QNetworkRequest request { url };
+		request.setHeader (QNetworkRequest::ContentTypeHeader, "application/x-www-form-urlencoded");
+		return Request { request, Method::Post };
+	}
+
+	ChunkedUploadProtocol::Result UploadProtocol::HandleCommitReply (QNetworkReply *reply)
+	{
+		return HandleMetadataReply (reply);
+	}
+
+	bool UploadProtocol::IsSingleShot (qint64 total) const
+	{
+		return total <= ChunkSize;
+	}
+
+	ChunkedUploadProtocol::Result UploadProtocol::HandleMetadataReply (QNetworkReply *reply)
+	{
+		if (IsTransientError (reply))
+			return Result::Retry ();
+
+		const auto& data = reply->readAll ();
+		const auto& map = Util::ParseJson (data, Q_FUNC_INFO).toMap ();
+		if (map.contains ("path"))
+			return Result::Finished (data);
+
+		return Result::Failed (map.value ("error",
+					QObject::tr ("Unexpected server reply: %1.").arg (reply->errorString ())).toString ());
+	}
+}
+}
+}
@@ -51,6 +51,7 @@
 #include <util/sll/qtutil.h>
 #include <util/sll/urlaccessor.h>
 #include <util/threads/futures.h>
+#include <chunkeduploader.h>
 #include "account.h"
 #include "core.h"
 #include "xmlsettingsmanager.h"
@@ -89,11 +90,31 @@ namespace GoogleDrive
 		return storageItem;
 	}
 
+	namespace
+	{
+		const int MaxParallelUploads = 3;
+	}
+
 	DriveManager::DriveManager (Account *acc, QObject *parent)
 	: QObject (parent)
 	, DirectoryId_ ("application/vnd.google-apps.folder")
 	, Account_ (acc)
+	, Uploader_ (new ChunkedUploader (Core::Instance ().GetProxy ()->GetNetworkAccessManager (),
+			MaxParallelUploads,
+			this))
 	{
+		connect (Uploader_,
+				SIGNAL (uploadProgress (qint64, qint64, QString)),
+				this,
+				SIGNAL (uploadProgress (qint64, qint64, QString)));
+		connect (Uploader_,
+				SIGNAL (uploadError (QString, QString)),
+				this,
+				SIGNAL (uploadError (QString, QString)));
+		connect (Uploader_,
+				SIGNAL (finished (QByteArray, QString)),
+				this,
+				SLOT (handleUploadFinished (QByteArray, QString)));
 	}
 
 	QFuture<DriveManager::ListingResult_t> DriveManager::RefreshListing ()
@@ -164,8 +185,20 @@ namespace GoogleDrive
 	void DriveManager::Upload (const QString& filePath, const QStringList& parentId)
 	{
 		QString parent = parentId.value (0);
-		ApiCallQueue_ << [this, filePath, parent] (const QString& key) { RequestUpload (filePath, parent, key); };
-		RequestAccessToken ();
+		Uploader_->Schedule (filePath,
+				[this, filePath, parent]
+				{
+					ApiCallQueue_ << ApiCall
+					{
+						[this, filePath, parent] (const QString& key) { RequestUpload (filePath, parent, key); },
+						[this, filePath] (const QString& error)
+						{
+							Uploader_->Abort (filePath,
+									tr ("Unable to get the access token: %1.").arg (error));
+						}
+					};
+					RequestAccessToken ();
+				});
 	}
 
 	void DriveManager::Download (const QString& id, const QString& filepath,
@@ -780,22 +813,37 @@ namespace GoogleDrive
 
 		reply->deleteLater ();
 
+		if (ApiCallQueue_.isEmpty ())
+			return;
+
+		// Each queued call has its own token request, so the call is
+		// dequeued even if the request has failed.
+		const auto call = ApiCallQueue_.dequeue ();
+		const auto fail = [&call] (const QString& error)
+		{
+			if (call.Fail_)
+				call.Fail_ (error);
+		};
+
 		const auto& res = Util::ParseJson (reply, Q_FUNC_INFO);
 		if (res.isNull ())
+		{
+			fail (reply->error () != QNetworkReply::NoError ?
+					reply->errorString () :
+					tr ("invalid reply"));
 			return;
+		}
 
 		qDebug () << res.toMap ();
 		const auto& accessKey = res.toMap ().value ("access_token").toString ();
 		if (accessKey.isEmpty ())
 		{
 			qDebug () << Q_FUNC_INFO << "access token is empty";
+			fail (res.toMap ().value ("error").toString ());
 			return;
 		}
 
-		if (ApiCallQueue_.isEmpty ())
-			return;
-
-		ApiCallQueue_.dequeue () (accessKey);
+		call.Call_ (accessKey);
 	}
 
 	void DriveManager::handleRequestEntryRemoving ()
@@ -885,96 +933,39 @@ namespace GoogleDrive
 			qWarning () << Q_FUNC_INFO
 					<< "upload initiating failed with code:"
 					<< code;
+			Uploader_->Abort (path, tr ("Unable to initiate upload: %1.")
+					.arg (reply->errorString ()));
 			return;
 		}
 
 		emit uploadStatusChanged (tr ("Uploading..."), path);
 
-		QFile *file = new QFile (path);
-		if (!file->open (QIODevice::ReadOnly))
-		{
-			qWarning () << Q_FUNC_INFO
-					<< "unable to open file: "
-					<< file->errorString ();
-			return;
-		}
-
-		QUrl url (reply->rawHeader ("Location"));
-		QNetworkRequest request (url);
+		const QUrl url (reply->rawHeader ("Location"));
 		Util::MimeDetector detector;
-		request.setHeader (QNetworkRequest::ContentTypeHeader, detector (path));
-		request.setHeader (QNetworkRequest::ContentLengthHeader,
-				QString::number (QFileInfo (path).size ()).toUtf8 ());
-
-		QNetworkReply *uploadReply = Core::Instance ().GetProxy ()->
-				GetNetworkAccessManager ()->put (request, file);
-		file->setParent (uploadReply);
-		Reply2FilePath_ [uploadReply] = path;
-
-		connect (uploadReply,
-				SIGNAL (finished ()),
-				this,
-				SLOT (handleUploadFinished ()));
-		connect (uploadReply,
-				SIGNAL (error (QNetworkReply::NetworkError)),
-				this,
-				SLOT (handleUploadError (QNetworkReply::NetworkError)));
-		connect (uploadReply,
-				SIGNAL (uploadProgress (qint64, qint64)),
-				this,
-				SLOT (handleUploadProgress (qint64, qint64)));
+		Uploader_->Run (path, std::make_shared<ContentRangeUploadProtocol> (url, detector (path)));
 	}
 
-	void DriveManager::handleUploadFinished ()
+	void DriveManager::handleUploadFinished (const QByteArray& data, const QString& path)
 	{
-		QNetworkReply *reply = qobject_cast<QNetworkReply*> (sender ());
-		if (!reply)
-			return;
-
-		reply->deleteLater ();
-
-		const auto& res = Util::ParseJson (reply, Q_FUNC_INFO);
+		const auto& res = Util::ParseJson (data, Q_FUNC_INFO);
 		if (res.isNull ())
+		{
+			emit uploadError (tr ("Unable to parse server reply."), path);
 			return;
+		}
 
 		const auto& map = res.toMap ();
-		const auto& id = map ["id"].toString ();
-
-		if (!map.contains ("error"))
+		if (map.contains ("error"))
 		{
-			qDebug () << Q_FUNC_INFO
-					<< "file uploaded successfully";
-			RequestFileChanges (XmlSettingsManager::Instance ().Property ("largestChangeId", 0)
-					.toLongLong ());
-			emit finished (id, Reply2FilePath_.take (reply));
+			emit uploadError (ParseError (map), path);
 			return;
 		}
 
-		 ParseError (map);
-	}
-
-	void DriveManager::handleUploadProgress (qint64 uploaded, qint64 total)
-	{
-		QNetworkReply *reply = qobject_cast<QNetworkReply*> (sender ());
-		if (!reply)
-			return;
-
-		emit uploadProgress (uploaded, total, Reply2FilePath_ [reply]);
-	}
-
-	void DriveManager::handleUploadError (QNetworkReply::NetworkError error)
-	{
-		QNetworkReply *reply = qobject_cast<QNetworkReply*> (sender ());
-		if (!reply)
-			return;
-
-		reply->deleteLater ();
-
-		emit uploadError ("Error", Reply2FilePath_.take (reply));
-		if (error == QNetworkReply::ProtocolUnknownError)
-		{
-			//TODO resume upload
-		}
+		qDebug () << Q_FUNC_INFO
+				<< "file uploaded successfully";
+		RequestFileChanges (XmlSettingsManager::Instance ().Property ("largestChangeId", 0)
+				.toLongLong ());
+		emit finished (map ["id"].toString (), path);
 	}
 
 	void DriveManager::handleCreateDirectory ()
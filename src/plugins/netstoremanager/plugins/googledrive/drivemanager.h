@@ -31,6 +31,7 @@
 
 #include <functional>
 #include <memory>
+#include <type_traits>
 #include <QObject>
 #include <QQueue>
 #include <QDateTime>
@@ -49,6 +50,7 @@ namespace LeechCraft
 namespace NetStoreManager
 {
 struct StorageItem;
+class ChunkedUploader;
 
 namespace GoogleDrive
 {
@@ -160,12 +162,31 @@ namespace GoogleDrive
 		const QString DirectoryId_;
 
 		Account *Account_;
-		QQueue<std::function<void (const QString&)>> ApiCallQueue_;
+
+		/* An API call waiting for an access token. Fail_, if set, is
+		 * called with the error message if the token can't be obtained.
+		 */
+		struct ApiCall
+		{
+			std::function<void (const QString&)> Call_;
+			std::function<void (const QString&)> Fail_;
+
+			template<typename F,
+					typename = typename std::enable_if<!std::is_same<typename std::decay<F>::type, ApiCall>::value>::type>
+			ApiCall (F&& call, std::function<void (const QString&)> fail = {})
+			: Call_ (std::forward<F> (call))
+			, Fail_ (std::move (fail))
+			{
+			}
+		};
+		QQueue<ApiCall> ApiCallQueue_;
 		QQueue<std::function<void (const QUrl&)>> DownloadsQueue_;
 		QHash<QNetworkReply*, QString> Reply2FilePath_;
 		QHash<QNetworkReply*, QString> Reply2DownloadAccessToken_;
 		bool SecondRequestIfNoItems_ = true;
 
+		ChunkedUploader * const Uploader_;
+
 	public:
 		DriveManager (Account *acc, QObject *parent = 0);
 
@@ -221,9 +242,7 @@ namespace GoogleDrive
 		void handleRequestMovingEntryToTrash ();
 		void handleRequestRestoreEntryFromTrash ();
 		void handleUploadRequestFinished ();
-		void handleUploadFinished ();
-		void handleUploadProgress (qint64 uploaded, qint64 total);
-		void handleUploadError (QNetworkReply::NetworkError error);
+		void handleUploadFinished (const QByteArray& reply, const QString& filePath);
 		void handleCreateDirectory ();
 		void handleCopyItem ();
 		void handleMoveItem ();
@@ -31,10 +31,13 @@
 #include <future>
 #include <QCryptographicHash>
 #include <QFileInfo>
+#include <QSet>
 #include <QStandardItem>
 #include <QtDebug>
 #include <QUuid>
+#include <util/sys/paths.h>
 #include "interfaces/netstoremanager/istorageaccount.h"
+#include "filehashcache.h"
 #include "utils.h"
 
 namespace LeechCraft
@@ -52,6 +55,8 @@ namespace NetStoreManager
 	{
 	}
 
+	Syncer::~Syncer () = default;
+
 	QByteArray Syncer::GetAccountID () const
 	{
 		return Account_->GetUniqueID ();
@@ -74,9 +79,20 @@ namespace NetStoreManager
 
 	void Syncer::SetSnapshot (const Changes_t& changes)
 	{
+		// Snapshots are keyed by the path relative to the synced directory,
+		// just like the local ones created by CreateSnapshot ().
+		const auto& prefix = RemotePath_ + "/";
+
 		Snapshot_.clear ();
-		for (const auto& change : changes)
+		for (auto change : changes)
+		{
+			const auto pos = Id2Path_.left.find (change.ItemID_);
+			if (pos == Id2Path_.left.end () || !pos->second.startsWith (prefix))
+				continue;
+
+			change.ID_ = pos->second.mid (prefix.size ()).toUtf8 ();
 			Snapshot_ [change.ID_] = change;
+		}
 	}
 
 	bool Syncer::IsStarted () const
@@ -164,55 +180,129 @@ namespace NetStoreManager
 		}
 	}
 
+	FileHashCache& Syncer::GetHashCache ()
+	{
+		if (!HashCache_)
+		{
+			const auto& name = QCryptographicHash::hash (GetAccountID () + '/' + LocalPath_.toUtf8 (),
+					QCryptographicHash::Md5).toHex ();
+			const auto& dir = Util::GetUserDir (Util::UserDir::Cache, "netstoremanager/hashes");
+			HashCache_.reset (new FileHashCache (dir.filePath (name),
+					NSMHashType2QtCryproHashAlgorithm (SFLAccount_->GetCheckSumAlgorithm ())));
+		}
+
+		return *HashCache_;
+	}
+
 	Snapshot_t Syncer::CreateSnapshot ()
 	{
 		Snapshot_t snapshot;
 
-		for (const auto& fi : QDir (LocalPath_).entryInfoList (QDir::NoDotAndDotDot | QDir::AllEntries))
-		{
-			const QString path = fi.absoluteFilePath ().remove (LocalPath_ + "/");
-			Change change;
-			StorageItem storage;
-			if (!Id2Path_.right.count (path))
-				change.ItemID_ = Id2Path_.right.at (path);
-			else
-			{
-				change.ItemID_ = QUuid::createUuid ().toByteArray ();
-
-				storage.IsDirectory_ = fi.isDir ();
-				storage.Name_ = fi.fileName ();
-				storage.ModifyDate_ = fi.lastModified ();
-				storage.ID_ = change.ItemID_;
-			}
+		const auto& entries = QDir (LocalPath_).entryInfoList (QDir::NoDotAndDotDot | QDir::AllEntries);
 
+		QList<QFileInfo> files;
+		QSet<QString> filePaths;
+		for (const auto& fi : entries)
 			if (fi.isFile ())
 			{
-				QFile file (fi.absoluteFilePath ());
-				if (file.open (QIODevice::ReadOnly))
-				{
-					const auto& ba = file.readAll ();
-					storage.Hash_ = QCryptographicHash::hash (ba,
-							NSMHashType2QtCryproHashAlgorithm (SFLAccount_->GetCheckSumAlgorithm ()));
-					file.close ();
-				}
-				else
-					qWarning () << Q_FUNC_INFO
-							<< "unable to open file for hash calculation";
-
-				storage.Size_ = fi.size ();
+				files << fi;
+				filePaths << fi.absoluteFilePath ();
 			}
 
-			change.Item_ = storage;
+		auto& cache = GetHashCache ();
+		const auto& hashes = cache.GetHashes (files);
+		cache.Prune (filePaths);
+		cache.Save ();
+
+		for (const auto& fi : entries)
+		{
+			const auto& change = MakeChange (fi, hashes);
 			snapshot [change.ID_] = change;
 		}
 
 		return snapshot;
 	}
 
-	Snapshot_t Syncer::CreateDiffSnapshot (const Snapshot_t& newSnapshot,
-			const Snapshot_t& oldSnapshot)
+	Change Syncer::MakeChange (const QFileInfo& fi, const QHash<QString, QByteArray>& hashes) const
+	{
+		const QString path = fi.absoluteFilePath ().remove (LocalPath_ + "/");
+		Change change;
+		// Local snapshots are keyed by the path relative to the synced directory.
+		change.ID_ = path.toUtf8 ();
+		change.Deleted_ = false;
+
+		StorageItem storage;
+		if (Id2Path_.right.count (path))
+			change.ItemID_ = Id2Path_.right.at (path);
+		else
+		{
+			change.ItemID_ = QUuid::createUuid ().toByteArray ();
+
+			storage.IsDirectory_ = fi.isDir ();
+			storage.Name_ = fi.fileName ();
+			storage.ModifyDate_ = fi.lastModified ();
+			storage.ID_ = change.ItemID_;
+		}
+
+		if (fi.isFile ())
+		{
+			storage.Hash_ = hashes.value (fi.absoluteFilePath ());
+			storage.Size_ = fi.size ();
+		}
+
+		change.Item_ = storage;
+		return change;
+	}
+
+	Snapshot_t Syncer::CreateDiffSnapshot ()
 	{
 		Snapshot_t diffSnapshot;
+		if (ChangedPaths_.isEmpty ())
+			return diffSnapshot;
+
+		// Only the changed files are hashed, the rest of the tree isn't touched.
+		QList<QFileInfo> files;
+		for (const auto& path : ChangedPaths_)
+		{
+			const QFileInfo fi { path };
+			if (fi.isFile ())
+				files << fi;
+		}
+
+		auto& cache = GetHashCache ();
+		const auto& hashes = cache.GetHashes (files);
+		cache.Save ();
+
+		for (const auto& path : ChangedPaths_)
+		{
+			const auto& key = QString { path }.remove (LocalPath_ + "/").toUtf8 ();
+			const auto oldPos = Snapshot_.find (key);
+
+			const QFileInfo fi { path };
+			if (!fi.exists ())
+			{
+				if (oldPos == Snapshot_.end ())
+					continue;
+
+				auto change = *oldPos;
+				change.Deleted_ = true;
+				diffSnapshot [key] = change;
+				Snapshot_.erase (oldPos);
+				continue;
+			}
+
+			const auto& change = MakeChange (fi, hashes);
+			if (oldPos != Snapshot_.end () &&
+					oldPos->Item_.IsDirectory_ == change.Item_.IsDirectory_ &&
+					oldPos->Item_.Size_ == change.Item_.Size_ &&
+					oldPos->Item_.Hash_ == change.Item_.Hash_)
+				continue;
+
+			diffSnapshot [key] = change;
+			Snapshot_ [key] = change;
+		}
+
+		ChangedPaths_.clear ();
 		return diffSnapshot;
 	}
 
@@ -225,8 +315,8 @@ namespace NetStoreManager
 		QStringList path = RemotePath_.split ('/');
 		CreateRemotePath (path);
 
-		const auto& newSnapshot = CreateSnapshot ();
-		//TODO create diff
+		Snapshot_ = CreateSnapshot ();
+		ChangedPaths_.clear ();
 	}
 
 	void Syncer::stop ()
@@ -337,6 +427,8 @@ namespace NetStoreManager
 
 	void Syncer::localDirWasCreated (const QString& path)
 	{
+		ChangedPaths_ << path;
+
 		if (!SFLAccount_)
 			return;
 
@@ -353,6 +445,8 @@ namespace NetStoreManager
 
 	void Syncer::localDirWasRemoved (const QString& path)
 	{
+		ChangedPaths_ << path;
+
 		if (!SFLAccount_)
 			return;
 
@@ -366,6 +460,8 @@ namespace NetStoreManager
 
 	void Syncer::localFileWasCreated (const QString& path)
 	{
+		ChangedPaths_ << path;
+
 		QString filePath = path;
 		QString dirPath = QFileInfo (filePath).dir ().absolutePath ();
 		filePath.replace (LocalPath_, RemotePath_);
@@ -379,6 +475,8 @@ namespace NetStoreManager
 
 	void Syncer::localFileWasRemoved (const QString& path)
 	{
+		ChangedPaths_ << path;
+
 		if (!SFLAccount_)
 			return;
 
@@ -389,11 +487,13 @@ namespace NetStoreManager
 
 	void Syncer::localFileWasUpdated (const QString& path)
 	{
-		qDebug () << Q_FUNC_INFO << path;
+		ChangedPaths_ << path;
 	}
 
 	void Syncer::localFileWasRenamed (const QString& oldName, const QString& newName)
 	{
+		ChangedPaths_ << oldName << newName;
+
 		QString filePath = oldName;
 		filePath.replace (LocalPath_, RemotePath_);
 // 		if (Id2Path_.right.count (filePath))
@@ -30,6 +30,7 @@
 #pragma once
 
 #include <functional>
+#include <memory>
 
 #ifndef Q_MOC_RUN
 #include <boost/bimap.hpp>
@@ -37,14 +38,18 @@
 
 #include <QObject>
 #include <QQueue>
+#include <QSet>
 #include "interfaces/netstoremanager/isupportfilelistings.h"
 #include "syncmanager.h"
 
+class QFileInfo;
+
 namespace LeechCraft
 {
 namespace NetStoreManager
 {
 	class IStorageAccount;
+	class FileHashCache;
 
 	class Syncer : public QObject
 	{
@@ -60,10 +65,13 @@ namespace NetStoreManager
 		QQueue<std::function<void (void)>> CallsQueue_;
 
 		Snapshot_t Snapshot_;
+		QSet<QString> ChangedPaths_;
 
+		std::unique_ptr<FileHashCache> HashCache_;
 	public:
 		explicit Syncer (const QString& dirPath, const QString& remotePath,
 				IStorageAccount *isa, QObject *parent = 0);
+		~Syncer ();
 
 		QByteArray GetAccountID () const;
 		QString GetLocalPath () const;
@@ -77,9 +85,15 @@ namespace NetStoreManager
 		void CreateRemotePath (const QStringList& path);
 		void DeleteRemotePath (const QStringList& path);
 		void RenameItem (const StorageItem& item, const QString& path);
+		FileHashCache& GetHashCache ();
+		Change MakeChange (const QFileInfo&, const QHash<QString, QByteArray>& hashes) const;
 		Snapshot_t CreateSnapshot ();
-		Snapshot_t CreateDiffSnapshot (const Snapshot_t& newSnapshot,
-				const Snapshot_t& oldSnapshot);
+
+		/** Brings the paths changed locally since the last call up to
+		 * date in the snapshot, and returns the entries that actually
+		 * differ, with the removed ones marked as deleted.
+		 */
+		Snapshot_t CreateDiffSnapshot ();
 
 	public slots:
 		void start ();
@@ -0,0 +1,261 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+
+#include "chunkeduploadertest.h"
+#include <memory>
+#include <QtTest>
+#include <QNetworkAccessManager>
+#include <QTcpSocket>
+#include <QTemporaryFile>
+#include <chunkeduploader.h>
+
+QTEST_MAIN (LeechCraft::NetStoreManager::ChunkedUploaderTest)
+
+namespace LeechCraft
+{
+namespace NetStoreManager
+{
+	ResumableServer::ResumableServer ()
+	{
+		Server_.listen (QHostAddress::LocalHost);
+		connect (&Server_,
+				SIGNAL (newConnection ()),
+				this,
+				SLOT (handleNewConnection ()));
+	}
+
+	QUrl ResumableServer::GetSessionUrl (const QString& session) const
+	{
+		return QString ("http://127.0.0.1:%1/upload/%2")
+				.arg (Server_.serverPort ())
+				.arg (session);
+	}
+
+	QByteArray ResumableServer::GetReceived (const QString& session) const
+	{
+		return Received_.value ("/upload/" + session.toUtf8 ());
+	}
+
+	void ResumableServer::SetDropOnChunk (int chunk)
+	{
+		DropOnChunk_ = chunk;
+	}
+
+	int ResumableServer::GetMaxActive () const
+	{
+		return MaxActive_;
+	}
+
+	bool ResumableServer::HandleRequest (QTcpSocket *socket)
+	{
+		auto& buffer = Buffers_ [socket];
+		const auto headersEnd = buffer.indexOf ("\r\n\r\n");
+		if (headersEnd == -1)
+			return false;
+
+		auto lines = buffer.left (headersEnd).split ('\n');
+		const auto& requestLine = lines.takeFirst ().trimmed ().split (' ');
+		QHash<QByteArray, QByteArray> headers;
+		for (const auto& line : lines)
+		{
+			const auto colon = line.indexOf (':');
+			headers [line.left (colon).trimmed ().toLower ()] = line.mid (colon + 1).trimmed ();
+		}
+
+		const auto length = headers.value ("content-length", "0").toInt ();
+		if (buffer.size () < headersEnd + 4 + length)
+			return false;
+
+		const auto& body = buffer.mid (headersEnd + 4, length);
+		buffer.remove (0, headersEnd + 4 + length);
+
+		const auto& session = requestLine.value (1);
+		const auto& range = headers.value ("content-range");
+		const auto slashPos = range.indexOf ('/');
+		const auto total = range.mid (slashPos + 1).toLongLong ();
+
+		auto& received = Received_ [session];
+		if (!Totals_.contains (session))
+		{
+			Totals_ [session] = total;
+			MaxActive_ = std::max (MaxActive_, ++Active_);
+		}
+
+		if (!range.startsWith ("bytes */"))
+		{
+			const auto start = range.mid (6, range.indexOf ('-') - 6).toLongLong ();
+			if (start == received.size ())
+			{
+				received += body;
+
+				if (++AcceptedChunks_ == DropOnChunk_)
+				{
+					DropOnChunk_ = -1;
+					Buffers_.remove (socket);
+					socket->abort ();
+					return false;
+				}
+			}
+		}
+
+		if (received.size () == total)
+		{
+			if (Totals_ [session] != -1)
+				--Active_;
+			Totals_ [session] = -1;
+			Reply (socket, 200, {}, "{ \"id\": \"" + session + "\" }");
+		}
+		else
+			Reply (socket, 308, GetRange (session), {});
+
+		return true;
+	}
+
+	void ResumableServer::Reply (QTcpSocket *socket, int code, const QByteArray& range, const QByteArray& body)
+	{
+		QByteArray reply = "HTTP/1.1 " + QByteArray::number (code) +
+				(code == 200 ? " OK" : " Resume Incomplete") + "\r\n";
+		if (!range.isEmpty ())
+			reply += "Range: " + range + "\r\n";
+		reply += "Content-Length: " + QByteArray::number (body.size ()) + "\r\n\r\n";
+		reply += body;
+		socket->write (reply);
+	}
+
+	QByteArray ResumableServer::GetRange (const QByteArray& session) const
+	{
+		const auto size = Received_.value (session).size ();
+		return size ? "bytes=0-" + QByteArray::number (size - 1) : QByteArray {};
+	}
+
+	void ResumableServer::handleNewConnection ()
+	{
+		while (const auto socket = Server_.nextPendingConnection ())
+		{
+			connect (socket,
+					SIGNAL (readyRead ()),
+					this,
+					SLOT (handleReadyRead ()));
+			connect (socket,
+					SIGNAL (disconnected ()),
+					socket,
+					SLOT (deleteLater ()));
+		}
+	}
+
+	void ResumableServer::handleReadyRead ()
+	{
+		const auto socket = qobject_cast<QTcpSocket*> (sender ());
+		Buffers_ [socket] += socket->readAll ();
+		while (HandleRequest (socket))
+			;
+	}
+
+	namespace
+	{
+		std::shared_ptr<QTemporaryFile> MakeFile (qint64 size)
+		{
+			const auto file = std::make_shared<QTemporaryFile> ();
+			file->open ();
+
+			QByteArray data;
+			data.reserve (size);
+			for (qint64 i = 0; i < size; ++i)
+				data += static_cast<char> (qrand ());
+			file->write (data);
+			file->flush ();
+			return file;
+		}
+
+		QByteArray ReadAll (const std::shared_ptr<QTemporaryFile>& file)
+		{
+			file->seek (0);
+			return file->readAll ();
+		}
+
+		void Start (ChunkedUploader& uploader, ResumableServer& server,
+				const QString& path, const QString& session)
+		{
+			uploader.Schedule (path,
+					[&uploader, &server, path, session]
+					{
+						uploader.Run (path,
+								std::make_shared<ContentRangeUploadProtocol> (server.GetSessionUrl (session),
+										"application/octet-stream",
+										ContentRangeUploadProtocol::Granularity));
+					});
+		}
+	}
+
+	void ChunkedUploaderTest::testResumeAfterDrop ()
+	{
+		ResumableServer server;
+		server.SetDropOnChunk (3);
+
+		QNetworkAccessManager nam;
+		ChunkedUploader uploader { &nam, 1 };
+		uploader.SetRetryPolicy (3, 10);
+
+		QSignalSpy finishedSpy { &uploader, SIGNAL (finished (QByteArray, QString)) };
+		QSignalSpy errorSpy { &uploader, SIGNAL (uploadError (QString, QString)) };
+
+		const auto& file = MakeFile (5 * ContentRangeUploadProtocol::Granularity + 100);
+		Start (uploader, server, file->fileName (), "drop");
+
+		QVERIFY (finishedSpy.wait (10000));
+		QCOMPARE (errorSpy.count (), 0);
+		QCOMPARE (server.GetReceived ("drop"), ReadAll (file));
+	}
+
+	void ChunkedUploaderTest::testParallelLimit ()
+	{
+		ResumableServer server;
+
+		QNetworkAccessManager nam;
+		ChunkedUploader uploader { &nam, 2 };
+
+		QSignalSpy finishedSpy { &uploader, SIGNAL (finished (QByteArray, QString)) };
+
+		QList<std::shared_ptr<QTemporaryFile>> files;
+		for (int i = 0; i < 4; ++i)
+		{
+			files << MakeFile (2 * ContentRangeUploadProtocol::Granularity + i);
+			Start (uploader, server, files.last ()->fileName (), QString::number (i));
+		}
+
+		while (finishedSpy.count () < files.size ())
+			QVERIFY (finishedSpy.wait (10000));
+
+		QVERIFY (server.GetMaxActive () <= 2);
+		for (int i = 0; i < files.size (); ++i)
+			QCOMPARE (server.GetReceived (QString::number (i)), ReadAll (files.at (i)));
+	}
+}
+}
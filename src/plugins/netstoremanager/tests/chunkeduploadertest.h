@@ -0,0 +1,89 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+
+#pragma once
+
+#include <QObject>
+#include <QHash>
+#include <QTcpServer>
+
+class QTcpSocket;
+
+namespace LeechCraft
+{
+namespace NetStoreManager
+{
+	/** @brief Local HTTP stand-in implementing the Content-Range
+	 * resumable upload protocol.
+	 */
+	class ResumableServer : public QObject
+	{
+		Q_OBJECT
+
+		QTcpServer Server_;
+		QHash<QTcpSocket*, QByteArray> Buffers_;
+
+		QHash<QByteArray, QByteArray> Received_;
+		QHash<QByteArray, qint64> Totals_;
+
+		int AcceptedChunks_ = 0;
+		int DropOnChunk_ = -1;
+
+		int Active_ = 0;
+		int MaxActive_ = 0;
+	public:
+		ResumableServer ();
+
+		QUrl GetSessionUrl (const QString& session) const;
+		QByteArray GetReceived (const QString& session) const;
+
+		/** @brief Drops the connection without replying after the
+		 * given chunk is accepted.
+		 */
+		void SetDropOnChunk (int);
+		int GetMaxActive () const;
+	private:
+		bool HandleRequest (QTcpSocket*);
+		void Reply (QTcpSocket*, int code, const QByteArray& range, const QByteArray& body);
+		QByteArray GetRange (const QByteArray& session) const;
+	private slots:
+		void handleNewConnection ();
+		void handleReadyRead ();
+	};
+
+	class ChunkedUploaderTest : public QObject
+	{
+		Q_OBJECT
+	private slots:
+		void testResumeAfterDrop ();
+		void testParallelLimit ();
+	};
+}
+}
@@ -33,8 +33,18 @@
 #include <QSortFilterProxyModel>
 #include <QMainWindow>
 #include <QNetworkAccessManager>
+#include <QDialogButtonBox>
+#include <QDir>
+#include <QFileDialog>
+#include <QHeaderView>
+#include <QLabel>
+#include <QMessageBox>
+#include <QTreeWidget>
+#include <QVBoxLayout>
 #include <util/util.h>
+#include <util/sys/savefile.h>
 #include <interfaces/core/icoreproxy.h>
+#include "requestlog.h"
 #include "requestmodel.h"
 #include "headermodel.h"
 
@@ -63,9 +73,10 @@ namespace LeechCraft
 				ProxyModel_ = new QSortFilterProxyModel (this);
 				ProxyModel_->setDynamicSortFilter (true);
 
-				Model_ = new RequestModel (this);
+				Log_ = new RequestLog (RequestLog::DefaultCapacity, this);
+				Model_ = new RequestModel (Log_, this);
 				ProxyModel_->setSourceModel (Model_);
-				ProxyModel_->setFilterKeyColumn (3);
+				ProxyModel_->setFilterKeyColumn (RequestModel::Column::Url);
 				Ui_.RequestsView_->setModel (ProxyModel_);
 				connect (Ui_.RequestsView_->selectionModel (),
 						SIGNAL (currentRowChanged (const QModelIndex&, const QModelIndex&)),
@@ -79,11 +90,21 @@ namespace LeechCraft
 						SIGNAL (toggled (bool)),
 						Model_,
 						SLOT (setClear (bool)));
+				Model_->setClear (Ui_.ClearFinished_->isChecked ());
+
+				connect (Ui_.ShowStats_,
+						SIGNAL (released ()),
+						this,
+						SLOT (showStats ()));
+				connect (Ui_.ExportHar_,
+						SIGNAL (released ()),
+						this,
+						SLOT (exportHar ()));
 
 				connect (NetworkAccessManager_,
 						SIGNAL (requestCreated (QNetworkAccessManager::Operation,
 								const QNetworkRequest&, QNetworkReply*)),
-						Model_,
+						Log_,
 						SLOT (handleRequest (QNetworkAccessManager::Operation,
 								const QNetworkRequest&, QNetworkReply*)));
 
@@ -162,6 +183,162 @@ namespace LeechCraft
 						break;
 				}
 			}
+
+			namespace
+			{
+				QString FormatTime (qint64 msecs)
+				{
+					return msecs >= 0 ?
+							Plugin::tr ("%1 ms").arg (msecs) :
+							QString {};
+				}
+
+				const int StatsSortRole = Qt::UserRole + 1;
+
+				// Sorts the numeric columns by the values and not the
+				// formatted strings.
+				class StatsItem : public QTreeWidgetItem
+				{
+				public:
+					StatsItem (const HostStats& stats)
+					: QTreeWidgetItem ({
+							stats.Host_,
+							QString::number (stats.Requests_),
+							QString::number (stats.Failed_),
+							Util::MakePrettySize (stats.BytesSent_),
+							Util::MakePrettySize (stats.BytesReceived_),
+							FormatTime (stats.MedianTime_),
+							FormatTime (stats.P95Time_)
+						})
+					{
+						const QList<qint64> values
+						{
+							stats.Requests_,
+							stats.Failed_,
+							stats.BytesSent_,
+							stats.BytesReceived_,
+							stats.MedianTime_,
+							stats.P95Time_
+						};
+						for (int i = 0; i < values.size (); ++i)
+						{
+							setData (i + 1, StatsSortRole, values.at (i));
+							setTextAlignment (i + 1, Qt::AlignRight | Qt::AlignVCenter);
+						}
+					}
+
+					bool operator< (const QTreeWidgetItem& other) const
+					{
+						const auto column = treeWidget ()->sortColumn ();
+						if (!column)
+							return QTreeWidgetItem::operator< (other);
+
+						return data (column, StatsSortRole).toLongLong () <
+								other.data (column, StatsSortRole).toLongLong ();
+					}
+				};
+
+				QString MakeTotalText (const HostStats& total)
+				{
+					auto text = Plugin::tr ("Total: %n request(s)", 0, total.Requests_) +
+							", " + Plugin::tr ("%n failed", 0, total.Failed_) +
+							", " + Plugin::tr ("%1 sent, %2 received")
+								.arg (Util::MakePrettySize (total.BytesSent_))
+								.arg (Util::MakePrettySize (total.BytesReceived_));
+					if (total.MedianTime_ >= 0)
+						text += ", " + Plugin::tr ("median time %1, 95th percentile %2")
+								.arg (FormatTime (total.MedianTime_))
+								.arg (FormatTime (total.P95Time_));
+					return text;
+				}
+			}
+
+			void Plugin::showStats ()
+			{
+				auto dia = new QDialog (this);
+				dia->setAttribute (Qt::WA_DeleteOnClose);
+				dia->setWindowTitle (tr ("Network statistics"));
+
+				auto tree = new QTreeWidget;
+				tree->setRootIsDecorated (false);
+				tree->setSortingEnabled (true);
+				tree->setHeaderLabels ({
+						tr ("Host"),
+						tr ("Requests"),
+						tr ("Failed"),
+						tr ("Sent"),
+						tr ("Received"),
+						tr ("Median time"),
+						tr ("95th percentile")
+					});
+
+				for (const auto& stats : Log_->GetHostStats ())
+					tree->addTopLevelItem (new StatsItem (stats));
+				tree->sortByColumn (1, Qt::DescendingOrder);
+
+				for (int i = 0; i < tree->columnCount (); ++i)
+					tree->resizeColumnToContents (i);
+
+				// The total is kept out of the tree so that it isn't sorted
+				// along with the hosts.
+				auto totalLabel = new QLabel (MakeTotalText (Log_->GetTotalStats ()));
+				auto font = totalLabel->font ();
+				font.setBold (true);
+				totalLabel->setFont (font);
+				totalLabel->setWordWrap (true);
+
+				auto buttons = new QDialogButtonBox (QDialogButtonBox::Close);
+				connect (buttons,
+						SIGNAL (rejected ()),
+						dia,
+						SLOT (reject ()));
+
+				auto lay = new QVBoxLayout (dia);
+				lay->addWidget (tree);
+				lay->addWidget (totalLabel);
+				lay->addWidget (buttons);
+
+				dia->resize (700, 400);
+				dia->show ();
+			}
+
+			void Plugin::exportHar ()
+			{
+				const auto& filename = QFileDialog::getSaveFileName (this,
+						tr ("Export HAR"),
+						QDir::homePath (),
+						tr ("HTTP archives (*.har)"));
+				if (filename.isEmpty ())
+					return;
+
+				Util::SaveFile file (filename);
+				if (!file.open (QIODevice::WriteOnly))
+				{
+					qWarning () << Q_FUNC_INFO
+							<< "unable to open file"
+							<< filename
+							<< file.errorString ();
+					QMessageBox::critical (this,
+							"LeechCraft",
+							tr ("Unable to open %1 for writing: %2.")
+								.arg (filename)
+								.arg (file.errorString ()));
+					return;
+				}
+
+				if (!Log_->ExportHar (&file) || !file.commit ())
+				{
+					qWarning () << Q_FUNC_INFO
+							<< "unable to write"
+							<< filename
+							<< file.errorString ();
+					QMessageBox::critical (this,
+							"LeechCraft",
+							tr ("Unable to export requests to %1: %2.")
+								.arg (filename)
+								.arg (file.errorString ()));
+				}
+			}
 		};
 	};
 };
@@ -44,6 +44,7 @@ namespace LeechCraft
 	{
 		namespace NetworkMonitor
 		{
+			class RequestLog;
 			class RequestModel;
 
 			class Plugin : public QDialog
@@ -56,6 +57,7 @@ namespace LeechCraft
 				LC_PLUGIN_METADATA ("org.LeechCraft.NetworkMonitor")
 
 				Ui::NetworkMonitor Ui_;
+				RequestLog *Log_;
 				RequestModel *Model_;
 				QSortFilterProxyModel *ProxyModel_;
 				QNetworkAccessManager *NetworkAccessManager_;
@@ -73,6 +75,8 @@ namespace LeechCraft
 			public slots:
 				void handleCurrentChanged (const QModelIndex&);
 				void filterUpdated ();
+				void showStats ();
+				void exportHar ();
 			signals:
 				void gotActions (QList<QAction*>, LeechCraft::ActionsEmbedPlace);
 			};
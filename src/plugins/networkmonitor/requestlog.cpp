@@ -0,0 +1,627 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+
+#include "requestlog.h"
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <QDateTime>
+#include <QIODevice>
+#include <QNetworkRequest>
+#include <QTextCodec>
+#include <QTextStream>
+#include <QtDebug>
+
+namespace LeechCraft
+{
+namespace Plugins
+{
+namespace NetworkMonitor
+{
+namespace
+{
+	const quint32 NoString = std::numeric_limits<quint32>::max ();
+}
+
+StringPool::StringPool ()
+{
+	String2ID_ [QString {}] = 0;
+	Strings_ << QString {};
+	Refs_ << 1;
+}
+
+quint32 StringPool::Intern (const QString& string)
+{
+	if (string.isEmpty ())
+		return 0;
+
+	const auto pos = String2ID_.constFind (string);
+	if (pos != String2ID_.constEnd ())
+	{
+		++Refs_ [*pos];
+		return *pos;
+	}
+
+	quint32 id = 0;
+	if (!Free_.isEmpty ())
+	{
+		id = Free_.takeLast ();
+		Strings_ [id] = string;
+		Refs_ [id] = 1;
+	}
+	else
+	{
+		id = Strings_.size ();
+		Strings_ << string;
+		Refs_ << 1;
+	}
+
+	String2ID_ [string] = id;
+	return id;
+}
+
+void StringPool::Release (quint32 id)
+{
+	if (!id || --Refs_ [id])
+		return;
+
+	String2ID_.remove (Strings_ [id]);
+	Strings_ [id].clear ();
+	Free_ << id;
+}
+
+const QString& StringPool::Get (quint32 id) const
+{
+	return Strings_.at (id);
+}
+
+quint32 StringPool::Find (const QString& string) const
+{
+	return String2ID_.value (string, NoString);
+}
+
+RequestLog::RequestLog (int capacity, QObject *parent)
+: QObject { parent }
+, Capacity_ { std::max (capacity, 1) }
+, Started_ (Capacity_)
+, Finished_ (Capacity_)
+, Operations_ (Capacity_)
+, Statuses_ (Capacity_)
+, Errors_ (Capacity_)
+, Reasons_ (Capacity_)
+, Urls_ (Capacity_)
+, Hosts_ (Capacity_)
+, BytesSent_ (Capacity_)
+, BytesReceived_ (Capacity_)
+, RequestHeaders_ (Capacity_)
+, ReplyHeaders_ (Capacity_)
+{
+}
+
+int RequestLog::GetCapacity () const
+{
+	return Capacity_;
+}
+
+quint64 RequestLog::GetFirstID () const
+{
+	return First_;
+}
+
+quint64 RequestLog::GetNextID () const
+{
+	return Next_;
+}
+
+bool RequestLog::Contains (quint64 id) const
+{
+	return id >= First_ && id < Next_;
+}
+
+QList<quint64> RequestLog::GetPending () const
+{
+	auto result = PendingReplies_.keys ();
+	std::sort (result.begin (), result.end ());
+	return result;
+}
+
+QNetworkReply* RequestLog::GetPendingReply (quint64 id) const
+{
+	return PendingReplies_.value (id);
+}
+
+qint64 RequestLog::GetStarted (quint64 id) const
+{
+	return Started_.at (Slot (id));
+}
+
+qint64 RequestLog::GetFinished (quint64 id) const
+{
+	return Finished_.at (Slot (id));
+}
+
+qint64 RequestLog::GetTime (quint64 id) const
+{
+	const auto finished = GetFinished (id);
+	return finished >= 0 ? finished - GetStarted (id) : -1;
+}
+
+QNetworkAccessManager::Operation RequestLog::GetOperation (quint64 id) const
+{
+	return static_cast<QNetworkAccessManager::Operation> (Operations_.at (Slot (id)));
+}
+
+int RequestLog::GetStatus (quint64 id) const
+{
+	return Statuses_.at (Slot (id));
+}
+
+QString RequestLog::GetReason (quint64 id) const
+{
+	return Strings_.Get (Reasons_.at (Slot (id)));
+}
+
+QNetworkReply::NetworkError RequestLog::GetError (quint64 id) const
+{
+	return static_cast<QNetworkReply::NetworkError> (Errors_.at (Slot (id)));
+}
+
+QString RequestLog::GetUrl (quint64 id) const
+{
+	return Urls_.at (Slot (id));
+}
+
+QString RequestLog::GetHost (quint64 id) const
+{
+	return Strings_.Get (Hosts_.at (Slot (id)));
+}
+
+qint64 RequestLog::GetBytesSent (quint64 id) const
+{
+	return BytesSent_.at (Slot (id));
+}
+
+qint64 RequestLog::GetBytesReceived (quint64 id) const
+{
+	return BytesReceived_.at (Slot (id));
+}
+
+Headers_t RequestLog::GetRequestHeaders (quint64 id) const
+{
+	return Resolve (RequestHeaders_.at (Slot (id)));
+}
+
+Headers_t RequestLog::GetReplyHeaders (quint64 id) const
+{
+	return Resolve (ReplyHeaders_.at (Slot (id)));
+}
+
+bool RequestLog::Matches (quint64 id, const Filter& filter, quint32 hostId) const
+{
+	const auto slot = Slot (id);
+	if (Finished_.at (slot) < 0)
+		return false;
+
+	if (!filter.Host_.isEmpty () && Hosts_.at (slot) != hostId)
+		return false;
+
+	const auto status = Statuses_.at (slot);
+	if (status < filter.MinStatus_ || status > filter.MaxStatus_)
+		return false;
+
+	return Finished_.at (slot) - Started_.at (slot) >= filter.MinTime_;
+}
+
+QList<quint64> RequestLog::Select (const Filter& filter) const
+{
+	QList<quint64> result;
+
+	const auto hostId = Strings_.Find (filter.Host_);
+	if (!filter.Host_.isEmpty () && hostId == NoString)
+		return result;
+
+	for (auto id = First_; id < Next_; ++id)
+		if (Matches (id, filter, hostId))
+			result << id;
+	return result;
+}
+
+qint64 Percentile (QVector<qint64>& values, double p)
+{
+	if (values.isEmpty ())
+		return -1;
+
+	const auto rank = static_cast<int> (std::ceil (p * values.size ())) - 1;
+	const auto pos = values.begin () + std::max (0, std::min (rank, values.size () - 1));
+	std::nth_element (values.begin (), pos, values.end ());
+	return *pos;
+}
+
+namespace
+{
+	struct StatsAccumulator
+	{
+		HostStats Stats_;
+		QVector<qint64> Times_;
+
+		void Add (const RequestLog& log, quint64 id)
+		{
+			++Stats_.Requests_;
+			if (log.GetError (id) != QNetworkReply::NoError)
+				++Stats_.Failed_;
+			Stats_.BytesSent_ += log.GetBytesSent (id);
+			Stats_.BytesReceived_ += log.GetBytesReceived (id);
+			Times_ << log.GetTime (id);
+		}
+
+		HostStats Finish ()
+		{
+			Stats_.MedianTime_ = Percentile (Times_, 0.5);
+			Stats_.P95Time_ = Percentile (Times_, 0.95);
+			return Stats_;
+		}
+	};
+}
+
+QList<HostStats> RequestLog::GetHostStats (const Filter& filter) const
+{
+	QHash<quint32, StatsAccumulator> accs;
+	for (const auto id : Select (filter))
+	{
+		const auto hostId = Hosts_.at (Slot (id));
+		auto& acc = accs [hostId];
+		if (!acc.Stats_.Requests_)
+			acc.Stats_.Host_ = Strings_.Get (hostId);
+		acc.Add (*this, id);
+	}
+
+	QList<HostStats> result;
+	for (auto& acc : accs)
+		result << acc.Finish ();
+	std::sort (result.begin (), result.end (),
+			[] (const HostStats& left, const HostStats& right)
+				{ return left.Requests_ > right.Requests_; });
+	return result;
+}
+
+HostStats RequestLog::GetTotalStats (const Filter& filter) const
+{
+	StatsAccumulator acc;
+	for (const auto id : Select (filter))
+		acc.Add (*this, id);
+	return acc.Finish ();
+}
+
+namespace
+{
+	QString JsonString (const QString& string)
+	{
+		QString result;
+		result.reserve (string.size () + 2);
+		result += '"';
+		for (const auto c : string)
+			switch (c.unicode ())
+			{
+			case '"':
+				result += "\\\"";
+				break;
+			case '\\':
+				result += "\\\\";
+				break;
+			case '\n':
+				result += "\\n";
+				break;
+			case '\r':
+				result += "\\r";
+				break;
+			case '\t':
+				result += "\\t";
+				break;
+			default:
+				if (c.unicode () < 0x20)
+					result += QString ("\\u%1").arg (c.unicode (), 4, 16, QChar ('0'));
+				else
+					result += c;
+				break;
+			}
+		result += '"';
+		return result;
+	}
+
+	QString HarDate (qint64 msecs)
+	{
+		return QDateTime::fromMSecsSinceEpoch (msecs).toUTC ()
+				.toString ("yyyy-MM-ddThh:mm:ss.zzzZ");
+	}
+
+	QString OperationName (QNetworkAccessManager::Operation op)
+	{
+		switch (op)
+		{
+		case QNetworkAccessManager::HeadOperation:
+			return "HEAD";
+		case QNetworkAccessManager::GetOperation:
+			return "GET";
+		case QNetworkAccessManager::PutOperation:
+			return "PUT";
+		case QNetworkAccessManager::PostOperation:
+			return "POST";
+		case QNetworkAccessManager::DeleteOperation:
+			return "DELETE";
+		default:
+			return "UNKNOWN";
+		}
+	}
+
+	void WriteHarHeaders (QTextStream& out, const Headers_t& headers)
+	{
+		out << "[";
+		bool first = true;
+		for (const auto& pair : headers)
+		{
+			if (!first)
+				out << ",";
+			first = false;
+			out << "{\"name\":" << JsonString (pair.first)
+					<< ",\"value\":" << JsonString (pair.second) << "}";
+		}
+		out << "]";
+	}
+
+	QString FindHeader (const Headers_t& headers, const QString& name)
+	{
+		for (const auto& pair : headers)
+			if (!pair.first.compare (name, Qt::CaseInsensitive))
+				return pair.second;
+		return {};
+	}
+}
+
+bool RequestLog::ExportHar (QIODevice *device) const
+{
+	QTextStream out { device };
+	out.setCodec ("UTF-8");
+
+	out << "{\"log\":{\"version\":\"1.2\","
+			<< "\"creator\":{\"name\":\"LeechCraft NetworkMonitor\",\"version\":\"1.0\"},"
+			<< "\"entries\":[";
+
+	bool first = true;
+	for (auto id = First_; id < Next_; ++id)
+	{
+		const auto time = GetTime (id);
+		if (time < 0)
+			continue;
+
+		if (!first)
+			out << ",";
+		first = false;
+
+		const auto& replyHeaders = GetReplyHeaders (id);
+		const auto received = GetBytesReceived (id);
+
+		out << "{\"startedDateTime\":" << JsonString (HarDate (GetStarted (id)))
+				<< ",\"time\":" << time
+				<< ",\"request\":{\"method\":" << JsonString (OperationName (GetOperation (id)))
+				<< ",\"url\":" << JsonString (GetUrl (id))
+				<< ",\"httpVersion\":\"unknown\",\"cookies\":[],\"headers\":";
+		WriteHarHeaders (out, GetRequestHeaders (id));
+		out << ",\"queryString\":[],\"headersSize\":-1,\"bodySize\":" << GetBytesSent (id) << "}"
+				<< ",\"response\":{\"status\":" << GetStatus (id)
+				<< ",\"statusText\":" << JsonString (GetReason (id))
+				<< ",\"httpVersion\":\"unknown\",\"cookies\":[],\"headers\":";
+		WriteHarHeaders (out, replyHeaders);
+		out << ",\"content\":{\"size\":" << received
+				<< ",\"mimeType\":" << JsonString (FindHeader (replyHeaders, "Content-Type")) << "}"
+				<< ",\"redirectURL\":" << JsonString (FindHeader (replyHeaders, "Location"))
+				<< ",\"headersSize\":-1,\"bodySize\":" << received << "}"
+				<< ",\"cache\":{},\"timings\":{\"send\":0,\"wait\":" << time << ",\"receive\":0}}";
+
+		// Don't let the whole log pile up in the stream buffer.
+		out.flush ();
+	}
+
+	out << "]}}";
+	out.flush ();
+
+	return out.status () == QTextStream::Ok;
+}
+
+int RequestLog::Slot (quint64 id) const
+{
+	return static_cast<int> (id % Capacity_);
+}
+
+void RequestLog::Evict ()
+{
+	const auto id = First_++;
+	const auto slot = Slot (id);
+
+	Strings_.Release (Hosts_ [slot]);
+	Strings_.Release (Reasons_ [slot]);
+	Hosts_ [slot] = 0;
+	Reasons_ [slot] = 0;
+	Urls_ [slot].clear ();
+	Release (RequestHeaders_ [slot]);
+	Release (ReplyHeaders_ [slot]);
+
+	if (const auto reply = PendingReplies_.take (id))
+		Reply2ID_.remove (reply);
+}
+
+RequestLog::InternedHeaders_t RequestLog::Intern (const Headers_t& headers)
+{
+	InternedHeaders_t result;
+	result.reserve (headers.size ());
+	for (const auto& pair : headers)
+		result.append ({ Strings_.Intern (pair.first), Strings_.Intern (pair.second) });
+	return result;
+}
+
+Headers_t RequestLog::Resolve (const InternedHeaders_t& headers) const
+{
+	Headers_t result;
+	result.reserve (headers.size ());
+	for (const auto& pair : headers)
+		result.append ({ Strings_.Get (pair.first), Strings_.Get (pair.second) });
+	return result;
+}
+
+void RequestLog::Release (InternedHeaders_t& headers)
+{
+	for (const auto& pair : headers)
+	{
+		Strings_.Release (pair.first);
+		Strings_.Release (pair.second);
+	}
+	headers.clear ();
+}
+
+namespace
+{
+	template<typename T>
+	Headers_t GetHeaders (const T& object)
+	{
+		Headers_t result;
+		const auto codec = QTextCodec::codecForName ("UTF-8");
+		for (const auto& header : object.rawHeaderList ())
+			result.append ({ codec->toUnicode (header), codec->toUnicode (object.rawHeader (header)) });
+		return result;
+	}
+}
+
+void RequestLog::handleRequest (QNetworkAccessManager::Operation op,
+		const QNetworkRequest& req, QNetworkReply *rep)
+{
+	if (rep->isFinished ())
+	{
+		qWarning () << Q_FUNC_INFO
+			<< "skipping the finished reply"
+			<< rep;
+		return;
+	}
+
+	if (Next_ - First_ >= static_cast<quint64> (Capacity_))
+		Evict ();
+
+	const auto id = Next_++;
+	const auto slot = Slot (id);
+
+	const auto& url = req.url ();
+	Started_ [slot] = QDateTime::currentMSecsSinceEpoch ();
+	Finished_ [slot] = -1;
+	Operations_ [slot] = op;
+	Statuses_ [slot] = 0;
+	Errors_ [slot] = QNetworkReply::NoError;
+	Urls_ [slot] = url.toString ();
+	Hosts_ [slot] = Strings_.Intern (url.host ());
+	BytesSent_ [slot] = req.header (QNetworkRequest::ContentLengthHeader).toLongLong ();
+	BytesReceived_ [slot] = 0;
+
+	Reply2ID_ [rep] = id;
+	PendingReplies_ [id] = rep;
+
+	connect (rep,
+			SIGNAL (error (QNetworkReply::NetworkError)),
+			this,
+			SLOT (handleFinished ()));
+	connect (rep,
+			SIGNAL (finished ()),
+			this,
+			SLOT (handleFinished ()));
+	connect (rep,
+			SIGNAL (destroyed (QObject*)),
+			this,
+			SLOT (handleReplyDestroyed (QObject*)));
+
+	emit requestAdded (id);
+}
+
+void RequestLog::Finish (quint64 id, QNetworkReply *reply)
+{
+	PendingReplies_.remove (id);
+
+	const auto slot = Slot (id);
+	Finished_ [slot] = QDateTime::currentMSecsSinceEpoch ();
+
+	if (reply)
+	{
+		Statuses_ [slot] = reply->attribute (QNetworkRequest::HttpStatusCodeAttribute).toInt ();
+		Errors_ [slot] = reply->error ();
+		Reasons_ [slot] = Strings_.Intern (reply->attribute (QNetworkRequest::HttpReasonPhraseAttribute).toString ());
+
+		const auto& length = reply->header (QNetworkRequest::ContentLengthHeader);
+		BytesReceived_ [slot] = length.isValid () ?
+				length.toLongLong () :
+				reply->bytesAvailable ();
+
+		RequestHeaders_ [slot] = Intern (GetHeaders (reply->request ()));
+		ReplyHeaders_ [slot] = Intern (GetHeaders (*reply));
+	}
+	else
+		Errors_ [slot] = QNetworkReply::OperationCanceledError;
+
+	emit requestFinished (id);
+}
+
+void RequestLog::handleFinished ()
+{
+	const auto reply = qobject_cast<QNetworkReply*> (sender ());
+	if (!reply)
+	{
+		qWarning () << Q_FUNC_INFO
+			<< sender ()
+			<< "not found";
+		return;
+	}
+
+	// Both error() and finished() lead here, only the first one counts.
+	const auto pos = Reply2ID_.find (reply);
+	if (pos == Reply2ID_.end ())
+		return;
+
+	const auto id = *pos;
+	Reply2ID_.erase (pos);
+	Finish (id, reply);
+}
+
+void RequestLog::handleReplyDestroyed (QObject *obj)
+{
+	const auto pos = Reply2ID_.find (static_cast<QNetworkReply*> (obj));
+	if (pos == Reply2ID_.end ())
+		return;
+
+	const auto id = *pos;
+	Reply2ID_.erase (pos);
+	Finish (id, nullptr);
+}
+}
+}
+}
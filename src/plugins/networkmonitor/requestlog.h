@@ -0,0 +1,203 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+
+#pragma once
+
+#include <QHash>
+#include <QObject>
+#include <QPair>
+#include <QPointer>
+#include <QVector>
+#include <QNetworkAccessManager>
+#include <QNetworkReply>
+
+class QIODevice;
+
+namespace LeechCraft
+{
+	namespace Plugins
+	{
+		namespace NetworkMonitor
+		{
+			/** @brief Reference-counted pool of interned strings.
+			 *
+			 * The empty string always has the ID 0.
+			 */
+			class StringPool
+			{
+				QHash<QString, quint32> String2ID_;
+				QVector<QString> Strings_;
+				QVector<quint32> Refs_;
+				QVector<quint32> Free_;
+			public:
+				StringPool ();
+
+				quint32 Intern (const QString&);
+				void Release (quint32);
+
+				const QString& Get (quint32) const;
+				quint32 Find (const QString&) const;
+			};
+
+			using Headers_t = QList<QPair<QString, QString>>;
+
+			struct HostStats
+			{
+				QString Host_;
+				int Requests_ = 0;
+				int Failed_ = 0;
+				qint64 BytesSent_ = 0;
+				qint64 BytesReceived_ = 0;
+				qint64 MedianTime_ = -1;
+				qint64 P95Time_ = -1;
+			};
+
+			/** @brief Returns the nearest-rank percentile of the values.
+			 *
+			 * The values are partially reordered. -1 is returned for an
+			 * empty vector.
+			 *
+			 * @param[in] p The percentile in the [0; 1] range.
+			 */
+			qint64 Percentile (QVector<qint64>& values, double p);
+
+			/** @brief Bounded log of the network requests.
+			 *
+			 * Requests are identified by sequential IDs. Only the last
+			 * GetCapacity() requests are kept, each request taking a
+			 * slot in the fixed-size columns, and the strings repeating
+			 * between the requests (hosts, header names and values) are
+			 * interned.
+			 */
+			class RequestLog : public QObject
+			{
+				Q_OBJECT
+
+				using InternedHeaders_t = QVector<QPair<quint32, quint32>>;
+
+				const int Capacity_;
+				quint64 First_ = 0;
+				quint64 Next_ = 0;
+
+				QVector<qint64> Started_;
+				QVector<qint64> Finished_;
+				QVector<quint8> Operations_;
+				QVector<qint16> Statuses_;
+				QVector<qint16> Errors_;
+				QVector<quint32> Reasons_;
+				QVector<QString> Urls_;
+				QVector<quint32> Hosts_;
+				QVector<qint64> BytesSent_;
+				QVector<qint64> BytesReceived_;
+				QVector<InternedHeaders_t> RequestHeaders_;
+				QVector<InternedHeaders_t> ReplyHeaders_;
+
+				StringPool Strings_;
+
+				QHash<QNetworkReply*, quint64> Reply2ID_;
+				QHash<quint64, QPointer<QNetworkReply>> PendingReplies_;
+			public:
+				static const int DefaultCapacity = 10000;
+
+				struct Filter
+				{
+					QString Host_;
+					int MinStatus_ = 0;
+					int MaxStatus_ = 999;
+					qint64 MinTime_ = 0;
+				};
+
+				RequestLog (int capacity = DefaultCapacity, QObject* = nullptr);
+
+				int GetCapacity () const;
+				quint64 GetFirstID () const;
+				quint64 GetNextID () const;
+				bool Contains (quint64) const;
+
+				QList<quint64> GetPending () const;
+				QNetworkReply* GetPendingReply (quint64) const;
+
+				qint64 GetStarted (quint64) const;
+				qint64 GetFinished (quint64) const;
+				qint64 GetTime (quint64) const;
+				QNetworkAccessManager::Operation GetOperation (quint64) const;
+				int GetStatus (quint64) const;
+				QString GetReason (quint64) const;
+				QNetworkReply::NetworkError GetError (quint64) const;
+				QString GetUrl (quint64) const;
+				QString GetHost (quint64) const;
+				qint64 GetBytesSent (quint64) const;
+				qint64 GetBytesReceived (quint64) const;
+				Headers_t GetRequestHeaders (quint64) const;
+				Headers_t GetReplyHeaders (quint64) const;
+
+				/** @brief Returns the finished requests matching the filter.
+				 */
+				QList<quint64> Select (const Filter&) const;
+
+				/** @brief Returns the per-host statistics of the finished
+				 * requests matching the filter.
+				 *
+				 * The times are in milliseconds.
+				 */
+				QList<HostStats> GetHostStats (const Filter& = {}) const;
+
+				/** @brief Returns the statistics over all the finished
+				 * requests matching the filter.
+				 */
+				HostStats GetTotalStats (const Filter& = {}) const;
+
+				/** @brief Writes the finished requests as a HAR 1.2 log.
+				 *
+				 * The log is written entry by entry without building it
+				 * in memory first.
+				 */
+				bool ExportHar (QIODevice*) const;
+			private:
+				int Slot (quint64 id) const;
+				void Evict ();
+				InternedHeaders_t Intern (const Headers_t&);
+				Headers_t Resolve (const InternedHeaders_t&) const;
+				void Release (InternedHeaders_t&);
+				bool Matches (quint64, const Filter&, quint32 hostId) const;
+				void Finish (quint64, QNetworkReply*);
+			public slots:
+				void handleRequest (QNetworkAccessManager::Operation,
+						const QNetworkRequest&, QNetworkReply*);
+			private slots:
+				void handleFinished ();
+				void handleReplyDestroyed (QObject*);
+			signals:
+				void requestAdded (quint64);
+				void requestFinished (quint64);
+			};
+		}
+	}
+}
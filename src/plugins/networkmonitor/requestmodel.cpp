@@ -27,18 +27,18 @@
  * DEALINGS IN THE SOFTWARE.
  **********************************************************************/
 
+
 #include "requestmodel.h"
+#include <algorithm>
 #include <QNetworkRequest>
 #include <QNetworkReply>
-#include <QPointer>
 #include <QTextCodec>
 #include <QDateTime>
+#include <QTimer>
 #include <QtDebug>
-#include <util/sll/qtutil.h>
+#include <util/util.h>
 #include "headermodel.h"
-
-using GuardedReply_t = QPointer<QNetworkReply>;
-Q_DECLARE_METATYPE (GuardedReply_t)
+#include "requestlog.h"
 
 namespace LeechCraft
 {
@@ -46,17 +46,30 @@ namespace Plugins
 {
 namespace NetworkMonitor
 {
-RequestModel::RequestModel (QObject *parent)
-: QStandardItemModel { parent }
+RequestModel::RequestModel (RequestLog *log, QObject *parent)
+: QAbstractItemModel { parent }
+, Log_ { log }
 , RequestHeadersModel_ { new HeaderModel { this } }
 , ReplyHeadersModel_ { new HeaderModel { this } }
+, FlushTimer_ { new QTimer { this } }
 {
-	setHorizontalHeaderLabels ({
-			tr ("Date started"),
-			tr ("Date finished"),
-			tr ("Type"),
-			tr ("Host")
-		});
+	FlushTimer_->setSingleShot (true);
+	FlushTimer_->setInterval (FlushInterval);
+	connect (FlushTimer_,
+			SIGNAL (timeout ()),
+			this,
+			SLOT (flush ()));
+
+	connect (Log_,
+			SIGNAL (requestAdded (quint64)),
+			this,
+			SLOT (handleRequestAdded ()));
+	connect (Log_,
+			SIGNAL (requestFinished (quint64)),
+			this,
+			SLOT (handleRequestFinished (quint64)));
+
+	Seen_ = Log_->GetNextID ();
 }
 
 HeaderModel* RequestModel::GetRequestHeadersModel () const
@@ -69,136 +82,183 @@ HeaderModel* RequestModel::GetReplyHeadersModel () const
 	return ReplyHeadersModel_;
 }
 
-void RequestModel::handleRequest (QNetworkAccessManager::Operation op,
-		const QNetworkRequest& req, QNetworkReply *rep)
+QModelIndex RequestModel::index (int row, int column, const QModelIndex& parent) const
 {
-	if (rep->isFinished ())
-	{
-		qWarning () << Q_FUNC_INFO
-			<< "skipping the finished reply"
-			<< rep;
-		return;
-	}
-	QList<QStandardItem*> items;
-	QString opName;
-	switch (op)
-	{
-		case QNetworkAccessManager::HeadOperation:
-			opName = "HEAD";
-			break;
-		case QNetworkAccessManager::GetOperation:
-			opName = "GET";
-			break;
-		case QNetworkAccessManager::PutOperation:
-			opName = "PUT";
-			break;
-		case QNetworkAccessManager::PostOperation:
-			opName = "POST";
-			break;
-		case QNetworkAccessManager::DeleteOperation:
-			opName = "DELETE";
-			break;
-		case QNetworkAccessManager::UnknownOperation:
-			opName = "Unknown";
-			break;
-		case QNetworkAccessManager::CustomOperation:
-			opName = "Custom";
-			break;
-	}
-	items.push_back (new QStandardItem (QDateTime::currentDateTime ().toString ()));
-	items.push_back (new QStandardItem (tr ("In progress")));
-	items.push_back (new QStandardItem (opName));
-	items.push_back (new QStandardItem (req.url ().toString ()));
-	items.first ()->setData (QVariant::fromValue<GuardedReply_t> (rep));
-	appendRow (items);
-
-	connect (rep,
-			SIGNAL (error (QNetworkReply::NetworkError )),
-			this,
-			SLOT (handleFinished ()));
-	connect (rep,
-			SIGNAL (finished ()),
-			this,
-			SLOT (handleFinished ()));
-	connect (rep,
-			SIGNAL (destroyed (QObject*)),
-			this,
-			SLOT (handleGonnaDestroy (QObject*)));
+	if (parent.isValid () ||
+			row < 0 || row >= Rows_.size () ||
+			column < 0 || column >= columnCount ())
+		return {};
+
+	return createIndex (row, column);
+}
+
+QModelIndex RequestModel::parent (const QModelIndex&) const
+{
+	return {};
+}
+
+int RequestModel::rowCount (const QModelIndex& parent) const
+{
+	return parent.isValid () ? 0 : Rows_.size ();
+}
+
+int RequestModel::columnCount (const QModelIndex&) const
+{
+	return Column::Time + 1;
 }
 
 namespace
 {
-	template<typename T>
-	QMap<QString, QVariant> GetHeaders (const T *object)
+	QString GetOperationName (QNetworkAccessManager::Operation op)
 	{
-		QMap<QString, QVariant> result;
-		const auto codec = QTextCodec::codecForName ("UTF-8");
-		for (const auto& header : object->rawHeaderList ())
-			result [codec->toUnicode (header)] = codec->toUnicode (object->rawHeader (header));
-		return result;
-	}
+		switch (op)
+		{
+			case QNetworkAccessManager::HeadOperation:
+				return "HEAD";
+			case QNetworkAccessManager::GetOperation:
+				return "GET";
+			case QNetworkAccessManager::PutOperation:
+				return "PUT";
+			case QNetworkAccessManager::PostOperation:
+				return "POST";
+			case QNetworkAccessManager::DeleteOperation:
+				return "DELETE";
+			case QNetworkAccessManager::UnknownOperation:
+				return "Unknown";
+			case QNetworkAccessManager::CustomOperation:
+				return "Custom";
+		}
 
-	template<typename T>
-	void FeedHeaders (const T& object, HeaderModel *model)
-	{
-		FeedHeaders (GetHeaders (object), model);
+		return {};
 	}
 
-	template<>
-	void FeedHeaders (const QMap<QString, QVariant>& headers, HeaderModel *model)
+	QString FormatTime (qint64 msecs)
 	{
-		for (const auto& pair : Util::Stlize (headers))
-			model->AddHeader (pair.first, pair.second.toString ());
+		return QDateTime::fromMSecsSinceEpoch (msecs).toString ();
 	}
 }
 
-void RequestModel::handleFinished ()
+QVariant RequestModel::data (const QModelIndex& index, int role) const
 {
-	const auto reply = qobject_cast<QNetworkReply*> (sender ());
-	if (!reply)
+	if (!index.isValid () || role != Qt::DisplayRole)
+		return {};
+
+	const auto id = Rows_.at (index.row ());
+	if (!Log_->Contains (id))
+		return {};
+
+	const auto isFinished = Log_->GetFinished (id) >= 0;
+
+	switch (index.column ())
 	{
-		qWarning () << Q_FUNC_INFO
-			<< sender ()
-			<< "not found";
-		return;
+	case Column::Started:
+		return FormatTime (Log_->GetStarted (id));
+	case Column::Finished:
+		return isFinished ?
+				FormatTime (Log_->GetFinished (id)) :
+				tr ("In progress");
+	case Column::Type:
+		return GetOperationName (Log_->GetOperation (id));
+	case Column::Url:
+		return Log_->GetUrl (id);
+	case Column::Status:
+		if (!isFinished)
+			return {};
+		if (const auto status = Log_->GetStatus (id))
+			return status;
+		return Log_->GetError (id) == QNetworkReply::NoError ?
+				QVariant {} :
+				tr ("Error %1").arg (Log_->GetError (id));
+	case Column::Size:
+		return isFinished ?
+				Util::MakePrettySize (Log_->GetBytesReceived (id)) :
+				QVariant {};
+	case Column::Time:
+		return isFinished ?
+				tr ("%1 ms").arg (Log_->GetTime (id)) :
+				QVariant {};
 	}
 
-	for (int i = 0; i < rowCount (); ++i)
+	return {};
+}
+
+QVariant RequestModel::headerData (int section, Qt::Orientation orient, int role) const
+{
+	if (orient != Qt::Horizontal || role != Qt::DisplayRole)
+		return {};
+
+	switch (section)
 	{
-		if (item (i)->data ().value<GuardedReply_t> () != reply)
-			continue;
+	case Column::Started:
+		return tr ("Date started");
+	case Column::Finished:
+		return tr ("Date finished");
+	case Column::Type:
+		return tr ("Type");
+	case Column::Url:
+		return tr ("Host");
+	case Column::Status:
+		return tr ("Status");
+	case Column::Size:
+		return tr ("Size");
+	case Column::Time:
+		return tr ("Time");
+	}
 
-		if (Clear_)
-		{
-			removeRow (i);
-			break;
-		}
+	return {};
+}
 
-		item (i, 0)->setData ({});
-		item (i, 1)->setText (QDateTime::currentDateTime ().toString ());
+bool RequestModel::IsShown (quint64 id) const
+{
+	return Log_->Contains (id) &&
+			(!Clear_ || Log_->GetPendingReply (id));
+}
 
-		const auto& r = reply->request ();
-		item (i, 1)->setData (GetHeaders (&r));
+int RequestModel::FindRow (quint64 id) const
+{
+	const auto pos = std::lower_bound (Rows_.begin (), Rows_.end (), id);
+	return pos != Rows_.end () && *pos == id ?
+			std::distance (Rows_.begin (), pos) :
+			-1;
+}
 
-		auto headers = GetHeaders (reply);
-		headers ["[HTTP response]"] = QString ("%1 (%2)")
-				.arg (reply->attribute (QNetworkRequest::HttpStatusCodeAttribute).toInt ())
-				.arg (reply->attribute (QNetworkRequest::HttpReasonPhraseAttribute).toString ());
-		item (i, 2)->setData (headers);
-		break;
-	}
+void RequestModel::ScheduleFlush ()
+{
+	if (!FlushTimer_->isActive ())
+		FlushTimer_->start ();
 }
 
 void RequestModel::setClear (bool clear)
 {
+	FlushTimer_->stop ();
+
+	beginResetModel ();
 	Clear_ = clear;
+	Rows_.clear ();
+	for (auto id = Log_->GetFirstID (); id < Log_->GetNextID (); ++id)
+		if (IsShown (id))
+			Rows_ << id;
+	Seen_ = Log_->GetNextID ();
+	Dirty_.clear ();
+	endResetModel ();
 
-	if (Clear_)
+	handleCurrentChanged ({});
+}
+
+namespace
+{
+	template<typename T>
+	void FeedHeaders (const T& object, HeaderModel *model)
 	{
-		for (int i = rowCount () - 1; i >= 0; --i)
-			if (!item (i)->data ().value<GuardedReply_t> ())
-				removeRow (i);
-		handleCurrentChanged ({});
+		const auto codec = QTextCodec::codecForName ("UTF-8");
+		for (const auto& header : object.rawHeaderList ())
+			model->AddHeader (codec->toUnicode (header), codec->toUnicode (object.rawHeader (header)));
+	}
+
+	void FeedHeaders (const Headers_t& headers, HeaderModel *model)
+	{
+		for (const auto& pair : headers)
+			model->AddHeader (pair.first, pair.second);
 	}
 }
 
@@ -210,36 +270,86 @@ void RequestModel::handleCurrentChanged (const QModelIndex& newItem)
 	if (!newItem.isValid ())
 		return;
 
-	const auto reply = item (newItem.row (), 0)->data ().value<GuardedReply_t> ();
-	if (reply)
+	const auto id = Rows_.value (newItem.row ());
+	if (!Log_->Contains (id))
+		return;
+
+	if (const auto reply = Log_->GetPendingReply (id))
 	{
-		const auto& r = reply->request ();
-		FeedHeaders (&r, RequestHeadersModel_);
-		FeedHeaders (reply.data (), ReplyHeadersModel_);
+		FeedHeaders (reply->request (), RequestHeadersModel_);
+		FeedHeaders (*reply, ReplyHeadersModel_);
 	}
 	else
 	{
-		FeedHeaders (item (newItem.row (), 1)->
-				data ().toMap (), RequestHeadersModel_);
-		FeedHeaders (item (newItem.row (), 2)->
-				data ().toMap (), ReplyHeadersModel_);
+		FeedHeaders (Log_->GetRequestHeaders (id), RequestHeadersModel_);
+		ReplyHeadersModel_->AddHeader ("[HTTP response]",
+				QString ("%1 (%2)")
+					.arg (Log_->GetStatus (id))
+					.arg (Log_->GetReason (id)));
+		FeedHeaders (Log_->GetReplyHeaders (id), ReplyHeadersModel_);
 	}
 }
 
-void RequestModel::handleGonnaDestroy (QObject *obj)
+void RequestModel::handleRequestAdded ()
+{
+	ScheduleFlush ();
+}
+
+void RequestModel::handleRequestFinished (quint64 id)
 {
-	for (int i = 0; i < rowCount (); ++i)
+	Dirty_ << id;
+	ScheduleFlush ();
+}
+
+void RequestModel::flush ()
+{
+	for (int i = Rows_.size () - 1; i >= 0; )
 	{
-		const auto ci = item (i);
-		if (ci->data ().value<GuardedReply_t> () == obj)
+		if (IsShown (Rows_.at (i)))
 		{
-			if (Clear_)
-				removeRow (i);
-			else
-				ci->setData ({});
-			break;
+			--i;
+			continue;
 		}
+
+		int first = i;
+		while (first > 0 && !IsShown (Rows_.at (first - 1)))
+			--first;
+
+		beginRemoveRows ({}, first, i);
+		Rows_.erase (Rows_.begin () + first, Rows_.begin () + i + 1);
+		endRemoveRows ();
+
+		i = first - 1;
 	}
+
+	QList<quint64> added;
+	for (auto id = std::max (Seen_, Log_->GetFirstID ()); id < Log_->GetNextID (); ++id)
+		if (IsShown (id))
+			added << id;
+	Seen_ = Log_->GetNextID ();
+
+	if (!added.isEmpty ())
+	{
+		beginInsertRows ({}, Rows_.size (), Rows_.size () + added.size () - 1);
+		Rows_ += added;
+		endInsertRows ();
+	}
+
+	int minRow = Rows_.size ();
+	int maxRow = -1;
+	for (const auto id : Dirty_)
+	{
+		const auto row = FindRow (id);
+		if (row < 0)
+			continue;
+
+		minRow = std::min (minRow, row);
+		maxRow = std::max (maxRow, row);
+	}
+	Dirty_.clear ();
+
+	if (maxRow >= 0)
+		emit dataChanged (index (minRow, 0), index (maxRow, columnCount () - 1));
 }
 }
 }
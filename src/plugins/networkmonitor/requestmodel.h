@@ -27,10 +27,13 @@
  * DEALINGS IN THE SOFTWARE.
  **********************************************************************/
 
+
 #pragma once
 
-#include <QStandardItemModel>
-#include <QNetworkAccessManager>
+#include <QAbstractItemModel>
+#include <QSet>
+
+class QTimer;
 
 namespace LeechCraft
 {
@@ -39,25 +42,65 @@ namespace LeechCraft
 		namespace NetworkMonitor
 		{
 			class HeaderModel;
+			class RequestLog;
 
-			class RequestModel : public QStandardItemModel
+			/** @brief Flat table view over the RequestLog.
+			 *
+			 * The model keeps only the IDs of the shown requests, the
+			 * data itself is fetched from the log on demand. Changes in
+			 * the log are accumulated and applied to the model in
+			 * batches so that bursts of requests don't flood the views.
+			 */
+			class RequestModel : public QAbstractItemModel
 			{
 				Q_OBJECT
 
+				RequestLog * const Log_;
 				HeaderModel * const RequestHeadersModel_;
 				HeaderModel * const ReplyHeadersModel_;
+				QTimer * const FlushTimer_;
+
 				bool Clear_ = true;
+
+				QList<quint64> Rows_;
+				quint64 Seen_ = 0;
+				QSet<quint64> Dirty_;
 			public:
-				RequestModel (QObject* = 0);
+				enum Column
+				{
+					Started,
+					Finished,
+					Type,
+					Url,
+					Status,
+					Size,
+					Time
+				};
+
+				static const int FlushInterval = 250;
+
+				RequestModel (RequestLog*, QObject* = 0);
+
 				HeaderModel* GetRequestHeadersModel () const;
 				HeaderModel* GetReplyHeadersModel () const;
+
+				QModelIndex index (int, int, const QModelIndex& = {}) const;
+				QModelIndex parent (const QModelIndex&) const;
+				int rowCount (const QModelIndex& = {}) const;
+				int columnCount (const QModelIndex& = {}) const;
+				QVariant data (const QModelIndex&, int) const;
+				QVariant headerData (int, Qt::Orientation, int) const;
+			private:
+				bool IsShown (quint64) const;
+				int FindRow (quint64) const;
+				void ScheduleFlush ();
 			public slots:
-				void handleRequest (QNetworkAccessManager::Operation,
-						const QNetworkRequest&, QNetworkReply*);
-				void handleFinished ();
 				void setClear (bool);
 				void handleCurrentChanged (const QModelIndex&);
-				void handleGonnaDestroy (QObject*);
+			private slots:
+				void handleRequestAdded ();
+				void handleRequestFinished (quint64);
+				void flush ();
 			};
 		}
 	}
@@ -0,0 +1,182 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+
+#include "requestlogtest.h"
+#include <QtTest>
+#include <requestlog.h>
+
+QTEST_MAIN (LeechCraft::Plugins::NetworkMonitor::RequestLogTest)
+
+namespace LeechCraft
+{
+	namespace Plugins
+	{
+		namespace NetworkMonitor
+		{
+			namespace
+			{
+				class FakeReply : public QNetworkReply
+				{
+				public:
+					FakeReply (const QNetworkRequest& req, QObject *parent)
+					: QNetworkReply { parent }
+					{
+						setRequest (req);
+						setUrl (req.url ());
+						setOperation (QNetworkAccessManager::GetOperation);
+						open (QIODevice::ReadOnly);
+					}
+
+					void Finish (int status, qint64 size, NetworkError code = NoError)
+					{
+						setAttribute (QNetworkRequest::HttpStatusCodeAttribute, status);
+						setHeader (QNetworkRequest::ContentLengthHeader, size);
+						if (code != NoError)
+						{
+							setError (code, "fake error");
+							emit error (code);
+						}
+						setFinished (true);
+						emit finished ();
+					}
+
+					void abort ()
+					{
+					}
+				protected:
+					qint64 readData (char*, qint64)
+					{
+						return -1;
+					}
+				};
+
+				FakeReply* AddRequest (RequestLog& log, const QString& host)
+				{
+					const QNetworkRequest req { QUrl { "http://" + host + "/" } };
+					const auto reply = new FakeReply { req, &log };
+					log.handleRequest (QNetworkAccessManager::GetOperation, req, reply);
+					return reply;
+				}
+			}
+
+			void RequestLogTest::testRingEviction ()
+			{
+				RequestLog log { 3 };
+				for (int i = 0; i < 5; ++i)
+					AddRequest (log, QString ("h%1.example").arg (i))->Finish (200, i);
+
+				QCOMPARE (log.GetFirstID (), 2ull);
+				QCOMPARE (log.GetNextID (), 5ull);
+				QVERIFY (!log.Contains (1));
+				QVERIFY (log.Contains (2));
+				QVERIFY (!log.Contains (5));
+
+				QCOMPARE (log.GetHost (2), QString ("h2.example"));
+				QCOMPARE (log.GetHost (4), QString ("h4.example"));
+				QCOMPARE (log.GetBytesReceived (3), 3ll);
+				QCOMPARE (log.Select ({}), (QList<quint64> { 2, 3, 4 }));
+
+				// The strings of the evicted requests are released.
+				RequestLog::Filter filter;
+				filter.Host_ = "h0.example";
+				QVERIFY (log.Select (filter).isEmpty ());
+				QCOMPARE (log.GetHostStats ().size (), 3);
+				QCOMPARE (log.GetTotalStats ().Requests_, 3);
+			}
+
+			void RequestLogTest::testEvictPending ()
+			{
+				RequestLog log { 2 };
+				const auto pending = AddRequest (log, "slow.example");
+				AddRequest (log, "fast.example")->Finish (200, 0);
+				QCOMPARE (log.GetPending (), (QList<quint64> { 0 }));
+
+				AddRequest (log, "fast.example")->Finish (200, 0);
+				QVERIFY (!log.Contains (0));
+				QVERIFY (log.GetPending ().isEmpty ());
+
+				QSignalSpy spy { &log, SIGNAL (requestFinished (quint64)) };
+				pending->Finish (200, 0);
+				QCOMPARE (spy.count (), 0);
+				QCOMPARE (log.GetTotalStats ().Requests_, 2);
+			}
+
+			void RequestLogTest::testHostStats ()
+			{
+				RequestLog log;
+				AddRequest (log, "a.example")->Finish (200, 100);
+				AddRequest (log, "a.example")->Finish (404, 10, QNetworkReply::ContentNotFoundError);
+				AddRequest (log, "b.example")->Finish (200, 1000);
+				AddRequest (log, "a.example")->Finish (200, 1);
+
+				const auto& stats = log.GetHostStats ();
+				QCOMPARE (stats.size (), 2);
+				QCOMPARE (stats.at (0).Host_, QString ("a.example"));
+				QCOMPARE (stats.at (0).Requests_, 3);
+				QCOMPARE (stats.at (0).Failed_, 1);
+				QCOMPARE (stats.at (0).BytesReceived_, 111ll);
+				QCOMPARE (stats.at (1).Host_, QString ("b.example"));
+				QCOMPARE (stats.at (1).Requests_, 1);
+
+				const auto& total = log.GetTotalStats ();
+				QCOMPARE (total.Requests_, 4);
+				QCOMPARE (total.Failed_, 1);
+				QCOMPARE (total.BytesReceived_, 1111ll);
+				QVERIFY (total.MedianTime_ >= 0);
+				QVERIFY (total.P95Time_ >= total.MedianTime_);
+
+				RequestLog::Filter filter;
+				filter.MinStatus_ = 400;
+				QCOMPARE (log.Select (filter), (QList<quint64> { 1 }));
+			}
+
+			void RequestLogTest::testPercentile ()
+			{
+				QVector<qint64> empty;
+				QCOMPARE (Percentile (empty, 0.5), -1ll);
+
+				QVector<qint64> single { 42 };
+				QCOMPARE (Percentile (single, 0.5), 42ll);
+				QCOMPARE (Percentile (single, 0.95), 42ll);
+
+				QVector<qint64> values;
+				for (int i = 20; i > 0; --i)
+					values << i;
+				QCOMPARE (Percentile (values, 0.5), 10ll);
+				QCOMPARE (Percentile (values, 0.95), 19ll);
+				QCOMPARE (Percentile (values, 1), 20ll);
+				QCOMPARE (Percentile (values, 0), 1ll);
+
+				QVector<qint64> odd { 5, 1, 3 };
+				QCOMPARE (Percentile (odd, 0.5), 3ll);
+			}
+		}
+	}
+}
@@ -160,6 +160,16 @@ namespace Otlozhu
 		mgr->GetTodoStorage ()->AddItem (item);
 	}
 
+	QStringList Plugin::GetHandledMimes () const
+	{
+		return { "x-leechcraft/todo-item" };
+	}
+
+	QStringList Plugin::GetHandledUrlSchemes () const
+	{
+		return {};
+	}
+
 	Util::XmlSettingsDialog_ptr Plugin::GetSettingsDialog () const
 	{
 		return XSD_;
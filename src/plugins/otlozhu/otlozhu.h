@@ -38,6 +38,7 @@
 #endif
 
 #include <interfaces/ientityhandler.h>
+#include <interfaces/ientitydispatchhints.h>
 #include <interfaces/ihavesettings.h>
 
 namespace LeechCraft
@@ -51,12 +52,13 @@ namespace Otlozhu
 					, public IHaveTabs
 					, public IHaveSettings
 					, public IEntityHandler
+					, public IEntityDispatchHints
 #ifndef DISABLE_SYNC
 					, public ISyncable
 #endif
 	{
 		Q_OBJECT
-		Q_INTERFACES (IInfo IHaveTabs IEntityHandler IHaveSettings)
+		Q_INTERFACES (IInfo IHaveTabs IEntityHandler IEntityDispatchHints IHaveSettings)
 #ifndef DISABLE_SYNC
 		Q_INTERFACES (ISyncable)
 #endif
@@ -85,6 +87,9 @@ namespace Otlozhu
 		EntityTestHandleResult CouldHandle (const Entity&) const;
 		void Handle (Entity);
 
+		QStringList GetHandledMimes () const;
+		QStringList GetHandledUrlSchemes () const;
+
 		Util::XmlSettingsDialog_ptr GetSettingsDialog () const;
 
 #ifndef DISABLE_SYNC
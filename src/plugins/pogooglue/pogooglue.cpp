@@ -42,13 +42,13 @@ namespace Pogooglue
 {
 	void Plugin::Init (ICoreProxy_ptr proxy)
 	{
-		Util::InstallTranslator ("pogooglue");
-
 		Proxy_ = proxy;
 	}
 
 	void Plugin::SecondInit ()
 	{
+		// Init() may run outside of the main thread, see the manifest.
+		Util::InstallTranslator ("pogooglue");
 	}
 
 	void Plugin::Release ()
@@ -318,7 +318,7 @@ namespace CleanWeb
 				const QList<QList<FilterItem_ptr>>& exceptions,
 				const QList<QList<FilterItem_ptr>>& filters)
 		{
-			if (!XmlSettingsManager::Instance ()->property ("EnableFiltering").toBool ())
+			if (!XmlSettingsManager::Instance ()->EnableFiltering_.Get ())
 				return false;
 
 			if (!req.PageUrl_.isValid ())
@@ -30,6 +30,7 @@
 #pragma once
 
 #include <xmlsettingsdialog/basesettingsmanager.h>
+#include <xmlsettingsdialog/settinghandle.h>
 
 namespace LeechCraft
 {
@@ -41,6 +42,8 @@ namespace CleanWeb
 	{
 		XmlSettingsManager ();
 	public:
+		Util::SettingHandle<bool> EnableFiltering_ { this, "EnableFiltering", true };
+
 		static XmlSettingsManager* Instance ();
 	protected:
 		QSettings* BeginSettings () const override;
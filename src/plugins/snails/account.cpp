@@ -244,6 +244,9 @@ namespace Snails
 									HandleMsgHeaders (msgs.NewHeaders_, folder);
 									HandleUpdatedMessages (msgs.UpdatedMsgs_, folder);
 
+									if (msgs.SyncState_)
+										Storage_->SetFolderSyncState (this, folder, *msgs.SyncState_);
+
 									UpdateFolderCount (folder);
 
 									stats.NewMsgsCount_ += msgs.NewHeaders_.size ();
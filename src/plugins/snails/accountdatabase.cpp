@@ -206,6 +206,36 @@ namespace Snails
 		lock.Good ();
 	}
 
+	boost::optional<FolderSyncState> AccountDatabase::GetFolderSyncState (const QStringList& folder)
+	{
+		QueryGetFolderSyncState_.bindValue (":path", folder.join ("/"));
+		Util::DBLock::Execute (QueryGetFolderSyncState_);
+
+		const std::shared_ptr<void> finishGuard
+		{
+			nullptr,
+			[this] (void*) { QueryGetFolderSyncState_.finish (); }
+		};
+
+		if (!QueryGetFolderSyncState_.next ())
+			return {};
+
+		FolderSyncState state;
+		state.UIDValidity_ = QueryGetFolderSyncState_.value (0).toUInt ();
+		state.HighestModSeq_ = QueryGetFolderSyncState_.value (1).toULongLong ();
+		return state;
+	}
+
+	void AccountDatabase::SetFolderSyncState (const QStringList& folder, const FolderSyncState& state)
+	{
+		const auto folderId = AddFolder (folder);
+
+		QuerySetFolderSyncState_.bindValue (":folderId", folderId);
+		QuerySetFolderSyncState_.bindValue (":uidValidity", state.UIDValidity_);
+		QuerySetFolderSyncState_.bindValue (":highestModSeq", state.HighestModSeq_);
+		Util::DBLock::Execute (QuerySetFolderSyncState_);
+	}
+
 	int AccountDatabase::AddMessageUnfoldered (const Message_ptr& msg)
 	{
 		const auto& uniqueId = msg->GetMessageID ();
@@ -265,6 +295,14 @@ namespace Snails
 					FolderMessageId TEXT NOT NULL
 					)
 				)d";
+		table2queries ["folder_sync_state"] <<
+				R"d(
+					CREATE TABLE folder_sync_state (
+					FolderId INTEGER PRIMARY KEY REFERENCES folders (Id) ON DELETE CASCADE,
+					UIDValidity INTEGER NOT NULL,
+					HighestModSeq INTEGER NOT NULL
+					)
+				)d";
 
 		QSqlQuery query { *DB_ };
 		for (const auto& pair : Util::Stlize (table2queries))
@@ -358,6 +396,22 @@ namespace Snails
 					VALUES
 					(:msgTableId, :folderId, :msgId)
 				)d");
+
+		QueryGetFolderSyncState_ = QSqlQuery { *DB_ };
+		QueryGetFolderSyncState_.prepare (R"d(
+					SELECT folder_sync_state.UIDValidity, folder_sync_state.HighestModSeq
+					FROM folder_sync_state, folders
+					WHERE folders.FolderPath = :path
+					AND folders.Id = folder_sync_state.FolderId
+				)d");
+
+		QuerySetFolderSyncState_ = QSqlQuery { *DB_ };
+		QuerySetFolderSyncState_.prepare (R"d(
+					INSERT OR REPLACE INTO folder_sync_state
+					(FolderId, UIDValidity, HighestModSeq)
+					VALUES
+					(:folderId, :uidValidity, :highestModSeq)
+				)d");
 	}
 
 	int AccountDatabase::AddFolder (const QStringList& folder)
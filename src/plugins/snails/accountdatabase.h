@@ -35,6 +35,8 @@
 #include <QSqlQuery>
 #include <QStringList>
 #include <QMap>
+#include <QHash>
+#include "common.h"
 
 class QSqlDatabase;
 typedef std::shared_ptr<QSqlDatabase> QSqlDatabase_ptr;
@@ -76,6 +78,9 @@ namespace Snails
 		QSqlQuery QueryAddMsgUnfoldered_;
 		QSqlQuery QueryAddMsgToFolder_;
 
+		QSqlQuery QueryGetFolderSyncState_;
+		QSqlQuery QuerySetFolderSyncState_;
+
 		QMap<QStringList, int> KnownFolders_;
 	public:
 		AccountDatabase (const QDir&, Account*, QObject* = nullptr);
@@ -89,6 +94,9 @@ namespace Snails
 		void RemoveMessage (const QByteArray& msgId, const QStringList& folder,
 				const std::function<void ()>& continuation = {});
 
+		boost::optional<FolderSyncState> GetFolderSyncState (const QStringList& folder);
+		void SetFolderSyncState (const QStringList& folder, const FolderSyncState&);
+
 		boost::optional<int> GetMsgTableId (const QByteArray& uniqueId);
 		boost::optional<int> GetMsgTableId (const QByteArray& msgId, const QStringList& folder);
 	private:
@@ -283,19 +283,26 @@ namespace Snails
 		}
 
 		template<typename F, typename... Args>
-		QFuture<WrapFunctionType_t<F, Args...>> Schedule (QFutureInterface<WrapFunctionType_t<F, Args...>> iface, TaskPriority, const F& func, const Args&... args)
+		QFuture<WrapFunctionType_t<F, Args...>> Schedule (QFutureInterface<WrapFunctionType_t<F, Args...>> iface, TaskPriority prio, const F& func, const Args&... args)
 		{
-			auto reporting = [this, func, iface, args...] (AccountThreadWorker *w) mutable
+			auto reporting = [this, func, args...] (QFutureInterface<WrapFunctionType_t<F, Args...>>& iface)
 			{
 				IsRunning_ = true;
 
+				const auto w = Worker_.get ();
 				iface.reportStarted ();
 				Util::ReportFutureResult (iface, detail::WrapFunction<Args...> (w, func), w, args...);
 
 				IsRunning_ = false;
 			};
 
-			ScheduleImpl (std::move (reporting));
+			const TaskOptions options
+			{
+				prio == TaskPriority::High ? Priority::Interactive : Priority::Background
+			};
+			// The task reports to iface directly, so canceling the
+			// returned future drops the task if it's still queued.
+			ScheduleReporting (options, iface, std::move (reporting));
 
 			return iface.future ();
 		}
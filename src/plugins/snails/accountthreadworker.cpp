@@ -42,6 +42,7 @@
 #include <vmime/net/transport.hpp>
 #include <vmime/net/store.hpp>
 #include <vmime/net/message.hpp>
+#include <vmime/net/imap/IMAPFolderStatus.hpp>
 #include <vmime/utility/datetimeUtils.hpp>
 #include <vmime/dateTime.hpp>
 #include <vmime/messageParser.hpp>
@@ -560,15 +561,20 @@ namespace Snails
 
 	namespace
 	{
-		MessageVector_t GetMessagesInFolder (const VmimeFolder_ptr& folder, const QByteArray& lastId)
-		{
-			const int desiredFlags = vmime::net::fetchAttributes::FLAGS |
-						vmime::net::fetchAttributes::SIZE |
-						vmime::net::fetchAttributes::UID |
-						vmime::net::fetchAttributes::FULL_HEADER |
-						vmime::net::fetchAttributes::STRUCTURE |
-						vmime::net::fetchAttributes::ENVELOPE;
+		const int ListingFlags = vmime::net::fetchAttributes::FLAGS |
+				vmime::net::fetchAttributes::UID;
+
+		const int HeadersFlags = vmime::net::fetchAttributes::FLAGS |
+				vmime::net::fetchAttributes::SIZE |
+				vmime::net::fetchAttributes::UID |
+				vmime::net::fetchAttributes::FULL_HEADER |
+				vmime::net::fetchAttributes::STRUCTURE |
+				vmime::net::fetchAttributes::ENVELOPE;
+
+		const vmime::size_t FetchChunkSize = 100;
 
+		MessageVector_t GetMessagesInFolder (const VmimeFolder_ptr& folder, const QByteArray& lastId, int desiredFlags)
+		{
 			if (lastId.isEmpty ())
 			{
 				const auto count = folder->getMessageCount ();
@@ -576,10 +582,9 @@ namespace Snails
 				MessageVector_t messages;
 				messages.reserve (count);
 
-				const auto chunkSize = 100;
-				for (vmime::size_t i = 0; i < count; i += chunkSize)
+				for (vmime::size_t i = 0; i < count; i += FetchChunkSize)
 				{
-					const auto endVal = i + chunkSize;
+					const auto endVal = i + FetchChunkSize;
 					const auto& set = vmime::net::messageSet::byNumber (i + 1, std::min (count, endVal));
 					try
 					{
@@ -619,6 +624,62 @@ namespace Snails
 				}
 			}
 		}
+
+		bool FetchHeaders (const VmimeFolder_ptr& folder, MessageVector_t& messages)
+		{
+			for (size_t i = 0; i < messages.size (); i += FetchChunkSize)
+			{
+				const auto end = std::min (messages.size (), i + FetchChunkSize);
+				MessageVector_t chunk (messages.begin () + i, messages.begin () + end);
+				try
+				{
+					folder->fetchMessages (chunk, HeadersFlags);
+				}
+				catch (const std::exception& e)
+				{
+					qWarning () << Q_FUNC_INFO
+							<< "cannot fetch headers for messages"
+							<< i
+							<< "to"
+							<< end
+							<< "because:"
+							<< e.what ();
+					return false;
+				}
+			}
+
+			return true;
+		}
+
+		FolderSyncState GetServerSyncState (const VmimeFolder_ptr& folder)
+		{
+			FolderSyncState state;
+
+			/* The IMAP folder status carries UIDVALIDITY and, if the
+			 * server advertises CONDSTORE, HIGHESTMODSEQ as well.
+			 */
+			try
+			{
+				if (const auto& imapStatus = vmime::dynamicCast<vmime::net::imap::IMAPFolderStatus> (folder->getStatus ()))
+				{
+					state.UIDValidity_ = imapStatus->getUIDValidity ();
+					state.HighestModSeq_ = imapStatus->getHighestModSeq ();
+				}
+			}
+			catch (const std::exception& e)
+			{
+				qWarning () << Q_FUNC_INFO
+						<< "cannot get folder status:"
+						<< e.what ();
+			}
+
+			return state;
+		}
+
+		QByteArray GetUID (const vmime::shared_ptr<vmime::net::message>& msg)
+		{
+			return static_cast<vmime::string> (msg->getUID ()).c_str ();
+		}
 	}
 
 	auto AccountThreadWorker::FetchMessagesInFolder (const QStringList& folderName,
@@ -628,58 +689,132 @@ namespace Snails
 
 		qDebug () << Q_FUNC_INFO << folderName << folder.get () << lastId;
 
-		auto messages = GetMessagesInFolder (folder, lastId);
-		auto newMessages = Util::Map (messages, [this, &folderName] (const auto& msg)
-				{
-					auto res = FromHeaders (msg);
-					res->AddFolder (folderName);
-					return res;
-				});
-		auto existing = Storage_->LoadIDs (A_, folderName);
+		const auto isFullSync = lastId.isEmpty ();
+
+		const auto& serverState = GetServerSyncState (folder);
+		const auto& localState = Storage_->GetFolderSyncState (A_, folderName);
+
+		const auto& existingList = Storage_->LoadIDs (A_, folderName);
+		auto existing = existingList.toSet ();
+
+		/* If UIDVALIDITY has changed, all the UIDs we know are
+		 * meaningless, so we drop them and refetch the folder.
+		 */
+		const auto uidsInvalidated = localState && serverState.UIDValidity_ &&
+				localState->UIDValidity_ != serverState.UIDValidity_;
+		if (uidsInvalidated)
+		{
+			qDebug () << Q_FUNC_INFO
+					<< "UIDVALIDITY changed for"
+					<< folderName
+					<< "; dropping local messages";
+			existing.clear ();
+		}
+
+		/* With CONDSTORE the folder is known to be unchanged since the
+		 * last full sync if its HIGHESTMODSEQ is the same. The message
+		 * count check catches servers that don't bump it on expunge.
+		 */
+		if (isFullSync && localState && !uidsInvalidated && serverState.HighestModSeq_ &&
+				localState->HighestModSeq_ == serverState.HighestModSeq_ &&
+				static_cast<int> (folder->getMessageCount ()) == existing.size ())
+		{
+			qDebug () << Q_FUNC_INFO
+					<< folderName
+					<< "is unchanged since modseq"
+					<< serverState.HighestModSeq_;
+			return { {}, {}, existingList, {}, serverState };
+		}
+
+		const auto& listing = GetMessagesInFolder (folder, lastId, ListingFlags);
+
+		const auto& readStatuses = Storage_->GetReadStatuses (A_, folderName);
 
+		MessageVector_t newNetMessages;
+		QHash<QByteArray, bool> changedReadStatuses;
 		QList<QByteArray> ids;
+		QSet<QByteArray> seen;
+		seen.reserve (listing.size ());
 
-		QList<Message_ptr> updatedMessages;
-		Q_FOREACH (const auto& msg, newMessages)
+		for (const auto& netMsg : listing)
 		{
-			if (!existing.contains (msg->GetFolderID ()))
+			const auto& id = GetUID (netMsg);
+			seen << id;
+
+			if (!existing.contains (id))
+			{
+				newNetMessages.push_back (netMsg);
 				continue;
+			}
+
+			const bool isRead = netMsg->getFlags () & vmime::net::message::FLAG_SEEN;
+			const auto storedRead = readStatuses.find (id);
+			if (storedRead == readStatuses.end () || *storedRead != isRead)
+				changedReadStatuses [id] = isRead;
+			else
+				ids << id;
+		}
 
-			existing.removeAll (msg->GetFolderID ());
-			newMessages.removeAll (msg);
+		const auto headersFetched = FetchHeaders (folder, newNetMessages);
+		if (!headersFetched)
+			newNetMessages.clear ();
 
-			bool isUpdated = false;
+		const auto& newMessages = Util::Map (newNetMessages, [this, &folderName] (const auto& msg)
+				{
+					auto res = FromHeaders (msg);
+					res->AddFolder (folderName);
+					return res;
+				});
 
-			auto updated = Storage_->LoadMessage (A_, folderName, msg->GetFolderID ());
+		QList<Message_ptr> updatedMessages;
+		for (auto pos = changedReadStatuses.begin (); pos != changedReadStatuses.end (); ++pos)
+		{
+			const auto& id = pos.key ();
 
-			if (updated->IsRead () != msg->IsRead ())
+			Message_ptr updated;
+			try
 			{
-				updated->SetRead (msg->IsRead ());
-				isUpdated = true;
+				updated = Storage_->LoadMessage (A_, folderName, id);
 			}
-
-			auto sumFolders = updated->GetFolders ();
-			if (!folderName.isEmpty () &&
-					!sumFolders.contains (folderName))
+			catch (const std::exception& e)
 			{
-				updated->AddFolder (folderName);
-				isUpdated = true;
+				qWarning () << Q_FUNC_INFO
+						<< "unable to load"
+						<< id.toHex ()
+						<< e.what ();
+				continue;
 			}
 
-			updated->SetVmimeHeader (msg->GetVmimeHeader ());
+			updated->SetRead (*pos);
+			if (!folderName.isEmpty () &&
+					!updated->GetFolders ().contains (folderName))
+				updated->AddFolder (folderName);
 
-			if (isUpdated)
-				updatedMessages << updated;
-			else
-				ids << msg->GetFolderID ();
+			updatedMessages << updated;
 		}
 
+		/* An empty listing of a non-empty folder means the listing
+		 * has failed, so don't consider everything as removed then.
+		 */
+		const auto listingFailed = listing.empty () && !existing.isEmpty () && folder->getMessageCount ();
+
+		QList<QByteArray> removedIds;
+		if (uidsInvalidated)
+			removedIds = existingList;
+		else if (isFullSync && !listingFailed)
+			for (const auto& id : existingList)
+				if (!seen.contains (id))
+					removedIds << id;
+
 		return
 		{
 			newMessages,
 			updatedMessages,
 			ids,
-			lastId.isEmpty () ? existing : QList<QByteArray> {}
+			removedIds,
+			isFullSync && !listingFailed && headersFetched ?
+					boost::optional<FolderSyncState> { serverState } :
+					boost::optional<FolderSyncState> {}
 		};
 	}
 
@@ -30,6 +30,7 @@
 #pragma once
 
 #include <boost/variant.hpp>
+#include <boost/optional.hpp>
 #include <QObject>
 #include <vmime/net/session.hpp>
 #include <vmime/net/message.hpp>
@@ -43,6 +44,7 @@
 #include "message.h"
 #include "account.h"
 #include "accountthreadworkerfwd.h"
+#include "common.h"
 
 class QTimer;
 
@@ -101,6 +103,11 @@ namespace Snails
 			QList<Message_ptr> UpdatedMsgs_;
 			QList<QByteArray> OtherIds_;
 			QList<QByteArray> RemovedIds_;
+
+			/** The server-side state of the folder to be stored once
+			 * the messages above are saved, if this was a full sync.
+			 */
+			boost::optional<FolderSyncState> SyncState_;
 		};
 		using Folder2Messages_t = QHash<QStringList, FolderMessages>;
 	private:
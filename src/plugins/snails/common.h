@@ -52,5 +52,15 @@ namespace Snails
 		Normal,
 		MultiSelect
 	};
+
+	/** @brief The state of a folder as of the last full synchronization.
+	 *
+	 * HighestModSeq_ is zero if the server doesn't support CONDSTORE.
+	 */
+	struct FolderSyncState
+	{
+		quint32 UIDValidity_ = 0;
+		quint64 HighestModSeq_ = 0;
+	};
 }
 }
@@ -289,8 +289,10 @@ namespace Snails
 			VmimeHeader_.reset ();
 	}
 
-	QByteArray Message::Serialize () const
+	QByteArray Message::Serialize (SerializationContents contents) const
 	{
+		const bool withBodies = contents == SerializationContents::Full;
+
 		QByteArray result;
 
 		QDataStream str (&result, QIODevice::WriteOnly);
@@ -304,8 +306,8 @@ namespace Snails
 			<< Recipients_
 			<< Subject_
 			<< IsRead_
-			<< Body_
-			<< HTMLBody_
+			<< (withBodies ? Body_ : QString {})
+			<< (withBodies ? HTMLBody_ : QString {})
 			<< InReplyTo_
 			<< References_
 			<< Addresses_
@@ -148,7 +148,20 @@ namespace Snails
 		vmime::shared_ptr<const vmime::header> GetVmimeHeader () const;
 		void SetVmimeHeader (const vmime::shared_ptr<const vmime::header>&);
 
-		QByteArray Serialize () const;
+		enum class SerializationContents
+		{
+			Full,
+			HeadersOnly
+		};
+
+		/** @brief Serializes this message.
+		 *
+		 * If contents is SerializationContents::HeadersOnly, the plain
+		 * text and HTML bodies are omitted from the result. The result
+		 * is still deserializable by Deserialize(), but the message
+		 * won't be considered fully fetched.
+		 */
+		QByteArray Serialize (SerializationContents contents = SerializationContents::Full) const;
 		void Deserialize (const QByteArray&);
 	signals:
 		void readStatusChanged (const QByteArray&, bool);
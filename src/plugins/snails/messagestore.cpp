@@ -0,0 +1,746 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+
+#include "messagestore.h"
+#include <stdexcept>
+#include <algorithm>
+#include <cstdio>
+#include <QDataStream>
+#include <QDir>
+#include <QtEndian>
+#include <QtDebug>
+
+#ifdef Q_OS_WIN
+#include <windows.h>
+#else
+#include <unistd.h>
+#endif
+
+namespace LeechCraft
+{
+namespace Snails
+{
+	namespace
+	{
+		const QString IndexFileName = "messages.idx";
+		const QString SegmentFileName = "messages.seg";
+
+		const quint32 FrameMagic = 0x4c43534d;
+		const qint64 FrameHeaderSize = 8;
+
+		const quint8 RecordVersion = 1;
+
+		enum class RecordKind : quint8
+		{
+			Put,
+			Remove
+		};
+
+		struct IndexRecord
+		{
+			RecordKind Kind_ = RecordKind::Put;
+
+			QStringList Folder_;
+			QByteArray ID_;
+
+			bool IsRead_ = false;
+			QDateTime Date_;
+
+			qint64 SegmentPos_ = 0;
+			quint32 SegmentSize_ = 0;
+
+			QByteArray Headers_;
+		};
+
+		QByteArray SerializeRecord (const IndexRecord& rec)
+		{
+			QByteArray result;
+
+			QDataStream str (&result, QIODevice::WriteOnly);
+			str.setVersion (QDataStream::Qt_4_8);
+			str << RecordVersion
+				<< static_cast<quint8> (rec.Kind_)
+				<< rec.Folder_
+				<< rec.ID_;
+
+			if (rec.Kind_ == RecordKind::Put)
+				str << rec.IsRead_
+					<< rec.Date_
+					<< rec.SegmentPos_
+					<< rec.SegmentSize_
+					<< rec.Headers_;
+
+			return result;
+		}
+
+		enum class ParseHeaders
+		{
+			Yes,
+			No
+		};
+
+		IndexRecord ParseRecord (const QByteArray& data, ParseHeaders parseHeaders)
+		{
+			QDataStream str (data);
+			str.setVersion (QDataStream::Qt_4_8);
+
+			quint8 version = 0;
+			str >> version;
+			if (version != RecordVersion)
+				throw std::runtime_error (qPrintable ("Unknown index record version " + QString::number (version)));
+
+			IndexRecord rec;
+
+			quint8 kind = 0;
+			str >> kind
+				>> rec.Folder_
+				>> rec.ID_;
+			rec.Kind_ = static_cast<RecordKind> (kind);
+
+			if (rec.Kind_ == RecordKind::Put)
+			{
+				str >> rec.IsRead_
+					>> rec.Date_
+					>> rec.SegmentPos_
+					>> rec.SegmentSize_;
+				if (parseHeaders == ParseHeaders::Yes)
+					str >> rec.Headers_;
+			}
+
+			if (str.status () != QDataStream::Ok)
+				throw std::runtime_error ("Truncated index record");
+
+			return rec;
+		}
+
+		/* Appends the frame with the given data to the end of the file
+		 * and returns the position of the data in the file.
+		 */
+		qint64 WriteFrame (QFile& file, const QByteArray& data)
+		{
+			const auto pos = file.size ();
+			if (!file.seek (pos))
+				throw std::runtime_error (qPrintable ("Unable to seek " + file.fileName ()));
+
+			uchar header [FrameHeaderSize];
+			qToBigEndian<quint32> (FrameMagic, header);
+			qToBigEndian<quint32> (data.size (), header + 4);
+
+			if (file.write (reinterpret_cast<const char*> (header), FrameHeaderSize) != FrameHeaderSize ||
+					file.write (data) != data.size ())
+			{
+				qWarning () << Q_FUNC_INFO
+						<< "unable to write to"
+						<< file.fileName ()
+						<< file.errorString ();
+				throw std::runtime_error (qPrintable ("Unable to write to " + file.fileName ()));
+			}
+
+			return pos + FrameHeaderSize;
+		}
+
+		void OpenFile (QFile& file, QIODevice::OpenMode mode)
+		{
+			if (!file.open (mode))
+			{
+				qWarning () << Q_FUNC_INFO
+						<< "unable to open"
+						<< file.fileName ()
+						<< file.errorString ();
+				throw std::runtime_error (qPrintable ("Unable to open " + file.fileName ()));
+			}
+		}
+
+		void SyncFile (QFile& file)
+		{
+			file.flush ();
+#ifndef Q_OS_WIN
+			fsync (file.handle ());
+#endif
+		}
+
+		// Atomically replaces the \em to file with the \em from one.
+		bool ReplaceFile (const QString& from, const QString& to)
+		{
+#ifdef Q_OS_WIN
+			return MoveFileExW (reinterpret_cast<const wchar_t*> (QDir::toNativeSeparators (from).utf16 ()),
+					reinterpret_cast<const wchar_t*> (QDir::toNativeSeparators (to).utf16 ()),
+					MOVEFILE_REPLACE_EXISTING | MOVEFILE_WRITE_THROUGH);
+#else
+			return !std::rename (QFile::encodeName (from).constData (),
+					QFile::encodeName (to).constData ());
+#endif
+		}
+	}
+
+	MessageStore::MessageStore (const QDir& dir)
+	: Dir_ { dir }
+	{
+		FinishCompaction ();
+
+		Open ();
+		LoadIndex ();
+
+		if (!NeedsCompaction ())
+			return;
+
+		try
+		{
+			Compact ();
+		}
+		catch (const std::exception& e)
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unable to compact the store in"
+					<< Dir_.path ()
+					<< e.what ();
+
+			FinishCompaction ();
+			if (!Index_.isOpen ())
+			{
+				Open ();
+				LoadIndex ();
+			}
+		}
+	}
+
+	MessageStore::~MessageStore ()
+	{
+		Close ();
+	}
+
+	void MessageStore::Put (const QStringList& folder, const QList<Message_ptr>& messages)
+	{
+		struct PreparedMessage
+		{
+			IndexRecord Record_;
+			QByteArray Data_;
+		};
+
+		QList<PreparedMessage> prepared;
+		for (const auto& msg : messages)
+		{
+			if (msg->GetFolderID ().isEmpty ())
+				continue;
+
+			IndexRecord rec;
+			rec.Folder_ = folder;
+			rec.ID_ = msg->GetFolderID ();
+			rec.IsRead_ = msg->IsRead ();
+			rec.Date_ = msg->GetDate ();
+			rec.Headers_ = msg->Serialize (Message::SerializationContents::HeadersOnly);
+
+			prepared.append ({ rec, qCompress (msg->Serialize (), 9) });
+		}
+
+		if (prepared.isEmpty ())
+			return;
+
+		QMutexLocker locker { &Mutex_ };
+
+		/* The bodies go first, so that the index never refers to the
+		 * data that hasn't been written yet.
+		 */
+		for (auto& item : prepared)
+		{
+			item.Record_.SegmentPos_ = WriteFrame (Segment_, item.Data_);
+			item.Record_.SegmentSize_ = item.Data_.size ();
+		}
+		Segment_.flush ();
+
+		for (const auto& item : prepared)
+		{
+			const auto& rec = item.Record_;
+			const auto& payload = SerializeRecord (rec);
+			const auto recordPos = WriteFrame (Index_, payload);
+
+			Forget (rec.Folder_, rec.ID_);
+			Entries_ [rec.Folder_] [rec.ID_] = IndexEntry
+			{
+				recordPos,
+				static_cast<quint32> (payload.size ()),
+				rec.SegmentPos_,
+				rec.SegmentSize_,
+				rec.IsRead_
+			};
+
+			LiveIndexSize_ += FrameHeaderSize + payload.size ();
+			LiveSegmentSize_ += FrameHeaderSize + rec.SegmentSize_;
+		}
+		Index_.flush ();
+	}
+
+	void MessageStore::Remove (const QStringList& folder, const QByteArray& id)
+	{
+		QMutexLocker locker { &Mutex_ };
+
+		if (!Entries_.value (folder).contains (id))
+			return;
+
+		IndexRecord rec;
+		rec.Kind_ = RecordKind::Remove;
+		rec.Folder_ = folder;
+		rec.ID_ = id;
+		WriteFrame (Index_, SerializeRecord (rec));
+		Index_.flush ();
+
+		Forget (folder, id);
+	}
+
+	bool MessageStore::Contains (const QStringList& folder, const QByteArray& id) const
+	{
+		QMutexLocker locker { &Mutex_ };
+		return Entries_.value (folder).contains (id);
+	}
+
+	Message_ptr MessageStore::LoadHeaders (const QStringList& folder, const QByteArray& id) const
+	{
+		QByteArray headers;
+
+		{
+			QMutexLocker locker { &Mutex_ };
+			const auto& payload = GetIndexPayload (GetEntry (folder, id));
+			headers = ParseRecord (payload, ParseHeaders::Yes).Headers_;
+		}
+
+		const auto& msg = std::make_shared<Message> ();
+		msg->Deserialize (headers);
+		return msg;
+	}
+
+	QList<Message_ptr> MessageStore::LoadHeaders (const QStringList& folder, const QList<QByteArray>& ids) const
+	{
+		QList<QByteArray> headersList;
+
+		{
+			QMutexLocker locker { &Mutex_ };
+
+			const auto& entries = Entries_.value (folder);
+			for (const auto& id : ids)
+			{
+				const auto pos = entries.find (id);
+				if (pos == entries.end ())
+					continue;
+
+				try
+				{
+					const auto& payload = GetIndexPayload (*pos);
+					headersList << ParseRecord (payload, ParseHeaders::Yes).Headers_;
+				}
+				catch (const std::exception& e)
+				{
+					qWarning () << Q_FUNC_INFO
+							<< "unable to read index record for"
+							<< id.toHex ()
+							<< e.what ();
+				}
+			}
+		}
+
+		QList<Message_ptr> result;
+		result.reserve (headersList.size ());
+		for (const auto& headers : headersList)
+		{
+			const auto& msg = std::make_shared<Message> ();
+			try
+			{
+				msg->Deserialize (headers);
+			}
+			catch (const std::exception& e)
+			{
+				qWarning () << Q_FUNC_INFO
+						<< "error deserializing message headers"
+						<< e.what ();
+				continue;
+			}
+			result << msg;
+		}
+		return result;
+	}
+
+	Message_ptr MessageStore::LoadFull (const QStringList& folder, const QByteArray& id) const
+	{
+		QByteArray data;
+
+		{
+			QMutexLocker locker { &Mutex_ };
+			data = ReadSegment (GetEntry (folder, id));
+		}
+
+		const auto& msg = std::make_shared<Message> ();
+		msg->Deserialize (qUncompress (data));
+		return msg;
+	}
+
+	boost::optional<bool> MessageStore::IsRead (const QStringList& folder, const QByteArray& id) const
+	{
+		QMutexLocker locker { &Mutex_ };
+
+		const auto& entries = Entries_.value (folder);
+		const auto pos = entries.find (id);
+		if (pos == entries.end ())
+			return {};
+
+		return pos->IsRead_;
+	}
+
+	QHash<QByteArray, bool> MessageStore::GetReadStatuses (const QStringList& folder) const
+	{
+		QMutexLocker locker { &Mutex_ };
+
+		const auto& entries = Entries_.value (folder);
+
+		QHash<QByteArray, bool> result;
+		result.reserve (entries.size ());
+		for (auto pos = entries.begin (); pos != entries.end (); ++pos)
+			result [pos.key ()] = pos->IsRead_;
+		return result;
+	}
+
+	QList<QStringList> MessageStore::GetFolders () const
+	{
+		QMutexLocker locker { &Mutex_ };
+		return Entries_.keys ();
+	}
+
+	QList<QByteArray> MessageStore::GetIDs (const QStringList& folder) const
+	{
+		QMutexLocker locker { &Mutex_ };
+		return Entries_.value (folder).keys ();
+	}
+
+	int MessageStore::GetCount () const
+	{
+		QMutexLocker locker { &Mutex_ };
+
+		int result = 0;
+		for (const auto& entries : Entries_)
+			result += entries.size ();
+		return result;
+	}
+
+	int MessageStore::GetCount (const QStringList& folder) const
+	{
+		QMutexLocker locker { &Mutex_ };
+		return Entries_.value (folder).size ();
+	}
+
+	int MessageStore::GetUnreadCount (const QStringList& folder) const
+	{
+		QMutexLocker locker { &Mutex_ };
+
+		const auto& entries = Entries_.value (folder);
+		return std::count_if (entries.begin (), entries.end (),
+				[] (const IndexEntry& entry) { return !entry.IsRead_; });
+	}
+
+	void MessageStore::Open ()
+	{
+		Index_.setFileName (Dir_.filePath (IndexFileName));
+		OpenFile (Index_, QIODevice::ReadWrite);
+
+		Segment_.setFileName (Dir_.filePath (SegmentFileName));
+		OpenFile (Segment_, QIODevice::ReadWrite);
+	}
+
+	void MessageStore::Close ()
+	{
+		Unmap ();
+
+		Index_.close ();
+		Segment_.close ();
+	}
+
+	void MessageStore::LoadIndex ()
+	{
+		Entries_.clear ();
+		LiveIndexSize_ = 0;
+		LiveSegmentSize_ = 0;
+
+		Unmap ();
+
+		const auto size = Index_.size ();
+		if (!size)
+			return;
+
+		IndexMap_ = Index_.map (0, size);
+		if (!IndexMap_)
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unable to map"
+					<< Index_.fileName ()
+					<< Index_.errorString ();
+			throw std::runtime_error ("Unable to map the index file");
+		}
+		IndexMapSize_ = size;
+
+		const auto segmentSize = Segment_.size ();
+
+		qint64 pos = 0;
+		while (pos + FrameHeaderSize <= size)
+		{
+			const auto frame = IndexMap_ + pos;
+			const auto magic = qFromBigEndian<quint32> (frame);
+			const auto recordSize = qFromBigEndian<quint32> (frame + 4);
+			if (magic != FrameMagic || pos + FrameHeaderSize + recordSize > size)
+				break;
+
+			const auto& payload = QByteArray::fromRawData (reinterpret_cast<const char*> (frame + FrameHeaderSize),
+					recordSize);
+
+			IndexRecord rec;
+			try
+			{
+				rec = ParseRecord (payload, ParseHeaders::No);
+			}
+			catch (const std::exception& e)
+			{
+				qWarning () << Q_FUNC_INFO
+						<< "corrupted record at"
+						<< pos
+						<< e.what ();
+				break;
+			}
+
+			Forget (rec.Folder_, rec.ID_);
+
+			if (rec.Kind_ == RecordKind::Put &&
+					rec.SegmentPos_ + rec.SegmentSize_ <= segmentSize)
+			{
+				Entries_ [rec.Folder_] [rec.ID_] = IndexEntry
+				{
+					pos + FrameHeaderSize,
+					recordSize,
+					rec.SegmentPos_,
+					rec.SegmentSize_,
+					rec.IsRead_
+				};
+
+				LiveIndexSize_ += FrameHeaderSize + recordSize;
+				LiveSegmentSize_ += FrameHeaderSize + rec.SegmentSize_;
+			}
+
+			pos += FrameHeaderSize + recordSize;
+		}
+
+		if (pos == size)
+			return;
+
+		qWarning () << Q_FUNC_INFO
+				<< "truncating the index"
+				<< Index_.fileName ()
+				<< "from"
+				<< size
+				<< "to"
+				<< pos;
+		Unmap ();
+		Index_.resize (pos);
+	}
+
+	bool MessageStore::NeedsCompaction () const
+	{
+		const auto indexGarbage = Index_.size () - LiveIndexSize_;
+		const auto segmentGarbage = Segment_.size () - LiveSegmentSize_;
+
+		return (segmentGarbage > 16 * 1024 * 1024 && segmentGarbage > LiveSegmentSize_) ||
+				(indexGarbage > 4 * 1024 * 1024 && indexGarbage > LiveIndexSize_);
+	}
+
+	void MessageStore::Compact ()
+	{
+		qDebug () << Q_FUNC_INFO
+				<< "compacting"
+				<< Dir_.path ();
+
+		QFile newIndex { Dir_.filePath (IndexFileName + ".new") };
+		OpenFile (newIndex, QIODevice::WriteOnly | QIODevice::Truncate);
+		QFile newSegment { Dir_.filePath (SegmentFileName + ".new") };
+		OpenFile (newSegment, QIODevice::WriteOnly | QIODevice::Truncate);
+
+		for (auto folderPos = Entries_.begin (); folderPos != Entries_.end (); ++folderPos)
+			for (const auto& entry : *folderPos)
+			{
+				auto rec = ParseRecord (GetIndexPayload (entry), ParseHeaders::Yes);
+				rec.SegmentPos_ = WriteFrame (newSegment, ReadSegment (entry));
+				WriteFrame (newIndex, SerializeRecord (rec));
+			}
+
+		SyncFile (newSegment);
+		newSegment.close ();
+		SyncFile (newIndex);
+		newIndex.close ();
+
+		Close ();
+
+		/* The segment is replaced first: as long as its new version
+		 * exists, the old files are intact and the compaction may be
+		 * just dropped, and once it's gone, the new index is the only
+		 * one matching the segment. See FinishCompaction().
+		 */
+		const auto& segmentPath = Dir_.filePath (SegmentFileName);
+		if (!ReplaceFile (segmentPath + ".new", segmentPath))
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unable to replace"
+					<< segmentPath;
+			throw std::runtime_error ("Unable to replace the store segment");
+		}
+
+		const auto& indexPath = Dir_.filePath (IndexFileName);
+		if (!ReplaceFile (indexPath + ".new", indexPath))
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unable to replace"
+					<< indexPath;
+			throw std::runtime_error ("Unable to replace the store index");
+		}
+
+		Open ();
+		LoadIndex ();
+	}
+
+	void MessageStore::FinishCompaction ()
+	{
+		const auto& newSegmentPath = Dir_.filePath (SegmentFileName + ".new");
+		const auto& newIndexPath = Dir_.filePath (IndexFileName + ".new");
+
+		// The compaction hasn't replaced anything yet, so the old files are intact.
+		if (QFile::exists (newSegmentPath))
+		{
+			QFile::remove (newSegmentPath);
+			QFile::remove (newIndexPath);
+			return;
+		}
+
+		if (!QFile::exists (newIndexPath))
+			return;
+
+		const auto& indexPath = Dir_.filePath (IndexFileName);
+		qWarning () << Q_FUNC_INFO
+				<< "finishing the interrupted compaction in"
+				<< Dir_.path ();
+		if (!ReplaceFile (newIndexPath, indexPath))
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unable to replace"
+					<< indexPath;
+			throw std::runtime_error ("Unable to replace the store index");
+		}
+	}
+
+	void MessageStore::Unmap () const
+	{
+		if (!IndexMap_)
+			return;
+
+		Index_.unmap (IndexMap_);
+		IndexMap_ = nullptr;
+		IndexMapSize_ = 0;
+	}
+
+	QByteArray MessageStore::GetIndexPayload (const IndexEntry& entry) const
+	{
+		if (entry.RecordPos_ + entry.RecordSize_ > IndexMapSize_)
+		{
+			Unmap ();
+
+			const auto size = Index_.size ();
+			IndexMap_ = Index_.map (0, size);
+			if (!IndexMap_)
+			{
+				qWarning () << Q_FUNC_INFO
+						<< "unable to map"
+						<< Index_.fileName ()
+						<< Index_.errorString ();
+				throw std::runtime_error ("Unable to map the index file");
+			}
+			IndexMapSize_ = size;
+		}
+
+		return QByteArray::fromRawData (reinterpret_cast<const char*> (IndexMap_ + entry.RecordPos_),
+				entry.RecordSize_);
+	}
+
+	QByteArray MessageStore::ReadSegment (const IndexEntry& entry) const
+	{
+		if (!Segment_.seek (entry.SegmentPos_))
+			throw std::runtime_error ("Unable to seek in the segment file");
+
+		const auto& data = Segment_.read (entry.SegmentSize_);
+		if (static_cast<quint32> (data.size ()) != entry.SegmentSize_)
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "short read from"
+					<< Segment_.fileName ()
+					<< data.size ()
+					<< entry.SegmentSize_;
+			throw std::runtime_error ("Short read from the segment file");
+		}
+
+		return data;
+	}
+
+	void MessageStore::Forget (const QStringList& folder, const QByteArray& id)
+	{
+		const auto folderPos = Entries_.find (folder);
+		if (folderPos == Entries_.end ())
+			return;
+
+		const auto pos = folderPos->find (id);
+		if (pos == folderPos->end ())
+			return;
+
+		LiveIndexSize_ -= FrameHeaderSize + pos->RecordSize_;
+		LiveSegmentSize_ -= FrameHeaderSize + pos->SegmentSize_;
+
+		folderPos->erase (pos);
+		if (folderPos->isEmpty ())
+			Entries_.erase (folderPos);
+	}
+
+	const MessageStore::IndexEntry& MessageStore::GetEntry (const QStringList& folder, const QByteArray& id) const
+	{
+		const auto folderPos = Entries_.find (folder);
+		if (folderPos != Entries_.end ())
+		{
+			const auto pos = folderPos->find (id);
+			if (pos != folderPos->end ())
+				return *pos;
+		}
+
+		qWarning () << Q_FUNC_INFO
+				<< "no message"
+				<< id.toHex ()
+				<< "in"
+				<< folder;
+		throw std::runtime_error ("No such message in the store");
+	}
+}
+}
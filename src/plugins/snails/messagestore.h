@@ -0,0 +1,166 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+
+#pragma once
+
+#include <memory>
+#include <boost/optional.hpp>
+#include <QDir>
+#include <QFile>
+#include <QHash>
+#include <QMutex>
+#include <QStringList>
+#include "message.h"
+#include "common.h"
+
+namespace LeechCraft
+{
+namespace Snails
+{
+	/** @brief Packed on-disk storage for the messages of an account.
+	 *
+	 * The store consists of two append-only files:
+	 * - the segment file containing compressed serialized messages,
+	 *   including their bodies;
+	 * - the index file containing a record per stored message with its
+	 *   folder, UID, flags, position in the segment file and the
+	 *   serialized headers (everything except the bodies).
+	 *
+	 * The index file is memory-mapped and scanned once on opening, so
+	 * the per-folder lists of messages can be built without touching
+	 * the segment file at all. Bodies are read from the segment file
+	 * only when the full message is requested via LoadFull().
+	 *
+	 * Updating a message appends a new record superseding the old one,
+	 * and removing a message appends a tombstone record. The files are
+	 * compacted on opening once the amount of superseded data becomes
+	 * large enough.
+	 *
+	 * This class is thread-safe.
+	 */
+	class MessageStore
+	{
+		struct IndexEntry
+		{
+			qint64 RecordPos_;
+			quint32 RecordSize_;
+
+			qint64 SegmentPos_;
+			quint32 SegmentSize_;
+
+			bool IsRead_;
+		};
+
+		mutable QMutex Mutex_;
+
+		const QDir Dir_;
+
+		mutable QFile Index_;
+		mutable QFile Segment_;
+
+		mutable uchar *IndexMap_ = nullptr;
+		mutable qint64 IndexMapSize_ = 0;
+
+		QHash<QStringList, QHash<QByteArray, IndexEntry>> Entries_;
+
+		qint64 LiveIndexSize_ = 0;
+		qint64 LiveSegmentSize_ = 0;
+	public:
+		/** @brief Opens or creates the store in the given directory.
+		 *
+		 * @param[in] dir The directory to keep the store files in.
+		 *
+		 * @exception std::runtime_error If the store files cannot be
+		 * opened.
+		 */
+		MessageStore (const QDir& dir);
+		~MessageStore ();
+
+		MessageStore (const MessageStore&) = delete;
+		MessageStore& operator= (const MessageStore&) = delete;
+
+		/** @brief Stores or updates the given messages in the folder.
+		 *
+		 * Messages are stored along with their bodies, if any.
+		 */
+		void Put (const QStringList& folder, const QList<Message_ptr>& messages);
+		void Remove (const QStringList& folder, const QByteArray& id);
+
+		bool Contains (const QStringList& folder, const QByteArray& id) const;
+
+		/** @brief Loads the message without its bodies from the index.
+		 *
+		 * @exception std::runtime_error If there is no such message or
+		 * the index is corrupted.
+		 */
+		Message_ptr LoadHeaders (const QStringList& folder, const QByteArray& id) const;
+
+		/** @brief Loads the messages without their bodies from the index.
+		 *
+		 * Unknown IDs are silently skipped.
+		 */
+		QList<Message_ptr> LoadHeaders (const QStringList& folder, const QList<QByteArray>& ids) const;
+
+		/** @brief Loads the full message, including bodies.
+		 *
+		 * @exception std::runtime_error If there is no such message or
+		 * the segment file is corrupted.
+		 */
+		Message_ptr LoadFull (const QStringList& folder, const QByteArray& id) const;
+
+		boost::optional<bool> IsRead (const QStringList& folder, const QByteArray& id) const;
+		QHash<QByteArray, bool> GetReadStatuses (const QStringList& folder) const;
+
+		QList<QStringList> GetFolders () const;
+		QList<QByteArray> GetIDs (const QStringList& folder) const;
+
+		int GetCount () const;
+		int GetCount (const QStringList& folder) const;
+		int GetUnreadCount (const QStringList& folder) const;
+	private:
+		void Open ();
+		void Close ();
+
+		void LoadIndex ();
+		bool NeedsCompaction () const;
+		void Compact ();
+		void FinishCompaction ();
+
+		void Unmap () const;
+		QByteArray GetIndexPayload (const IndexEntry&) const;
+		QByteArray ReadSegment (const IndexEntry&) const;
+
+		void Forget (const QStringList& folder, const QByteArray& id);
+		const IndexEntry& GetEntry (const QStringList& folder, const QByteArray& id) const;
+	};
+
+	using MessageStore_ptr = std::shared_ptr<MessageStore>;
+}
+}
@@ -30,14 +30,11 @@
 #include "storage.h"
 #include <stdexcept>
 #include <QFile>
+#include <QFileInfo>
+#include <QDirIterator>
 #include <QApplication>
-#include <QtConcurrentMap>
-#include <QSqlDatabase>
-#include <QSqlQuery>
-#include <QSqlError>
-#include <QDataStream>
 #include <QtConcurrentRun>
-#include <util/db/dblock.h>
+#include <QtDebug>
 #include <util/sys/paths.h>
 #include <util/threads/futures.h>
 #include "xmlsettingsmanager.h"
@@ -48,18 +45,6 @@ namespace LeechCraft
 {
 namespace Snails
 {
-	namespace
-	{
-		template<typename T>
-		QByteArray Serialize (const T& t)
-		{
-			QByteArray result;
-			QDataStream stream (&result, QIODevice::WriteOnly);
-			stream << t;
-			return result;
-		}
-	}
-
 	Storage::Storage (QObject *parent)
 	: QObject (parent)
 	, Settings_ (QCoreApplication::organizationName (),
@@ -68,65 +53,33 @@ namespace Snails
 		SDir_ = Util::CreateIfNotExists ("snails/storage");
 	}
 
-	namespace
-	{
-		QList<Message_ptr> MessageSaverProc (QList<Message_ptr> msgs, const QDir& dir)
-		{
-			for (const auto& msg : msgs)
-			{
-				if (msg->GetFolderID ().isEmpty ())
-					continue;
-
-				const QString dirName = msg->GetFolderID ().toHex ().right (3);
-
-				QDir msgDir = dir;
-				if (!dir.exists (dirName))
-					msgDir.mkdir (dirName);
-				if (!msgDir.cd (dirName))
-				{
-					qWarning () << Q_FUNC_INFO
-							<< "unable to cd into"
-							<< msgDir.filePath (dirName);
-					continue;
-				}
-
-				QFile file (msgDir.filePath (msg->GetFolderID ().toHex ()));
-				file.open (QIODevice::WriteOnly);
-				file.write (qCompress (msg->Serialize (), 9));
-			}
-
-			return msgs;
-		}
-	}
-
 	void Storage::SaveMessages (Account *acc, const QStringList& folder, const QList<Message_ptr>& msgs)
 	{
-		auto dir = DirForAccount (acc);
-		for (const auto& elem : folder)
-		{
-			const auto& subdir = elem.toUtf8 ().toHex ();
-			if (!dir.exists (subdir))
-				dir.mkdir (subdir);
+		const auto& store = StoreForAccount (acc);
 
-			if (!dir.cd (subdir))
-			{
-				qWarning () << Q_FUNC_INFO
-						<< "unable to cd to"
-						<< dir.filePath (subdir);
-				throw std::runtime_error ("Unable to cd to the directory");
-			}
+		{
+			QMutexLocker locker { &PendingSaveMutex_ };
+			auto& pending = PendingSaveMessages_ [acc];
+			for (const auto& msg : msgs)
+				pending [msg->GetFolderID ()] = msg;
 		}
 
-		for (const auto& msg : msgs)
-			PendingSaveMessages_ [acc] [msg->GetFolderID ()] = msg;
-
-		Util::Sequence (this, QtConcurrent::run (MessageSaverProc, msgs, dir)) >>
+		Util::Sequence (this,
+				QtConcurrent::run ([store, folder, msgs]
+					{
+						store->Put (folder, msgs);
+						return msgs;
+					})) >>
 				[this, acc] (const QList<Message_ptr>& messages)
 				{
-					auto& hash = PendingSaveMessages_ [acc];
+					QMutexLocker locker { &PendingSaveMutex_ };
+
+					const auto pos = PendingSaveMessages_.find (acc);
+					if (pos == PendingSaveMessages_.end ())
+						return;
 
 					for (const auto& msg : messages)
-						hash.remove (msg->GetFolderID ());
+						pos->remove (msg->GetFolderID ());
 				};
 
 		for (const auto& msg : msgs)
@@ -143,49 +96,15 @@ namespace Snails
 	{
 		MessageSet result;
 
-		const QDir& dir = DirForAccount (acc);
-		for (const auto& str : dir.entryList (QDir::NoDotAndDotDot | QDir::Dirs))
-		{
-			QDir subdir = dir;
-			if (!subdir.cd (str))
-			{
-				qWarning () << Q_FUNC_INFO
-						<< "unable to cd to"
-						<< str;
-				continue;
-			}
-
-			for (const auto& str : subdir.entryList (QDir::NoDotAndDotDot | QDir::Files))
+		const auto& store = StoreForAccount (acc);
+		for (const auto& folder : store->GetFolders ())
+			for (const auto& msg : store->LoadHeaders (folder, store->GetIDs (folder)))
 			{
-				QFile file (subdir.filePath (str));
-				if (!file.open (QIODevice::ReadOnly))
-				{
-					qWarning () << Q_FUNC_INFO
-							<< "unable to open"
-							<< str
-							<< file.errorString ();
-					continue;
-				}
-
-				const auto& msg = std::make_shared<Message> ();
-				try
-				{
-					msg->Deserialize (qUncompress (file.readAll ()));
-				}
-				catch (const std::exception& e)
-				{
-					qWarning () << Q_FUNC_INFO
-							<< "error deserializing the message from"
-							<< file.fileName ()
-							<< e.what ();
-					continue;
-				}
 				result << msg;
 				UpdateCaches (msg);
 			}
-		}
 
-		for (const auto& msg : PendingSaveMessages_ [acc])
+		for (const auto& msg : GetPendingMessages (acc))
 		{
 			result << msg;
 			UpdateCaches (msg);
@@ -196,93 +115,48 @@ namespace Snails
 
 	Message_ptr Storage::LoadMessage (Account *acc, const QStringList& folder, const QByteArray& id)
 	{
-		if (PendingSaveMessages_ [acc].contains (id))
-			return PendingSaveMessages_ [acc] [id];
-
-		auto dir = DirForAccount (acc);
-		for (const auto& elem : folder)
 		{
-			const auto& subdir = elem.toUtf8 ().toHex ();
-			if (!dir.cd (subdir))
-			{
-				qWarning () << Q_FUNC_INFO
-						<< "unable to cd to"
-						<< dir.filePath (subdir);
-				throw std::runtime_error ("Unable to cd to the directory");
-			}
-		}
-
-		const auto& msg = LoadMessage (acc, dir, id);
-		UpdateCaches (msg);
-		return msg;
-	}
-
-	Message_ptr Storage::LoadMessage (Account *acc, QDir dir, const QByteArray& id) const
-	{
-		if (PendingSaveMessages_ [acc].contains (id))
-			return PendingSaveMessages_ [acc] [id];
-
-		if (!dir.cd (id.toHex ().right (3)))
-		{
-			qWarning () << Q_FUNC_INFO
-					<< "unable to cd to"
-					<< dir.filePath (id.toHex ().right (3));
-			throw std::runtime_error ("Unable to cd to the directory");
+			QMutexLocker locker { &PendingSaveMutex_ };
+			if (const auto& msg = PendingSaveMessages_.value (acc).value (id))
+				return msg;
 		}
 
-		QFile file (dir.filePath (id.toHex ()));
-		if (!file.open (QIODevice::ReadOnly))
-		{
-			qWarning () << Q_FUNC_INFO
-					<< "unable to open"
-					<< file.fileName ()
-					<< file.errorString ();
-			throw std::runtime_error ("Unable to open the message file");
-		}
-
-		const auto& msg = std::make_shared<Message> ();
+		Message_ptr msg;
 		try
 		{
-			msg->Deserialize (qUncompress (file.readAll ()));
+			msg = StoreForAccount (acc)->LoadFull (folder, id);
 		}
 		catch (const std::exception& e)
 		{
 			qWarning () << Q_FUNC_INFO
-					<< "error deserializing the message from"
-					<< file.fileName ()
+					<< "error loading the message"
+					<< id.toHex ()
+					<< "from"
+					<< folder
 					<< e.what ();
 			throw;
 		}
 
+		UpdateCaches (msg);
 		return msg;
 	}
 
 	QList<Message_ptr> Storage::LoadMessages (Account *acc, const QStringList& folder, const QList<QByteArray>& ids)
 	{
-		auto rootDir = DirForAccount (acc);
-		for (const auto& elem : folder)
-		{
-			const auto& subdir = elem.toUtf8 ().toHex ();
-			if (!rootDir.cd (subdir) &&
-					!(rootDir.mkpath (subdir) && rootDir.cd (subdir)))
-			{
-				qWarning () << Q_FUNC_INFO
-						<< "unable to cd to"
-						<< rootDir.filePath (subdir);
-				throw std::runtime_error ("Unable to cd to the directory");
-			}
-		}
+		const auto& pending = GetPendingMessages (acc);
 
 		QList<Message_ptr> result;
-		auto future = QtConcurrent::mapped (ids,
-				std::function<Message_ptr (QByteArray)>
-				{
-					[this, acc, rootDir] (const QByteArray& id)
-						{ return LoadMessage (acc, rootDir, id); }
-				});
+		QList<QByteArray> storedIds;
+		for (const auto& id : ids)
+		{
+			const auto pos = pending.find (id);
+			if (pos != pending.end ())
+				result << *pos;
+			else
+				storedIds << id;
+		}
 
-		for (const auto& item : future.results ())
-			result << item;
+		result += StoreForAccount (acc)->LoadHeaders (folder, storedIds);
 
 		for (const auto& msg : result)
 			UpdateCaches (msg);
@@ -297,32 +171,21 @@ namespace Snails
 
 	void Storage::RemoveMessage (Account *acc, const QStringList& folder, const QByteArray& id)
 	{
-		PendingSaveMessages_ [acc].remove (id);
+		{
+			QMutexLocker locker { &PendingSaveMutex_ };
+			const auto pos = PendingSaveMessages_.find (acc);
+			if (pos != PendingSaveMessages_.end ())
+				pos->remove (id);
+		}
 
+		const auto& store = StoreForAccount (acc);
 		BaseForAccount (acc)->RemoveMessage (id, folder,
-				[this, acc, folder, id] { RemoveMessageFile (acc, folder, id); });
+				[store, folder, id] { store->Remove (folder, id); });
 	}
 
-	int Storage::GetNumMessages (Account *acc) const
+	int Storage::GetNumMessages (Account *acc)
 	{
-		int result = 0;
-
-		const QDir& dir = DirForAccount (acc);
-		for (const auto& str : dir.entryList (QDir::NoDotAndDotDot | QDir::Dirs))
-		{
-			QDir subdir = dir;
-			if (!subdir.cd (str))
-			{
-				qWarning () << Q_FUNC_INFO
-						<< "unable to cd to"
-						<< str;
-				continue;
-			}
-
-			result += subdir.entryList (QDir::NoDotAndDotDot | QDir::Files).size ();
-		}
-
-		return result;
+		return StoreForAccount (acc)->GetCount ();
 	}
 
 	int Storage::GetNumMessages (Account *acc, const QStringList& folder)
@@ -335,54 +198,43 @@ namespace Snails
 		return BaseForAccount (acc)->GetUnreadMessageCount (folder);
 	}
 
-	bool Storage::HasMessagesIn (Account *acc) const
+	bool Storage::HasMessagesIn (Account *acc)
 	{
 		return GetNumMessages (acc);
 	}
 
 	bool Storage::IsMessageRead (Account *acc, const QStringList& folder, const QByteArray& id)
 	{
-		if (IsMessageRead_.contains (id))
-			return IsMessageRead_ [id];
+		{
+			QMutexLocker locker { &IsMessageReadMutex_ };
+			const auto pos = IsMessageRead_.constFind (id);
+			if (pos != IsMessageRead_.constEnd ())
+				return *pos;
+		}
+
+		if (const auto isRead = StoreForAccount (acc)->IsRead (folder, id))
+			return *isRead;
 
 		return LoadMessage (acc, folder, id)->IsRead ();
 	}
 
-	void Storage::RemoveMessageFile (Account *acc, const QStringList& folder, const QByteArray& id)
+	QHash<QByteArray, bool> Storage::GetReadStatuses (Account *acc, const QStringList& folder)
 	{
-		auto dir = DirForAccount (acc);
-		for (const auto& elem : folder)
-		{
-			const auto& subdir = elem.toUtf8 ().toHex ();
-			if (!dir.cd (subdir))
-			{
-				qWarning () << Q_FUNC_INFO
-						<< "unable to cd to"
-						<< dir.filePath (subdir);
-				throw std::runtime_error ("Unable to cd to the directory");
-			}
-		}
-
-		if (!dir.cd (id.toHex ().right (3)))
-		{
-			qWarning () << Q_FUNC_INFO
-					<< "unable to cd to"
-					<< dir.filePath (id.toHex ().right (3));
-			throw std::runtime_error ("Unable to cd to the directory");
-		}
+		auto result = StoreForAccount (acc)->GetReadStatuses (folder);
+		for (const auto& msg : GetPendingMessages (acc))
+			if (msg->GetFolders ().contains (folder))
+				result [msg->GetFolderID ()] = msg->IsRead ();
+		return result;
+	}
 
-		QFile file (dir.filePath (id.toHex ()));
-		if (!file.exists ())
-			return;
+	boost::optional<FolderSyncState> Storage::GetFolderSyncState (Account *acc, const QStringList& folder)
+	{
+		return BaseForAccount (acc)->GetFolderSyncState (folder);
+	}
 
-		qDebug () << "removing" << file.fileName () << file.size ();
-		if (!file.remove ())
-		{
-			qWarning () << Q_FUNC_INFO
-					<< "unable to remove the file:"
-					<< file.errorString ();
-			throw std::runtime_error ("Unable to remove the file");
-		}
+	void Storage::SetFolderSyncState (Account *acc, const QStringList& folder, const FolderSyncState& state)
+	{
+		BaseForAccount (acc)->SetFolderSyncState (folder, state);
 	}
 
 	QDir Storage::DirForAccount (Account *acc) const
@@ -403,6 +255,168 @@ namespace Snails
 		return dir;
 	}
 
+	MessageStore_ptr Storage::StoreForAccount (Account *acc)
+	{
+		{
+			QMutexLocker locker { &AccountStoresMutex_ };
+			if (const auto& store = AccountStores_.value (acc))
+				return store;
+		}
+
+		/* Opening a store may involve migrating the legacy messages,
+		 * which takes a while, so only the other openers wait for it,
+		 * while the lookups of the already opened stores don't.
+		 */
+		QMutexLocker openLocker { &StoreOpenMutex_ };
+
+		{
+			QMutexLocker locker { &AccountStoresMutex_ };
+			if (const auto& store = AccountStores_.value (acc))
+				return store;
+		}
+
+		const auto& dir = DirForAccount (acc);
+		const auto& store = std::make_shared<MessageStore> (dir);
+		MigrateLegacyMessages (dir, store);
+
+		QMutexLocker locker { &AccountStoresMutex_ };
+		AccountStores_ [acc] = store;
+		return store;
+	}
+
+	namespace
+	{
+		const QString LegacyMigratedMarker = "legacy.migrated";
+
+		/* Previously each message lived in its own compressed file at
+		 * <account>/<hex folder component>.../<last 3 hex chars of ID>/<hex ID>.
+		 */
+		template<typename F>
+		void ForEachLegacyMessage (const QDir& accDir, F&& f)
+		{
+			QDirIterator it { accDir.path (), QDir::Files, QDirIterator::Subdirectories };
+			while (it.hasNext ())
+			{
+				const auto& path = it.next ();
+				auto components = accDir.relativeFilePath (path).split ('/');
+				if (components.size () < 3 ||
+						!components.last ().endsWith (components.value (components.size () - 2)))
+					continue;
+
+				components.removeLast ();
+				components.removeLast ();
+				f (path, components);
+			}
+		}
+
+		void RemoveLegacyMessages (const QDir& accDir)
+		{
+			QStringList paths;
+			ForEachLegacyMessage (accDir,
+					[&paths] (const QString& path, const QStringList&) { paths << path; });
+
+			QSet<QString> dirs;
+			int count = 0;
+			for (const auto& path : paths)
+			{
+				if (!QFile::remove (path))
+				{
+					qWarning () << Q_FUNC_INFO
+							<< "unable to remove"
+							<< path;
+					continue;
+				}
+
+				dirs << QFileInfo { path }.absolutePath ();
+				++count;
+			}
+
+			if (!count)
+				return;
+
+			// rmpath() removes the empty parents up to the account dir.
+			for (const auto& dir : dirs)
+				accDir.rmpath (accDir.relativeFilePath (dir));
+
+			qDebug () << Q_FUNC_INFO
+					<< "removed"
+					<< count
+					<< "legacy messages from"
+					<< accDir.path ();
+		}
+	}
+
+	void Storage::MigrateLegacyMessages (const QDir& accDir, const MessageStore_ptr& store)
+	{
+		if (accDir.exists (LegacyMigratedMarker))
+		{
+			// A previous run might have been interrupted before the cleanup.
+			RemoveLegacyMessages (accDir);
+			return;
+		}
+
+		QHash<QStringList, QList<Message_ptr>> folder2msgs;
+		int count = 0;
+
+		ForEachLegacyMessage (accDir,
+				[&] (const QString& path, const QStringList& components)
+				{
+					QFile file { path };
+					if (!file.open (QIODevice::ReadOnly))
+					{
+						qWarning () << Q_FUNC_INFO
+								<< "unable to open"
+								<< path
+								<< file.errorString ();
+						return;
+					}
+
+					const auto& msg = std::make_shared<Message> ();
+					try
+					{
+						msg->Deserialize (qUncompress (file.readAll ()));
+					}
+					catch (const std::exception& e)
+					{
+						qWarning () << Q_FUNC_INFO
+								<< "error deserializing the message from"
+								<< path
+								<< e.what ();
+						return;
+					}
+
+					QStringList folder;
+					for (const auto& component : components)
+						folder << QString::fromUtf8 (QByteArray::fromHex (component.toLatin1 ()));
+
+					folder2msgs [folder] << msg;
+					++count;
+				});
+
+		for (auto pos = folder2msgs.begin (); pos != folder2msgs.end (); ++pos)
+			store->Put (pos.key (), *pos);
+
+		qDebug () << Q_FUNC_INFO
+				<< "migrated"
+				<< count
+				<< "messages in"
+				<< accDir.path ();
+
+		QFile marker { accDir.filePath (LegacyMigratedMarker) };
+		if (!marker.open (QIODevice::WriteOnly))
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unable to create"
+					<< marker.fileName ()
+					<< marker.errorString ()
+					<< "; keeping the legacy messages";
+			return;
+		}
+		marker.close ();
+
+		RemoveLegacyMessages (accDir);
+	}
+
 	AccountDatabase_ptr Storage::BaseForAccount (Account *acc)
 	{
 		if (AccountBases_.contains (acc))
@@ -414,6 +428,12 @@ namespace Snails
 		return base;
 	}
 
+	QHash<QByteArray, Message_ptr> Storage::GetPendingMessages (Account *acc) const
+	{
+		QMutexLocker locker { &PendingSaveMutex_ };
+		return PendingSaveMessages_.value (acc);
+	}
+
 	void Storage::AddMessage (Message_ptr msg, Account *acc)
 	{
 		const auto& base = BaseForAccount (acc);
@@ -422,6 +442,7 @@ namespace Snails
 
 	void Storage::UpdateCaches (Message_ptr msg)
 	{
+		QMutexLocker locker { &IsMessageReadMutex_ };
 		IsMessageRead_ [msg->GetFolderID ()] = msg->IsRead ();
 	}
 }
@@ -29,12 +29,16 @@
 
 #pragma once
 
+#include <boost/optional.hpp>
 #include <QObject>
 #include <QDir>
 #include <QSettings>
 #include <QHash>
 #include <QSet>
+#include <QMutex>
 #include "message.h"
+#include "messagestore.h"
+#include "common.h"
 
 namespace LeechCraft
 {
@@ -51,34 +55,68 @@ namespace Snails
 
 		QDir SDir_;
 		QSettings Settings_;
+		QMutex IsMessageReadMutex_;
 		QHash<QByteArray, bool> IsMessageRead_;
 
 		QHash<Account*, AccountDatabase_ptr> AccountBases_;
+		QMutex AccountStoresMutex_;
+		QMutex StoreOpenMutex_;
+		QHash<Account*, MessageStore_ptr> AccountStores_;
+
+		/* Accessed both from the GUI thread and from the account
+		 * threads (see GetReadStatuses() and LoadMessage()).
+		 */
+		mutable QMutex PendingSaveMutex_;
 		QHash<Account*, QHash<QByteArray, Message_ptr>> PendingSaveMessages_;
 	public:
 		Storage (QObject* = nullptr);
 
 		void SaveMessages (Account*, const QStringList& folders, const QList<Message_ptr>&);
 
+		/** @brief Loads the headers of all the messages of the account.
+		 *
+		 * The returned messages don't contain bodies.
+		 */
 		MessageSet LoadMessages (Account*);
+
+		/** @brief Loads the full message, including its bodies.
+		 */
 		Message_ptr LoadMessage (Account*, const QStringList& folder, const QByteArray& id);
+
+		/** @brief Loads the headers of the given messages.
+		 *
+		 * Only the index of the packed store is consulted, so the
+		 * returned messages don't contain bodies. Use LoadMessage() to
+		 * get the full message.
+		 */
 		QList<Message_ptr> LoadMessages (Account*, const QStringList& folder, const QList<QByteArray>& ids);
 
 		QList<QByteArray> LoadIDs (Account*, const QStringList& folder);
 		void RemoveMessage (Account*, const QStringList&, const QByteArray&);
 
-		int GetNumMessages (Account*) const;
+		int GetNumMessages (Account*);
 		int GetNumMessages (Account*, const QStringList& folder);
 		int GetNumUnread (Account*, const QStringList& folder);
-		bool HasMessagesIn (Account*) const;
+		bool HasMessagesIn (Account*);
 
 		bool IsMessageRead (Account*, const QStringList& folder, const QByteArray&);
-	private:
-		Message_ptr LoadMessage (Account*, QDir, const QByteArray&) const;
-		void RemoveMessageFile (Account*, const QStringList&, const QByteArray&);
+
+		/** @brief Returns the read status of all stored messages in the folder.
+		 *
+		 * Only the index of the packed store is consulted.
+		 */
+		QHash<QByteArray, bool> GetReadStatuses (Account*, const QStringList& folder);
+
+		boost::optional<FolderSyncState> GetFolderSyncState (Account*, const QStringList& folder);
+		void SetFolderSyncState (Account*, const QStringList& folder, const FolderSyncState&);
 	private:
 		QDir DirForAccount (Account*) const;
 		AccountDatabase_ptr BaseForAccount (Account*);
+		MessageStore_ptr StoreForAccount (Account*);
+
+		void MigrateLegacyMessages (const QDir&, const MessageStore_ptr&);
+
+		QHash<QByteArray, Message_ptr> GetPendingMessages (Account*) const;
 
 		void AddMessage (Message_ptr, Account*);
 		void UpdateCaches (Message_ptr);
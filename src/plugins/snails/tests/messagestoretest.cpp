@@ -0,0 +1,257 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+
+#include "messagestoretest.h"
+#include <QtTest>
+#include <QTemporaryDir>
+#include <QFileInfo>
+#include "messagestore.h"
+
+QTEST_MAIN (LeechCraft::Snails::MessageStoreTest)
+
+namespace LeechCraft
+{
+namespace Snails
+{
+	namespace
+	{
+		const QStringList Inbox { "INBOX" };
+		const QStringList Archive { "Archive", "2014" };
+
+		Message_ptr MakeMessage (const QByteArray& id, bool isRead = false, const QString& body = {})
+		{
+			const auto& msg = std::make_shared<Message> ();
+			msg->SetFolderID (id);
+			msg->SetFolders ({ Inbox });
+			msg->SetSubject ("Subject " + QString::fromLatin1 (id));
+			msg->SetBody (body.isEmpty () ? "Body " + QString::fromLatin1 (id) : body);
+			msg->SetRead (isRead);
+			return msg;
+		}
+
+		QByteArray MakeIncompressible (int size)
+		{
+			QByteArray result;
+			result.reserve (size);
+
+			quint32 state = 0x12345678;
+			for (int i = 0; i < size; ++i)
+			{
+				state = state * 1103515245 + 12345;
+				result.append (static_cast<char> (state >> 24));
+			}
+			return result;
+		}
+	}
+
+	void MessageStoreTest::testPutLoad ()
+	{
+		QTemporaryDir dir;
+		MessageStore store { QDir { dir.path () } };
+
+		store.Put (Inbox, { MakeMessage ("1"), MakeMessage ("2", true) });
+		store.Put (Archive, { MakeMessage ("3") });
+
+		QCOMPARE (store.GetCount (), 3);
+		QCOMPARE (store.GetCount (Inbox), 2);
+		QCOMPARE (store.GetUnreadCount (Inbox), 1);
+		QCOMPARE (store.Contains (Inbox, "2"), true);
+		QCOMPARE (store.Contains (Archive, "2"), false);
+
+		const auto& headers = store.LoadHeaders (Inbox, "1");
+		QCOMPARE (headers->GetSubject (), QString { "Subject 1" });
+		QCOMPARE (headers->GetBody (), QString {});
+
+		const auto& full = store.LoadFull (Inbox, "1");
+		QCOMPARE (full->GetSubject (), QString { "Subject 1" });
+		QCOMPARE (full->GetBody (), QString { "Body 1" });
+
+		QCOMPARE (store.LoadHeaders (Inbox, { "1", "unknown", "2" }).size (), 2);
+		QCOMPARE (*store.IsRead (Inbox, "2"), true);
+		QCOMPARE (store.IsRead (Inbox, "unknown").is_initialized (), false);
+
+		QVERIFY_EXCEPTION_THROWN (store.LoadFull (Inbox, "unknown"), std::runtime_error);
+	}
+
+	void MessageStoreTest::testUpdateRemove ()
+	{
+		QTemporaryDir dir;
+		MessageStore store { QDir { dir.path () } };
+
+		store.Put (Inbox, { MakeMessage ("1"), MakeMessage ("2") });
+		store.Put (Inbox, { MakeMessage ("1", true, "Updated") });
+
+		QCOMPARE (store.GetCount (Inbox), 2);
+		QCOMPARE (store.GetUnreadCount (Inbox), 1);
+		QCOMPARE (store.LoadFull (Inbox, "1")->GetBody (), QString { "Updated" });
+
+		store.Remove (Inbox, "2");
+		store.Remove (Inbox, "unknown");
+
+		QCOMPARE (store.GetIDs (Inbox), QList<QByteArray> { "1" });
+		QCOMPARE (store.GetReadStatuses (Inbox).value ("1"), true);
+	}
+
+	void MessageStoreTest::testReopen ()
+	{
+		QTemporaryDir dir;
+
+		{
+			MessageStore store { QDir { dir.path () } };
+			store.Put (Inbox, { MakeMessage ("1"), MakeMessage ("2") });
+			store.Put (Archive, { MakeMessage ("3", true) });
+			store.Put (Inbox, { MakeMessage ("1", true) });
+			store.Remove (Inbox, "2");
+		}
+
+		MessageStore store { QDir { dir.path () } };
+		QCOMPARE (store.GetCount (), 2);
+		QCOMPARE (store.GetIDs (Inbox), QList<QByteArray> { "1" });
+		QCOMPARE (*store.IsRead (Inbox, "1"), true);
+		QCOMPARE (store.LoadFull (Archive, "3")->GetBody (), QString { "Body 3" });
+	}
+
+	void MessageStoreTest::testCompaction ()
+	{
+		QTemporaryDir dir;
+		const auto& body = QString::fromLatin1 (MakeIncompressible (1024 * 1024).toHex ());
+
+		{
+			MessageStore store { QDir { dir.path () } };
+			store.Put (Inbox, { MakeMessage ("keep") });
+			for (int i = 0; i < 20; ++i)
+				store.Put (Inbox, { MakeMessage ("big", false, body) });
+		}
+
+		const auto& segmentPath = QDir { dir.path () }.filePath ("messages.seg");
+		const auto sizeBefore = QFileInfo { segmentPath }.size ();
+
+		MessageStore store { QDir { dir.path () } };
+		QVERIFY (QFileInfo { segmentPath }.size () < sizeBefore / 4);
+		QCOMPARE (store.GetCount (Inbox), 2);
+		QCOMPARE (store.LoadFull (Inbox, "big")->GetBody (), body);
+		QCOMPARE (store.LoadFull (Inbox, "keep")->GetBody (), QString { "Body keep" });
+		QVERIFY (!QFile::exists (segmentPath + ".new"));
+	}
+
+	void MessageStoreTest::testInterruptedCompaction ()
+	{
+		QTemporaryDir dir;
+		const QDir qdir { dir.path () };
+		const auto& indexPath = qdir.filePath ("messages.idx");
+		const auto& segmentPath = qdir.filePath ("messages.seg");
+
+		{
+			MessageStore store { qdir };
+			store.Put (Inbox, { MakeMessage ("1"), MakeMessage ("2") });
+		}
+
+		// Interrupted while writing the new files: they are dropped.
+		for (const auto& path : { indexPath, segmentPath })
+		{
+			QFile file { path + ".new" };
+			QVERIFY (file.open (QIODevice::WriteOnly));
+			file.write ("garbage");
+		}
+
+		{
+			MessageStore store { qdir };
+			QCOMPARE (store.GetCount (Inbox), 2);
+			QVERIFY (!QFile::exists (indexPath + ".new"));
+			QVERIFY (!QFile::exists (segmentPath + ".new"));
+		}
+
+		// Interrupted after replacing the segment: the new index is kept.
+		QVERIFY (QFile::copy (indexPath, indexPath + ".new"));
+		{
+			QFile index { indexPath };
+			QVERIFY (index.open (QIODevice::WriteOnly | QIODevice::Truncate));
+		}
+
+		MessageStore store { qdir };
+		QCOMPARE (store.GetCount (Inbox), 2);
+		QCOMPARE (store.LoadFull (Inbox, "2")->GetBody (), QString { "Body 2" });
+		QVERIFY (!QFile::exists (indexPath + ".new"));
+	}
+
+	void MessageStoreTest::testCorruptedIndexTail ()
+	{
+		QTemporaryDir dir;
+
+		{
+			MessageStore store { QDir { dir.path () } };
+			store.Put (Inbox, { MakeMessage ("1"), MakeMessage ("2") });
+		}
+
+		const auto& indexPath = QDir { dir.path () }.filePath ("messages.idx");
+		const auto goodSize = QFileInfo { indexPath }.size ();
+
+		{
+			QFile index { indexPath };
+			QVERIFY (index.open (QIODevice::Append));
+			index.write ("garbage that is not a frame");
+		}
+
+		{
+			MessageStore store { QDir { dir.path () } };
+			QCOMPARE (store.GetCount (Inbox), 2);
+			QCOMPARE (QFileInfo { indexPath }.size (), goodSize);
+
+			store.Put (Inbox, { MakeMessage ("3") });
+		}
+
+		MessageStore store { QDir { dir.path () } };
+		QCOMPARE (store.GetCount (Inbox), 3);
+		QCOMPARE (store.LoadFull (Inbox, "3")->GetBody (), QString { "Body 3" });
+	}
+
+	void MessageStoreTest::testTruncatedSegment ()
+	{
+		QTemporaryDir dir;
+
+		qint64 firstSize = 0;
+		{
+			MessageStore store { QDir { dir.path () } };
+			store.Put (Inbox, { MakeMessage ("1") });
+			firstSize = QFileInfo { QDir { dir.path () }.filePath ("messages.seg") }.size ();
+			store.Put (Inbox, { MakeMessage ("2") });
+		}
+
+		{
+			QFile segment { QDir { dir.path () }.filePath ("messages.seg") };
+			QVERIFY (segment.resize (firstSize + 4));
+		}
+
+		MessageStore store { QDir { dir.path () } };
+		QCOMPARE (store.GetIDs (Inbox), QList<QByteArray> { "1" });
+		QCOMPARE (store.LoadFull (Inbox, "1")->GetBody (), QString { "Body 1" });
+	}
+}
+}
@@ -0,0 +1,142 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "placeholdertab.h"
+#include <QLabel>
+#include <QVBoxLayout>
+
+namespace LeechCraft
+{
+namespace TabSessManager
+{
+	PlaceholderTab::PlaceholderTab (QObject *plugin, const RecInfo& info, QObject *tsmPlugin)
+	: TSMPlugin_ { tsmPlugin }
+	, Plugin_ { plugin }
+	, Info_ (info)
+	{
+		const auto label = new QLabel { tr ("This tab will be loaded once it's activated.") };
+		label->setAlignment (Qt::AlignCenter);
+
+		const auto lay = new QVBoxLayout;
+		lay->addWidget (label);
+		setLayout (lay);
+	}
+
+	TabClassInfo PlaceholderTab::GetStaticTabClassInfo ()
+	{
+		return
+		{
+			"TabSessManager.Placeholder",
+			tr ("Session placeholder"),
+			tr ("A tab from the previous session that is loaded on first activation."),
+			{},
+			0,
+			TFEmpty
+		};
+	}
+
+	QObject* PlaceholderTab::GetPlugin () const
+	{
+		return Plugin_;
+	}
+
+	const RecInfo& PlaceholderTab::GetRecInfo () const
+	{
+		return Info_;
+	}
+
+	bool PlaceholderTab::IsMaterializing () const
+	{
+		return IsMaterializing_;
+	}
+
+	void PlaceholderTab::CancelMaterializing ()
+	{
+		IsMaterializing_ = false;
+	}
+
+	void PlaceholderTab::MarkReplaced ()
+	{
+		IsReplaced_ = true;
+	}
+
+	bool PlaceholderTab::IsReplaced () const
+	{
+		return IsReplaced_;
+	}
+
+	TabClassInfo PlaceholderTab::GetTabClassInfo () const
+	{
+		auto info = GetStaticTabClassInfo ();
+		info.VisibleName_ = Info_.Name_;
+		info.Icon_ = Info_.Icon_;
+		return info;
+	}
+
+	QObject* PlaceholderTab::ParentMultiTabs ()
+	{
+		return TSMPlugin_;
+	}
+
+	void PlaceholderTab::Remove ()
+	{
+		emit removeTab (this);
+		deleteLater ();
+	}
+
+	QToolBar* PlaceholderTab::GetToolBar () const
+	{
+		return nullptr;
+	}
+
+	void PlaceholderTab::TabMadeCurrent ()
+	{
+		if (IsMaterializing_)
+			return;
+
+		IsMaterializing_ = true;
+		emit materializeRequested ();
+	}
+
+	QByteArray PlaceholderTab::GetTabRecoverData () const
+	{
+		return Info_.Data_;
+	}
+
+	QString PlaceholderTab::GetTabRecoverName () const
+	{
+		return Info_.Name_;
+	}
+
+	QIcon PlaceholderTab::GetTabRecoverIcon () const
+	{
+		return Info_.Icon_;
+	}
+}
+}
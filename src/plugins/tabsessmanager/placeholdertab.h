@@ -0,0 +1,116 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#pragma once
+
+#include <QWidget>
+#include <interfaces/ihavetabs.h>
+#include <interfaces/ihaverecoverabletabs.h>
+#include "recinfo.h"
+
+namespace LeechCraft
+{
+namespace TabSessManager
+{
+	/** @brief A lightweight stand-in for a tab restored from a session.
+	 *
+	 * The placeholder keeps only the recovery data, name, icon and
+	 * session properties of the tab it stands for. The actual tab is
+	 * opened by the owning plugin when the placeholder is first made
+	 * current, and then it replaces the placeholder.
+	 *
+	 * The placeholder reports the recovery data of the original tab, so
+	 * it is saved into the session and uncloses just as the original
+	 * tab would.
+	 */
+	class PlaceholderTab : public QWidget
+						 , public ITabWidget
+						 , public IRecoverableTab
+	{
+		Q_OBJECT
+		Q_INTERFACES (ITabWidget IRecoverableTab)
+
+		QObject * const TSMPlugin_;
+		QObject * const Plugin_;
+		const RecInfo Info_;
+
+		bool IsMaterializing_ = false;
+		bool IsReplaced_ = false;
+	public:
+		PlaceholderTab (QObject *plugin, const RecInfo& info, QObject *tsmPlugin);
+
+		static TabClassInfo GetStaticTabClassInfo ();
+
+		/** @brief Returns the plugin the original tab belongs to.
+		 */
+		QObject* GetPlugin () const;
+
+		/** @brief Returns the saved information about the original tab.
+		 */
+		const RecInfo& GetRecInfo () const;
+
+		/** @brief Returns whether the original tab is being opened to
+		 * replace this placeholder.
+		 */
+		bool IsMaterializing () const;
+
+		/** @brief Allows opening the original tab again.
+		 *
+		 * This is called if the original tab hasn't appeared in time.
+		 */
+		void CancelMaterializing ();
+
+		/** @brief Marks the placeholder as replaced by the original tab,
+		 * so its removal isn't treated as closing the tab.
+		 */
+		void MarkReplaced ();
+
+		/** @brief Returns whether the placeholder has been replaced by
+		 * the original tab.
+		 */
+		bool IsReplaced () const;
+
+		TabClassInfo GetTabClassInfo () const override;
+		QObject* ParentMultiTabs () override;
+		void Remove () override;
+		QToolBar* GetToolBar () const override;
+		void TabMadeCurrent () override;
+
+		QByteArray GetTabRecoverData () const override;
+		QString GetTabRecoverName () const override;
+		QIcon GetTabRecoverIcon () const override;
+	signals:
+		void materializeRequested ();
+
+		void removeTab (QWidget*);
+
+		void tabRecoverDataChanged ();
+	};
+}
+}
@@ -0,0 +1,267 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "sessionrecordstore.h"
+#include <QDataStream>
+#include <QtDebug>
+#include <util/sll/qtutil.h>
+#include <util/sys/savefile.h>
+
+namespace LeechCraft
+{
+namespace TabSessManager
+{
+	namespace
+	{
+		const quint8 StoreVersion = 1;
+
+		enum class EntryType : quint8
+		{
+			Record,
+			Layout
+		};
+
+		QByteArray SerializeRecord (quint64 id, const QByteArray& record)
+		{
+			QByteArray result;
+			QDataStream out { &result, QIODevice::WriteOnly };
+			out.setVersion (QDataStream::Qt_4_8);
+			out << static_cast<quint8> (EntryType::Record) << id << record;
+			return result;
+		}
+
+		QByteArray SerializeLayout (const SessionRecordStore::Layout_t& layout)
+		{
+			QByteArray result;
+			QDataStream out { &result, QIODevice::WriteOnly };
+			out.setVersion (QDataStream::Qt_4_8);
+			out << static_cast<quint8> (EntryType::Layout) << layout;
+			return result;
+		}
+
+		qint64 GetLiveSize (const QHash<quint64, QByteArray>& records)
+		{
+			qint64 result = 0;
+			for (const auto& record : records)
+				result += record.size ();
+			return result;
+		}
+	}
+
+	SessionRecordStore::SessionRecordStore (const QString& path)
+	: Path_ { path }
+	, Log_ { path }
+	{
+	}
+
+	boost::optional<QByteArray> SessionRecordStore::Load () const
+	{
+		QFile file { Path_ };
+		if (!file.exists ())
+			return {};
+
+		if (!file.open (QIODevice::ReadOnly))
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unable to open"
+					<< Path_
+					<< file.errorString ();
+			return {};
+		}
+
+		QDataStream in { &file };
+		in.setVersion (QDataStream::Qt_4_8);
+
+		quint8 version = 0;
+		in >> version;
+		if (version != StoreVersion)
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unknown store version"
+					<< version;
+			return {};
+		}
+
+		QHash<quint64, QByteArray> records;
+		Layout_t layout;
+
+		while (!in.atEnd ())
+		{
+			quint8 type = 0;
+			in >> type;
+
+			switch (static_cast<EntryType> (type))
+			{
+			case EntryType::Record:
+			{
+				quint64 id = 0;
+				QByteArray record;
+				in >> id >> record;
+				if (in.status () == QDataStream::Ok)
+					records [id] = record;
+				break;
+			}
+			case EntryType::Layout:
+			{
+				Layout_t entryLayout;
+				in >> entryLayout;
+				if (in.status () == QDataStream::Ok)
+					layout = entryLayout;
+				break;
+			}
+			default:
+				in.setStatus (QDataStream::ReadCorruptData);
+				break;
+			}
+
+			if (in.status () != QDataStream::Ok)
+			{
+				qWarning () << Q_FUNC_INFO
+						<< "incomplete or corrupted entry at"
+						<< file.pos ()
+						<< "of"
+						<< file.size ()
+						<< "; using the entries before it";
+				break;
+			}
+		}
+
+		QByteArray result;
+		QDataStream out { &result, QIODevice::WriteOnly };
+		for (const auto& pair : layout)
+		{
+			const auto pos = records.constFind (pair.first);
+			if (pos == records.constEnd () || pos->isEmpty ())
+				continue;
+
+			out.writeRawData (pos->constData (), pos->size ());
+			out << pair.second;
+		}
+		return result;
+	}
+
+	bool SessionRecordStore::IsOpen () const
+	{
+		return Log_.isOpen ();
+	}
+
+	void SessionRecordStore::Reset (const QHash<quint64, QByteArray>& records, const Layout_t& layout)
+	{
+		Log_.close ();
+
+		Records_ = records;
+		Layout_ = layout;
+
+		Util::SaveFile file { Path_ };
+		if (!file.open (QIODevice::WriteOnly))
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unable to open"
+					<< Path_
+					<< file.errorString ();
+			return;
+		}
+
+		{
+			QDataStream out { &file };
+			out.setVersion (QDataStream::Qt_4_8);
+			out << StoreVersion;
+		}
+
+		for (const auto& pair : Util::Stlize (Records_))
+			file.write (SerializeRecord (pair.first, pair.second));
+		file.write (SerializeLayout (Layout_));
+
+		if (!file.commit ())
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unable to commit"
+					<< Path_
+					<< file.errorString ();
+			return;
+		}
+
+		if (!Log_.open (QIODevice::WriteOnly | QIODevice::Append))
+			qWarning () << Q_FUNC_INFO
+					<< "unable to reopen"
+					<< Path_
+					<< Log_.errorString ();
+	}
+
+	void SessionRecordStore::Put (quint64 id, const QByteArray& record)
+	{
+		auto& stored = Records_ [id];
+		if (stored == record)
+			return;
+
+		stored = record;
+		Append (SerializeRecord (id, record));
+	}
+
+	void SessionRecordStore::SetLayout (const Layout_t& layout)
+	{
+		if (layout == Layout_)
+			return;
+
+		Layout_ = layout;
+
+		QHash<quint64, QByteArray> live;
+		for (const auto& pair : Layout_)
+			if (Records_.contains (pair.first))
+				live [pair.first] = Records_ [pair.first];
+		Records_ = live;
+
+		Append (SerializeLayout (Layout_));
+	}
+
+	void SessionRecordStore::Flush ()
+	{
+		if (!Log_.isOpen ())
+			return;
+
+		Log_.flush ();
+
+		const auto liveSize = GetLiveSize (Records_);
+		if (Log_.size () > 4 * liveSize + 64 * 1024)
+			Reset (Records_, Layout_);
+	}
+
+	void SessionRecordStore::Append (const QByteArray& entry)
+	{
+		if (!Log_.isOpen ())
+			return;
+
+		if (Log_.write (entry) != entry.size ())
+			qWarning () << Q_FUNC_INFO
+					<< "unable to append to"
+					<< Path_
+					<< Log_.errorString ();
+	}
+}
+}
@@ -0,0 +1,108 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#pragma once
+
+#include <boost/optional.hpp>
+#include <QHash>
+#include <QList>
+#include <QPair>
+#include <QFile>
+
+namespace LeechCraft
+{
+namespace TabSessManager
+{
+	/** @brief Append-only on-disk store of per-tab session records.
+	 *
+	 * Each tab is stored as a separate opaque record identified by a
+	 * numeric tab ID, and the order of the tabs along with their
+	 * windows is stored as a separate layout record. Changing a single
+	 * tab appends just its record to the log, and the log is compacted
+	 * into a snapshot once it grows much larger than the live data.
+	 *
+	 * Loading the store replays the log, stopping at the first
+	 * incomplete entry, so a session interrupted by a crash is restored
+	 * up to the last completely written record.
+	 */
+	class SessionRecordStore
+	{
+	public:
+		/** @brief The tab IDs in session order along with their window
+		 * indexes.
+		 */
+		using Layout_t = QList<QPair<quint64, int>>;
+	private:
+		const QString Path_;
+		QFile Log_;
+
+		QHash<quint64, QByteArray> Records_;
+		Layout_t Layout_;
+	public:
+		SessionRecordStore (const QString& path);
+
+		/** @brief Replays the log and returns the session.
+		 *
+		 * The session is returned in the same format as the one used
+		 * for sessions stored in the settings: each record followed by
+		 * its window index, in the layout order.
+		 *
+		 * @return The session, or an empty optional if there is no log
+		 * or it can't be read.
+		 */
+		boost::optional<QByteArray> Load () const;
+
+		/** @brief Returns whether a snapshot has been written by this
+		 * instance, so that records may be appended.
+		 */
+		bool IsOpen () const;
+
+		/** @brief Rewrites the log from scratch with the given records.
+		 */
+		void Reset (const QHash<quint64, QByteArray>& records, const Layout_t& layout);
+
+		/** @brief Appends the record of the tab with the given \em id
+		 * unless it hasn't changed since it was last stored.
+		 */
+		void Put (quint64 id, const QByteArray& record);
+
+		/** @brief Appends the layout unless it hasn't changed.
+		 *
+		 * Records of the tabs missing from the \em layout are dropped.
+		 */
+		void SetLayout (const Layout_t& layout);
+
+		/** @brief Compacts the log if it has outgrown the live data.
+		 */
+		void Flush ();
+	private:
+		void Append (const QByteArray&);
+	};
+}
+}
@@ -34,6 +34,7 @@
 #include <QTimer>
 #include <QInputDialog>
 #include <QMainWindow>
+#include <QPointer>
 #include <QtDebug>
 #include <interfaces/iinfo.h>
 #include <interfaces/ihavetabs.h>
@@ -41,21 +42,31 @@
 #include <interfaces/core/ipluginsmanager.h>
 #include <interfaces/core/irootwindowsmanager.h>
 #include <interfaces/core/icoretabwidget.h>
+#include <util/sll/delayedexecutor.h>
 #include <util/sll/qtutil.h>
+#include <util/sys/paths.h>
 #include "recinfo.h"
 #include "restoresessiondialog.h"
 #include "util.h"
 #include "tabspropsmanager.h"
+#include "placeholdertab.h"
 
 namespace LeechCraft
 {
 namespace TabSessManager
 {
+	namespace
+	{
+		const int MaterializeTimeout = 30 * 1000;
+	}
+
 	SessionsManager::SessionsManager (const ICoreProxy_ptr& proxy,
-			TabsPropsManager *tpm, QObject *parent)
+			TabsPropsManager *tpm, QObject *tsmPlugin, QObject *parent)
 	: QObject { parent }
 	, Proxy_ { proxy }
 	, TabsPropsMgr_ { tpm }
+	, TSMPlugin_ { tsmPlugin }
+	, Store_ { Util::GetUserDir (Util::UserDir::LC, "tabsessmanager").filePath ("session.log") }
 	{
 		const auto& roots = Proxy_->GetPluginsManager ()->
 				GetAllCastableRoots<IHaveTabs*> ();
@@ -103,7 +114,7 @@ namespace TabSessManager
 				str >> pluginId >> recData >> name >> icon >> props >> winId;
 				if (!pluginCache.contains (pluginId))
 				{
-					const auto obj = proxy->GetPluginsManager ()->GetPluginByID (pluginId);
+					const auto obj = proxy->GetPluginsManager ()->LoadPluginByID (pluginId);
 					pluginCache [pluginId] = obj;
 				}
 
@@ -166,21 +177,29 @@ namespace TabSessManager
 				[tab] (const QList<QObject*>& list) { return list.indexOf (tab) != -1; });
 	}
 
-	bool SessionsManager::eventFilter (QObject*, QEvent *e)
+	bool SessionsManager::eventFilter (QObject *obj, QEvent *e)
 	{
 		if (e->type () != QEvent::DynamicPropertyChange)
 			return false;
 
 		auto propEvent = static_cast<QDynamicPropertyChangeEvent*> (e);
 		if (propEvent->propertyName ().startsWith ("SessionData/"))
-			handleTabRecoverDataChanged ();
+			MarkTabDirty (obj);
 
 		return false;
 	}
 
 	namespace
 	{
-		void WriteRecoverableTab (QDataStream& str, int windowIndex,
+		QObject* GetTabPlugin (QObject *tab, ITabWidget *tw)
+		{
+			if (const auto placeholder = qobject_cast<PlaceholderTab*> (tab))
+				return placeholder->GetPlugin ();
+
+			return tw->ParentMultiTabs ();
+		}
+
+		void WriteRecoverableTab (QDataStream& str,
 				QObject *tab, IRecoverableTab *rec, IInfo *plugin)
 		{
 			const auto& data = rec->GetTabRecoverData ();
@@ -193,19 +212,45 @@ namespace TabSessManager
 					<< data
 					<< rec->GetTabRecoverName ()
 					<< forRecover
-					<< GetSessionProps (tab)
-					<< windowIndex;
+					<< GetSessionProps (tab);
 		}
 
-		void WriteSingleTab (QDataStream& str, int windowIndex,
+		void WriteSingleTab (QDataStream& str,
 				QObject *tab, const TabClassInfo& tc, IInfo *plugin)
 		{
 			str << plugin->GetUniqueID ()
 					<< tc.TabClass_
 					<< tc.VisibleName_
 					<< tc.Icon_.pixmap (32, 32)
-					<< GetSessionProps (tab)
-					<< windowIndex;
+					<< GetSessionProps (tab);
+		}
+
+		/* Returns the session record of the given tab without its window
+		 * index, or an empty byte array if the tab isn't to be saved.
+		 */
+		QByteArray SerializeTab (QObject *tab)
+		{
+			auto tw = qobject_cast<ITabWidget*> (tab);
+			if (!tw)
+				return {};
+
+			auto plugin = qobject_cast<IInfo*> (GetTabPlugin (tab, tw));
+			if (!plugin)
+				return {};
+
+			QByteArray result;
+			QDataStream str (&result, QIODevice::WriteOnly);
+
+			if (const auto rec = qobject_cast<IRecoverableTab*> (tab))
+				WriteRecoverableTab (str, tab, rec, plugin);
+			else
+			{
+				const auto& tc = tw->GetTabClassInfo ();
+				if (IsGoodSingleTC (tc))
+					WriteSingleTab (str, tab, tc, plugin);
+			}
+
+			return result;
 		}
 	}
 
@@ -219,22 +264,12 @@ namespace TabSessManager
 		{
 			for (auto tab : list)
 			{
-				auto tw = qobject_cast<ITabWidget*> (tab);
-				if (!tw)
-					continue;
-
-				auto plugin = qobject_cast<IInfo*> (tw->ParentMultiTabs ());
-				if (!plugin)
+				const auto& record = SerializeTab (tab);
+				if (record.isEmpty ())
 					continue;
 
-				if (const auto rec = qobject_cast<IRecoverableTab*> (tab))
-					WriteRecoverableTab (str, windowIndex, tab, rec, plugin);
-				else
-				{
-					const auto& tc = tw->GetTabClassInfo ();
-					if (IsGoodSingleTC (tc))
-						WriteSingleTab (str, windowIndex, tab, tc, plugin);
-				}
+				str.writeRawData (record.constData (), record.size ());
+				str << windowIndex;
 			}
 
 			++windowIndex;
@@ -243,6 +278,59 @@ namespace TabSessManager
 		return result;
 	}
 
+	quint64 SessionsManager::GetTabId (QObject *tab)
+	{
+		auto& id = TabIds_ [tab];
+		if (!id)
+			id = NextTabId_++;
+		return id;
+	}
+
+	SessionRecordStore::Layout_t SessionsManager::GetLayout ()
+	{
+		SessionRecordStore::Layout_t result;
+
+		int windowIndex = 0;
+		for (const auto& list : Tabs_)
+		{
+			for (const auto tab : list)
+				result.append ({ GetTabId (tab), windowIndex });
+
+			++windowIndex;
+		}
+
+		return result;
+	}
+
+	void SessionsManager::MarkTabDirty (QObject *tab)
+	{
+		if (!tab)
+			return;
+
+		DirtyTabs_ << tab;
+		ScheduleSave ();
+	}
+
+	void SessionsManager::MarkLayoutDirty ()
+	{
+		IsLayoutDirty_ = true;
+		ScheduleSave ();
+	}
+
+	void SessionsManager::ScheduleSave ()
+	{
+		if (IsRecovering_ || Proxy_->IsShuttingDown ())
+			return;
+
+		if (IsScheduled_)
+			return;
+
+		IsScheduled_ = true;
+		QTimer::singleShot (2000,
+				this,
+				SLOT (saveDefaultSession ()));
+	}
+
 	void SessionsManager::OpenTabs (const QHash<QObject*, QList<RecInfo>>& tabs)
 	{
 		QList<QPair<QObject*, RecInfo>> ordered;
@@ -264,19 +352,97 @@ namespace TabSessManager
 		{
 			const auto winGuard = TabsPropsMgr_->AppendWindow (pair.second.WindowID_);
 			const auto propsGuard = TabsPropsMgr_->AppendProps (pair.second.Props_);
-			if (const auto ihrt = qobject_cast<IHaveRecoverableTabs*> (pair.first))
-				ihrt->RecoverTabs ({ TabRecoverInfo { pair.second.Data_, {} } });
+			if (qobject_cast<IHaveRecoverableTabs*> (pair.first))
+				OpenPlaceholder (pair.first, pair.second);
 			else if (const auto iht = qobject_cast<IHaveTabs*> (pair.first))
 				iht->TabOpenRequested (pair.second.Data_);
 		}
 	}
 
+	void SessionsManager::OpenPlaceholder (QObject *plugin, const RecInfo& info)
+	{
+		const auto placeholder = new PlaceholderTab { plugin, info, TSMPlugin_ };
+		connect (placeholder,
+				SIGNAL (materializeRequested ()),
+				this,
+				SLOT (handleMaterializeRequested ()),
+				Qt::QueuedConnection);
+		connect (placeholder,
+				SIGNAL (removeTab (QWidget*)),
+				this,
+				SIGNAL (removeTab (QWidget*)));
+
+		emit addNewTab (info.Name_, placeholder);
+		emit changeTabIcon (placeholder, info.Icon_);
+	}
+
+	void SessionsManager::TryReplacePlaceholder (QWidget *widget)
+	{
+		if (Materializing_.isEmpty ())
+			return;
+
+		const auto irt = qobject_cast<IRecoverableTab*> (widget);
+		if (!irt || qobject_cast<PlaceholderTab*> (widget))
+			return;
+
+		const auto& data = irt->GetTabRecoverData ();
+		const auto placeholder = Materializing_.value (data);
+		if (!placeholder ||
+				qobject_cast<ITabWidget*> (widget)->ParentMultiTabs () != placeholder->GetPlugin ())
+			return;
+
+		Materializing_.remove (data);
+		ReplacePlaceholder (placeholder, widget);
+	}
+
+	void SessionsManager::ReplacePlaceholder (PlaceholderTab *placeholder, QWidget *tab)
+	{
+		for (const auto& pair : GetSessionProps (placeholder))
+			if (!tab->property (pair.first).isValid ())
+				tab->setProperty (pair.first, pair.second);
+
+		const auto rootWM = Proxy_->GetRootWindowsManager ();
+		const auto windowIndex = rootWM->GetWindowForTab (qobject_cast<ITabWidget*> (tab));
+		if (windowIndex >= 0)
+		{
+			const auto tabWidget = rootWM->GetTabWidget (windowIndex);
+
+			// The tab might have been opened asynchronously, so it is put
+			// right after the placeholder here instead of via the props.
+			if (windowIndex == rootWM->GetWindowForTab (placeholder))
+			{
+				const auto phIdx = tabWidget->IndexOf (placeholder);
+				const auto tabIdx = tabWidget->IndexOf (tab);
+				const auto targetIdx = tabIdx > phIdx ? phIdx + 1 : phIdx;
+				if (tabIdx != targetIdx)
+					tabWidget->MoveTab (tabIdx, targetIdx);
+			}
+
+			tabWidget->setCurrentWidget (tab);
+		}
+
+		placeholder->MarkReplaced ();
+		placeholder->Remove ();
+	}
+
+	void SessionsManager::CancelMaterializing (PlaceholderTab *placeholder)
+	{
+		for (auto i = Materializing_.begin (); i != Materializing_.end (); )
+			if (i.value () == placeholder)
+				i = Materializing_.erase (i);
+			else
+				++i;
+	}
+
 	void SessionsManager::recover ()
 	{
 		QSettings settings { QCoreApplication::organizationName (),
 				QCoreApplication::applicationName () + "_TabSessManager" };
 
-		QDataStream str (settings.value ("Data").toByteArray ());
+		// Sessions saved before the record store was introduced are only
+		// kept in the settings.
+		const auto& stored = Store_.Load ();
+		QDataStream str (stored ? *stored : settings.value ("Data").toByteArray ());
 		auto tabs = GetTabsFromStream (str, Proxy_);
 
 		if (!settings.value ("CleanShutdown", false).toBool ())
@@ -290,27 +456,41 @@ namespace TabSessManager
 
 	void SessionsManager::handleTabRecoverDataChanged ()
 	{
-		if (IsRecovering_ || Proxy_->IsShuttingDown ())
-			return;
-
-		if (IsScheduled_)
-			return;
+		MarkTabDirty (sender ());
 
-		IsScheduled_ = true;
-		QTimer::singleShot (2000,
-				this,
-				SLOT (saveDefaultSession ()));
+		if (const auto widget = qobject_cast<QWidget*> (sender ()))
+			TryReplacePlaceholder (widget);
 	}
 
 	void SessionsManager::saveDefaultSession ()
 	{
 		IsScheduled_ = false;
 
-		const auto& result = GetCurrentSession ();
+		if (!Store_.IsOpen ())
+		{
+			// The first save in this run writes the whole session, since
+			// the tab IDs from the previous run are meaningless now.
+			QHash<quint64, QByteArray> records;
+			for (const auto& list : Tabs_)
+				for (const auto tab : list)
+					records [GetTabId (tab)] = SerializeTab (tab);
+
+			Store_.Reset (records, GetLayout ());
+		}
+		else
+		{
+			for (const auto tab : DirtyTabs_)
+				if (HasTab (tab))
+					Store_.Put (GetTabId (tab), SerializeTab (tab));
 
-		QSettings settings (QCoreApplication::organizationName (),
-				QCoreApplication::applicationName () + "_TabSessManager");
-		settings.setValue ("Data", result);
+			if (IsLayoutDirty_)
+				Store_.SetLayout (GetLayout ());
+		}
+
+		DirtyTabs_.clear ();
+		IsLayoutDirty_ = false;
+
+		Store_.Flush ();
 	}
 
 	void SessionsManager::saveCustomSession ()
@@ -365,7 +545,7 @@ namespace TabSessManager
 				if (!tw || !rec)
 					continue;
 
-				plugin2recoveries [tw->ParentMultiTabs ()] << rec->GetTabRecoverData ();
+				plugin2recoveries [GetTabPlugin (tab, tw)] << rec->GetTabRecoverData ();
 			}
 
 		for (const auto& pair : Util::Stlize (tabs))
@@ -402,7 +582,12 @@ namespace TabSessManager
 			if (list.removeOne (widget))
 				break;
 
-		handleTabRecoverDataChanged ();
+		TabIds_.remove (widget);
+		DirtyTabs_.remove (widget);
+		MarkLayoutDirty ();
+
+		if (const auto placeholder = qobject_cast<PlaceholderTab*> (widget))
+			CancelMaterializing (placeholder);
 	}
 
 	void SessionsManager::handleNewTab (const QString&, QWidget *widget)
@@ -441,7 +626,10 @@ namespace TabSessManager
 		widget->installEventFilter (this);
 
 		if (!irt || !irt->GetTabRecoverData ().isEmpty ())
-			handleTabRecoverDataChanged ();
+		{
+			MarkTabDirty (widget);
+			MarkLayoutDirty ();
+		}
 
 		const auto& posProp = widget->property ("TabSessManager/Position");
 		if (posProp.isValid ())
@@ -453,6 +641,8 @@ namespace TabSessManager
 			if (prevPos < tabWidget->WidgetCount () && currentIdx != prevPos)
 				tabWidget->MoveTab (currentIdx, prevPos);
 		}
+
+		TryReplacePlaceholder (widget);
 	}
 
 	void SessionsManager::handleTabMoved (int from, int to)
@@ -479,7 +669,7 @@ namespace TabSessManager
 		auto tab = tabs.takeAt (from);
 		tabs.insert (to, tab);
 
-		handleTabRecoverDataChanged ();
+		MarkLayoutDirty ();
 	}
 
 	void SessionsManager::handleWindow (int index)
@@ -494,7 +684,53 @@ namespace TabSessManager
 	void SessionsManager::handleWindowRemoved (int index)
 	{
 		Tabs_.removeAt (index);
-		handleTabRecoverDataChanged ();
+		MarkLayoutDirty ();
+	}
+
+	void SessionsManager::handleMaterializeRequested ()
+	{
+		const auto placeholder = qobject_cast<PlaceholderTab*> (sender ());
+		if (!placeholder)
+			return;
+
+		const auto rootWM = Proxy_->GetRootWindowsManager ();
+		const auto windowIndex = rootWM->GetWindowForTab (placeholder);
+		if (!HasTab (placeholder) || windowIndex < 0)
+		{
+			placeholder->CancelMaterializing ();
+			return;
+		}
+
+		// The plugin might open the tab later, or not at all, so the tab
+		// is matched by its recover data once it appears, see
+		// TryReplacePlaceholder().
+		const auto& data = placeholder->GetRecInfo ().Data_;
+		Materializing_ [data] = placeholder;
+
+		const QPointer<PlaceholderTab> guarded { placeholder };
+		new Util::DelayedExecutor
+		{
+			[this, guarded, data]
+			{
+				if (!guarded || Materializing_.value (data) != guarded)
+					return;
+
+				qWarning () << Q_FUNC_INFO
+						<< "tab for"
+						<< guarded->GetRecInfo ().Name_
+						<< "hasn't appeared in time";
+				Materializing_.remove (data);
+				guarded->CancelMaterializing ();
+			},
+			MaterializeTimeout,
+			this
+		};
+
+		const auto winGuard = TabsPropsMgr_->AppendWindow (windowIndex);
+		const auto propsGuard = TabsPropsMgr_->AppendProps (GetSessionProps (placeholder));
+
+		const auto ihrt = qobject_cast<IHaveRecoverableTabs*> (placeholder->GetPlugin ());
+		ihrt->RecoverTabs ({ TabRecoverInfo { data, {} } });
 	}
 }
 }
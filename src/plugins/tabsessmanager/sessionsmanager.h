@@ -31,7 +31,12 @@
 
 #include <QObject>
 #include <QPair>
+#include <QIcon>
+#include <QSet>
 #include <interfaces/core/icoreproxy.h>
+#include "sessionrecordstore.h"
+
+class QWidget;
 
 namespace LeechCraft
 {
@@ -39,6 +44,7 @@ namespace TabSessManager
 {
 	struct RecInfo;
 	class TabsPropsManager;
+	class PlaceholderTab;
 
 	class SessionsManager : public QObject
 	{
@@ -47,13 +53,23 @@ namespace TabSessManager
 		const ICoreProxy_ptr Proxy_;
 
 		TabsPropsManager * const TabsPropsMgr_;
+		QObject * const TSMPlugin_;
 
 		bool IsScheduled_ = false;
 		bool IsRecovering_ = true;
 
 		QList<QList<QObject*>> Tabs_;
+
+		SessionRecordStore Store_;
+		QHash<QObject*, quint64> TabIds_;
+		quint64 NextTabId_ = 1;
+		QSet<QObject*> DirtyTabs_;
+		bool IsLayoutDirty_ = false;
+
+		// Placeholders waiting for their tabs, keyed by the recover data.
+		QHash<QByteArray, PlaceholderTab*> Materializing_;
 	public:
-		SessionsManager (const ICoreProxy_ptr&, TabsPropsManager*,  QObject* = nullptr);
+		SessionsManager (const ICoreProxy_ptr&, TabsPropsManager*, QObject *tsmPlugin, QObject* = nullptr);
 
 		QStringList GetCustomSessions () const;
 
@@ -66,6 +82,18 @@ namespace TabSessManager
 		bool eventFilter (QObject*, QEvent*);
 	private:
 		QByteArray GetCurrentSession () const;
+
+		quint64 GetTabId (QObject*);
+		SessionRecordStore::Layout_t GetLayout ();
+
+		void MarkTabDirty (QObject*);
+		void MarkLayoutDirty ();
+		void ScheduleSave ();
+
+		void OpenPlaceholder (QObject*, const RecInfo&);
+		void TryReplacePlaceholder (QWidget*);
+		void ReplacePlaceholder (PlaceholderTab*, QWidget*);
+		void CancelMaterializing (PlaceholderTab*);
 	public slots:
 		void recover ();
 		void handleTabRecoverDataChanged ();
@@ -84,8 +112,14 @@ namespace TabSessManager
 
 		void handleWindow (int);
 		void handleWindowRemoved (int);
+
+		void handleMaterializeRequested ();
 	signals:
 		void gotCustomSession (const QString&);
+
+		void addNewTab (const QString&, QWidget*);
+		void changeTabIcon (QWidget*, const QIcon&);
+		void removeTab (QWidget*);
 	};
 }
 }
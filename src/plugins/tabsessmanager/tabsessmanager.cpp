@@ -43,6 +43,7 @@
 #include "sessionsmanager.h"
 #include "unclosemanager.h"
 #include "tabspropsmanager.h"
+#include "placeholdertab.h"
 
 namespace LeechCraft
 {
@@ -55,9 +56,9 @@ namespace TabSessManager
 		SessionsManager SessionsMgr_;
 		SessionMenuManager SessionMenuMgr_;
 
-		Managers (const ICoreProxy_ptr& proxy)
+		Managers (const ICoreProxy_ptr& proxy, QObject *plugin)
 		: UncloseMgr_ { proxy, &TabsPropsMgr_ }
-		, SessionsMgr_ { proxy, &TabsPropsMgr_ }
+		, SessionsMgr_ { proxy, &TabsPropsMgr_, plugin }
 		, SessionMenuMgr_ { &SessionsMgr_ }
 		{
 			QObject::connect (&SessionMenuMgr_,
@@ -81,6 +82,19 @@ namespace TabSessManager
 					SIGNAL (gotCustomSession (QString)),
 					&SessionMenuMgr_,
 					SLOT (addCustomSession (QString)));
+
+			QObject::connect (&SessionsMgr_,
+					SIGNAL (addNewTab (QString, QWidget*)),
+					plugin,
+					SIGNAL (addNewTab (QString, QWidget*)));
+			QObject::connect (&SessionsMgr_,
+					SIGNAL (changeTabIcon (QWidget*, QIcon)),
+					plugin,
+					SIGNAL (changeTabIcon (QWidget*, QIcon)));
+			QObject::connect (&SessionsMgr_,
+					SIGNAL (removeTab (QWidget*)),
+					plugin,
+					SIGNAL (removeTab (QWidget*)));
 		}
 	};
 
@@ -88,7 +102,7 @@ namespace TabSessManager
 	{
 		Util::InstallTranslator ("tabsessmanager");
 
-		Mgrs_ = std::make_shared<Managers> (proxy);
+		Mgrs_ = std::make_shared<Managers> (proxy, this);
 
 		Proxy_ = proxy;
 
@@ -157,6 +171,18 @@ namespace TabSessManager
 		}
 	}
 
+	TabClasses_t Plugin::GetTabClasses () const
+	{
+		return { PlaceholderTab::GetStaticTabClassInfo () };
+	}
+
+	void Plugin::TabOpenRequested (const QByteArray& tabClass)
+	{
+		qWarning () << Q_FUNC_INFO
+				<< "unknown tab class"
+				<< tabClass;
+	}
+
 	void Plugin::HandleShutdownInitiated ()
 	{
 		Mgrs_.reset ();
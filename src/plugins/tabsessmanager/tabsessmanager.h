@@ -33,6 +33,7 @@
 #include <interfaces/iinfo.h>
 #include <interfaces/iplugin2.h>
 #include <interfaces/iactionsexporter.h>
+#include <interfaces/ihavetabs.h>
 #include <interfaces/ishutdownlistener.h>
 #include <interfaces/core/ihookproxy.h>
 
@@ -49,10 +50,11 @@ namespace TabSessManager
 				 , public IInfo
 				 , public IPlugin2
 				 , public IActionsExporter
+				 , public IHaveTabs
 				 , public IShutdownListener
 	{
 		Q_OBJECT
-		Q_INTERFACES (IInfo IPlugin2 IActionsExporter IShutdownListener)
+		Q_INTERFACES (IInfo IPlugin2 IActionsExporter IHaveTabs IShutdownListener)
 
 		LC_PLUGIN_METADATA ("org.LeechCraft.TabSessManager")
 
@@ -73,6 +75,9 @@ namespace TabSessManager
 
 		QList<QAction*> GetActions (ActionsEmbedPlace) const;
 
+		TabClasses_t GetTabClasses () const;
+		void TabOpenRequested (const QByteArray&);
+
 		void HandleShutdownInitiated ();
 	public slots:
 		void hookTabIsRemoving (LeechCraft::IHookProxy_ptr proxy,
@@ -84,6 +89,13 @@ namespace TabSessManager
 				const QWidget *widget) const;
 	signals:
 		void gotActions (QList<QAction*>, LeechCraft::ActionsEmbedPlace);
+
+		void addNewTab (const QString&, QWidget*);
+		void changeTabIcon (QWidget*, const QIcon&);
+		void changeTabName (QWidget*, const QString&);
+		void raiseTab (QWidget*);
+		void removeTab (QWidget*);
+		void statusBarChanged (QWidget*, const QString&);
 	};
 }
 }
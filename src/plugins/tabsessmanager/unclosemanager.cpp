@@ -36,6 +36,7 @@
 #include <interfaces/core/irootwindowsmanager.h>
 #include <interfaces/core/icoretabwidget.h>
 #include "tabspropsmanager.h"
+#include "placeholdertab.h"
 #include "util.h"
 
 namespace LeechCraft
@@ -61,7 +62,14 @@ namespace TabSessManager
 		if (!tab)
 			return;
 
-		if (const auto recTab = qobject_cast<IRecoverableTab*> (widget))
+		if (const auto placeholder = qobject_cast<PlaceholderTab*> (widget))
+		{
+			// A materialized placeholder is replaced by the actual tab,
+			// not closed by the user.
+			if (!placeholder->IsReplaced ())
+				HandleRemovePlaceholder (placeholder);
+		}
+		else if (const auto recTab = qobject_cast<IRecoverableTab*> (widget))
 			HandleRemoveRecoverableTab (widget, recTab);
 		else if (IsGoodSingleTC (tab->GetTabClassInfo ()))
 			HandleRemoveSingleTab (widget, tab);
@@ -155,6 +163,23 @@ namespace TabSessManager
 			});
 	}
 
+	void UncloseManager::HandleRemovePlaceholder (PlaceholderTab *placeholder)
+	{
+		const auto& recInfo = placeholder->GetRecInfo ();
+		const auto plugin = placeholder->GetPlugin ();
+
+		GenericRemoveTab ({
+				recInfo.Data_,
+				recInfo.Name_,
+				recInfo.Icon_,
+				placeholder,
+				[plugin] (QObject*, const TabRecoverInfo& info)
+				{
+					qobject_cast<IHaveRecoverableTabs*> (plugin)->RecoverTabs ({ info });
+				}
+			});
+	}
+
 	void UncloseManager::HandleRemoveSingleTab (QWidget *widget, ITabWidget *tab)
 	{
 		const auto& tc = tab->GetTabClassInfo ();
@@ -42,6 +42,7 @@ namespace LeechCraft
 namespace TabSessManager
 {
 	class TabsPropsManager;
+	class PlaceholderTab;
 
 	class UncloseManager : public QObject
 	{
@@ -64,6 +65,7 @@ namespace TabSessManager
 		void GenericRemoveTab (const RemoveTabParams&);
 		void HandleRemoveRecoverableTab (QWidget*, IRecoverableTab*);
 		void HandleRemoveSingleTab (QWidget*, ITabWidget*);
+		void HandleRemovePlaceholder (PlaceholderTab*);
 	};
 }
 }
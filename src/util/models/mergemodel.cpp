@@ -190,20 +190,45 @@ namespace Util
 		}
 
 		auto currentItem = Root_;
+		auto row = 0;
 		for (const auto& idx : hier)
 		{
-			currentItem = currentItem->FindChild (idx);
-			if (!currentItem)
+			if (currentItem == Root_)
 			{
-				qWarning () << Q_FUNC_INFO
-						<< "no next item for"
-						<< idx
-						<< hier;
-				return {};
+				const auto pos = GetModelPosition (idx.model ());
+				if (pos < 0)
+				{
+					qWarning () << Q_FUNC_INFO
+							<< "unknown model"
+							<< idx.model ();
+					return {};
+				}
+
+				row = GetRowsBefore (pos) + idx.row ();
 			}
+			else
+				row = idx.row ();
+
+			// The expected child is checked against the index in case
+			// the source model hasn't notified us about some change yet.
+			auto child = currentItem->GetChild (row);
+			if (!child || child->GetIndex () != idx.sibling (idx.row (), 0))
+			{
+				child = currentItem->FindChild (idx);
+				if (!child)
+				{
+					qWarning () << Q_FUNC_INFO
+							<< "no next item for"
+							<< idx
+							<< hier;
+					return {};
+				}
+				row = currentItem->GetRow (child);
+			}
+			currentItem = child;
 		}
 
-		return createIndex (currentItem->GetRow (), sourceIndex.column (), currentItem.get ());
+		return createIndex (row, sourceIndex.column (), currentItem.get ());
 	}
 
 	QModelIndex MergeModel::mapToSource (const QModelIndex& proxyIndex) const
@@ -232,6 +257,8 @@ namespace Util
 			return;
 
 		Models_.push_back (model);
+		ModelRowCounts_ << 0;
+		RebuildRowCounts ();
 
 		connect (model,
 				SIGNAL (columnsAboutToBeInserted (const QModelIndex&, int, int)),
@@ -292,6 +319,7 @@ namespace Util
 
 			for (auto i = 0; i < rc; ++i)
 				Root_->AppendChild (model, model->index (i, 0), Root_);
+			UpdateRowCount (Models_.size () - 1, rc);
 
 			endInsertRows ();
 		}
@@ -299,37 +327,44 @@ namespace Util
 
 	MergeModel::const_iterator MergeModel::FindModel (const QAbstractItemModel *model) const
 	{
-		return std::find (Models_.begin (), Models_.end (), model);
+		const auto pos = GetModelPosition (model);
+		return pos >= 0 ? Models_.begin () + pos : Models_.end ();
 	}
 
 	MergeModel::iterator MergeModel::FindModel (const QAbstractItemModel *model)
 	{
-		return std::find (Models_.begin (), Models_.end (), model);
+		const auto pos = GetModelPosition (model);
+		return pos >= 0 ? Models_.begin () + pos : Models_.end ();
 	}
 
 	void MergeModel::RemoveModel (QAbstractItemModel *model)
 	{
-		auto i = FindModel (model);
-
-		if (i == Models_.end ())
+		const auto pos = GetModelPosition (model);
+		if (pos < 0)
 		{
 			qWarning () << Q_FUNC_INFO << "not found model" << model;
 			return;
 		}
 
-		for (auto r = Root_->begin (); r != Root_->end (); )
-			if ((*r)->GetModel () == model)
-			{
-				const auto idx = std::distance (Root_->begin (), r);
+		flushDataChanges ();
 
-				beginRemoveRows ({}, idx, idx);
-				r = Root_->EraseChild (r);
-				endRemoveRows ();
-			}
-			else
-				++r;
+		disconnect (model,
+				nullptr,
+				this,
+				nullptr);
+
+		if (const auto rc = ModelRowCounts_.at (pos))
+		{
+			const auto startingRow = GetRowsBefore (pos);
 
-		Models_.erase (i);
+			beginRemoveRows ({}, startingRow, startingRow + rc - 1);
+			Root_->EraseChildren (Root_->begin () + startingRow, Root_->begin () + startingRow + rc);
+			endRemoveRows ();
+		}
+
+		Models_.removeAt (pos);
+		ModelRowCounts_.remove (pos);
+		RebuildRowCounts ();
 	}
 
 	size_t MergeModel::Size () const
@@ -339,32 +374,25 @@ namespace Util
 
 	int MergeModel::GetStartingRow (MergeModel::const_iterator it) const
 	{
-		int result = 0;
-		for (auto i = Models_.begin (); i != it; ++i)
-			result += (*i)->rowCount ({});
-		return result;
+		return GetRowsBefore (std::distance (Models_.begin (), it));
 	}
 
 	MergeModel::const_iterator MergeModel::GetModelForRow (int row, int *starting) const
 	{
-		const auto child = Root_->GetChild (row);
-		const auto it = FindModel (child->GetModel ());
-
-		if (starting)
-			*starting = GetStartingRow (it);
+		const auto pos = FindModelPosition (row, starting);
+		if (pos < 0)
+			throw std::runtime_error ("MergeModel::GetModelForRow(): no model for the given row");
 
-		return it;
+		return Models_.begin () + pos;
 	}
 
 	MergeModel::iterator MergeModel::GetModelForRow (int row, int *starting)
 	{
-		const auto child = Root_->GetChild (row);
-		const auto it = FindModel (child->GetModel ());
+		const auto pos = FindModelPosition (row, starting);
+		if (pos < 0)
+			throw std::runtime_error ("MergeModel::GetModelForRow(): no model for the given row");
 
-		if (starting)
-			*starting = GetStartingRow (it);
-
-		return it;
+		return Models_.begin () + pos;
 	}
 
 	QList<QAbstractItemModel*> MergeModel::GetAllModels () const
@@ -399,17 +427,44 @@ namespace Util
 	void MergeModel::handleDataChanged (const QModelIndex& topLeft,
 			const QModelIndex& bottomRight)
 	{
-		emit dataChanged (mapFromSource (topLeft), mapFromSource (bottomRight));
+		const auto& mappedTopLeft = mapFromSource (topLeft);
+		const auto& mappedBottomRight = mapFromSource (bottomRight);
+		if (!mappedTopLeft.isValid () || !mappedBottomRight.isValid ())
+			return;
+
+		const auto item = static_cast<ModelItem*> (mappedTopLeft.internalPointer ());
+		const auto parentItem = item->GetParent ().get ();
+
+		auto& change = PendingDataChanges_ [parentItem];
+		if (change.Rows_.isEmpty ())
+		{
+			change.FirstColumn_ = mappedTopLeft.column ();
+			change.LastColumn_ = mappedBottomRight.column ();
+		}
+		else
+		{
+			change.FirstColumn_ = std::min (change.FirstColumn_, mappedTopLeft.column ());
+			change.LastColumn_ = std::max (change.LastColumn_, mappedBottomRight.column ());
+		}
+		change.Rows_.append ({ mappedTopLeft.row (), mappedBottomRight.row () });
+
+		if (!DataChangesFlushScheduled_)
+		{
+			DataChangesFlushScheduled_ = true;
+			QMetaObject::invokeMethod (this, "flushDataChanges", Qt::QueuedConnection);
+		}
 	}
 
 	void MergeModel::handleRowsAboutToBeInserted (const QModelIndex& parent,
 			int first, int last)
 	{
+		flushDataChanges ();
+
 		const auto model = static_cast<QAbstractItemModel*> (sender ());
 
 		const auto startingRow = parent.isValid () ?
 				0 :
-				GetStartingRow (FindModel (model));
+				GetRowsBefore (GetModelPosition (model));
 		beginInsertRows (mapFromSource (parent),
 				first + startingRow, last + startingRow);
 	}
@@ -417,11 +472,14 @@ namespace Util
 	void MergeModel::handleRowsAboutToBeRemoved (const QModelIndex& parent,
 			int first, int last)
 	{
+		flushDataChanges ();
+
 		auto model = static_cast<QAbstractItemModel*> (sender ());
 
+		const auto modelPos = GetModelPosition (model);
 		const auto startingRow = parent.isValid () ?
 				0 :
-				GetStartingRow (FindModel (model));
+				GetRowsBefore (modelPos);
 		beginRemoveRows (mapFromSource (parent),
 				first + startingRow, last + startingRow);
 
@@ -433,10 +491,13 @@ namespace Util
 		auto it = item->EraseChildren (item->begin () + startingRow + first,
 				item->begin () + startingRow + last + 1);
 
+		if (!parent.isValid ())
+			UpdateRowCount (modelPos, first - last - 1);
+
 		RemovalRefreshers_.push ([=] () mutable
 				{
-					for ( ; it != item->end () && (*it)->GetModel () == model; ++it)
-						(*it)->RefreshIndex (startingRow);
+					for (auto row = first; it != item->end () && (*it)->GetModel () == model; ++it, ++row)
+						(*it)->SetSourceRow (row);
 				});
 	}
 
@@ -444,15 +505,19 @@ namespace Util
 	{
 		const auto model = static_cast<QAbstractItemModel*> (sender ());
 
+		const auto modelPos = GetModelPosition (model);
 		const auto startingRow = parent.isValid () ?
 				0 :
-				GetStartingRow (FindModel (model));
+				GetRowsBefore (modelPos);
 
 		const auto rawItem = parent.isValid () ?
 				static_cast<ModelItem*> (mapFromSource (parent).internalPointer ()) :
 				Root_.get ();
 		const auto& item = rawItem->shared_from_this ();
 
+		if (!parent.isValid ())
+			UpdateRowCount (modelPos, last - first + 1);
+
 		for ( ; first <= last; ++first)
 		{
 			const auto& srcIdx = model->index (first, 0, parent);
@@ -468,7 +533,7 @@ namespace Util
 			if (child->GetModel () != model)
 				break;
 
-			child->RefreshIndex (startingRow);
+			child->SetSourceRow (last - startingRow);
 		}
 
 		endInsertRows ();
@@ -482,12 +547,16 @@ namespace Util
 
 	void MergeModel::handleModelAboutToBeReset ()
 	{
+		flushDataChanges ();
+
 		const auto model = static_cast<QAbstractItemModel*> (sender ());
-		if (const auto rc = model->rowCount ())
+		const auto modelPos = GetModelPosition (model);
+		if (const auto rc = ModelRowCounts_.value (modelPos))
 		{
-			const auto startingRow = GetStartingRow (FindModel (model));
+			const auto startingRow = GetRowsBefore (modelPos);
 			beginRemoveRows ({}, startingRow, rc + startingRow - 1);
 			Root_->EraseChildren (Root_->begin () + startingRow, Root_->begin () + startingRow + rc);
+			UpdateRowCount (modelPos, -rc);
 			endRemoveRows ();
 		}
 	}
@@ -497,17 +566,59 @@ namespace Util
 		const auto model = static_cast<QAbstractItemModel*> (sender ());
 		if (const auto rc = model->rowCount ())
 		{
-			const auto startingRow = GetStartingRow (FindModel (model));
+			const auto modelPos = GetModelPosition (model);
+			const auto startingRow = GetRowsBefore (modelPos);
 
 			beginInsertRows ({}, startingRow, rc + startingRow - 1);
 
 			for (int i = 0; i < rc; ++i)
 				Root_->InsertChild (startingRow + i, model, model->index (i, 0, {}), Root_);
+			UpdateRowCount (modelPos, rc);
 
 			endInsertRows ();
 		}
 	}
 
+	void MergeModel::flushDataChanges ()
+	{
+		DataChangesFlushScheduled_ = false;
+		if (PendingDataChanges_.isEmpty ())
+			return;
+
+		decltype (PendingDataChanges_) changes;
+		changes.swap (PendingDataChanges_);
+
+		for (auto it = changes.begin (); it != changes.end (); ++it)
+		{
+			const auto parentItem = it.key ();
+			const auto& parent = parentItem == Root_.get () ?
+					QModelIndex {} :
+					createIndex (parentItem->GetRow (), 0, parentItem);
+
+			auto& rows = it->Rows_;
+			std::sort (rows.begin (), rows.end ());
+
+			auto emitRange = [&] (int first, int last)
+			{
+				emit dataChanged (index (first, it->FirstColumn_, parent),
+						index (last, it->LastColumn_, parent));
+			};
+
+			auto range = rows.first ();
+			for (const auto& next : rows)
+			{
+				if (next.first > range.second + 1)
+				{
+					emitRange (range.first, range.second);
+					range = next;
+				}
+				else
+					range.second = std::max (range.second, next.second);
+			}
+			emitRange (range.first, range.second);
+		}
+	}
+
 	bool MergeModel::AcceptsRow (QAbstractItemModel*, int) const
 	{
 		DefaultAcceptsRowImpl_ = true;
@@ -528,5 +639,74 @@ namespace Util
 			result += AcceptsRow (model, i) ? 1 : 0;
 		return result;
 	}
+
+	int MergeModel::GetModelPosition (const QAbstractItemModel *model) const
+	{
+		return ModelPositions_.value (model, -1);
+	}
+
+	/* RowCountsTree_ is a Fenwick tree over ModelRowCounts_: its i-th
+	 * element (1-based) holds the sum of the (i & -i) counts ending at
+	 * the i-th model.
+	 */
+	int MergeModel::GetRowsBefore (int modelPos) const
+	{
+		int result = 0;
+		for (int i = modelPos; i > 0; i -= i & -i)
+			result += RowCountsTree_.at (i - 1);
+		return result;
+	}
+
+	int MergeModel::FindModelPosition (int row, int *starting) const
+	{
+		const auto size = RowCountsTree_.size ();
+		if (row < 0 || !size)
+			return -1;
+
+		int step = 1;
+		while (step * 2 <= size)
+			step *= 2;
+
+		// Finds the largest position whose prefix sum doesn't exceed row.
+		int pos = 0;
+		int remaining = row;
+		for ( ; step; step /= 2)
+			if (pos + step <= size && RowCountsTree_.at (pos + step - 1) <= remaining)
+			{
+				pos += step;
+				remaining -= RowCountsTree_.at (pos - 1);
+			}
+
+		if (pos >= size)
+			return -1;
+
+		if (starting)
+			*starting = row - remaining;
+		return pos;
+	}
+
+	void MergeModel::UpdateRowCount (int modelPos, int delta)
+	{
+		ModelRowCounts_ [modelPos] += delta;
+		for (int i = modelPos + 1; i <= RowCountsTree_.size (); i += i & -i)
+			RowCountsTree_ [i - 1] += delta;
+	}
+
+	void MergeModel::RebuildRowCounts ()
+	{
+		RowCountsTree_ = ModelRowCounts_;
+
+		const auto size = RowCountsTree_.size ();
+		for (int i = 1; i <= size; ++i)
+		{
+			const auto parent = i + (i & -i);
+			if (parent <= size)
+				RowCountsTree_ [parent - 1] += RowCountsTree_.at (i - 1);
+		}
+
+		ModelPositions_.clear ();
+		for (int i = 0; i < Models_.size (); ++i)
+			ModelPositions_ [Models_.at (i).data ()] = i;
+	}
 }
 }
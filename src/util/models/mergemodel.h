@@ -34,6 +34,8 @@
 #include <QAbstractProxyModel>
 #include <QStringList>
 #include <QStack>
+#include <QVector>
+#include <QHash>
 #include "modelsconfig.h"
 #include "modelitem.h"
 
@@ -52,6 +54,18 @@ namespace LeechCraft
 		 * Seems like it would never support it at least someone would
 		 * try to implement it.
 		 *
+		 * The number of rows each source model contributes is kept in a
+		 * Fenwick tree, so mapping between rows of this model and rows
+		 * of the source models is logarithmic in the number of models
+		 * and doesn't depend on the number of rows.
+		 *
+		 * dataChanged() signals of the source models are not forwarded
+		 * immediately. Instead, they are collected until the control
+		 * returns to the event loop (or until the structure of a source
+		 * model changes), and adjacent or overlapping rows are merged
+		 * into ranges, so a burst of per-row changes results in a few
+		 * dataChanged() signals of this model.
+		 *
 		 * @ingroup ModelUtil
 		 */
 		class UTIL_MODELS_API MergeModel : public QAbstractItemModel
@@ -68,6 +82,19 @@ namespace LeechCraft
 			ModelItem_ptr Root_;
 
 			QStack<std::function<void ()>> RemovalRefreshers_;
+
+			QHash<const QAbstractItemModel*, int> ModelPositions_;
+			QVector<int> ModelRowCounts_;
+			QVector<int> RowCountsTree_;
+
+			struct PendingDataChange
+			{
+				QList<QPair<int, int>> Rows_;
+				int FirstColumn_;
+				int LastColumn_;
+			};
+			QHash<ModelItem*, PendingDataChange> PendingDataChanges_;
+			bool DataChangesFlushScheduled_ = false;
 		public:
 			typedef models_t::iterator iterator;
 			typedef models_t::const_iterator const_iterator;
@@ -263,6 +290,14 @@ namespace LeechCraft
 			virtual bool AcceptsRow (QAbstractItemModel *model, int row) const;
 		private:
 			int RowCount (QAbstractItemModel*) const;
+
+			int GetModelPosition (const QAbstractItemModel*) const;
+			int GetRowsBefore (int modelPos) const;
+			int FindModelPosition (int row, int *starting) const;
+			void UpdateRowCount (int modelPos, int delta);
+			void RebuildRowCounts ();
+		private Q_SLOTS:
+			void flushDataChanges ();
 		};
 	}
 }
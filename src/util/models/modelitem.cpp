@@ -65,9 +65,14 @@ namespace Util
 	}
 
 	void ModelItem::RefreshIndex (int modelStartingRow)
+	{
+		SetSourceRow (GetRow () - modelStartingRow);
+	}
+
+	void ModelItem::SetSourceRow (int row)
 	{
 		if (SrcIdx_.isValid ())
-			SrcIdx_ = Model_->index (GetRow () - modelStartingRow, 0, Parent_.lock ()->GetIndex ());
+			SrcIdx_ = Model_->index (row, 0, Parent_.lock ()->GetIndex ());
 	}
 
 	QAbstractItemModel* ModelItem::GetModel () const
@@ -80,7 +85,7 @@ namespace Util
 		index = index.sibling (index.row (), 0);
 
 		const auto pos = std::find_if (Children_.begin (), Children_.end (),
-				[&index] (const ModelItem_ptr& item) { return item->GetIndex () == index; });
+				[&index] (const ModelItem_ptr& item) { return item && item->GetIndex () == index; });
 		return pos == Children_.end () ? ModelItem_ptr {} : *pos;
 	}
 }
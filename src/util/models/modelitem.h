@@ -115,6 +115,20 @@ namespace Util
 		 */
 		void RefreshIndex (int modelStartingRow);
 
+		/** @brief Updates the wrapped index so that it points at the
+		 * given source \em row.
+		 *
+		 * Unlike RefreshIndex(), this function doesn't need to look up
+		 * this item's own row among its siblings, which is linear in
+		 * the number of siblings.
+		 *
+		 * @param[in] row The row of the wrapped index among the children
+		 * of the parent item's wrapped index.
+		 *
+		 * @sa RefreshIndex()
+		 */
+		void SetSourceRow (int row);
+
 		/** @brief Finds a child item for the given \em index.
 		 *
 		 * The \em index is assumed to be the child of the one wrapped by
@@ -0,0 +1,182 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "mergemodeltest.h"
+#include <memory>
+#include <QtTest>
+#include <QStandardItemModel>
+#include <mergemodel.h>
+
+QTEST_MAIN (LeechCraft::Util::MergeModelTest)
+
+namespace LeechCraft
+{
+namespace Util
+{
+	namespace
+	{
+		using Model_ptr = std::shared_ptr<QStandardItemModel>;
+
+		Model_ptr MakeModel (const QString& prefix, int rows)
+		{
+			const auto model = std::make_shared<QStandardItemModel> ();
+			for (int i = 0; i < rows; ++i)
+				model->appendRow (new QStandardItem { prefix + QString::number (i) });
+			return model;
+		}
+
+		QStringList GetRows (const QAbstractItemModel& model)
+		{
+			QStringList result;
+			for (int i = 0; i < model.rowCount (); ++i)
+				result << model.index (i, 0).data ().toString ();
+			return result;
+		}
+	}
+
+	void MergeModelTest::testRowMapping ()
+	{
+		const auto a = MakeModel ("a", 2);
+		const auto b = MakeModel ("b", 0);
+		const auto c = MakeModel ("c", 3);
+
+		MergeModel merge { QStringList { "Name" } };
+		merge.AddModel (a.get ());
+		merge.AddModel (b.get ());
+		merge.AddModel (c.get ());
+
+		QCOMPARE (GetRows (merge), (QStringList { "a0", "a1", "c0", "c1", "c2" }));
+
+		int starting = -1;
+		QCOMPARE (merge.GetModelForRow (1, &starting)->data (), static_cast<QAbstractItemModel*> (a.get ()));
+		QCOMPARE (starting, 0);
+		QCOMPARE (merge.GetModelForRow (2, &starting)->data (), static_cast<QAbstractItemModel*> (c.get ()));
+		QCOMPARE (starting, 2);
+		QCOMPARE (merge.GetStartingRow (merge.FindModel (c.get ())), 2);
+
+		const auto& mapped = merge.mapFromSource (c->index (1, 0));
+		QCOMPARE (mapped.row (), 3);
+		QCOMPARE (merge.mapToSource (mapped), c->index (1, 0));
+
+		merge.RemoveModel (a.get ());
+		QCOMPARE (GetRows (merge), (QStringList { "c0", "c1", "c2" }));
+		QCOMPARE (merge.mapFromSource (c->index (1, 0)).row (), 1);
+	}
+
+	void MergeModelTest::testRowsInsertedRemoved ()
+	{
+		const auto a = MakeModel ("a", 2);
+		const auto b = MakeModel ("b", 2);
+
+		MergeModel merge { QStringList { "Name" } };
+		merge.AddModel (a.get ());
+		merge.AddModel (b.get ());
+
+		a->insertRow (1, new QStandardItem { "new" });
+		QCOMPARE (GetRows (merge), (QStringList { "a0", "new", "a1", "b0", "b1" }));
+		QCOMPARE (merge.mapFromSource (a->index (2, 0)).row (), 2);
+		QCOMPARE (merge.mapFromSource (b->index (0, 0)).row (), 3);
+
+		a->removeRows (0, 2);
+		QCOMPARE (GetRows (merge), (QStringList { "a1", "b0", "b1" }));
+		QCOMPARE (merge.mapToSource (merge.index (0, 0)), a->index (0, 0));
+		QCOMPARE (merge.mapFromSource (b->index (1, 0)).row (), 2);
+
+		b->clear ();
+		QCOMPARE (GetRows (merge), (QStringList { "a1" }));
+	}
+
+	void MergeModelTest::testDataChangedRanges ()
+	{
+		const auto a = MakeModel ("a", 2);
+		const auto b = MakeModel ("b", 10);
+
+		MergeModel merge { QStringList { "Name" } };
+		merge.AddModel (a.get ());
+		merge.AddModel (b.get ());
+
+		QSignalSpy spy { &merge, SIGNAL (dataChanged (QModelIndex, QModelIndex)) };
+
+		for (int row : { 0, 1, 2, 3, 6 })
+			b->item (row)->setText ("changed");
+		QCOMPARE (spy.count (), 0);
+
+		QCoreApplication::processEvents ();
+
+		QCOMPARE (spy.count (), 2);
+		QCOMPARE (spy.at (0).at (0).value<QModelIndex> ().row (), 2);
+		QCOMPARE (spy.at (0).at (1).value<QModelIndex> ().row (), 5);
+		QCOMPARE (spy.at (1).at (0).value<QModelIndex> ().row (), 8);
+		QCOMPARE (spy.at (1).at (1).value<QModelIndex> ().row (), 8);
+	}
+
+	namespace
+	{
+		const int ModelsCount = 20;
+		const int RowsCount = 1000;
+
+		QList<Model_ptr> MakeModels (MergeModel& merge)
+		{
+			QList<Model_ptr> models;
+			for (int i = 0; i < ModelsCount; ++i)
+			{
+				models << MakeModel ("m" + QString::number (i) + "_", RowsCount);
+				merge.AddModel (models.last ().get ());
+			}
+			return models;
+		}
+	}
+
+	void MergeModelTest::benchmarkMapFromSource ()
+	{
+		MergeModel merge { QStringList { "Name" } };
+		const auto& models = MakeModels (merge);
+
+		QBENCHMARK {
+			for (const auto& model : models)
+				for (int i = 0; i < RowsCount; i += 10)
+					merge.mapFromSource (model->index (i, 0));
+		}
+	}
+
+	void MergeModelTest::benchmarkDataChanged ()
+	{
+		MergeModel merge { QStringList { "Name" } };
+		const auto& models = MakeModels (merge);
+
+		int counter = 0;
+		QBENCHMARK {
+			const auto& text = QString::number (++counter);
+			for (int i = 0; i < RowsCount; ++i)
+				models.last ()->item (i)->setText (text);
+			QCoreApplication::processEvents ();
+		}
+	}
+}
+}
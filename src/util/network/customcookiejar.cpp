@@ -28,19 +28,154 @@
  **********************************************************************/
 
 #include "customcookiejar.h"
-#include <set>
 #include <algorithm>
 #include <QNetworkCookie>
+#include <QHostAddress>
+#include <QFile>
+#include <QDataStream>
 #include <QtDebug>
 #include <QDateTime>
-#include <QtConcurrentRun>
-#include <util/sll/util.h>
-#include <util/threads/futures.h>
+#include <util/sys/savefile.h>
 
 namespace LeechCraft
 {
 namespace Util
 {
+	namespace
+	{
+		const quint32 JournalMagic = 0x4c43434a;
+		const quint8 JournalVersion = 1;
+
+		enum RecordType : quint8
+		{
+			RTPut,
+			RTRemove
+		};
+
+		QString MakeKey (const QString& domain)
+		{
+			return (domain.startsWith ('.') ? domain.mid (1) : domain).toLower ();
+		}
+
+		bool IsSameCookie (const QNetworkCookie& left, const QNetworkCookie& right)
+		{
+			return left.name () == right.name () &&
+					left.domain () == right.domain () &&
+					left.path () == right.path ();
+		}
+
+		bool IsExpired (const QNetworkCookie& cookie, const QDateTime& now)
+		{
+			return !cookie.isSessionCookie () && cookie.expirationDate () < now;
+		}
+
+		bool IsTracking (const QNetworkCookie& cookie)
+		{
+			return cookie.name ().startsWith ("__utm");
+		}
+
+		/* Same rules as QNetworkCookieJar uses: a domain starting with
+		 * a dot matches itself and all its subdomains, otherwise only
+		 * the exactly same host matches.
+		 */
+		bool IsParentDomain (const QString& domain, const QString& reference)
+		{
+			if (!reference.startsWith ('.'))
+				return domain == reference;
+
+			return domain.endsWith (reference) || domain == reference.mid (1);
+		}
+
+		bool IsParentPath (const QString& path, const QString& reference)
+		{
+			if (!path.startsWith (reference))
+				return false;
+
+			return reference.endsWith ('/') ||
+					path.size () == reference.size () ||
+					path.at (reference.size ()) == '/';
+		}
+
+		void InsertByPath (QList<QNetworkCookie>& list, const QNetworkCookie& cookie)
+		{
+			const auto pathLength = cookie.path ().size ();
+			const auto pos = std::find_if (list.begin (), list.end (),
+					[pathLength] (const QNetworkCookie& other) { return other.path ().size () < pathLength; });
+			list.insert (pos, cookie);
+		}
+
+		/* Returns the domain name denoted by the regexp pattern if the
+		 * pattern consists of letters, digits, dashes and (possibly
+		 * escaped) dots only, or a null string otherwise.
+		 */
+		QString UnescapeDomain (const QString& pattern)
+		{
+			QString result;
+			result.reserve (pattern.size ());
+			for (int i = 0; i < pattern.size (); ++i)
+			{
+				auto c = pattern.at (i);
+				if (c == '\\' && i + 1 < pattern.size () && pattern.at (i + 1) == '.')
+					c = pattern.at (++i);
+				else if (!c.isLetterOrNumber () && c != '-' && c != '_' && c != '.')
+					return {};
+
+				result += c;
+			}
+			return result;
+		}
+	}
+
+	CustomCookieJar::DomainList::DomainList (const QList<QRegExp>& list)
+	{
+		for (const auto& rx : list)
+		{
+			const auto& pattern = rx.pattern ();
+
+			if (rx.patternSyntax () == QRegExp::RegExp &&
+					rx.caseSensitivity () == Qt::CaseSensitive)
+			{
+				if (pattern.startsWith (".*"))
+				{
+					const auto& suffix = UnescapeDomain (pattern.mid (2));
+					if (!suffix.isEmpty ())
+					{
+						Suffixes_ << suffix;
+						continue;
+					}
+				}
+				else
+				{
+					const auto& domain = UnescapeDomain (pattern);
+					if (!domain.isEmpty ())
+					{
+						Exact_ << domain;
+						continue;
+					}
+				}
+			}
+
+			Regexps_ << rx;
+		}
+	}
+
+	bool CustomCookieJar::DomainList::Matches (const QString& str) const
+	{
+		if (Exact_.contains (str))
+			return true;
+
+		if (!Suffixes_.isEmpty ())
+			for (int i = 0; i <= str.size (); ++i)
+				if (Suffixes_.contains (str.mid (i)))
+					return true;
+
+		for (const auto& rx : Regexps_)
+			if (rx.exactMatch (str))
+				return true;
+
+		return false;
+	}
+
 	CustomCookieJar::CustomCookieJar (QObject *parent)
 	: QNetworkCookieJar (parent)
 	{
@@ -63,26 +198,26 @@ namespace Util
 
 	void CustomCookieJar::SetWhitelist (const QList<QRegExp>& list)
 	{
-		WL_ = list;
+		WL_ = DomainList { list };
 	}
 
 	void CustomCookieJar::SetBlacklist (const QList<QRegExp>& list)
 	{
-		BL_ = list;
+		BL_ = DomainList { list };
 	}
 
 	QByteArray CustomCookieJar::Save () const
 	{
-		QList<QNetworkCookie> cookies = allCookies ();
 		QByteArray result;
-		for (const auto& cookie : cookies)
-		{
-			if (cookie.isSessionCookie ())
-				continue;
+		for (const auto& list : Domain2Cookies_)
+			for (const auto& cookie : list)
+			{
+				if (cookie.isSessionCookie ())
+					continue;
 
-			result += cookie.toRawForm ();
-			result += "\n";
-		}
+				result += cookie.toRawForm ();
+				result += "\n";
+			}
 		return result;
 	}
 
@@ -95,8 +230,7 @@ namespace Util
 		const auto& now = QDateTime::currentDateTime ();
 		for (const auto& cookie : cookies)
 		{
-			if (FilterTrackingCookies_ &&
-					cookie.name ().startsWith ("__utm"))
+			if (FilterTrackingCookies_ && IsTracking (cookie))
 				continue;
 
 			if (cookie.expirationDate () < now)
@@ -108,24 +242,174 @@ namespace Util
 		setAllCookies (filteredCookies);
 	}
 
-	void CustomCookieJar::CollectGarbage ()
+	bool CustomCookieJar::LoadJournal (const QString& path)
 	{
-		const auto& cookies = allCookies ();
-		QList<QNetworkCookie> result;
-		const auto& now = QDateTime::currentDateTime ();
-		for (const auto& cookie : cookies)
+		JournalPath_.clear ();
+		PendingJournal_.clear ();
+		JournalRecords_ = 0;
+
+		const auto finalizer = [this, &path] (bool loaded)
 		{
-			if (!cookie.isSessionCookie () &&
-					cookie.expirationDate () < now)
-				continue;
+			JournalPath_ = path;
+			if (!loaded)
+				NeedsSnapshot_ = true;
+			return loaded;
+		};
 
-			if (result.contains (cookie))
-				continue;
+		QFile file { path };
+		if (!file.open (QIODevice::ReadOnly))
+			return finalizer (false);
+
+		QDataStream in { &file };
+		in.setVersion (QDataStream::Qt_4_8);
+
+		quint32 magic = 0;
+		quint8 version = 0;
+		in >> magic >> version;
+		if (magic != JournalMagic || version != JournalVersion)
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unknown journal format"
+					<< path
+					<< magic
+					<< version;
+			return finalizer (false);
+		}
+
+		Clear ();
+
+		const auto& now = QDateTime::currentDateTimeUtc ();
+		QList<QNetworkCookie> added, removed;
+		bool isTorn = false;
+		while (!in.atEnd ())
+		{
+			quint8 type = 0;
+			QByteArray raw;
+			in >> type >> raw;
+
+			const auto& cookies = QNetworkCookie::parseCookies (raw);
+			if (in.status () != QDataStream::Ok ||
+					cookies.size () != 1 ||
+					type > RTRemove)
+			{
+				isTorn = true;
+				break;
+			}
+
+			const auto& cookie = cookies.first ();
+			if (type == RTRemove ||
+					IsExpired (cookie, now) ||
+					(FilterTrackingCookies_ && IsTracking (cookie)))
+				Take (cookie, removed);
+			else
+				Put (cookie, added, removed);
+
+			++JournalRecords_;
+		}
+
+		if (isTorn)
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "journal"
+					<< path
+					<< "is damaged, rewriting";
+			NeedsSnapshot_ = true;
+		}
 
-			result << cookie;
+		emit cookiesAdded (allCookies ());
+
+		return finalizer (true);
+	}
+
+	void CustomCookieJar::FlushJournal ()
+	{
+		if (JournalPath_.isEmpty ())
+			return;
+
+		if (NeedsSnapshot_ || JournalRecords_ > 1000)
+		{
+			int count = 0;
+			for (const auto& list : Domain2Cookies_)
+				count += list.size ();
+
+			if (NeedsSnapshot_ || JournalRecords_ > 2 * count + 1000)
+			{
+				WriteSnapshot ();
+				return;
+			}
+		}
+
+		if (PendingJournal_.isEmpty ())
+			return;
+
+		QFile file { JournalPath_ };
+		if (!file.open (QIODevice::WriteOnly | QIODevice::Append))
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unable to open"
+					<< JournalPath_
+					<< file.errorString ();
+			return;
+		}
+
+		file.write (PendingJournal_);
+		PendingJournal_.clear ();
+	}
+
+	void CustomCookieJar::DiscardJournal ()
+	{
+		if (JournalPath_.isEmpty ())
+			return;
+
+		// An empty journal is written instead of removing it, so that
+		// the legacy cookies file isn't imported again on the next start.
+		PendingJournal_.clear ();
+		JournalRecords_ = 0;
+		WriteJournalFile ();
+		NeedsSnapshot_ = true;
+	}
+
+	void CustomCookieJar::CollectGarbage ()
+	{
+		const auto& now = QDateTime::currentDateTimeUtc ();
+
+		int before = 0;
+		int after = 0;
+		for (auto pos = Domain2Cookies_.begin (); pos != Domain2Cookies_.end (); )
+		{
+			auto& list = *pos;
+			before += list.size ();
+			list.erase (std::remove_if (list.begin (), list.end (),
+						[&now] (const QNetworkCookie& cookie) { return IsExpired (cookie, now); }),
+					list.end ());
+			after += list.size ();
+
+			if (list.isEmpty ())
+				pos = Domain2Cookies_.erase (pos);
+			else
+				++pos;
 		}
-		qDebug () << Q_FUNC_INFO << cookies.size () << result.size ();
-		setAllCookies (result);
+		qDebug () << Q_FUNC_INFO << before << after;
+	}
+
+	QList<QNetworkCookie> CustomCookieJar::allCookies () const
+	{
+		QList<QNetworkCookie> result;
+		for (const auto& list : Domain2Cookies_)
+			result += list;
+		return result;
+	}
+
+	void CustomCookieJar::setAllCookies (const QList<QNetworkCookie>& cookies)
+	{
+		Clear ();
+
+		QList<QNetworkCookie> added, removed;
+		for (const auto& cookie : cookies)
+			Put (cookie, added, removed);
+
+		PendingJournal_.clear ();
+		NeedsSnapshot_ = true;
 	}
 
 	QList<QNetworkCookie> CustomCookieJar::cookiesForUrl (const QUrl& url) const
@@ -133,11 +417,37 @@ namespace Util
 		if (!Enabled_)
 			return {};
 
-		QList<QNetworkCookie> filtered;
-		for (const auto& cookie : QNetworkCookieJar::cookiesForUrl (url))
-			if (!filtered.contains (cookie))
-				filtered << cookie;
-		return filtered;
+		const auto& host = url.host ();
+		const auto& path = url.path ();
+		const bool isEncrypted = url.scheme () == "https";
+		const auto& now = QDateTime::currentDateTimeUtc ();
+
+		QList<QNetworkCookie> result;
+
+		// Visit the host itself and all its parent domains.
+		auto key = host.toLower ();
+		while (true)
+		{
+			const auto pos = Domain2Cookies_.constFind (key);
+			if (pos != Domain2Cookies_.constEnd ())
+				for (const auto& cookie : *pos)
+				{
+					if (!IsParentDomain (host, cookie.domain ()) ||
+							!IsParentPath (path, cookie.path ()) ||
+							IsExpired (cookie, now) ||
+							(cookie.isSecure () && !isEncrypted))
+						continue;
+
+					InsertByPath (result, cookie);
+				}
+
+			const auto dotPos = key.indexOf ('.');
+			if (dotPos == -1)
+				break;
+			key = key.mid (dotPos + 1);
+		}
+
+		return result;
 	}
 
 	namespace
@@ -158,112 +468,235 @@ namespace Util
 			const auto idx = domain.indexOf (cookieDomain);
 			return idx > 0 && domain.at (idx - 1) == '.';
 		}
+	}
+
+	bool CustomCookieJar::setCookiesFromUrl (const QList<QNetworkCookie>& cookieList, const QUrl& url)
+	{
+		if (!Enabled_)
+			return false;
+
+		const auto& now = QDateTime::currentDateTimeUtc ();
 
-		bool Check (const QList<QRegExp>& list, const QString& str)
+		QList<QNetworkCookie> added;
+		QList<QNetworkCookie> removed;
+		for (auto cookie : cookieList)
 		{
-			for (auto& rx : list)
-				if (str == rx.pattern () || rx.exactMatch (str))
-					return true;
+			if (cookie.domain ().isEmpty ())
+				cookie.setDomain (url.host ());
 
-			return false;
+			if (!IsAccepted (cookie, url) || !Validate (cookie, url))
+				continue;
+
+			if (IsExpired (cookie, now))
+				Take (cookie, removed);
+			else
+				Put (cookie, added, removed);
 		}
 
-		struct CookiesDiff
-		{
-			QList<QNetworkCookie> Added_;
-			QList<QNetworkCookie> Removed_;
-		};
+		if (!removed.isEmpty ())
+			emit cookiesRemoved (removed);
+		if (!added.isEmpty ())
+			emit cookiesAdded (added);
+
+		return !added.isEmpty () || !removed.isEmpty ();
+	}
+
+#if QT_VERSION >= 0x050000
+	bool CustomCookieJar::insertCookie (const QNetworkCookie& cookie)
+	{
+		QList<QNetworkCookie> added, removed;
+		if (!Put (cookie, added, removed))
+			return false;
+
+		if (!removed.isEmpty ())
+			emit cookiesRemoved (removed);
+		emit cookiesAdded (added);
+		return true;
+	}
+
+	bool CustomCookieJar::updateCookie (const QNetworkCookie& cookie)
+	{
+		QList<QNetworkCookie> added, removed;
+		if (!Take (cookie, removed))
+			return false;
+
+		Put (cookie, added, removed);
+
+		emit cookiesRemoved (removed);
+		emit cookiesAdded (added);
+		return true;
+	}
+
+	bool CustomCookieJar::deleteCookie (const QNetworkCookie& cookie)
+	{
+		QList<QNetworkCookie> removed;
+		if (!Take (cookie, removed))
+			return false;
+
+		emit cookiesRemoved (removed);
+		return true;
+	}
+#endif
+
+	bool CustomCookieJar::Validate (QNetworkCookie& cookie, const QUrl& url) const
+	{
+		const auto& host = url.host ();
 
-		auto CookieToTuple (const QNetworkCookie& c)
+		if (cookie.path ().isEmpty ())
 		{
-			return std::make_tuple (c.isHttpOnly (),
-					c.isSecure (),
-					c.isSessionCookie (),
-					c.name (),
-					c.domain (),
-					c.path (),
-					c.value (),
-					c.expirationDate ());
+			const auto& path = url.path ();
+			const auto& defaultPath = path.left (path.lastIndexOf ('/') + 1);
+			cookie.setPath (defaultPath.isEmpty () ? QString { "/" } : defaultPath);
 		}
 
-		struct CookieLess
+		auto domain = cookie.domain ();
+		if (!domain.startsWith ('.') && QHostAddress { domain }.isNull ())
 		{
-			bool operator() (const QNetworkCookie& left, const QNetworkCookie& right) const
-			{
-				return CookieToTuple (left) < CookieToTuple (right);
-			}
-		};
+			domain.prepend ('.');
+			cookie.setDomain (domain);
+		}
+
+		if (!IsParentDomain (domain, host) && !IsParentDomain (host, domain))
+			return false;
 
-		CookiesDiff CheckDifferences (const QList<QNetworkCookie>& previousList,
-				const QList<QNetworkCookie>& currentList)
+		const auto& bareDomain = domain.startsWith ('.') ? domain.mid (1) : domain;
+		if (bareDomain == host)
+			return true;
+
+		// Reject the cookies set for the effective TLDs like .co.uk.
+		QUrl domainUrl;
+		domainUrl.setHost (bareDomain);
+		return domainUrl.topLevelDomain () != '.' + bareDomain.toLower ();
+	}
+
+	bool CustomCookieJar::IsAccepted (const QNetworkCookie& cookie, const QUrl& url) const
+	{
+		const auto& domain = cookie.domain ();
+
+		if (MatchDomainExactly_ && !MatchDomain (url.host (), domain))
+			return WL_.Matches (domain);
+
+		if (FilterTrackingCookies_ && IsTracking (cookie))
+			return WL_.Matches (domain);
+
+		return !BL_.Matches (domain) || WL_.Matches (domain);
+	}
+
+	bool CustomCookieJar::Put (const QNetworkCookie& cookie,
+			QList<QNetworkCookie>& added, QList<QNetworkCookie>& removed)
+	{
+		auto& list = Domain2Cookies_ [MakeKey (cookie.domain ())];
+
+		const auto pos = std::find_if (list.begin (), list.end (),
+				[&cookie] (const QNetworkCookie& other) { return IsSameCookie (cookie, other); });
+		if (pos != list.end ())
 		{
-			using Set_t = std::set<QNetworkCookie, CookieLess>;
-			Set_t previous { previousList.begin (), previousList.end () };
-			Set_t current { currentList.begin (), currentList.end () };
-
-			CookiesDiff diff;
-			std::set_difference (previous.begin (), previous.end (),
-					current.begin (), current.end (),
-					std::back_inserter (diff.Removed_),
-					CookieLess {});
-			std::set_difference (current.begin (), current.end (),
-					previous.begin (), previous.end (),
-					std::back_inserter (diff.Added_),
-					CookieLess {});
-			return diff;
+			if (*pos == cookie)
+				return false;
+
+			if (!pos->isSessionCookie () && cookie.isSessionCookie ())
+				AppendRecord (RTRemove, *pos);
+
+			removed << *pos;
+			list.erase (pos);
 		}
+
+		InsertByPath (list, cookie);
+		added << cookie;
+
+		if (!cookie.isSessionCookie ())
+			AppendRecord (RTPut, cookie);
+
+		return true;
 	}
 
-	bool CustomCookieJar::setCookiesFromUrl (const QList<QNetworkCookie>& cookieList, const QUrl& url)
+	bool CustomCookieJar::Take (const QNetworkCookie& cookie, QList<QNetworkCookie>& removed)
 	{
-		if (!Enabled_)
+		const auto listPos = Domain2Cookies_.find (MakeKey (cookie.domain ()));
+		if (listPos == Domain2Cookies_.end ())
 			return false;
 
-		QList<QNetworkCookie> filtered;
-		filtered.reserve (cookieList.size ());
-		for (auto cookie : cookieList)
-		{
-			if (cookie.domain ().isEmpty ())
-				cookie.setDomain (url.host ());
+		auto& list = *listPos;
+		const auto pos = std::find_if (list.begin (), list.end (),
+				[&cookie] (const QNetworkCookie& other) { return IsSameCookie (cookie, other); });
+		if (pos == list.end ())
+			return false;
 
-			bool checkWhitelist = false;
-			const auto wlGuard = Util::MakeScopeGuard ([&]
-					{
-						if (checkWhitelist && Check (WL_, cookie.domain ()))
-							filtered << cookie;
-					});
+		if (!pos->isSessionCookie ())
+			AppendRecord (RTRemove, *pos);
 
-			if (MatchDomainExactly_ && !MatchDomain (url.host (), cookie.domain ()))
-			{
-				checkWhitelist = true;
-				continue;
-			}
+		removed << *pos;
+		list.erase (pos);
 
-			if (FilterTrackingCookies_ &&
-					cookie.name ().startsWith ("__utm"))
-			{
-				checkWhitelist = true;
-				continue;
-			}
+		if (list.isEmpty ())
+			Domain2Cookies_.erase (listPos);
+
+		return true;
+	}
+
+	void CustomCookieJar::Clear ()
+	{
+		Domain2Cookies_.clear ();
+	}
+
+	void CustomCookieJar::AppendRecord (quint8 type, const QNetworkCookie& cookie)
+	{
+		if (JournalPath_.isEmpty ())
+			return;
+
+		QDataStream out { &PendingJournal_, QIODevice::WriteOnly | QIODevice::Append };
+		out.setVersion (QDataStream::Qt_4_8);
+		out << type << cookie.toRawForm ();
+		++JournalRecords_;
+	}
+
+	void CustomCookieJar::WriteSnapshot ()
+	{
+		PendingJournal_.clear ();
+		JournalRecords_ = 0;
+
+		const auto& now = QDateTime::currentDateTimeUtc ();
+		for (const auto& list : Domain2Cookies_)
+			for (const auto& cookie : list)
+				if (!cookie.isSessionCookie () && !IsExpired (cookie, now))
+					AppendRecord (RTPut, cookie);
 
-			if (!Check (BL_, cookie.domain ()))
-				filtered << cookie;
+		if (!WriteJournalFile ())
+			return;
+
+		PendingJournal_.clear ();
+		NeedsSnapshot_ = false;
+	}
+
+	bool CustomCookieJar::WriteJournalFile ()
+	{
+		SaveFile file { JournalPath_ };
+		if (!file.open (QIODevice::WriteOnly))
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unable to open"
+					<< JournalPath_
+					<< file.errorString ();
+			return false;
 		}
 
-		const auto& existing = cookiesForUrl (url);
-		if (existing.isEmpty ())
-			emit cookiesAdded (filtered);
-		else
-			Util::Sequence (this, QtConcurrent::run (CheckDifferences, existing, filtered)) >>
-					[this] (const CookiesDiff& diff)
-					{
-						if (!diff.Removed_.isEmpty ())
-							emit cookiesRemoved (diff.Removed_);
-						if (!diff.Added_.isEmpty ())
-							emit cookiesAdded (diff.Added_);
-					};
+		{
+			QDataStream out { &file };
+			out.setVersion (QDataStream::Qt_4_8);
+			out << JournalMagic << JournalVersion;
+		}
+		file.write (PendingJournal_);
+
+		if (!file.commit ())
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unable to save"
+					<< JournalPath_
+					<< file.errorString ();
+			return false;
+		}
 
-		return QNetworkCookieJar::setCookiesFromUrl (filtered, url);
+		return true;
 	}
 }
 }
@@ -30,7 +30,10 @@
 #pragma once
 
 #include <QNetworkCookieJar>
+#include <QNetworkCookie>
 #include <QByteArray>
+#include <QHash>
+#include <QSet>
 #include <QRegExp>
 #include "networkconfig.h"
 
@@ -43,6 +46,14 @@ namespace Util
 	 * Allows one to filter tracking cookies, filter duplicate cookies
 	 * and has unlimited storage period.
 	 *
+	 * The cookies are indexed by their domain, so looking up the
+	 * cookies for an URL only visits the cookies set for the URL host
+	 * and its parent domains.
+	 *
+	 * The jar can optionally persist its cookies into an append-only
+	 * journal via LoadJournal() and FlushJournal(), so that only the
+	 * changed cookies are written to the disk.
+	 *
 	 * @ingroup NetworkUtil
 	 */
 	class UTIL_NETWORK_API CustomCookieJar : public QNetworkCookieJar
@@ -53,8 +64,27 @@ namespace Util
 		bool Enabled_ = true;
 		bool MatchDomainExactly_ = false;
 
-		QList<QRegExp> WL_;
-		QList<QRegExp> BL_;
+		struct DomainList
+		{
+			QSet<QString> Exact_;
+			QSet<QString> Suffixes_;
+			QList<QRegExp> Regexps_;
+
+			DomainList () = default;
+			DomainList (const QList<QRegExp>&);
+
+			bool Matches (const QString&) const;
+		};
+
+		DomainList WL_;
+		DomainList BL_;
+
+		QHash<QString, QList<QNetworkCookie>> Domain2Cookies_;
+
+		QString JournalPath_;
+		QByteArray PendingJournal_;
+		int JournalRecords_ = 0;
+		bool NeedsSnapshot_ = false;
 	public:
 		/** @brief Constructs the cookie jar.
 		 *
@@ -99,6 +129,10 @@ namespace Util
 		 * If cookies are disabled via SetEnabled(), this option has no
 		 * effect.
 		 *
+		 * The regexps that are plain domain names or a plain domain
+		 * name prefixed by <code>.*</code> are matched without invoking
+		 * the regexp engine.
+		 *
 		 * @param[in] list The whitelist.
 		 *
 		 * @sa SetBlacklist()
@@ -134,10 +168,67 @@ namespace Util
 		 */
 		void Load (const QByteArray& data);
 
-		/** Removes duplicate cookies.
+		/** @brief Loads the cookies from the journal at the given path.
+		 *
+		 * The current contents of the jar are replaced by the cookies
+		 * from the journal, and all further changes to the persistent
+		 * cookies are recorded to be written by FlushJournal().
+		 *
+		 * If there is no journal at the \em path, the jar contents are
+		 * left intact, and the next FlushJournal() call will create a
+		 * fresh journal from them. This allows importing the cookies
+		 * via Load() first.
+		 *
+		 * @param[in] path The path to the journal file.
+		 * @return Whether the journal has been loaded.
+		 *
+		 * @sa FlushJournal()
+		 */
+		bool LoadJournal (const QString& path);
+
+		/** @brief Writes the changes since the last flush to the
+		 * journal.
+		 *
+		 * The journal is compacted if it has grown too much compared to
+		 * the number of cookies in the jar.
+		 *
+		 * This function does nothing if LoadJournal() hasn't been
+		 * called.
+		 *
+		 * @sa LoadJournal(), DiscardJournal()
+		 */
+		void FlushJournal ();
+
+		/** @brief Empties the journal on the disk.
+		 *
+		 * The cookies are kept in memory, and the next FlushJournal()
+		 * call will recreate the journal from scratch.
+		 *
+		 * @sa FlushJournal()
+		 */
+		void DiscardJournal ();
+
+		/** Removes expired cookies.
 		 */
 		void CollectGarbage ();
 
+		/** @brief Returns all the cookies in the jar.
+		 *
+		 * The cookies are kept in the jar's own domain index, so this
+		 * function hides the protected QNetworkCookieJar::allCookies(),
+		 * which is always empty.
+		 *
+		 * @return The list of all the cookies.
+		 */
+		QList<QNetworkCookie> allCookies () const;
+
+		/** @brief Replaces the contents of the jar with the given
+		 * cookies.
+		 *
+		 * @param[in] cookies The new contents of the jar.
+		 */
+		void setAllCookies (const QList<QNetworkCookie>& cookies);
+
 		/** @brief Returns cookies for the given url.
 		 *
 		 * This function automatically filters out duplicate cookies.
@@ -147,7 +238,7 @@ namespace Util
 		 * @param[in] url The url to return cookies for.
 		 * @return The list of cookies, dup-free.
 		 */
-		QList<QNetworkCookie> cookiesForUrl (const QUrl& url) const;
+		QList<QNetworkCookie> cookiesForUrl (const QUrl& url) const override;
 
 		/** @brief Adds the cookieList for the given url to the jar.
 		 *
@@ -157,10 +248,31 @@ namespace Util
 		 * @param[in] url The url to set cookies for.
 		 * @return Whether the jar has been modified as the result.
 		 */
-		bool setCookiesFromUrl (const QList<QNetworkCookie>& cookieList, const QUrl& url);
+		bool setCookiesFromUrl (const QList<QNetworkCookie>& cookieList, const QUrl& url) override;
+#if QT_VERSION >= 0x050000
+		/** @brief Reimplemented from QNetworkCookieJar.
+		 */
+		bool insertCookie (const QNetworkCookie& cookie) override;
+
+		/** @brief Reimplemented from QNetworkCookieJar.
+		 */
+		bool updateCookie (const QNetworkCookie& cookie) override;
+
+		/** @brief Reimplemented from QNetworkCookieJar.
+		 */
+		bool deleteCookie (const QNetworkCookie& cookie) override;
+#endif
+	private:
+		bool Validate (QNetworkCookie&, const QUrl&) const;
+		bool IsAccepted (const QNetworkCookie&, const QUrl&) const;
+
+		bool Put (const QNetworkCookie&, QList<QNetworkCookie>& added, QList<QNetworkCookie>& removed);
+		bool Take (const QNetworkCookie&, QList<QNetworkCookie>& removed);
+		void Clear ();
 
-		using QNetworkCookieJar::allCookies;
-		using QNetworkCookieJar::setAllCookies;
+		void AppendRecord (quint8, const QNetworkCookie&);
+		void WriteSnapshot ();
+		bool WriteJournalFile ();
 	signals:
 		void cookiesAdded (const QList<QNetworkCookie>&);
 		void cookiesRemoved (const QList<QNetworkCookie>&);
@@ -30,11 +30,13 @@
 #include "networkdiskcache.h"
 #include <QtDebug>
 #include <QDir>
+#include <QBuffer>
 #include <QFuture>
 #include <QMutexLocker>
 #include <util/sys/paths.h>
 #include <util/threads/futures.h>
 #include "networkdiskcachegc.h"
+#include "networkdiskcacheindex.h"
 
 namespace LeechCraft
 {
@@ -46,86 +48,299 @@ namespace Util
 		{
 			return GetUserDir (UserDir::Cache, "network/" + subpath).absolutePath ();
 		}
+
+		const qint64 DefaultMemoryTierSize = 4 * 1024 * 1024;
+		const qint64 MemoryTierItemRatio = 64;
+
+		const int MaxPendingTouches = 64;
+		const qint64 PendingTouchesTimeout = 60 * 1000;
+
+		QIODevice* MakeMemoryDevice (const QByteArray& data)
+		{
+			const auto buffer = new QBuffer;
+			buffer->setData (data);
+			buffer->open (QIODevice::ReadOnly);
+			return buffer;
+		}
 	}
 
 	NetworkDiskCache::NetworkDiskCache (const QString& subpath, QObject *parent)
 	: QNetworkDiskCache (parent)
-	, CurrentSize_ (-1)
 	, InsertRemoveMutex_ (QMutex::Recursive)
 	, GcGuard_ (NetworkDiskCacheGC::Instance ().RegisterDirectory (GetCacheDir (subpath),
-			[this] { return maximumCacheSize (); }))
+			[this] { return maximumCacheSize (); },
+			[this] (const QList<QUrl>& urls) { DropFromMemory (urls); }))
+	, Index_ (NetworkDiskCacheGC::Instance ().GetIndex (GetCacheDir (subpath)))
 	{
 		setCacheDirectory (GetCacheDir (subpath));
+		SetMemoryTierSize (DefaultMemoryTierSize);
+	}
+
+	NetworkDiskCache::~NetworkDiskCache ()
+	{
+		FlushPendingTouches ();
+	}
+
+	void NetworkDiskCache::SetMemoryTierSize (qint64 size)
+	{
+		for (auto& shard : MemoryShards_)
+		{
+			QMutexLocker locker { &shard.Mutex_ };
+			shard.Items_.setMaxCost (size / MemoryShardsCount);
+		}
 	}
 
 	qint64 NetworkDiskCache::cacheSize () const
 	{
-		return CurrentSize_;
+		return Index_->GetTotalSize ();
 	}
 
 	QIODevice* NetworkDiskCache::data (const QUrl& url)
 	{
-		QMutexLocker lock (&InsertRemoveMutex_);
-		return QNetworkDiskCache::data (url);
+		auto& shard = GetShard (url);
+
+		{
+			QMutexLocker locker { &shard.Mutex_ };
+			if (const auto item = shard.Items_.object (url))
+			{
+				const auto dev = MakeMemoryDevice (item->Data_);
+
+				shard.PendingTouches_ << url;
+				const auto& touches = TakePendingTouches (shard, false);
+				locker.unlock ();
+
+				if (!touches.isEmpty ())
+					Index_->Touch (touches);
+				return dev;
+			}
+		}
+
+		QIODevice *dev = nullptr;
+		QNetworkCacheMetaData metaData;
+		{
+			QMutexLocker locker { &shard.ReaderMutex_ };
+			auto& reader = GetReader (shard);
+			dev = reader.data (url);
+			if (dev)
+				metaData = reader.metaData (url);
+			shard.ReaderUrl_ = url;
+		}
+
+		if (!dev)
+			return nullptr;
+
+		Index_->Touch (url);
+
+		if (const auto buffer = qobject_cast<QBuffer*> (dev))
+			PutInMemory (metaData, buffer->data ());
+
+		return dev;
 	}
 
 	void NetworkDiskCache::insert (QIODevice *device)
 	{
 		QMutexLocker lock (&InsertRemoveMutex_);
-		if (!PendingDev2Url_.contains (device))
+		if (!PendingDev2Meta_.contains (device))
 		{
 			qWarning () << Q_FUNC_INFO
 					<< "stall device detected";
 			return;
 		}
 
-		PendingUrl2Devs_ [PendingDev2Url_.take (device)].removeAll (device);
+		const auto& metaData = PendingDev2Meta_.take (device);
+		const auto& url = metaData.url ();
+		PendingUrl2Devs_ [url].removeAll (device);
+
+		Index_->Put (url, device->size ());
+
+		if (const auto buffer = qobject_cast<QBuffer*> (device))
+			PutInMemory (metaData, buffer->data ());
 
-		CurrentSize_ += device->size ();
 		QNetworkDiskCache::insert (device);
+		ResetReader (url);
 	}
 
 	QNetworkCacheMetaData NetworkDiskCache::metaData (const QUrl& url)
 	{
-		QMutexLocker lock (&InsertRemoveMutex_);
-		return QNetworkDiskCache::metaData (url);
+		{
+			auto& shard = GetShard (url);
+			QMutexLocker locker { &shard.Mutex_ };
+			if (const auto item = shard.Items_.object (url))
+				return item->MetaData_;
+		}
+
+		auto& shard = GetShard (url);
+		QMutexLocker locker { &shard.ReaderMutex_ };
+		shard.ReaderUrl_ = url;
+		return GetReader (shard).metaData (url);
 	}
 
 	QIODevice* NetworkDiskCache::prepare (const QNetworkCacheMetaData& metadata)
 	{
 		QMutexLocker lock (&InsertRemoveMutex_);
 		const auto dev = QNetworkDiskCache::prepare (metadata);
-		PendingDev2Url_ [dev] = metadata.url ();
+		if (!dev)
+			return nullptr;
+
+		PendingDev2Meta_ [dev] = metadata;
 		PendingUrl2Devs_ [metadata.url ()] << dev;
 		return dev;
 	}
 
 	bool NetworkDiskCache::remove (const QUrl& url)
 	{
+		{
+			auto& shard = GetShard (url);
+			QMutexLocker locker { &shard.Mutex_ };
+			shard.Items_.remove (url);
+			shard.PendingTouches_.remove (url);
+		}
+
 		QMutexLocker lock (&InsertRemoveMutex_);
 		for (const auto dev : PendingUrl2Devs_.take (url))
-			PendingDev2Url_.remove (dev);
-		return QNetworkDiskCache::remove (url);
+			PendingDev2Meta_.remove (dev);
+
+		Index_->Remove (url);
+		const auto result = QNetworkDiskCache::remove (url);
+		ResetReader (url);
+		return result;
 	}
 
 	void NetworkDiskCache::updateMetaData (const QNetworkCacheMetaData& metaData)
 	{
+		{
+			auto& shard = GetShard (metaData.url ());
+			QMutexLocker locker { &shard.Mutex_ };
+			if (const auto item = shard.Items_.object (metaData.url ()))
+				item->MetaData_ = metaData;
+		}
+
 		QMutexLocker lock (&InsertRemoveMutex_);
 		QNetworkDiskCache::updateMetaData (metaData);
+		ResetReader (metaData.url ());
+	}
+
+	void NetworkDiskCache::clear ()
+	{
+		for (auto& shard : MemoryShards_)
+		{
+			QMutexLocker locker { &shard.Mutex_ };
+			shard.Items_.clear ();
+			shard.PendingTouches_.clear ();
+		}
+
+		QMutexLocker lock (&InsertRemoveMutex_);
+		Index_->Clear ();
+		QNetworkDiskCache::clear ();
+
+		for (auto& shard : MemoryShards_)
+		{
+			QMutexLocker locker { &shard.ReaderMutex_ };
+			shard.Reader_.reset ();
+			shard.ReaderUrl_.clear ();
+		}
 	}
 
 	qint64 NetworkDiskCache::expire ()
 	{
-		if (CurrentSize_ < 0)
+		FlushPendingTouches ();
+
+		const auto size = Index_->GetTotalSize ();
+		if (size > maximumCacheSize ())
+			NetworkDiskCacheGC::Instance ().ScheduleCollect ();
+
+		return size;
+	}
+
+	NetworkDiskCache::MemoryShard& NetworkDiskCache::GetShard (const QUrl& url)
+	{
+		return MemoryShards_ [qHash (url) % MemoryShardsCount];
+	}
+
+	QNetworkDiskCache& NetworkDiskCache::GetReader (MemoryShard& shard)
+	{
+		if (!shard.Reader_)
 		{
-			const auto& dir = cacheDirectory ();
-			Util::Sequence (this, NetworkDiskCacheGC::Instance ().GetCurrentSize (dir)) >>
-					[this] (qint64 res) { CurrentSize_ = res; };
+			shard.Reader_.reset (new QNetworkDiskCache);
+			shard.Reader_->setCacheDirectory (cacheDirectory ());
+		}
+		return *shard.Reader_;
+	}
 
-			return maximumCacheSize () * 8 / 10;
+	void NetworkDiskCache::ResetReader (const QUrl& url)
+	{
+		// The reader keeps the last read entry, which is stale now.
+		auto& shard = GetShard (url);
+		QMutexLocker locker { &shard.ReaderMutex_ };
+		if (shard.ReaderUrl_ != url)
+			return;
+
+		shard.Reader_.reset ();
+		shard.ReaderUrl_.clear ();
+	}
+
+	void NetworkDiskCache::PutInMemory (const QNetworkCacheMetaData& metaData, const QByteArray& data)
+	{
+		if (!metaData.isValid ())
+			return;
+
+		auto& shard = GetShard (metaData.url ());
+		QMutexLocker locker { &shard.Mutex_ };
+
+		const auto maxItemSize = shard.Items_.maxCost () * MemoryShardsCount / MemoryTierItemRatio;
+		if (data.size () > maxItemSize)
+		{
+			shard.Items_.remove (metaData.url ());
+			return;
+		}
+
+		shard.Items_.insert (metaData.url (), new MemoryItem { metaData, data }, data.size ());
+	}
+	void NetworkDiskCache::DropFromMemory (const QList<QUrl>& urls)
+	{
+		for (const auto& url : urls)
+		{
+			auto& shard = GetShard (url);
+			QMutexLocker locker { &shard.Mutex_ };
+			shard.Items_.remove (url);
+			shard.PendingTouches_.remove (url);
+			locker.unlock ();
+
+			ResetReader (url);
+		}
+	}
+
+	QList<QUrl> NetworkDiskCache::TakePendingTouches (MemoryShard& shard, bool force)
+	{
+		if (shard.PendingTouches_.isEmpty ())
+			return {};
+
+		if (!shard.PendingTouchesTimer_.isValid ())
+			shard.PendingTouchesTimer_.start ();
+
+		if (!force &&
+				shard.PendingTouches_.size () < MaxPendingTouches &&
+				!shard.PendingTouchesTimer_.hasExpired (PendingTouchesTimeout))
+			return {};
+
+		shard.PendingTouchesTimer_.invalidate ();
+
+		const auto touches = shard.PendingTouches_.toList ();
+		shard.PendingTouches_.clear ();
+		return touches;
+	}
+
+	void NetworkDiskCache::FlushPendingTouches ()
+	{
+		QList<QUrl> touches;
+		for (auto& shard : MemoryShards_)
+		{
+			QMutexLocker locker { &shard.Mutex_ };
+			touches += TakePendingTouches (shard, true);
 		}
 
-		return CurrentSize_;
+		if (!touches.isEmpty ())
+			Index_->Touch (touches);
 	}
 }
 }
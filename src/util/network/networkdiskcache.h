@@ -29,9 +29,14 @@
 
 #pragma once
 
+#include <memory>
+#include <array>
 #include <QNetworkDiskCache>
 #include <QMutex>
 #include <QHash>
+#include <QSet>
+#include <QCache>
+#include <QElapsedTimer>
 #include <util/sll/util.h>
 #include "networkconfig.h"
 
@@ -39,6 +44,8 @@ namespace LeechCraft
 {
 namespace Util
 {
+	class NetworkDiskCacheIndex;
+
 	/** @brief A thread-safe garbage-collected network disk cache.
 	 *
 	 * This class is thread-safe unlike the original QNetworkDiskCache,
@@ -49,6 +56,21 @@ namespace Util
 	 * also triggered manually via the collectGarbage() slot.
 	 *
 	 * The garbage is collected until cache takes 90% of its maximum size.
+	 * The least recently used entries are removed first, as tracked by
+	 * the persistent NetworkDiskCacheIndex shared by all the caches
+	 * using the same directory.
+	 *
+	 * Small entries are additionally kept in a size-bounded in-memory
+	 * tier (see SetMemoryTierSize()). The in-memory tier is split into
+	 * several independently locked shards, so concurrent reads of
+	 * different hot entries don't block each other or the disk cache.
+	 * The accesses to the in-memory entries are passed to the index in
+	 * batches. The entries evicted by the garbage collector are dropped
+	 * from the in-memory tier as well.
+	 *
+	 * The entries are read from the disk by per-shard readers, so the
+	 * disk reads don't wait for the writes or for the reads of the
+	 * entries in other shards.
 	 *
 	 * @ingroup NetworkUtil
 	 */
@@ -56,14 +78,35 @@ namespace Util
 	{
 		Q_OBJECT
 
-		qint64 CurrentSize_;
-
 		mutable QMutex InsertRemoveMutex_;
 
-		QHash<QIODevice*, QUrl> PendingDev2Url_;
+		QHash<QIODevice*, QNetworkCacheMetaData> PendingDev2Meta_;
 		QHash<QUrl, QList<QIODevice*>> PendingUrl2Devs_;
 
+		struct MemoryItem
+		{
+			QNetworkCacheMetaData MetaData_;
+			QByteArray Data_;
+		};
+
+		struct MemoryShard
+		{
+			QMutex Mutex_;
+			QCache<QUrl, MemoryItem> Items_;
+
+			QSet<QUrl> PendingTouches_;
+			QElapsedTimer PendingTouchesTimer_;
+
+			QMutex ReaderMutex_;
+			std::unique_ptr<QNetworkDiskCache> Reader_;
+			QUrl ReaderUrl_;
+		};
+
+		static const int MemoryShardsCount = 16;
+		std::array<MemoryShard, MemoryShardsCount> MemoryShards_;
+
 		const Util::DefaultScopeGuard GcGuard_;
+		const std::shared_ptr<NetworkDiskCacheIndex> Index_;
 	public:
 		/** @brief Constructs the new disk cache.
 		 *
@@ -77,6 +120,21 @@ namespace Util
 		 */
 		NetworkDiskCache (const QString& subpath, QObject *parent = 0);
 
+		/** @brief Passes the pending accesses to the index.
+		 */
+		~NetworkDiskCache ();
+
+		/** @brief Sets the total size of the in-memory tier.
+		 *
+		 * Only the entries not bigger than 1/64 of the in-memory tier
+		 * size are kept in memory. Passing 0 disables the tier.
+		 *
+		 * The default size is 4 MiB.
+		 *
+		 * @param[in] size The total size of the in-memory tier in bytes.
+		 */
+		void SetMemoryTierSize (qint64 size);
+
 		/** @brief Reimplemented from QNetworkDiskCache.
 		 */
 		qint64 cacheSize () const override;
@@ -104,11 +162,23 @@ namespace Util
 		/** @brief Reimplemented from QNetworkDiskCache.
 		 */
 		void updateMetaData (const QNetworkCacheMetaData& metaData) override;
+	public slots:
+		/** @brief Reimplemented from QNetworkDiskCache.
+		 */
+		void clear () override;
 	protected:
 		/** @brief Reimplemented from QNetworkDiskCache.
 		 */
 		qint64 expire () override;
+	private:
+		MemoryShard& GetShard (const QUrl&);
+		QNetworkDiskCache& GetReader (MemoryShard&);
+		void ResetReader (const QUrl&);
+		void PutInMemory (const QNetworkCacheMetaData&, const QByteArray&);
+		void DropFromMemory (const QList<QUrl>&);
+
+		QList<QUrl> TakePendingTouches (MemoryShard&, bool force);
+		void FlushPendingTouches ();
 	};
 }
 }
-
@@ -33,11 +33,13 @@
 #include <QDirIterator>
 #include <QtConcurrentRun>
 #include <QDateTime>
+#include <QNetworkDiskCache>
 #include <QtDebug>
 #include <util/sll/qtutil.h>
 #include <util/sll/prelude.h>
 #include <util/sll/util.h>
 #include <util/threads/futures.h>
+#include "networkdiskcacheindex.h"
 
 namespace LeechCraft
 {
@@ -51,6 +53,13 @@ namespace Util
 				this,
 				SLOT (handleCollect ()));
 		timer->start (60 * 60 * 1000);
+
+		const auto flushTimer = new QTimer { this };
+		connect (flushTimer,
+				SIGNAL (timeout ()),
+				this,
+				SLOT (handleFlush ()));
+		flushTimer->start (5 * 60 * 1000);
 	}
 
 	NetworkDiskCacheGC& NetworkDiskCacheGC::Instance ()
@@ -88,20 +97,33 @@ namespace Util
 
 	QFuture<qint64> NetworkDiskCacheGC::GetCurrentSize (const QString& path) const
 	{
+		const auto& index = GetIndex (path);
+		if (index && index->IsSeeded ())
+			return Util::MakeReadyFuture (index->GetTotalSize ());
+
 		return QtConcurrent::run ([path] { return CollectSizes (path).TotalSize_; });
 	}
 
 	Util::DefaultScopeGuard NetworkDiskCacheGC::RegisterDirectory (const QString& path,
-			const std::function<int ()>& sizeGetter)
+			const SizeGetter_f& sizeGetter, const EvictHandler_f& evictHandler)
 	{
 		auto& list = Directories_ [path];
-		list.push_front (sizeGetter);
+		list.push_front ({ sizeGetter, evictHandler });
 		const auto thisItem = list.begin ();
 
+		if (!Indices_.contains (path))
+		{
+			const auto index = std::make_shared<NetworkDiskCacheIndex> (path);
+			Indices_ [path] = index;
+
+			if (!index->IsSeeded ())
+				QtConcurrent::run ([index] { index->Seed (); });
+		}
+
 		return Util::MakeScopeGuard ([this, path, thisItem] { UnregisterDirectory (path, thisItem); }).EraseType ();
 	}
 
-	void NetworkDiskCacheGC::UnregisterDirectory (const QString& path, CacheSizeGetters_t::iterator pos)
+	void NetworkDiskCacheGC::UnregisterDirectory (const QString& path, Registrations_t::iterator pos)
 	{
 		if (!Directories_.contains (path))
 		{
@@ -119,36 +141,63 @@ namespace Util
 
 		Directories_.remove (path);
 		LastSizes_.remove (path);
+		Indices_.remove (path);
+	}
+
+	std::shared_ptr<NetworkDiskCacheIndex> NetworkDiskCacheGC::GetIndex (const QString& path) const
+	{
+		return Indices_.value (path);
+	}
+
+	void NetworkDiskCacheGC::ScheduleCollect ()
+	{
+		if (!IsCollectScheduled_.testAndSetOrdered (0, 1))
+			return;
+
+		QMetaObject::invokeMethod (this, "handleCollect", Qt::QueuedConnection);
 	}
 
 	namespace
 	{
-		qint64 Collector (const QString& cacheDirectory, qint64 goal)
+		struct CollectResult
 		{
-			if (cacheDirectory.isEmpty ())
-				return 0;
-
-			qDebug () << Q_FUNC_INFO << "running..." << cacheDirectory << goal;
+			qint64 Size_ = 0;
+			QList<QUrl> Evicted_;
+		};
 
-			auto sizeInfoResult = CollectSizes (cacheDirectory);
+		CollectResult Collector (const std::shared_ptr<NetworkDiskCacheIndex>& index, qint64 goal)
+		{
+			if (!index->IsSeeded ())
+				index->Seed ();
 
-			for (auto i = sizeInfoResult.Items_.constBegin ();
-					i != sizeInfoResult.Items_.constEnd () && sizeInfoResult.TotalSize_ > goal;
-					++i)
+			if (index->GetTotalSize () <= goal)
 			{
-				QFile file { *i };
-				sizeInfoResult.TotalSize_ -= file.size ();
-				file.remove ();
+				index->Flush ();
+				return { index->GetTotalSize (), {} };
 			}
 
-			qDebug () << "collector finished" << sizeInfoResult.TotalSize_;
+			qDebug () << Q_FUNC_INFO << "running..." << index->GetCacheDirectory () << goal;
+
+			// Any disk cache on the same directory knows how to remove a URL.
+			QNetworkDiskCache remover;
+			remover.setCacheDirectory (index->GetCacheDirectory ());
+
+			const auto& urls = index->TakeLRU (goal * 9 / 10);
+			for (const auto& url : urls)
+				remover.remove (url);
+
+			index->Flush ();
+
+			qDebug () << "collector finished, removed" << urls.size () << "entries," << index->GetTotalSize ();
 
-			return sizeInfoResult.TotalSize_;
+			return { index->GetTotalSize (), urls };
 		}
 	};
 
 	void NetworkDiskCacheGC::handleCollect ()
 	{
+		IsCollectScheduled_.store (0);
+
 		if (IsCollecting_)
 		{
 			qWarning () << Q_FUNC_INFO
@@ -156,13 +205,13 @@ namespace Util
 			return;
 		}
 
-		QList<QPair<QString, int>> dirs;
+		QList<QPair<std::shared_ptr<NetworkDiskCacheIndex>, int>> dirs;
 		for (const auto& pair : Util::Stlize (Directories_))
 		{
-			const auto& getters = pair.second;
-			const auto minSize = (*std::min_element (getters.begin (), getters.end (),
-						Util::ComparingBy (Apply))) ();
-			dirs.append ({ pair.first, minSize });
+			const auto& regs = pair.second;
+			const auto minSize = std::min_element (regs.begin (), regs.end (),
+						Util::ComparingBy ([] (const Registration& reg) { return reg.SizeGetter_ (); }))->SizeGetter_ ();
+			dirs.append ({ Indices_.value (pair.first), minSize });
 		}
 
 		if (dirs.isEmpty ())
@@ -173,17 +222,36 @@ namespace Util
 		Util::Sequence (this,
 				QtConcurrent::run ([dirs]
 						{
-							QMap<QString, qint64> sizes;
+							QMap<QString, CollectResult> results;
 							for (const auto& pair : dirs)
-								sizes [pair.first] = Collector (pair.first, pair.second);
-							return sizes;
+								results [pair.first->GetCacheDirectory ()] = Collector (pair.first, pair.second);
+							return results;
 						})) >>
-				[this] (const QMap<QString, qint64>& sizes)
+				[this] (const QMap<QString, CollectResult>& results)
 				{
 					IsCollecting_ = false;
-					for (const auto& pair : Util::Stlize (sizes))
-						LastSizes_ [pair.first] = pair.second;
+					for (const auto& pair : Util::Stlize (results))
+					{
+						LastSizes_ [pair.first] = pair.second.Size_;
+
+						if (pair.second.Evicted_.isEmpty ())
+							continue;
+
+						for (const auto& reg : Directories_.value (pair.first))
+							if (reg.EvictHandler_)
+								reg.EvictHandler_ (pair.second.Evicted_);
+					}
 				};
 	}
+
+	void NetworkDiskCacheGC::handleFlush ()
+	{
+		const auto& indices = Indices_.values ();
+		QtConcurrent::run ([indices]
+				{
+					for (const auto& index : indices)
+						index->Flush ();
+				});
+	}
 }
 }
@@ -34,33 +34,59 @@
 #include <QObject>
 #include <QMap>
 #include <QLinkedList>
+#include <QAtomicInt>
 #include <util/sll/util.h>
 
 template<typename T>
 class QFuture;
 
+class QUrl;
+
 namespace LeechCraft
 {
 namespace Util
 {
+	class NetworkDiskCacheIndex;
+
 	/** @brief Garbage collection for a set of network disk caches.
 	 *
 	 * This GC manager class aids having multiple network disk caches at
 	 * the same path and running garbage collection periodically on them,
 	 * but only once per each path.
 	 *
+	 * Each registered path has a NetworkDiskCacheIndex, so the garbage
+	 * collection only removes the least recently used entries without
+	 * walking the whole cache directory, which is only done once to
+	 * seed the index if it doesn't exist yet.
+	 *
+	 * The caches registered for a path are notified about the evicted
+	 * URLs, so that they can drop the entries they keep in memory.
+	 *
 	 * @ingroup NetworkUtil
 	 */
 	class NetworkDiskCacheGC : public QObject
 	{
 		Q_OBJECT
 
-		using CacheSizeGetters_t = QLinkedList<std::function<int ()>>;
-		QMap<QString, CacheSizeGetters_t> Directories_;
+	public:
+		using SizeGetter_f = std::function<int ()>;
+		using EvictHandler_f = std::function<void (QList<QUrl>)>;
+	private:
+		struct Registration
+		{
+			SizeGetter_f SizeGetter_;
+			EvictHandler_f EvictHandler_;
+		};
+
+		using Registrations_t = QLinkedList<Registration>;
+		QMap<QString, Registrations_t> Directories_;
 
 		QMap<QString, qint64> LastSizes_;
 
+		QMap<QString, std::shared_ptr<NetworkDiskCacheIndex>> Indices_;
+
 		bool IsCollecting_ = false;
+		QAtomicInt IsCollectScheduled_;
 
 		NetworkDiskCacheGC ();
 	public:
@@ -99,18 +125,43 @@ namespace Util
 		 * registered multiple times with size getters returning
 		 * different values, the minimum one is used.
 		 *
+		 * The optional \em evictHandler is invoked in the main thread
+		 * with the URLs removed from the \em path by the garbage
+		 * collection.
+		 *
 		 * @param[in] path The path to register for garbage collection.
 		 * @param[in] sizeGetter The functor returning the desired total
 		 * size of files under the \em path.
+		 * @param[in] evictHandler The functor invoked with the evicted
+		 * URLs.
 		 * @return A guard object unregistering the path when it is
 		 * destroyed.
 		 */
 		Util::DefaultScopeGuard RegisterDirectory (const QString& path,
-				const std::function<int ()>& sizeGetter);
+				const SizeGetter_f& sizeGetter,
+				const EvictHandler_f& evictHandler = {});
+
+		/** @brief Returns the metadata index of the given cache \em path.
+		 *
+		 * The \em path should be registered via RegisterDirectory()
+		 * first, otherwise a null pointer is returned.
+		 *
+		 * @param[in] path The registered cache path.
+		 * @return The metadata index of the \em path.
+		 */
+		std::shared_ptr<NetworkDiskCacheIndex> GetIndex (const QString& path) const;
+
+		/** @brief Schedules a garbage collection run.
+		 *
+		 * This function is thread-safe. The collection itself is
+		 * performed asynchronously.
+		 */
+		void ScheduleCollect ();
 	private:
-		void UnregisterDirectory (const QString&, CacheSizeGetters_t::iterator);
+		void UnregisterDirectory (const QString&, Registrations_t::iterator);
 	private slots:
 		void handleCollect ();
+		void handleFlush ();
 	};
 }
 }
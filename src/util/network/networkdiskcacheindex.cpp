@@ -0,0 +1,479 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+
+#include "networkdiskcacheindex.h"
+#include <QUrl>
+#include <QFile>
+#include <QDataStream>
+#include <QDirIterator>
+#include <QDateTime>
+#include <QNetworkDiskCache>
+#include <QtDebug>
+#include <util/sys/savefile.h>
+
+namespace LeechCraft
+{
+namespace Util
+{
+	namespace
+	{
+		const quint32 JournalMagic = 0x4c434e49;
+		const quint8 JournalVersion = 1;
+
+		enum RecordType : quint8
+		{
+			RTPut,
+			RTTouch,
+			RTRemove,
+			RTClear,
+
+			/* Written when the index is loaded and when it is destroyed
+			 * respectively, so a journal not ending with RTClose hasn't
+			 * been closed cleanly.
+			 */
+			RTOpen,
+			RTClose
+		};
+
+		/* The minimum access time difference, in milliseconds, worth
+		 * being written to the journal.
+		 */
+		const qint64 TouchGranularity = 60 * 1000;
+
+		/* The overhead of a cache entry metadata, as estimated by
+		 * QNetworkDiskCache itself.
+		 */
+		const qint64 EntryOverhead = 1024;
+
+		QByteArray MakeKey (QUrl url)
+		{
+			url.setPassword ({});
+			url.setFragment ({});
+			return url.toEncoded ();
+		}
+
+		QString MakeJournalPath (QString cacheDir)
+		{
+			while (cacheDir.endsWith ('/'))
+				cacheDir.chop (1);
+			return cacheDir + ".lcindex";
+		}
+
+		qint64 Now ()
+		{
+			return QDateTime::currentMSecsSinceEpoch ();
+		}
+	}
+
+	NetworkDiskCacheIndex::NetworkDiskCacheIndex (const QString& cacheDir)
+	: CacheDir_ { cacheDir }
+	, JournalPath_ { MakeJournalPath (cacheDir) }
+	{
+		Load ();
+	}
+
+	NetworkDiskCacheIndex::~NetworkDiskCacheIndex ()
+	{
+		QMutexLocker locker { &Mutex_ };
+		FlushImpl ();
+
+		AppendRecord (RTClose, {}, 0, 0);
+		FlushImpl ();
+	}
+
+	const QString& NetworkDiskCacheIndex::GetCacheDirectory () const
+	{
+		return CacheDir_;
+	}
+
+	bool NetworkDiskCacheIndex::IsSeeded () const
+	{
+		QMutexLocker locker { &Mutex_ };
+		return IsSeeded_;
+	}
+
+	void NetworkDiskCacheIndex::Seed ()
+	{
+		struct FoundEntry
+		{
+			QByteArray Key_;
+			qint64 Size_;
+			qint64 ATime_;
+		};
+		QList<FoundEntry> found;
+
+		const auto seedStart = Now ();
+
+		QNetworkDiskCache reader;
+		QDirIterator it { CacheDir_, QDir::Files | QDir::NoDotAndDotDot, QDirIterator::Subdirectories };
+		while (it.hasNext ())
+		{
+			const auto& path = it.next ();
+
+			// Entries being written right now.
+			if (path.contains ("/prepared/"))
+				continue;
+
+			const auto& info = it.fileInfo ();
+			const auto& meta = reader.fileMetaData (path);
+			if (!meta.isValid ())
+			{
+				QFile::remove (path);
+				continue;
+			}
+
+			found.append ({ MakeKey (meta.url ()), info.size (), info.lastModified ().toMSecsSinceEpoch () });
+		}
+
+		QMutexLocker locker { &Mutex_ };
+
+		/* Drop the entries whose files are gone, keeping the ones put
+		 * during the walk, keep the known access times of the rest, and
+		 * pick up the files missing in the index.
+		 */
+		struct KnownEntry
+		{
+			qint64 Size_;
+			qint64 ATime_;
+		};
+		QHash<QByteArray, KnownEntry> known;
+		for (auto i = Entries_.begin (), end = Entries_.end (); i != end; ++i)
+			known [i.key ()] = { i->Size_, i->ATimePos_->first };
+
+		Entries_.clear ();
+		ByATime_.clear ();
+		TotalSize_ = 0;
+
+		for (const auto& entry : found)
+		{
+			const auto pos = known.constFind (entry.Key_);
+			PutImpl (entry.Key_, entry.Size_, pos == known.constEnd () ? entry.ATime_ : pos->ATime_);
+		}
+
+		for (auto i = known.begin (), end = known.end (); i != end; ++i)
+			if (i->ATime_ >= seedStart && !Entries_.contains (i.key ()))
+				PutImpl (i.key (), i->Size_, i->ATime_);
+
+		IsSeeded_ = true;
+		WriteSnapshot ();
+	}
+
+	void NetworkDiskCacheIndex::Put (const QUrl& url, qint64 size)
+	{
+		const auto& key = MakeKey (url);
+		const auto now = Now ();
+		size += EntryOverhead;
+
+		QMutexLocker locker { &Mutex_ };
+		PutImpl (key, size, now);
+		AppendRecord (RTPut, key, size, now);
+	}
+
+	void NetworkDiskCacheIndex::Touch (const QUrl& url)
+	{
+		const auto& key = MakeKey (url);
+		const auto now = Now ();
+
+		QMutexLocker locker { &Mutex_ };
+		TouchRecorded (key, now);
+	}
+
+	void NetworkDiskCacheIndex::Touch (const QList<QUrl>& urls)
+	{
+		QList<QByteArray> keys;
+		keys.reserve (urls.size ());
+		for (const auto& url : urls)
+			keys << MakeKey (url);
+
+		const auto now = Now ();
+
+		QMutexLocker locker { &Mutex_ };
+		for (const auto& key : keys)
+			TouchRecorded (key, now);
+	}
+
+	void NetworkDiskCacheIndex::Remove (const QUrl& url)
+	{
+		const auto& key = MakeKey (url);
+
+		QMutexLocker locker { &Mutex_ };
+		if (!Entries_.contains (key))
+			return;
+
+		RemoveImpl (key);
+		AppendRecord (RTRemove, key, 0, 0);
+	}
+
+	void NetworkDiskCacheIndex::Clear ()
+	{
+		QMutexLocker locker { &Mutex_ };
+		Entries_.clear ();
+		ByATime_.clear ();
+		TotalSize_ = 0;
+		AppendRecord (RTClear, {}, 0, 0);
+	}
+
+	qint64 NetworkDiskCacheIndex::GetTotalSize () const
+	{
+		QMutexLocker locker { &Mutex_ };
+		return TotalSize_;
+	}
+
+	QList<QUrl> NetworkDiskCacheIndex::TakeLRU (qint64 goal)
+	{
+		QMutexLocker locker { &Mutex_ };
+
+		QList<QUrl> result;
+		while (TotalSize_ > goal && !ByATime_.empty ())
+		{
+			const auto key = ByATime_.begin ()->second;
+			RemoveImpl (key);
+			AppendRecord (RTRemove, key, 0, 0);
+			result << QUrl::fromEncoded (key);
+		}
+		return result;
+	}
+
+	void NetworkDiskCacheIndex::Flush ()
+	{
+		QMutexLocker locker { &Mutex_ };
+		FlushImpl ();
+	}
+
+	void NetworkDiskCacheIndex::FlushImpl ()
+	{
+		// The snapshot will be written by Seed() anyway.
+		if (!IsSeeded_)
+		{
+			PendingJournal_.clear ();
+			return;
+		}
+
+		if (JournalRecords_ > 2 * Entries_.size () + 1000)
+		{
+			WriteSnapshot ();
+			return;
+		}
+
+		if (PendingJournal_.isEmpty ())
+			return;
+
+		QFile file { JournalPath_ };
+		if (!file.open (QIODevice::WriteOnly | QIODevice::Append))
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unable to open"
+					<< JournalPath_
+					<< file.errorString ();
+			return;
+		}
+
+		file.write (PendingJournal_);
+		PendingJournal_.clear ();
+	}
+
+	void NetworkDiskCacheIndex::PutImpl (const QByteArray& key, qint64 size, qint64 atime)
+	{
+		if (Entries_.contains (key))
+			RemoveImpl (key);
+
+		const auto pos = ByATime_.insert ({ atime, key });
+		Entries_ [key] = { size, pos };
+		TotalSize_ += size;
+	}
+
+	void NetworkDiskCacheIndex::TouchImpl (const QByteArray& key, qint64 atime)
+	{
+		const auto pos = Entries_.find (key);
+		if (pos == Entries_.end ())
+			return;
+
+		ByATime_.erase (pos->ATimePos_);
+		pos->ATimePos_ = ByATime_.insert ({ atime, key });
+	}
+
+	void NetworkDiskCacheIndex::TouchRecorded (const QByteArray& key, qint64 atime)
+	{
+		const auto pos = Entries_.find (key);
+		if (pos == Entries_.end ())
+			return;
+
+		const auto prevATime = pos->ATimePos_->first;
+		TouchImpl (key, atime);
+		if (atime - prevATime >= TouchGranularity)
+			AppendRecord (RTTouch, key, 0, atime);
+	}
+
+	void NetworkDiskCacheIndex::RemoveImpl (const QByteArray& key)
+	{
+		const auto pos = Entries_.find (key);
+		if (pos == Entries_.end ())
+			return;
+
+		TotalSize_ -= pos->Size_;
+		ByATime_.erase (pos->ATimePos_);
+		Entries_.erase (pos);
+	}
+
+	void NetworkDiskCacheIndex::AppendRecord (quint8 type,
+			const QByteArray& key, qint64 size, qint64 atime)
+	{
+		QDataStream out { &PendingJournal_, QIODevice::WriteOnly | QIODevice::Append };
+		out.setVersion (QDataStream::Qt_4_8);
+		out << type << key << size << atime;
+		++JournalRecords_;
+	}
+
+	void NetworkDiskCacheIndex::Load ()
+	{
+		QFile file { JournalPath_ };
+		if (!file.open (QIODevice::ReadOnly))
+			return;
+
+		QDataStream in { &file };
+		in.setVersion (QDataStream::Qt_4_8);
+
+		quint32 magic = 0;
+		quint8 version = 0;
+		in >> magic >> version;
+		if (magic != JournalMagic || version != JournalVersion)
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unknown journal format"
+					<< JournalPath_
+					<< magic
+					<< version;
+			return;
+		}
+
+		bool isClean = false;
+		bool isTorn = false;
+		while (!in.atEnd () && !isTorn)
+		{
+			quint8 type = 0;
+			QByteArray key;
+			qint64 size = 0;
+			qint64 atime = 0;
+			in >> type >> key >> size >> atime;
+			if (in.status () != QDataStream::Ok)
+			{
+				isTorn = true;
+				break;
+			}
+
+			isClean = false;
+
+			switch (type)
+			{
+			case RTPut:
+				PutImpl (key, size, atime);
+				break;
+			case RTTouch:
+				TouchImpl (key, atime);
+				break;
+			case RTRemove:
+				RemoveImpl (key);
+				break;
+			case RTClear:
+				Entries_.clear ();
+				ByATime_.clear ();
+				TotalSize_ = 0;
+				break;
+			case RTOpen:
+				break;
+			case RTClose:
+				isClean = true;
+				break;
+			default:
+				isTorn = true;
+				break;
+			}
+
+			++JournalRecords_;
+		}
+
+		file.close ();
+
+		/* The entries inserted after the last flush of a crashed session
+		 * aren't in the journal, so the index is reconciled with the
+		 * directory by Seed() in this case.
+		 */
+		if (!isClean || isTorn)
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "journal"
+					<< JournalPath_
+					<< "hasn't been closed cleanly, the index will be reseeded";
+			return;
+		}
+
+		IsSeeded_ = true;
+
+		AppendRecord (RTOpen, {}, 0, 0);
+		FlushImpl ();
+	}
+
+	void NetworkDiskCacheIndex::WriteSnapshot ()
+	{
+		PendingJournal_.clear ();
+		JournalRecords_ = 0;
+		for (const auto& pair : ByATime_)
+			AppendRecord (RTPut, pair.second, Entries_ [pair.second].Size_, pair.first);
+
+		SaveFile file { JournalPath_ };
+		if (!file.open (QIODevice::WriteOnly))
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unable to open"
+					<< JournalPath_
+					<< file.errorString ();
+			return;
+		}
+
+		{
+			QDataStream out { &file };
+			out.setVersion (QDataStream::Qt_4_8);
+			out << JournalMagic << JournalVersion;
+		}
+		file.write (PendingJournal_);
+
+		if (!file.commit ())
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unable to save"
+					<< JournalPath_
+					<< file.errorString ();
+			return;
+		}
+
+		PendingJournal_.clear ();
+	}
+}
+}
@@ -0,0 +1,178 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+
+#pragma once
+
+#include <map>
+#include <QHash>
+#include <QMutex>
+#include <QByteArray>
+#include <QString>
+#include "networkconfig.h"
+
+class QUrl;
+
+namespace LeechCraft
+{
+namespace Util
+{
+	/** @brief Persistent metadata index of a network disk cache.
+	 *
+	 * The index keeps the size and the last access time of each URL
+	 * stored in the cache directory, so that the garbage collector
+	 * doesn't need to walk the whole directory tree to find the
+	 * eviction candidates, and the total cache size is always known.
+	 *
+	 * The index is persisted as an append-only journal next to the
+	 * cache directory. The journal is periodically compacted into a
+	 * snapshot when it grows too much compared to the number of live
+	 * entries.
+	 *
+	 * If there is no journal yet, or if it hasn't been closed cleanly
+	 * (for example, after a crash), the index should be seeded via
+	 * Seed(), which walks the cache directory and reconciles the index
+	 * with it.
+	 *
+	 * This class is thread-safe.
+	 *
+	 * @ingroup NetworkUtil
+	 */
+	class UTIL_NETWORK_API NetworkDiskCacheIndex
+	{
+		const QString CacheDir_;
+		const QString JournalPath_;
+
+		mutable QMutex Mutex_;
+
+		using ByATime_t = std::multimap<qint64, QByteArray>;
+		ByATime_t ByATime_;
+
+		struct Entry
+		{
+			qint64 Size_;
+			ByATime_t::iterator ATimePos_;
+		};
+		QHash<QByteArray, Entry> Entries_;
+		qint64 TotalSize_ = 0;
+
+		bool IsSeeded_ = false;
+
+		QByteArray PendingJournal_;
+		int JournalRecords_ = 0;
+	public:
+		/** @brief Loads the index for the given \em cacheDir.
+		 *
+		 * @param[in] cacheDir The cache directory.
+		 */
+		NetworkDiskCacheIndex (const QString& cacheDir);
+
+		/** @brief Flushes the pending journal records and marks the
+		 * journal as closed cleanly.
+		 */
+		~NetworkDiskCacheIndex ();
+
+		NetworkDiskCacheIndex (const NetworkDiskCacheIndex&) = delete;
+		NetworkDiskCacheIndex& operator= (const NetworkDiskCacheIndex&) = delete;
+
+		const QString& GetCacheDirectory () const;
+
+		/** @brief Checks whether the index reflects the cache directory.
+		 *
+		 * @return Whether the index has been either loaded from a
+		 * cleanly closed journal or seeded via Seed().
+		 */
+		bool IsSeeded () const;
+
+		/** @brief Builds the index by walking the cache directory.
+		 *
+		 * The entries whose files are missing are dropped from the
+		 * index, and the files missing in the index are added to it.
+		 * The files that don't look like valid cache entries are
+		 * removed.
+		 *
+		 * This function is expensive and should be called from a
+		 * background thread.
+		 */
+		void Seed ();
+
+		/** @brief Records the \em url of the given \em size as just
+		 * inserted.
+		 */
+		void Put (const QUrl& url, qint64 size);
+
+		/** @brief Records the \em url as just accessed.
+		 */
+		void Touch (const QUrl& url);
+
+		/** @brief Records all the \em urls as just accessed.
+		 *
+		 * This is cheaper than calling Touch() for each URL.
+		 */
+		void Touch (const QList<QUrl>& urls);
+
+		/** @brief Records the \em url as removed.
+		 */
+		void Remove (const QUrl& url);
+
+		/** @brief Records all the URLs as removed.
+		 */
+		void Clear ();
+
+		/** @brief Returns the total size of the entries in the cache.
+		 */
+		qint64 GetTotalSize () const;
+
+		/** @brief Removes the least recently used entries from the index
+		 * until the total size is not bigger than the \em goal.
+		 *
+		 * @param[in] goal The desired total size of the cache.
+		 * @return The URLs of the removed entries, the least recently
+		 * used first.
+		 */
+		QList<QUrl> TakeLRU (qint64 goal);
+
+		/** @brief Writes the pending journal records to the disk.
+		 *
+		 * The journal is compacted if needed.
+		 */
+		void Flush ();
+	private:
+		void PutImpl (const QByteArray&, qint64, qint64);
+		void TouchImpl (const QByteArray&, qint64);
+		void TouchRecorded (const QByteArray&, qint64);
+		void RemoveImpl (const QByteArray&);
+
+		void AppendRecord (quint8, const QByteArray&, qint64, qint64);
+		void FlushImpl ();
+		void Load ();
+		void WriteSnapshot ();
+	};
+}
+}
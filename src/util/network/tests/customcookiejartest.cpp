@@ -0,0 +1,196 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+
+#include "customcookiejartest.h"
+#include <QtTest>
+#include <QTemporaryDir>
+#include <QNetworkCookie>
+#include <customcookiejar.h>
+
+QTEST_MAIN (LeechCraft::Util::CustomCookieJarTest)
+
+namespace LeechCraft
+{
+namespace Util
+{
+	namespace
+	{
+		QNetworkCookie MakeCookie (const QByteArray& name, const QByteArray& value,
+				const QString& domain = {}, const QString& path = {}, int days = 1)
+		{
+			QNetworkCookie cookie { name, value };
+			cookie.setDomain (domain);
+			cookie.setPath (path);
+			cookie.setExpirationDate (QDateTime::currentDateTime ().addDays (days));
+			return cookie;
+		}
+
+		QStringList GetNames (const QList<QNetworkCookie>& cookies)
+		{
+			QStringList result;
+			for (const auto& cookie : cookies)
+				result << cookie.name ();
+			return result;
+		}
+
+		QStringList GetSortedNames (const QList<QNetworkCookie>& cookies)
+		{
+			auto result = GetNames (cookies);
+			result.sort ();
+			return result;
+		}
+	}
+
+	void CustomCookieJarTest::testDomainMatching ()
+	{
+		CustomCookieJar jar;
+		jar.setCookiesFromUrl ({
+					MakeCookie ("domain", "1", "example.com", "/"),
+					MakeCookie ("host", "2", {}, "/"),
+					MakeCookie ("foreign", "3", "other.com", "/"),
+					MakeCookie ("tld", "4", "com", "/")
+				},
+				QUrl { "http://www.example.com/" });
+
+		QCOMPARE (GetSortedNames (jar.allCookies ()), (QStringList { "domain", "host" }));
+
+		QCOMPARE (GetSortedNames (jar.cookiesForUrl (QUrl { "http://www.example.com/" })),
+				(QStringList { "domain", "host" }));
+		QCOMPARE (GetSortedNames (jar.cookiesForUrl (QUrl { "http://example.com/" })),
+				(QStringList { "domain" }));
+		QCOMPARE (GetSortedNames (jar.cookiesForUrl (QUrl { "http://a.b.example.com/" })),
+				(QStringList { "domain" }));
+		QCOMPARE (jar.cookiesForUrl (QUrl { "http://notexample.com/" }).size (), 0);
+		QCOMPARE (jar.cookiesForUrl (QUrl { "http://other.com/" }).size (), 0);
+	}
+
+	void CustomCookieJarTest::testPathMatching ()
+	{
+		CustomCookieJar jar;
+		jar.setCookiesFromUrl ({
+					MakeCookie ("root", "1", "example.com", "/"),
+					MakeCookie ("dir", "2", "example.com", "/dir"),
+					MakeCookie ("subdir", "3", "example.com", "/dir/sub/"),
+					MakeCookie ("default", "4")
+				},
+				QUrl { "http://example.com/dir/sub/page" });
+
+		QCOMPARE (GetNames (jar.cookiesForUrl (QUrl { "http://example.com/dir/sub/x" })),
+				(QStringList { "subdir", "default", "dir", "root" }));
+		QCOMPARE (GetNames (jar.cookiesForUrl (QUrl { "http://example.com/dir" })),
+				(QStringList { "dir", "root" }));
+		QCOMPARE (GetNames (jar.cookiesForUrl (QUrl { "http://example.com/directory" })),
+				(QStringList { "root" }));
+	}
+
+	void CustomCookieJarTest::testReplaceAndExpire ()
+	{
+		qRegisterMetaType<QList<QNetworkCookie>> ("QList<QNetworkCookie>");
+
+		CustomCookieJar jar;
+		QSignalSpy addedSpy { &jar, SIGNAL (cookiesAdded (QList<QNetworkCookie>)) };
+		QSignalSpy removedSpy { &jar, SIGNAL (cookiesRemoved (QList<QNetworkCookie>)) };
+
+		const QUrl url { "http://example.com/" };
+		QVERIFY (jar.setCookiesFromUrl ({ MakeCookie ("a", "1", {}, "/") }, url));
+		QVERIFY (!jar.setCookiesFromUrl ({ jar.allCookies ().value (0) }, url));
+		QCOMPARE (addedSpy.count (), 1);
+
+		QVERIFY (jar.setCookiesFromUrl ({ MakeCookie ("a", "2", {}, "/") }, url));
+		QCOMPARE (jar.allCookies ().size (), 1);
+		QCOMPARE (jar.cookiesForUrl (url).value (0).value (), QByteArray { "2" });
+		QCOMPARE (removedSpy.count (), 1);
+
+		QVERIFY (jar.setCookiesFromUrl ({ MakeCookie ("a", "", {}, "/", -1) }, url));
+		QCOMPARE (jar.allCookies ().size (), 0);
+		QCOMPARE (removedSpy.count (), 2);
+	}
+
+	void CustomCookieJarTest::testLists ()
+	{
+		CustomCookieJar jar;
+		jar.SetBlacklist ({ QRegExp { ".*\\.tracker\\.com" }, QRegExp { "ads\\.net" }, QRegExp { "evil[0-9]+\\.org" } });
+		jar.SetWhitelist ({ QRegExp { "good.tracker.com" } });
+
+		const auto set = [&jar] (const QString& host)
+		{
+			return jar.setCookiesFromUrl ({ MakeCookie ("c", "1", host, "/") },
+					QUrl { "http://" + host + "/" });
+		};
+
+		QVERIFY (!set ("bad.tracker.com"));
+		QVERIFY (!set ("ads.net"));
+		QVERIFY (!set ("evil42.org"));
+		QVERIFY (set ("good.tracker.com"));
+		QVERIFY (set ("evil.org"));
+		QVERIFY (set ("tracker.com"));
+	}
+
+	void CustomCookieJarTest::testJournal ()
+	{
+		QTemporaryDir dir;
+		const auto& path = dir.path () + "/cookies.journal";
+		const QUrl url { "http://example.com/" };
+
+		{
+			CustomCookieJar jar;
+			QVERIFY (!jar.LoadJournal (path));
+			jar.setCookiesFromUrl ({
+						MakeCookie ("kept", "1", {}, "/"),
+						MakeCookie ("changed", "1", {}, "/"),
+						MakeCookie ("removed", "1", {}, "/")
+					},
+					url);
+			jar.FlushJournal ();
+
+			jar.setCookiesFromUrl ({
+						MakeCookie ("changed", "2", {}, "/"),
+						MakeCookie ("removed", "", {}, "/", -1),
+						QNetworkCookie { "session", "1" }
+					},
+					url);
+			jar.FlushJournal ();
+		}
+
+		CustomCookieJar jar;
+		QVERIFY (jar.LoadJournal (path));
+		QCOMPARE (GetSortedNames (jar.allCookies ()), (QStringList { "changed", "kept" }));
+		for (const auto& cookie : jar.allCookies ())
+			if (cookie.name () == "changed")
+				QCOMPARE (cookie.value (), QByteArray { "2" });
+
+		// A discarded journal is still loadable, just empty.
+		jar.DiscardJournal ();
+		CustomCookieJar discarded;
+		QVERIFY (discarded.LoadJournal (path));
+		QVERIFY (discarded.allCookies ().isEmpty ());
+	}
+}
+}
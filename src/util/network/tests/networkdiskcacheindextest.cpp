@@ -0,0 +1,166 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+
+#include "networkdiskcacheindextest.h"
+#include <algorithm>
+#include <QtTest>
+#include <QTemporaryDir>
+#include <QNetworkDiskCache>
+#include <networkdiskcacheindex.h>
+
+QTEST_MAIN (LeechCraft::Util::NetworkDiskCacheIndexTest)
+
+namespace LeechCraft
+{
+namespace Util
+{
+	namespace
+	{
+		const qint64 EntryOverhead = 1024;
+
+		void AddEntry (QNetworkDiskCache& cache, const QUrl& url, const QByteArray& data)
+		{
+			QNetworkCacheMetaData meta;
+			meta.setUrl (url);
+			meta.setSaveToDisk (true);
+
+			const auto dev = cache.prepare (meta);
+			QVERIFY (dev);
+			dev->write (data);
+			cache.insert (dev);
+		}
+
+		QList<QUrl> Sorted (QList<QUrl> urls)
+		{
+			std::sort (urls.begin (), urls.end (),
+					[] (const QUrl& left, const QUrl& right) { return left.toString () < right.toString (); });
+			return urls;
+		}
+	}
+
+	void NetworkDiskCacheIndexTest::testLoad ()
+	{
+		QTemporaryDir root;
+		const auto& dir = root.path () + "/cache";
+
+		{
+			NetworkDiskCacheIndex index { dir };
+			QVERIFY (!index.IsSeeded ());
+
+			index.Seed ();
+			QVERIFY (index.IsSeeded ());
+			QCOMPARE (index.GetTotalSize (), 0ll);
+
+			index.Put (QUrl { "http://example.com/a" }, 100);
+			index.Put (QUrl { "http://example.com/b" }, 200);
+			index.Remove (QUrl { "http://example.com/b" });
+			index.Put (QUrl { "http://example.com/c" }, 300);
+		}
+
+		NetworkDiskCacheIndex index { dir };
+		QVERIFY (index.IsSeeded ());
+		QCOMPARE (index.GetTotalSize (), 400 + 2 * EntryOverhead);
+	}
+
+	void NetworkDiskCacheIndexTest::testEviction ()
+	{
+		QTemporaryDir root;
+		const auto& dir = root.path () + "/cache";
+
+		const QUrl a { "http://example.com/a" };
+		const QUrl b { "http://example.com/b" };
+		const QUrl c { "http://example.com/c" };
+
+		{
+			NetworkDiskCacheIndex index { dir };
+			index.Seed ();
+			index.Put (a, 0);
+			index.Put (b, 0);
+			index.Put (c, 0);
+			index.Touch (a);
+
+			QCOMPARE (index.TakeLRU (EntryOverhead), (QList<QUrl> { b, c }));
+			QCOMPARE (index.GetTotalSize (), EntryOverhead);
+			QVERIFY (index.TakeLRU (EntryOverhead).isEmpty ());
+		}
+
+		NetworkDiskCacheIndex index { dir };
+		QCOMPARE (index.GetTotalSize (), EntryOverhead);
+		QCOMPARE (index.TakeLRU (0), (QList<QUrl> { a }));
+	}
+
+	void NetworkDiskCacheIndexTest::testReconcileAfterCrash ()
+	{
+		QTemporaryDir root;
+		const auto& dir = root.path () + "/cache";
+		const auto& journal = dir + ".lcindex";
+		const auto& crashed = root.path () + "/crashed.lcindex";
+
+		const QUrl x { "http://example.com/x" };
+		const QUrl y { "http://example.com/y" };
+		const QUrl z { "http://example.com/z" };
+
+		QNetworkDiskCache writer;
+		writer.setCacheDirectory (dir);
+		AddEntry (writer, x, "x");
+		AddEntry (writer, y, "y");
+
+		{
+			NetworkDiskCacheIndex index { dir };
+			index.Seed ();
+			QCOMPARE (Sorted (index.TakeLRU (-1)), (QList<QUrl> { x, y }));
+		}
+
+		{
+			NetworkDiskCacheIndex index { dir };
+			index.Seed ();
+			index.Flush ();
+
+			// The journal as left by a crash right after the flush.
+			QVERIFY (QFile::copy (journal, crashed));
+
+			AddEntry (writer, z, "z");
+			index.Put (z, 1);
+			writer.remove (x);
+			index.Remove (x);
+		}
+
+		QVERIFY (QFile::remove (journal));
+		QVERIFY (QFile::rename (crashed, journal));
+
+		NetworkDiskCacheIndex index { dir };
+		QVERIFY (!index.IsSeeded ());
+
+		index.Seed ();
+		QVERIFY (index.IsSeeded ());
+		QCOMPARE (Sorted (index.TakeLRU (-1)), (QList<QUrl> { y, z }));
+	}
+}
+}
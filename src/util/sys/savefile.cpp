@@ -1,6 +1,6 @@
 /**********************************************************************
  * LeechCraft - modular cross-platform feature rich internet client.
- * Copyright (C) 2010-2013  Oleg Linkin <MaledictusDeMagog@gmail.com>
+ * Copyright (C) 2006-2014  Georg Rudoy
  *
  * Boost Software License - Version 1.0 - August 17th, 2003
  *
@@ -27,50 +27,44 @@
  * DEALINGS IN THE SOFTWARE.
  **********************************************************************/
 
-#include "chunkiodevice.h"
+
+#include "savefile.h"
 
 namespace LeechCraft
 {
-namespace NetStoreManager
-{
-namespace DBox
+namespace Util
 {
-	ChunkIODevice::ChunkIODevice (const QString& path, QObject *parent)
-	: QIODevice (parent)
-	, ChunkSize_ (4 * 1024 * 1024)
-	{
-		File_.setFileName (path);
-	}
-
-	bool ChunkIODevice::atEnd () const
+#if QT_VERSION < 0x050000
+	SaveFile::SaveFile (const QString& target)
+	: QFile { target + ".tmp" }
+	, Target_ { target }
 	{
-		return File_.atEnd ();
 	}
 
-	bool ChunkIODevice::open (QIODevice::OpenMode mode)
+	SaveFile::~SaveFile ()
 	{
-		return File_.open (mode);
-	}
+		if (Committed_)
+			return;
 
-	void ChunkIODevice::close ()
-	{
-		File_.close ();
+		close ();
+		remove ();
 	}
 
-	QByteArray ChunkIODevice::GetNextChunk ()
+	bool SaveFile::commit ()
 	{
-		return File_.read (ChunkSize_);
-	}
+		flush ();
+		const bool ok = error () == QFile::NoError;
+		close ();
+		if (!ok)
+			return false;
 
-	qint64 ChunkIODevice::readData (char *data, qint64 maxlen)
-	{
-		return File_.read (data, maxlen);
-	}
+		if (QFile::exists (Target_) && !QFile::remove (Target_))
+			return false;
 
-	qint64 ChunkIODevice::writeData (const char *data, qint64 len)
-	{
-		return File_.write (data, len);
+		// The target is gone now, so the data is kept even if renaming fails.
+		Committed_ = true;
+		return rename (Target_);
 	}
-}
+#endif
 }
 }
@@ -0,0 +1,121 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+
+#include "affinitytest.h"
+#include <stdexcept>
+#include <QtTest>
+#include <affinity.h>
+
+QTEST_MAIN (LeechCraft::Util::AffinityTest)
+
+namespace LeechCraft
+{
+namespace Util
+{
+	namespace
+	{
+		class FuncThread : public QThread
+		{
+			const std::function<void ()> Func_;
+		public:
+			FuncThread (const std::function<void ()>& func)
+			: Func_ { func }
+			{
+			}
+		protected:
+			void run () override
+			{
+				Func_ ();
+			}
+		};
+	}
+
+	void AffinityTest::testMovedBack ()
+	{
+		const auto mainThread = QThread::currentThread ();
+
+		QObject obj;
+		const auto oldChild = new QObject { &obj };
+		obj.moveToThread (nullptr);
+
+		QObject *newChild = nullptr;
+		QThread *threadInside = nullptr;
+		FuncThread thread
+		{
+			[&]
+			{
+				RunAttached (&obj, mainThread,
+						[&]
+						{
+							threadInside = obj.thread ();
+							newChild = new QObject { &obj };
+						});
+			}
+		};
+		thread.start ();
+		thread.wait ();
+
+		QCOMPARE (threadInside, static_cast<QThread*> (&thread));
+		QVERIFY (newChild);
+		QCOMPARE (obj.thread (), mainThread);
+		QCOMPARE (oldChild->thread (), mainThread);
+		QCOMPARE (newChild->thread (), mainThread);
+	}
+
+	void AffinityTest::testMovedBackOnException ()
+	{
+		const auto mainThread = QThread::currentThread ();
+
+		QObject obj;
+		obj.moveToThread (nullptr);
+
+		bool caught = false;
+		FuncThread thread
+		{
+			[&]
+			{
+				try
+				{
+					RunAttached (&obj, mainThread, [] { throw std::runtime_error { "init failed" }; });
+				}
+				catch (const std::runtime_error&)
+				{
+					caught = true;
+				}
+			}
+		};
+		thread.start ();
+		thread.wait ();
+
+		QVERIFY (caught);
+		QCOMPARE (obj.thread (), mainThread);
+	}
+}
+}
@@ -0,0 +1,151 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+#include "workerthreadbasetest.h"
+#include <QtTest>
+#include <workerthreadbase.h>
+
+QTEST_MAIN (LeechCraft::Util::WorkerThreadBaseTest)
+
+namespace LeechCraft
+{
+namespace Util
+{
+	namespace
+	{
+		class TestThread : public WorkerThreadBase
+		{
+		public:
+			TestThread ()
+			{
+				SetPaused (true);
+				start ();
+			}
+
+			~TestThread ()
+			{
+				quit ();
+				wait ();
+			}
+		protected:
+			void Initialize () override
+			{
+			}
+
+			void Cleanup () override
+			{
+			}
+		};
+	}
+
+	void WorkerThreadBaseTest::testPriorities ()
+	{
+		TestThread thread;
+
+		QStringList order;
+		const auto append = [&order] (const QString& str) { return [&order, str] { order << str; }; };
+
+		const WorkerThreadBase::TaskOptions bg { WorkerThreadBase::Priority::Background };
+		const WorkerThreadBase::TaskOptions interactive { WorkerThreadBase::Priority::Interactive };
+
+		QList<QFuture<void>> futures;
+		futures << thread.ScheduleImplWith (bg, append ("b1"));
+		futures << thread.ScheduleImplWith (interactive, append ("i1"));
+		futures << thread.ScheduleImplWith (bg, append ("b2"));
+		futures << thread.ScheduleImplWith (interactive, append ("i2"));
+
+		thread.SetPaused (false);
+		for (auto future : futures)
+			future.waitForFinished ();
+
+		QCOMPARE (order, (QStringList { "i1", "i2", "b1", "b2" }));
+	}
+
+	void WorkerThreadBaseTest::testCoalescing ()
+	{
+		TestThread thread;
+
+		const WorkerThreadBase::TaskOptions options { WorkerThreadBase::Priority::Background, "key" };
+		auto first = thread.ScheduleImplWith (options, [] { return 1; });
+		auto second = thread.ScheduleImplWith (options, [] { return 2; });
+
+		QVERIFY (first.isCanceled ());
+
+		thread.SetPaused (false);
+		second.waitForFinished ();
+
+		QCOMPARE (second.result (), 2);
+
+		const auto& metrics = thread.GetMetrics ();
+		QCOMPARE (metrics.Executed_, quint64 { 1 });
+		QCOMPARE (metrics.Coalesced_, quint64 { 1 });
+	}
+
+	void WorkerThreadBaseTest::testCancellation ()
+	{
+		TestThread thread;
+
+		bool executed = false;
+		auto canceled = thread.ScheduleImpl ([&executed] { executed = true; });
+		canceled.cancel ();
+
+		auto next = thread.ScheduleImpl ([] {});
+
+		thread.SetPaused (false);
+		next.waitForFinished ();
+
+		QCOMPARE (executed, false);
+		QCOMPARE (thread.GetMetrics ().Canceled_, quint64 { 1 });
+	}
+
+	void WorkerThreadBaseTest::testExternalInterface ()
+	{
+		TestThread thread;
+
+		bool executed = false;
+		QFutureInterface<int> canceledIface;
+		thread.ScheduleReporting ({}, canceledIface,
+				[&executed] (QFutureInterface<int>&) { executed = true; });
+		canceledIface.future ().cancel ();
+
+		QFutureInterface<int> iface;
+		iface.reportStarted ();
+		thread.ScheduleReporting ({}, iface,
+				[] (QFutureInterface<int>& target) { ReportFutureResult (target, 42); });
+
+		thread.SetPaused (false);
+		auto future = iface.future ();
+		future.waitForFinished ();
+
+		QCOMPARE (executed, false);
+		QCOMPARE (future.result (), 42);
+		QCOMPARE (thread.GetMetrics ().Canceled_, quint64 { 1 });
+	}
+}
+}
@@ -28,12 +28,34 @@
  **********************************************************************/
 
 #include "workerthreadbase.h"
+#include <algorithm>
 #include <util/sll/slotclosure.h>
 
 namespace LeechCraft
 {
 namespace Util
 {
+	namespace
+	{
+		QMutex LiveThreadsMutex;
+		QList<WorkerThreadBase*> LiveThreads;
+	}
+
+	WorkerThreadBase::WorkerThreadBase (QObject *parent)
+	: QThread { parent }
+	{
+		Clock_.start ();
+
+		QMutexLocker locker { &LiveThreadsMutex };
+		LiveThreads << this;
+	}
+
+	WorkerThreadBase::~WorkerThreadBase ()
+	{
+		QMutexLocker locker { &LiveThreadsMutex };
+		LiveThreads.removeOne (this);
+	}
+
 	void WorkerThreadBase::SetPaused (bool paused)
 	{
 		if (paused == IsPaused_)
@@ -47,7 +69,84 @@ namespace Util
 	size_t WorkerThreadBase::GetQueueSize ()
 	{
 		QMutexLocker locker { &FunctionsMutex_ };
-		return Functions_.size ();
+		return Interactive_.size () + Background_.size ();
+	}
+
+	WorkerThreadBase::Metrics WorkerThreadBase::GetMetrics () const
+	{
+		QMutexLocker locker { &FunctionsMutex_ };
+		auto metrics = Metrics_;
+		metrics.InteractiveQueued_ = Interactive_.size ();
+		metrics.BackgroundQueued_ = Background_.size ();
+		return metrics;
+	}
+
+	QString WorkerThreadBase::GetDiagInfo ()
+	{
+		QMutexLocker locker { &LiveThreadsMutex };
+
+		QString result;
+		for (const auto thread : LiveThreads)
+		{
+			const auto& m = thread->GetMetrics ();
+			const auto& name = thread->objectName ().isEmpty () ?
+					QString::fromLatin1 (thread->metaObject ()->className ()) :
+					thread->objectName ();
+			const auto avgLatency = m.Executed_ ? m.TotalLatency_ / static_cast<qint64> (m.Executed_) : 0;
+			result += QString { "%1: queued %2 interactive / %3 background; "
+						"executed %4, canceled %5, coalesced %6; "
+						"latency avg %7 ms / max %8 ms; busy %9 ms\n" }
+					.arg (name)
+					.arg (m.InteractiveQueued_)
+					.arg (m.BackgroundQueued_)
+					.arg (m.Executed_)
+					.arg (m.Canceled_)
+					.arg (m.Coalesced_)
+					.arg (avgLatency)
+					.arg (m.MaxLatency_)
+					.arg (m.TotalExecTime_);
+		}
+		return result;
+	}
+
+	void WorkerThreadBase::Enqueue (const TaskOptions& options, const Task_ptr& task)
+	{
+		task->Key_ = options.CoalesceKey_;
+
+		Task_ptr superseded;
+
+		{
+			QMutexLocker locker { &FunctionsMutex_ };
+			task->EnqueuedAt_ = Clock_.elapsed ();
+
+			auto& lane = options.Priority_ == Priority::Interactive ?
+					Interactive_ :
+					Background_;
+
+			if (!task->Key_.isEmpty ())
+			{
+				superseded = Keyed_.value (task->Key_);
+				Keyed_ [task->Key_] = task;
+			}
+
+			if (superseded)
+			{
+				// The new task is appended instead of taking the replaced
+				// one's place so that it still runs after any other task
+				// scheduled in between, like a deletion of the same object.
+				if (!Interactive_.removeOne (superseded))
+					Background_.removeOne (superseded);
+
+				++Metrics_.Coalesced_;
+			}
+
+			lane << task;
+		}
+
+		if (superseded)
+			superseded->Cancel_ ();
+
+		emit rotateFuncs ();
 	}
 
 	void WorkerThreadBase::run ()
@@ -71,20 +170,51 @@ namespace Util
 
 	void WorkerThreadBase::RotateFuncs ()
 	{
-		if (IsPaused_)
-			return;
-
-		decltype (Functions_) funcs;
-
+		// Only the tasks queued by now are executed during this call: each
+		// task scheduled later emits rotateFuncs() on its own, and the event
+		// loop thus gets a chance to run in between.
+		auto budget = 0;
 		{
 			QMutexLocker locker { &FunctionsMutex_ };
-
-			using std::swap;
-			swap (funcs, Functions_);
+			budget = Interactive_.size () + Background_.size ();
 		}
 
-		for (const auto& func : funcs)
-			func ();
+		while (budget-- > 0 && !IsPaused_)
+		{
+			Task_ptr task;
+
+			{
+				QMutexLocker locker { &FunctionsMutex_ };
+
+				auto& lane = Interactive_.isEmpty () ? Background_ : Interactive_;
+				if (lane.isEmpty ())
+					return;
+
+				task = lane.takeFirst ();
+				if (!task->Key_.isEmpty ())
+					Keyed_.remove (task->Key_);
+			}
+
+			if (task->IsCanceled_ ())
+			{
+				task->Cancel_ ();
+
+				QMutexLocker locker { &FunctionsMutex_ };
+				++Metrics_.Canceled_;
+				continue;
+			}
+
+			const auto startedAt = Clock_.elapsed ();
+			task->Run_ ();
+			const auto finishedAt = Clock_.elapsed ();
+
+			QMutexLocker locker { &FunctionsMutex_ };
+			const auto latency = startedAt - task->EnqueuedAt_;
+			++Metrics_.Executed_;
+			Metrics_.TotalLatency_ += latency;
+			Metrics_.MaxLatency_ = std::max (Metrics_.MaxLatency_, latency);
+			Metrics_.TotalExecTime_ += finishedAt - startedAt;
+		}
 	}
 }
 }
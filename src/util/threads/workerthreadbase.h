@@ -31,12 +31,15 @@
 
 #include <functional>
 #include <atomic>
+#include <memory>
 #include <QThread>
 #include <QMutex>
 #include <QMutexLocker>
 #include <QFutureInterface>
 #include <QFuture>
 #include <QList>
+#include <QHash>
+#include <QElapsedTimer>
 #include "futures.h"
 #include "threadsconfig.h"
 
@@ -44,38 +47,140 @@ namespace LeechCraft
 {
 namespace Util
 {
+	/** @brief Base class for threads executing tasks in a dedicated
+	 * context, typically a worker object owned by the thread.
+	 *
+	 * Tasks are scheduled to one of two lanes: interactive tasks are
+	 * always executed before background ones, so a long backlog of
+	 * bulk work doesn't delay queries someone is waiting for.
+	 *
+	 * A task whose future is canceled before the task is started is
+	 * skipped. Tasks scheduled with a non-empty coalescing key replace
+	 * the pending task with the same key, if any, and the replaced
+	 * task's future is reported as canceled.
+	 */
 	class UTIL_THREADS_API WorkerThreadBase : public QThread
 	{
 		Q_OBJECT
 
 		std::atomic_bool IsPaused_ { false };
+	public:
+		/** @brief The lane a task is scheduled to.
+		 */
+		enum class Priority
+		{
+			/** @brief A task someone is waiting for, like a query for the UI.
+			 */
+			Interactive,
+
+			/** @brief A bulk or maintenance task that may be postponed.
+			 */
+			Background
+		};
+
+		/** @brief Options for scheduling a task.
+		 */
+		struct TaskOptions
+		{
+			/** @brief The lane to schedule the task to.
+			 */
+			Priority Priority_ = Priority::Interactive;
+
+			/** @brief The coalescing key, or an empty byte array to
+			 * never coalesce the task.
+			 */
+			QByteArray CoalesceKey_ = {};
+		};
+
+		/** @brief Execution statistics of a worker thread.
+		 *
+		 * Latencies are measured from the moment a task is scheduled
+		 * to the moment it is started, in milliseconds.
+		 */
+		struct Metrics
+		{
+			int InteractiveQueued_ = 0;
+			int BackgroundQueued_ = 0;
+
+			quint64 Executed_ = 0;
+			quint64 Canceled_ = 0;
+			quint64 Coalesced_ = 0;
 
-		QMutex FunctionsMutex_;
-		QList<std::function<void ()>> Functions_;
+			qint64 TotalLatency_ = 0;
+			qint64 MaxLatency_ = 0;
+			qint64 TotalExecTime_ = 0;
+		};
+	private:
+		struct Task
+		{
+			std::function<void ()> Run_;
+			std::function<bool ()> IsCanceled_;
+			std::function<void ()> Cancel_;
+			QByteArray Key_;
+			qint64 EnqueuedAt_;
+		};
+		using Task_ptr = std::shared_ptr<Task>;
+
+		mutable QMutex FunctionsMutex_;
+		QList<Task_ptr> Interactive_;
+		QList<Task_ptr> Background_;
+		QHash<QByteArray, Task_ptr> Keyed_;
+
+		QElapsedTimer Clock_;
+		Metrics Metrics_;
 	public:
-		using QThread::QThread;
+		WorkerThreadBase (QObject *parent = nullptr);
+		~WorkerThreadBase ();
 
 		void SetPaused (bool);
 
 		template<typename F>
-		QFuture<ResultOf_t<F ()>> ScheduleImpl (F func)
+		QFuture<ResultOf_t<F ()>> ScheduleImplWith (const TaskOptions& options, F func)
 		{
 			QFutureInterface<ResultOf_t<F ()>> iface;
 			iface.reportStarted ();
 
-			auto reporting = [func, iface] () mutable
-			{
-				ReportFutureResult (iface, func);
-			};
+			ScheduleReporting (options, iface, [func] (auto& target) mutable { ReportFutureResult (target, func); });
 
+			return iface.future ();
+		}
+
+		/** @brief Schedules a task reporting its result to the given
+		 * future interface.
+		 *
+		 * This is for the callers wrapping their tasks into their own
+		 * future interfaces: the task is skipped if \em iface gets
+		 * canceled before the task is started.
+		 *
+		 * @param[in] options The scheduling options.
+		 * @param[in] iface The future interface the task reports to.
+		 * @param[in] func The task, invoked with a reference to a copy
+		 * of \em iface.
+		 */
+		template<typename T, typename F>
+		void ScheduleReporting (const TaskOptions& options, const QFutureInterface<T>& iface, F func)
+		{
+			auto task = std::make_shared<Task> ();
+			task->Run_ = [func, iface] () mutable { func (iface); };
+			task->IsCanceled_ = [iface] { return iface.isCanceled (); };
+			task->Cancel_ = [iface] () mutable
 			{
-				QMutexLocker locker { &FunctionsMutex_ };
-				Functions_ << reporting;
-			}
+				iface.reportCanceled ();
+				iface.reportFinished ();
+			};
+			Enqueue (options, task);
+		}
 
-			emit rotateFuncs ();
+		template<typename F, typename... Args>
+		QFuture<ResultOf_t<F (Args...)>> ScheduleImplWith (const TaskOptions& options, F f, Args&&... args)
+		{
+			return ScheduleImplWith (options, [f, args...] () mutable { return Invoke (f, args...); });
+		}
 
-			return iface.future ();
+		template<typename F>
+		QFuture<ResultOf_t<F ()>> ScheduleImpl (F func)
+		{
+			return ScheduleImplWith ({}, func);
 		}
 
 		template<typename F, typename... Args>
@@ -85,12 +190,20 @@ namespace Util
 		}
 
 		virtual size_t GetQueueSize ();
+
+		Metrics GetMetrics () const;
+
+		/** @brief Returns the metrics of all live worker threads as
+		 * human-readable text.
+		 */
+		static QString GetDiagInfo ();
 	protected:
 		void run () override final;
 
 		virtual void Initialize () = 0;
 		virtual void Cleanup () = 0;
 	private:
+		void Enqueue (const TaskOptions&, const Task_ptr&);
 		void RotateFuncs ();
 	signals:
 		void rotateFuncs ();
@@ -173,6 +286,8 @@ namespace Util
 		}
 
 		using WorkerThreadBase::ScheduleImpl;
+		using WorkerThreadBase::ScheduleImplWith;
+		using WorkerThreadBase::ScheduleReporting;
 
 		void SetAutoQuit (bool autoQuit)
 		{
@@ -185,6 +300,13 @@ namespace Util
 			const auto fWrapped = [f, this] (auto... args) mutable { return Invoke (f, Worker_.get (), args...); };
 			return WorkerThreadBase::ScheduleImpl (fWrapped, std::forward<Args> (args)...);
 		}
+
+		template<typename F, typename... Args>
+		QFuture<ResultOf_t<F (WorkerType*, Args...)>> ScheduleImplWith (const TaskOptions& options, F f, Args&&... args)
+		{
+			const auto fWrapped = [f, this] (auto... args) mutable { return Invoke (f, Worker_.get (), args...); };
+			return WorkerThreadBase::ScheduleImplWith (options, fWrapped, std::forward<Args> (args)...);
+		}
 	protected:
 		void Initialize () override
 		{
@@ -62,6 +62,49 @@ namespace XDG
 		return !(left == right);
 	}
 
+	QDataStream& operator<< (QDataStream& out, const Item& item)
+	{
+		out << static_cast<quint8> (1)
+				<< item.Name_
+				<< item.GenericName_
+				<< item.Comments_
+				<< item.Categories_
+				<< item.Command_
+				<< item.WD_
+				<< item.IconName_
+				<< item.IsHidden_
+				<< static_cast<qint32> (item.Type_);
+		return out;
+	}
+
+	QDataStream& operator>> (QDataStream& in, Item& item)
+	{
+		quint8 version = 0;
+		in >> version;
+		if (version != 1)
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unknown version"
+					<< version;
+			in.setStatus (QDataStream::ReadCorruptData);
+			return in;
+		}
+
+		qint32 type = 0;
+		in >> item.Name_
+				>> item.GenericName_
+				>> item.Comments_
+				>> item.Categories_
+				>> item.Command_
+				>> item.WD_
+				>> item.IconName_
+				>> item.IsHidden_
+				>> type;
+		item.Type_ = static_cast<Type> (type);
+		item.Icon_.reset ();
+		return in;
+	}
+
 	bool Item::IsValid () const
 	{
 		return !Name_.isEmpty ();
@@ -34,6 +34,7 @@
 #include <QHash>
 #include <QDebug>
 #include <QIcon>
+#include <QDataStream>
 #include <interfaces/core/icoreproxy.h>
 #include "xdgconfig.h"
 #include "itemtypes.h"
@@ -95,6 +96,25 @@ namespace XDG
 		 */
 		friend UTIL_XDG_API bool operator!= (const Item& left, const Item& right);
 
+		/** @brief Serializes the \em item into the data \em stream.
+		 *
+		 * The icon obtained via GetIcon() is \em not serialized, only
+		 * the icon name is.
+		 *
+		 * @param[in] stream The data stream to serialize to.
+		 * @param[in] item The XDG item to serialize.
+		 * @return The \em stream.
+		 */
+		friend UTIL_XDG_API QDataStream& operator<< (QDataStream& stream, const Item& item);
+
+		/** @brief Deserializes the \em item from the data \em stream.
+		 *
+		 * @param[in] stream The data stream to deserialize from.
+		 * @param[out] item The XDG item to deserialize into.
+		 * @return The \em stream.
+		 */
+		friend UTIL_XDG_API QDataStream& operator>> (QDataStream& stream, Item& item);
+
 		/** @brief Checks whether this XDG item is valid.
 		 *
 		 * A valid item has name field set for at least one language.
@@ -28,6 +28,8 @@
  **********************************************************************/
 
 #include "itemsdatabase.h"
+#include <QDirIterator>
+#include <QFileInfo>
 #include <QFileSystemWatcher>
 #include <QSet>
 #include <QStringList>
@@ -44,15 +46,44 @@ namespace XDG
 	: ItemsFinder { proxy, types, parent }
 	, Watcher_ { new QFileSystemWatcher { this } }
 	{
-		Watcher_->addPaths (ToPaths (types));
+		for (const auto& dir : ToPaths (types))
+		{
+			if (!QFileInfo { dir }.isDir ())
+				continue;
+
+			Watcher_->addPath (dir);
+
+			QDirIterator it { dir,
+					QDir::Dirs | QDir::NoDotAndDotDot,
+					QDirIterator::Subdirectories | QDirIterator::FollowSymlinks };
+			while (it.hasNext ())
+				Watcher_->addPath (it.next ());
+		}
+
 		connect (Watcher_,
 				SIGNAL (directoryChanged (QString)),
 				this,
-				SLOT (scheduleUpdate ()));
+				SLOT (scheduleUpdate (QString)));
 	}
 
-	void ItemsDatabase::scheduleUpdate ()
+	void ItemsDatabase::scheduleUpdate (const QString& dir)
 	{
+		ChangedDirs_ << dir;
+
+		const auto& watched = Watcher_->directories ().toSet ();
+		QDirIterator it { dir,
+				QDir::Dirs | QDir::NoDotAndDotDot,
+				QDirIterator::Subdirectories | QDirIterator::FollowSymlinks };
+		while (it.hasNext ())
+		{
+			const auto& subdir = it.next ();
+			if (watched.contains (subdir))
+				continue;
+
+			Watcher_->addPath (subdir);
+			ChangedDirs_ << subdir;
+		}
+
 		if (UpdateScheduled_)
 			return;
 
@@ -60,9 +91,10 @@ namespace XDG
 		Util::ExecuteLater ([this]
 				{
 					UpdateScheduled_ = false;
-					update ();
+					update (ChangedDirs_.toList ());
+					ChangedDirs_.clear ();
 				},
-				10000);
+				2000);
 	}
 }
 }
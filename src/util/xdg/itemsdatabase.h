@@ -48,6 +48,8 @@ namespace XDG
 	 * both updates to the existing files as well as addition of new files
 	 * and removal of already existing ones.
 	 *
+	 * Only the directories that have actually changed are rescanned.
+	 *
 	 * Refer to the documentation for ItemsFinder for more information.
 	 *
 	 * @sa ItemsFinder
@@ -57,6 +59,7 @@ namespace XDG
 		Q_OBJECT
 
 		bool UpdateScheduled_ = false;
+		QSet<QString> ChangedDirs_;
 		QFileSystemWatcher * const Watcher_;
 	public:
 		/** @brief Creates the ItemsDatabase for the given \em types.
@@ -70,7 +73,7 @@ namespace XDG
 		 */
 		ItemsDatabase (ICoreProxy_ptr proxy, const QList<Type>& types, QObject *parent = nullptr);
 	private slots:
-		void scheduleUpdate ();
+		void scheduleUpdate (const QString&);
 	};
 }
 }
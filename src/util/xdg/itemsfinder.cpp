@@ -29,11 +29,15 @@
 
 #include "itemsfinder.h"
 #include <QDir>
+#include <QDirIterator>
+#include <QFile>
 #include <QTimer>
 #include <QtDebug>
 #include <QtConcurrentRun>
 #include <util/sll/prelude.h>
 #include <util/sll/qtutil.h>
+#include <util/sys/paths.h>
+#include <util/sys/savefile.h>
 #include <util/threads/futures.h>
 #include "xdg.h"
 #include "item.h"
@@ -44,38 +48,6 @@ namespace Util
 {
 namespace XDG
 {
-	ItemsFinder::ItemsFinder (ICoreProxy_ptr proxy,
-			const QList<Type>& types, QObject *parent)
-	: QObject { parent }
-	, Proxy_ { proxy }
-	, Types_ { types }
-	{
-		QTimer::singleShot (1000, this, SLOT (update ()));
-	}
-
-	bool ItemsFinder::IsReady () const
-	{
-		return IsReady_;
-	}
-
-	Cat2Items_t ItemsFinder::GetItems () const
-	{
-		return Items_;
-	}
-
-	Item_ptr ItemsFinder::FindItem (const QString& id) const
-	{
-		for (const auto& list : Items_)
-		{
-			const auto pos = std::find_if (list.begin (), list.end (),
-					[&id] (const Item_ptr& item) { return item->GetPermanentID () == id; });
-			if (pos != list.end ())
-				return *pos;
-		}
-
-		return {};
-	}
-
 	namespace
 	{
 		using Cat2ID2Item_t = QHash<QString, QHash<QString, Item_ptr>>;
@@ -105,57 +77,135 @@ namespace XDG
 			return result;
 		}
 
-		QStringList ScanDir (const QString& path)
+		Item_ptr ParseFile (const QString& path)
 		{
-			const auto& infos = QDir (path).entryInfoList ({ "*.desktop" },
-						QDir::Files | QDir::AllDirs | QDir::NoDotAndDotDot);
+			Item_ptr item;
+			try
+			{
+				item = Item::FromDesktopFile (path);
+			}
+			catch (const std::exception& e)
+			{
+				qWarning () << Q_FUNC_INFO
+						<< "error parsing"
+						<< path
+						<< e.what ();
+				return {};
+			}
 
-			return Util::ConcatMap (infos,
-					[] (const QFileInfo& info)
-					{
-						return info.isDir () ?
-								ScanDir (info.absoluteFilePath ()) :
-								QStringList { info.absoluteFilePath () };
-					});
+			if (!item->IsValid ())
+			{
+				qWarning () << Q_FUNC_INFO
+						<< "invalid item"
+						<< path;
+				return {};
+			}
+
+			return item;
 		}
 
-		Cat2ID2Item_t FindAndParse (const QList<Type>& types)
+		/* Returns the given dirs along with all their subdirectories.
+		 */
+		QStringList ExpandDirs (const QStringList& roots)
 		{
-			Cat2ID2Item_t result;
+			QStringList result;
+			for (const auto& root : roots)
+			{
+				result << root;
+
+				QDirIterator it { root,
+						QDir::Dirs | QDir::NoDotAndDotDot,
+						QDirIterator::Subdirectories | QDirIterator::FollowSymlinks };
+				while (it.hasNext ())
+					result << it.next ();
+			}
+			result.removeDuplicates ();
+			return result;
+		}
+
+		/* Rescans the given dirs and their subdirectories, reparsing
+		 * only the files whose mtime differs from the one recorded in
+		 * files. The subdirectories of the given dirs that don't exist
+		 * anymore are forgotten, as well as all the dirs not under the
+		 * given ones if dropUnlisted is set. Returns whether anything has
+		 * changed.
+		 */
+		bool Rescan (ItemsFinder::Dir2Files_t& files, QStringList roots, bool dropUnlisted)
+		{
+			bool changed = false;
+
+			for (auto& root : roots)
+				root = QDir::cleanPath (root);
 
-			QStringList paths;
-			for (const auto& dir : ToPaths (types))
-				paths << ScanDir (dir);
+			const auto& dirs = ExpandDirs (roots);
+			const auto& dirsSet = dirs.toSet ();
 
-			for (const auto& path : paths)
+			const auto isUnderRoots = [&roots] (const QString& dir)
 			{
-				Item_ptr item;
-				try
-				{
-					item = Item::FromDesktopFile (path);
-				}
-				catch (const std::exception& e)
+				return std::any_of (roots.begin (), roots.end (),
+						[&dir] (const QString& root) { return dir.startsWith (root + '/'); });
+			};
+
+			for (auto i = files.begin (); i != files.end (); )
+				if (!dirsSet.contains (i.key ()) && (dropUnlisted || isUnderRoots (i.key ())))
 				{
-					qWarning () << Q_FUNC_INFO
-							<< "error parsing"
-							<< path
-							<< e.what ();
-					continue;
+					i = files.erase (i);
+					changed = true;
 				}
+				else
+					++i;
 
-				if (!item->IsValid ())
+			for (const auto& dir : dirs)
+			{
+				const auto& known = files.value (dir);
+
+				QHash<QString, ItemsFinder::CachedFile> fresh;
+				for (const auto& info : QDir { dir }.entryInfoList ({ "*.desktop" }, QDir::Files))
 				{
-					qWarning () << Q_FUNC_INFO
-							<< "invalid item"
-							<< path;
-					continue;
+					const auto& path = info.absoluteFilePath ();
+					const auto mtime = info.lastModified ().toMSecsSinceEpoch ();
+
+					const auto pos = known.find (path);
+					if (pos != known.end () && pos->MTime_ == mtime)
+					{
+						fresh [path] = *pos;
+						continue;
+					}
+
+					fresh [path] = { mtime, ParseFile (path) };
+					changed = true;
 				}
 
-				for (const auto& cat : item->GetCategories ())
-					if (!cat.startsWith ("X-"))
-						result [cat] [item->GetPermanentID ()] = item;
+				// All the new or changed files have already been accounted
+				// for, so a size mismatch means something has been removed.
+				if (fresh.size () != known.size ())
+					changed = true;
+
+				if (fresh.isEmpty ())
+					files.remove (dir);
+				else
+					files [dir] = fresh;
 			}
 
+			return changed;
+		}
+
+		Cat2ID2Item_t Categorize (const ItemsFinder::Dir2Files_t& files)
+		{
+			Cat2ID2Item_t result;
+
+			for (const auto& dir : Util::Sorted (files.keys ()))
+				for (const auto& cached : files [dir])
+				{
+					const auto& item = cached.Item_;
+					if (!item)
+						continue;
+
+					for (const auto& cat : item->GetCategories ())
+						if (!cat.startsWith ("X-"))
+							result [cat] [item->GetPermanentID ()] = item;
+				}
+
 			return result;
 		}
 
@@ -235,31 +285,240 @@ namespace XDG
 
 			return ItemsMap2List (ourItems);
 		}
+
+		const quint8 CacheVersion = 1;
+
+		QString GetCachePath (const QList<Type>& types)
+		{
+			QStringList typeIds;
+			for (const auto type : types)
+				typeIds << QString::number (static_cast<int> (type));
+
+			return Util::GetUserDir (UserDir::Cache, "xdg")
+					.filePath ("items_" + typeIds.join ("_") + ".cache");
+		}
+
+		ItemsFinder::Dir2Files_t LoadCache (const QString& path)
+		{
+			QFile file { path };
+			if (!file.exists ())
+				return {};
+
+			if (!file.open (QIODevice::ReadOnly))
+			{
+				qWarning () << Q_FUNC_INFO
+						<< "unable to open"
+						<< path
+						<< file.errorString ();
+				return {};
+			}
+
+			QDataStream in { &file };
+			in.setVersion (QDataStream::Qt_4_8);
+
+			quint8 version = 0;
+			in >> version;
+			if (version != CacheVersion)
+			{
+				qWarning () << Q_FUNC_INFO
+						<< "unknown cache version"
+						<< version;
+				return {};
+			}
+
+			ItemsFinder::Dir2Files_t result;
+
+			quint32 dirsCount = 0;
+			in >> dirsCount;
+			for (quint32 i = 0; i < dirsCount && in.status () == QDataStream::Ok; ++i)
+			{
+				QString dir;
+				quint32 filesCount = 0;
+				in >> dir >> filesCount;
+
+				auto& files = result [dir];
+				for (quint32 j = 0; j < filesCount && in.status () == QDataStream::Ok; ++j)
+				{
+					QString filePath;
+					ItemsFinder::CachedFile cached { 0, {} };
+					bool hasItem = false;
+					in >> filePath >> cached.MTime_ >> hasItem;
+					if (hasItem)
+					{
+						cached.Item_ = std::make_shared<Item> ();
+						in >> *cached.Item_;
+					}
+					files [filePath] = cached;
+				}
+			}
+
+			if (in.status () != QDataStream::Ok)
+			{
+				qWarning () << Q_FUNC_INFO
+						<< "corrupted cache"
+						<< path;
+				return {};
+			}
+
+			return result;
+		}
+
+		void SaveCache (const QString& path, const ItemsFinder::Dir2Files_t& dirs)
+		{
+			SaveFile file { path };
+			if (!file.open (QIODevice::WriteOnly))
+			{
+				qWarning () << Q_FUNC_INFO
+						<< "unable to open"
+						<< path
+						<< file.errorString ();
+				return;
+			}
+
+			QDataStream out { &file };
+			out.setVersion (QDataStream::Qt_4_8);
+			out << CacheVersion
+					<< static_cast<quint32> (dirs.size ());
+			for (const auto& dirPair : Util::Stlize (dirs))
+			{
+				out << dirPair.first
+						<< static_cast<quint32> (dirPair.second.size ());
+				for (const auto& filePair : Util::Stlize (dirPair.second))
+				{
+					const auto& cached = filePair.second;
+					out << filePair.first
+							<< cached.MTime_
+							<< static_cast<bool> (cached.Item_);
+					if (cached.Item_)
+						out << *cached.Item_;
+				}
+			}
+
+			if (!file.commit ())
+				qWarning () << Q_FUNC_INFO
+						<< "unable to commit"
+						<< path
+						<< file.errorString ();
+		}
+
+		struct UpdateResult
+		{
+			ItemsFinder::Dir2Files_t Files_;
+			boost::optional<Cat2Items_t> Items_;
+		};
+
+		UpdateResult RunUpdate (ItemsFinder::Dir2Files_t files, const QStringList& dirs,
+				bool dropUnlisted, const Cat2Items_t& existing, const QString& cachePath)
+		{
+			if (!Rescan (files, dirs, dropUnlisted))
+				return { files, {} };
+
+			SaveCache (cachePath, files);
+
+			auto items = Merge (existing, Categorize (files));
+			return { files, items };
+		}
+	}
+
+	ItemsFinder::ItemsFinder (ICoreProxy_ptr proxy,
+			const QList<Type>& types, QObject *parent)
+	: QObject { parent }
+	, Proxy_ { proxy }
+	, CachePath_ { GetCachePath (types) }
+	, Types_ { types }
+	{
+		Files_ = LoadCache (CachePath_);
+		if (!Files_.isEmpty ())
+		{
+			Items_ = ItemsMap2List (Categorize (Files_));
+			RebuildIndex ();
+			IsReady_ = true;
+		}
+
+		QTimer::singleShot (1000, this, SLOT (update ()));
+	}
+
+	bool ItemsFinder::IsReady () const
+	{
+		return IsReady_;
+	}
+
+	Cat2Items_t ItemsFinder::GetItems () const
+	{
+		return Items_;
+	}
+
+	Item_ptr ItemsFinder::FindItem (const QString& id) const
+	{
+		return ID2Item_.value (id);
 	}
 
 	void ItemsFinder::update ()
 	{
 		if (IsScanning_)
+		{
+			FullUpdatePending_ = true;
 			return;
+		}
+
+		auto dirs = ToPaths (Types_);
+		dirs.removeDuplicates ();
+		StartUpdate (dirs, true);
+	}
 
+	void ItemsFinder::update (const QStringList& dirs)
+	{
+		if (IsScanning_)
+		{
+			PendingDirs_ += dirs.toSet ();
+			return;
+		}
+
+		StartUpdate (dirs, false);
+	}
+
+	void ItemsFinder::StartUpdate (const QStringList& dirs, bool full)
+	{
 		IsScanning_ = true;
 
-		Util::Sequence (this, QtConcurrent::run (FindAndParse, Types_)) >>
-				[this] (Cat2ID2Item_t result)
-				{
-					return QtConcurrent::run (Merge, Items_, result);
-				} >>
-				[this] (const boost::optional<Cat2Items_t>& result)
-				{
-					IsScanning_ = false;
-					IsReady_ = true;
+		Util::Sequence (this, QtConcurrent::run (RunUpdate, Files_, dirs, full, Items_, CachePath_)) >>
+				[this] (const UpdateResult& result) { HandleUpdated (result.Files_, result.Items_); };
+	}
 
-					if (result)
-					{
-						Items_ = *result;
-						emit itemsListChanged ();
-					}
-				};
+	void ItemsFinder::HandleUpdated (Dir2Files_t files, const boost::optional<Cat2Items_t>& items)
+	{
+		IsScanning_ = false;
+		IsReady_ = true;
+
+		Files_ = std::move (files);
+
+		if (items)
+		{
+			Items_ = *items;
+			RebuildIndex ();
+			emit itemsListChanged ();
+		}
+
+		if (FullUpdatePending_)
+		{
+			FullUpdatePending_ = false;
+			PendingDirs_.clear ();
+			update ();
+		}
+		else if (!PendingDirs_.isEmpty ())
+		{
+			const auto dirs = PendingDirs_.toList ();
+			PendingDirs_.clear ();
+			update (dirs);
+		}
+	}
+
+	void ItemsFinder::RebuildIndex ()
+	{
+		ID2Item_.clear ();
+		for (const auto& list : Items_)
+			for (const auto& item : list)
+				ID2Item_ [item->GetPermanentID ()] = item;
 	}
 }
 }
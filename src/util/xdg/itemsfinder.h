@@ -30,8 +30,11 @@
 #pragma once
 
 #include <memory>
+#include <boost/optional.hpp>
 #include <QObject>
 #include <QHash>
+#include <QSet>
+#include <QStringList>
 #include <interfaces/core/icoreproxy.h>
 #include "xdgconfig.h"
 
@@ -57,6 +60,11 @@ namespace XDG
 	 * itemsListChanged() signal is emitted each time the list of files
 	 * changes.
 	 *
+	 * The parsed items are cached on disk along with the modification
+	 * times of their files, so the items known during the previous run
+	 * are available right after construction, and subsequent updates
+	 * only reparse the files that have actually changed.
+	 *
 	 * This class does not watch for changes in the said paths. Use the
 	 * ItemsDatabase instead if that functionality is required.
 	 *
@@ -66,12 +74,40 @@ namespace XDG
 	{
 		Q_OBJECT
 
+	public:
+		/** @brief A parsed <code>.desktop</code> file.
+		 */
+		struct CachedFile
+		{
+			/** @brief The modification time of the file, in msecs since
+			 * epoch.
+			 */
+			qint64 MTime_;
+
+			/** @brief The item parsed from the file, or a null pointer
+			 * if the file is not a valid XDG item.
+			 */
+			Item_ptr Item_;
+		};
+
+		/** @brief Maps a directory to the <code>.desktop</code> files
+		 * directly contained in it.
+		 */
+		using Dir2Files_t = QHash<QString, QHash<QString, CachedFile>>;
+	private:
 		ICoreProxy_ptr Proxy_;
 		Cat2Items_t Items_;
+		QHash<QString, Item_ptr> ID2Item_;
+
+		Dir2Files_t Files_;
+		const QString CachePath_;
 
 		bool IsReady_ = false;
 		bool IsScanning_ = false;
 
+		bool FullUpdatePending_ = false;
+		QSet<QString> PendingDirs_;
+
 		const QList<Type> Types_;
 	public:
 		/** @brief Constructs the items finder for the given \em types.
@@ -79,6 +115,10 @@ namespace XDG
 		 * ToPaths() is used to get the list of directories for each of
 		 * the \em types.
 		 *
+		 * If there is a cache of items from the previous run, it is
+		 * loaded synchronously, and the finder is ready right after
+		 * construction.
+		 *
 		 * The ItemsFinder will asynchronously update itself
 		 * automatically a few moments after creation and emit
 		 * itemsListChanged() when the update finishes.
@@ -115,6 +155,8 @@ namespace XDG
 		Cat2Items_t GetItems () const;
 
 		/** @brief Finds an XDG item for the given permanent ID.
+		 *
+		 * This function runs in constant time.
 		 *
 		 * @param[in] permanentID The permanent ID of the item as returned
 		 * by Item::GetPermanentID().
@@ -130,12 +172,34 @@ namespace XDG
 		 * before returning.
 		 *
 		 * Otherwise, this function spawns an asynchronous update process.
+		 *
+		 * Only the files whose modification times have changed since
+		 * the last update are reparsed.
+		 *
+		 * @sa update(const QStringList&)
 		 */
 		void update ();
+
+		/** @brief Updates the items from the given directories only.
+		 *
+		 * This function spawns an asynchronous update process checking
+		 * only the <code>.desktop</code> files contained in the given
+		 * \em dirs and their subdirectories. As with update(), only the
+		 * files that have changed since the last update are reparsed.
+		 *
+		 * @param[in] dirs The directories to rescan.
+		 *
+		 * @sa update()
+		 */
+		void update (const QStringList& dirs);
 	signals:
 		/** @brief Notifies when the list of items changes in any way.
 		 */
 		void itemsListChanged ();
+	private:
+		void StartUpdate (const QStringList&, bool);
+		void HandleUpdated (Dir2Files_t, const boost::optional<Cat2Items_t>&);
+		void RebuildIndex ();
 	};
 }
 }
@@ -30,6 +30,7 @@
 #include "basesettingsmanager.h"
 #include <QtDebug>
 #include <QTimer>
+#include "settinghandle.h"
 #include "settingsthreadmanager.h"
 
 namespace LeechCraft
@@ -40,6 +41,7 @@ namespace Util
 	: QObject (parent)
 	, IsInitializing_ (false)
 	, CleanupScheduled_ (false)
+	, CoalesceWindow_ (DefaultCoalesceWindow)
 	, ReadAllKeys_ (readAllKeys)
 	{
 	}
@@ -145,6 +147,41 @@ namespace Util
 		return std::shared_ptr<void> (nullptr, [this] (void*) { IsInitializing_ = false; });
 	}
 
+	void BaseSettingsManager::RegisterHandle (SettingHandleBase *handle)
+	{
+		const auto& name = handle->GetName ();
+		Handles_.insert (name, handle);
+
+		const auto& value = property (name.constData ());
+		if (value.isValid ())
+			handle->Update (value);
+	}
+
+	void BaseSettingsManager::UnregisterHandle (SettingHandleBase *handle)
+	{
+		Handles_.remove (handle->GetName (), handle);
+	}
+
+	void BaseSettingsManager::SetCoalesceWindow (int msecs)
+	{
+		CoalesceWindow_ = msecs;
+	}
+
+	SettingsWriteStats BaseSettingsManager::GetWriteStats () const
+	{
+		return SettingsThreadManager::Instance ().GetStats (WriteTarget_);
+	}
+
+	const SettingsWriteTarget& BaseSettingsManager::GetWriteTarget ()
+	{
+		if (WriteTarget_.FileName_.isEmpty ())
+		{
+			const auto& settings = GetSettings ();
+			WriteTarget_ = { settings->fileName (), settings->format (), settings->group () };
+		}
+		return WriteTarget_;
+	}
+
 	bool BaseSettingsManager::event (QEvent *e)
 	{
 		if (e->type () != QEvent::DynamicPropertyChange)
@@ -157,8 +194,11 @@ namespace Util
 		const auto& propValue = property (name);
 
 		if (!IsInitializing_)
-			SettingsThreadManager::Instance ().Add (this,
-					propName, propValue);
+			SettingsThreadManager::Instance ().Add (GetWriteTarget (),
+					CoalesceWindow_, propName, propValue);
+
+		for (auto pos = Handles_.find (name); pos != Handles_.end () && pos.key () == name; ++pos)
+			(*pos)->Update (propValue);
 
 		PropertyChanged (propName, propValue);
 
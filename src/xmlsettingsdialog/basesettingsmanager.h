@@ -31,6 +31,7 @@
 
 #include <memory>
 #include <QMap>
+#include <QMultiHash>
 #include <QPair>
 #include <QObject>
 #include <QSettings>
@@ -45,10 +46,56 @@ typedef std::shared_ptr<QSettings> Settings_ptr;
 
 namespace LeechCraft
 {
-class SettingsThread;
-
 namespace Util
 {
+	class SettingHandleBase;
+
+	/** @brief Identifies the storage the settings are written to.
+	 *
+	 * The target is captured from the QSettings object returned by
+	 * BaseSettingsManager::BeginSettings(), so that the settings can
+	 * be written even after the manager itself is destroyed.
+	 */
+	struct SettingsWriteTarget
+	{
+		QString FileName_;
+		QSettings::Format Format_ = QSettings::NativeFormat;
+		QString Group_;
+	};
+
+	/** @brief Write statistics of a settings manager.
+	 *
+	 * @sa BaseSettingsManager::GetWriteStats()
+	 */
+	struct SettingsWriteStats
+	{
+		/** @brief The number of property changes queued for writing.
+		 */
+		quint64 Requested_ = 0;
+
+		/** @brief The number of values actually written after
+		 * coalescing the repeated changes of the same property.
+		 */
+		quint64 Written_ = 0;
+
+		/** @brief The number of times the settings storage has been
+		 * synced.
+		 */
+		quint64 Flushes_ = 0;
+
+		/** @brief The number of syncs that have failed.
+		 */
+		quint64 Failures_ = 0;
+
+		/** @brief The duration of the last sync, in milliseconds.
+		 */
+		qint64 LastFlushTime_ = 0;
+
+		/** @brief The total duration of all syncs, in milliseconds.
+		 */
+		qint64 TotalFlushTime_ = 0;
+	};
+
 	/** @brief Base class for settings manager.
 	 *
 	 * Facilitates creation of settings managers due to providing some
@@ -63,10 +110,13 @@ namespace Util
 		Properties2Object_t ApplyProps_;
 		Properties2Object_t SelectProps_;
 
+		QMultiHash<QByteArray, SettingHandleBase*> Handles_;
+
 		bool IsInitializing_;
 		bool CleanupScheduled_;
 
-		friend class LeechCraft::SettingsThread;
+		int CoalesceWindow_;
+		SettingsWriteTarget WriteTarget_;
 	protected:
 		bool ReadAllKeys_;
 	public:
@@ -173,6 +223,53 @@ namespace Util
 		void OptionSelected (const QByteArray&, const QVariant&);
 
 		std::shared_ptr<void> EnterInitMode ();
+
+		/** @brief Registers the typed settings handle.
+		 *
+		 * The handle is updated with the current value of its property,
+		 * if any, and then on each change of the property.
+		 *
+		 * This function is called by the handles themselves and
+		 * should rarely be used directly.
+		 *
+		 * @param[in] handle The handle to register.
+		 *
+		 * @sa SettingHandle
+		 */
+		void RegisterHandle (SettingHandleBase *handle);
+
+		/** @brief Unregisters the typed settings handle.
+		 *
+		 * @param[in] handle The handle previously registered via
+		 * RegisterHandle().
+		 */
+		void UnregisterHandle (SettingHandleBase *handle);
+
+		/** @brief The default value of the write coalescing window.
+		 *
+		 * @sa SetCoalesceWindow()
+		 */
+		static const int DefaultCoalesceWindow = 1000;
+
+		/** @brief Sets the write coalescing window of this manager.
+		 *
+		 * Changed properties are written to the disk at most once per
+		 * the given time window, repeated changes of the same property
+		 * within the window resulting in a single write of the last
+		 * value. Managers with frequently changing properties may want
+		 * to increase the window, while zero means writing the changes
+		 * as soon as possible.
+		 *
+		 * @param[in] msecs The window in milliseconds.
+		 */
+		void SetCoalesceWindow (int msecs);
+
+		/** @brief Returns the write statistics of this manager.
+		 *
+		 * @return The statistics of the writes since the application
+		 * start.
+		 */
+		SettingsWriteStats GetWriteStats () const;
 	protected:
 		virtual bool event (QEvent*);
 
@@ -198,6 +295,8 @@ namespace Util
 		virtual void PropertyChanged (const QString&, const QVariant&);
 
 		virtual Settings_ptr GetSettings () const;
+	private:
+		const SettingsWriteTarget& GetWriteTarget ();
 	private Q_SLOTS:
 		void scheduleCleanup ();
 		void cleanupObjects ();
@@ -0,0 +1,264 @@
+/**********************************************************************
+ * LeechCraft - modular cross-platform feature rich internet client.
+ * Copyright (C) 2006-2014  Georg Rudoy
+ *
+ * Boost Software License - Version 1.0 - August 17th, 2003
+ *
+ * Permission is hereby granted, free of charge, to any person or organization
+ * obtaining a copy of the software and accompanying documentation covered by
+ * this license (the "Software") to use, reproduce, display, distribute,
+ * execute, and transmit the Software, and to prepare derivative works of the
+ * Software, and to permit third-parties to whom the Software is furnished to
+ * do so, all subject to the following:
+ *
+ * The copyright notices in the Software and this entire statement, including
+ * the above license grant, this restriction and the following disclaimer,
+ * must be included in all copies of the Software, in whole or in part, and
+ * all derivative works of the Software, unless such copies or derivative
+ * works are solely in the form of machine-executable object code generated by
+ * a source language processor.
+ *
+ * THE SOFTWARE IS PROVIDED "AS IS", WITHOUT WARRANTY OF ANY KIND, EXPRESS OR
+ * IMPLIED, INCLUDING BUT NOT LIMITED TO THE WARRANTIES OF MERCHANTABILITY,
+ * FITNESS FOR A PARTICULAR PURPOSE, TITLE AND NON-INFRINGEMENT. IN NO EVENT
+ * SHALL THE COPYRIGHT HOLDERS OR ANYONE DISTRIBUTING THE SOFTWARE BE LIABLE
+ * FOR ANY DAMAGES OR OTHER LIABILITY, WHETHER IN CONTRACT, TORT OR OTHERWISE,
+ * ARISING FROM, OUT OF OR IN CONNECTION WITH THE SOFTWARE OR THE USE OR OTHER
+ * DEALINGS IN THE SOFTWARE.
+ **********************************************************************/
+
+
+#pragma once
+
+#include <atomic>
+#include <memory>
+#include <type_traits>
+#include <QVariant>
+#include "basesettingsmanager.h"
+
+namespace LeechCraft
+{
+namespace Util
+{
+	/** @brief Base class for the typed settings handles.
+	 *
+	 * Handles register themselves in the BaseSettingsManager they are
+	 * created for, and are notified about each change of the property
+	 * they correspond to via Update().
+	 *
+	 * @sa SettingHandle
+	 */
+	class SettingHandleBase
+	{
+		BaseSettingsManager * const Manager_;
+		const QByteArray Name_;
+	public:
+		SettingHandleBase (BaseSettingsManager *manager, const QByteArray& name)
+		: Manager_ { manager }
+		, Name_ { name }
+		{
+		}
+
+		virtual ~SettingHandleBase ()
+		{
+			Manager_->UnregisterHandle (this);
+		}
+
+		SettingHandleBase (const SettingHandleBase&) = delete;
+		SettingHandleBase& operator= (const SettingHandleBase&) = delete;
+
+		/** @brief Returns the name of the property of this handle.
+		 */
+		const QByteArray& GetName () const
+		{
+			return Name_;
+		}
+
+		/** @brief Returns the manager this handle is registered in.
+		 */
+		BaseSettingsManager* GetManager () const
+		{
+			return Manager_;
+		}
+
+		/** @brief Updates the cached value.
+		 *
+		 * This function is called by the BaseSettingsManager each time
+		 * the property changes, possibly from a non-GUI thread.
+		 *
+		 * @param[in] value The new value of the property, or an
+		 * invalid QVariant if the property has been removed.
+		 */
+		virtual void Update (const QVariant& value) = 0;
+	protected:
+		/** @brief Registers the handle in the manager.
+		 *
+		 * This function should be called by the most derived class
+		 * constructor once the handle is ready to accept Update()
+		 * calls.
+		 */
+		void Register ()
+		{
+			Manager_->RegisterHandle (this);
+		}
+	};
+
+	namespace detail
+	{
+		template<typename T>
+		typename std::enable_if<std::is_enum<T>::value, T>::type FromVariant (const QVariant& var)
+		{
+			return static_cast<T> (var.toInt ());
+		}
+
+		template<typename T>
+		typename std::enable_if<!std::is_enum<T>::value, T>::type FromVariant (const QVariant& var)
+		{
+			return var.value<T> ();
+		}
+
+		template<typename T>
+		typename std::enable_if<std::is_enum<T>::value, QVariant>::type ToVariant (T value)
+		{
+			return static_cast<int> (value);
+		}
+
+		template<typename T>
+		typename std::enable_if<!std::is_enum<T>::value, QVariant>::type ToVariant (const T& value)
+		{
+			return QVariant::fromValue (value);
+		}
+
+		template<typename T, bool = std::is_arithmetic<T>::value || std::is_enum<T>::value>
+		class SettingStorage
+		{
+			std::atomic<T> Value_;
+		public:
+			SettingStorage (T value)
+			: Value_ { value }
+			{
+			}
+
+			T Load () const
+			{
+				return Value_.load (std::memory_order_relaxed);
+			}
+
+			void Store (T value)
+			{
+				Value_.store (value, std::memory_order_relaxed);
+			}
+		};
+
+		template<typename T>
+		class SettingStorage<T, false>
+		{
+			std::shared_ptr<const T> Value_;
+		public:
+			SettingStorage (const T& value)
+			: Value_ { std::make_shared<const T> (value) }
+			{
+			}
+
+			T Load () const
+			{
+				return *std::atomic_load (&Value_);
+			}
+
+			void Store (const T& value)
+			{
+				std::atomic_store (&Value_, std::make_shared<const T> (value));
+			}
+		};
+	}
+
+	/** @brief A typed handle caching the value of a setting.
+	 *
+	 * A handle keeps the current value of the given property of a
+	 * BaseSettingsManager converted to the type \em T. The value is
+	 * updated by the manager whenever the property changes, so reading
+	 * it via Get() is just an atomic load instead of a dynamic property
+	 * lookup and a QVariant conversion. Thus handles are suitable for
+	 * the settings that are read on hot paths and from non-GUI
+	 * threads.
+	 *
+	 * Arithmetic and enum types are stored in a std::atomic. Other
+	 * types, like QString or QStringList, are stored in an atomically
+	 * replaced shared pointer, so Get() returns a copy.
+	 *
+	 * Handles are intended to be declared as the members of the
+	 * concrete settings manager, so that the property name and type
+	 * are written only once and misspelled handle names are caught by
+	 * the compiler:
+	 * @code
+	   class XmlSettingsManager : public Util::BaseSettingsManager
+	   {
+	   public:
+	       Util::SettingHandle<bool> EnableFoo_ { this, "EnableFoo", true };
+	       ...
+	   };
+
+	   if (XmlSettingsManager::Instance ().EnableFoo_.Get ())
+	       ...
+	   @endcode
+	 *
+	 * Such members are constructed before the manager constructor
+	 * calls BaseSettingsManager::Init(), so they pick up the stored
+	 * values as well as the defaults from the settings XML later.
+	 *
+	 * The usual property-based API of the manager keeps working for
+	 * the same properties, so existing code can be migrated to the
+	 * handles one call site at a time.
+	 *
+	 * The manager should outlive the handle.
+	 *
+	 * @tparam T The type of the setting value.
+	 */
+	template<typename T>
+	class SettingHandle final : public SettingHandleBase
+	{
+		const T Default_;
+		detail::SettingStorage<T> Value_;
+	public:
+		/** @brief Creates the handle for the given property.
+		 *
+		 * @param[in] manager The settings manager.
+		 * @param[in] name The name of the property.
+		 * @param[in] def The value to use while the property is not
+		 * set.
+		 */
+		SettingHandle (BaseSettingsManager *manager, const QByteArray& name, const T& def = T {})
+		: SettingHandleBase { manager, name }
+		, Default_ { def }
+		, Value_ { def }
+		{
+			Register ();
+		}
+
+		/** @brief Returns the current value of the setting.
+		 *
+		 * This function is thread-safe.
+		 */
+		T Get () const
+		{
+			return Value_.Load ();
+		}
+
+		/** @brief Sets the new value of the setting.
+		 *
+		 * The value is set via the property system of the manager, so
+		 * all the objects subscribed to the property are notified as
+		 * usual.
+		 */
+		void Set (const T& value)
+		{
+			GetManager ()->setProperty (GetName ().constData (), detail::ToVariant<T> (value));
+		}
+
+		void Update (const QVariant& value) override
+		{
+			Value_.Store (value.isValid () ? detail::FromVariant<T> (value) : Default_);
+		}
+	};
+}
+}
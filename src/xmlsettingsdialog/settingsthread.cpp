@@ -27,62 +27,66 @@
  * DEALINGS IN THE SOFTWARE.
  **********************************************************************/
 
+
 #include "settingsthread.h"
+#include <algorithm>
+#include <stdexcept>
 
-#ifndef Q_OS_WIN32
-#include <stdio.h>
-#include <sys/types.h>
-#include <sys/stat.h>
-#include <sys/file.h>
+#if QT_VERSION < 0x050A00 && !defined (Q_OS_WIN32)
+#include <string.h>
+#include <errno.h>
 #include <fcntl.h>
 #include <unistd.h>
+#include <util/sys/fdguard.h>
 #endif
 
-#include <QMutexLocker>
+#include <QDateTime>
+#include <QElapsedTimer>
 #include <QFile>
+#include <QMutexLocker>
 #include <QTimer>
 #include <QtDebug>
-#include <util/sll/qtutil.h>
-#include <util/sll/util.h>
-#include <util/sys/fdguard.h>
-#include "basesettingsmanager.h"
 
 namespace LeechCraft
 {
-	SettingsThread::~SettingsThread ()
-	{
-		QMutexLocker l { &Mutex_ };
-		if (!Pendings_.isEmpty ())
-			qWarning () << Q_FUNC_INFO
-					<< "there are pending settings to be saved, unfortunately they will be lost :(";
-	}
-
-	void SettingsThread::Save (Util::BaseSettingsManager *bsm, QString name, QVariant value)
+	namespace
 	{
-		QMutexLocker l { &Mutex_ };
+		QString GetKey (const Util::SettingsWriteTarget& target)
+		{
+			return target.FileName_ + '\n' + target.Group_;
+		}
 
-		if (Pendings_.isEmpty ())
-			QTimer::singleShot (0, this, SLOT (saveScheduled ()));
-		Pendings_ [bsm].push_back ({ name, value });
-	}
+		qint64 Now ()
+		{
+			return QDateTime::currentMSecsSinceEpoch ();
+		}
 
-	namespace
-	{
-		class FlushRAII
+#if QT_VERSION < 0x050A00 && !defined (Q_OS_WIN32)
+		/* QSettings before Qt 5.10 rewrites the settings file in place,
+		 * so the file is locked and backed up while being synced, and
+		 * the backup is removed once the new contents hit the disk.
+		 */
+		class BackupGuard
 		{
-			Util::DefaultScopeGuard SyncGuard_;
+			const QString Name_;
+			const QString Backup_;
+			const Util::FDGuard FD_;
 		public:
-			FlushRAII (const QString& name)
+			BackupGuard (const QString& name)
+			: Name_ { name }
+			, Backup_ { name + ".bak" }
+			, FD_ { QFile::encodeName (name).constData (), O_WRONLY | O_APPEND }
 			{
-#ifndef Q_OS_WIN32
-				const Util::FDGuard fd { name.toUtf8 ().constData (), O_WRONLY | O_APPEND };
+				// There is nothing to back up yet.
+				if (!FD_)
+					return;
 
 				struct flock fl;
 				fl.l_whence = SEEK_SET;
 				fl.l_start = 0;
 				fl.l_len = 0;
 				fl.l_type = F_WRLCK;
-				if (fcntl (fd, F_SETLKW, &fl))
+				if (fcntl (FD_, F_SETLKW, &fl))
 					throw std::runtime_error
 					{
 						QString { "cannot lock the settings file %1: %2 (%3)" }
@@ -92,79 +96,210 @@ namespace LeechCraft
 								.toStdString ()
 					};
 
-				const auto& backup = name + ".bak";
-#if 0
-				if (rename (name.toUtf8 ().constData (), backup.toUtf8 ().constData ()))
-					throw std::runtime_error
-					{
-						QString { "cannot rename %1 to %2: %3 (%4)" }
-								.arg (name)
-								.arg (backup)
-								.arg (strerror (errno))
-								.arg (errno)
-								.toStdString ()
-					};
-#else
+				// A backup left by an interrupted sync is the last good copy.
+				if (QFile::exists (Backup_))
+					return;
+
 				QFile nameFile { name };
-				if (!nameFile.copy (backup))
+				if (!nameFile.copy (Backup_))
 					throw std::runtime_error
 					{
 						QString { "cannot copy %1 to %2: %3 (%4)" }
 								.arg (name)
-								.arg (backup)
+								.arg (Backup_)
 								.arg (nameFile.errorString ())
 								.arg (nameFile.error ())
 								.toStdString ()
 					};
+			}
+
+			void Commit () const
+			{
+				if (!FD_)
+					return;
+
+				const Util::FDGuard fd { QFile::encodeName (Name_).constData (), O_WRONLY | O_APPEND };
+				if (!fd || fsync (fd))
+				{
+					qWarning () << Q_FUNC_INFO
+							<< "cannot fsync(2) settings file"
+							<< Name_
+							<< "; error:"
+							<< strerror (errno);
+					return;
+				}
+
+				if (!QFile::remove (Backup_))
+					qWarning () << Q_FUNC_INFO
+							<< "cannot remove backup"
+							<< Backup_;
+			}
+		};
+#endif
+	}
+
+	SettingsThread::SettingsThread ()
+	: Timer_ { new QTimer { this } }
+	{
+		Timer_->setSingleShot (true);
+		connect (Timer_,
+				SIGNAL (timeout ()),
+				this,
+				SLOT (saveScheduled ()));
+	}
+
+	SettingsThread::~SettingsThread ()
+	{
+		QMutexLocker l { &Mutex_ };
+		if (!Pendings_.isEmpty ())
+			qWarning () << Q_FUNC_INFO
+					<< "there are pending settings to be saved, unfortunately they will be lost :(";
+	}
+
+	void SettingsThread::Save (const Util::SettingsWriteTarget& target, int window,
+			const QString& name, const QVariant& value)
+	{
+		const auto& key = GetKey (target);
+
+		QMutexLocker l { &Mutex_ };
+
+		++Stats_ [key].Requested_;
+
+		auto& pending = Pendings_ [key];
+		const bool isNew = pending.Values_.isEmpty ();
+		pending.Values_ [name] = value;
+		if (!isNew)
+			return;
+
+		pending.Target_ = target;
+		pending.Deadline_ = Now () + std::max (window, 0);
+
+		// The timer lives in the worker thread, and the caller may live
+		// in any thread, including the ones without an event loop.
+		if (!RescheduleQueued_)
+		{
+			RescheduleQueued_ = true;
+			QMetaObject::invokeMethod (this, "reschedule", Qt::QueuedConnection);
+		}
+	}
+
+	Util::SettingsWriteStats SettingsThread::GetStats (const Util::SettingsWriteTarget& target) const
+	{
+		QMutexLocker l { &Mutex_ };
+		return Stats_.value (GetKey (target));
+	}
+
+	void SettingsThread::Write (const Pending& pending)
+	{
+		QElapsedTimer timer;
+		timer.start ();
+
+		bool ok = true;
+		try
+		{
+			// QSettings::sync() writes into a temporary file and renames
+			// it over the original one only since Qt 5.10.
+#if QT_VERSION < 0x050A00 && !defined (Q_OS_WIN32)
+			const BackupGuard backup { pending.Target_.FileName_ };
 #endif
 
-				SyncGuard_ = Util::MakeScopeGuard ([name, backup]
-						{
-							const Util::FDGuard fd { name.toUtf8 ().constData (), O_WRONLY | O_APPEND };
-							if (!fd)
-							{
-								qWarning () << Q_FUNC_INFO
-										<< "cannot open(2) settings file"
-										<< name
-										<< "; error:"
-										<< strerror (errno);
-								return;
-							}
-
-							if (fsync (fd))
-							{
-								qWarning () << Q_FUNC_INFO
-										<< "cannot fsync(2) backup file"
-										<< name
-										<< "; error:"
-										<< strerror (errno);
-								return;
-							}
-
-							if (!QFile::remove (backup))
-								qWarning () << Q_FUNC_INFO
-										<< "oops! cannot remove backup";
-						});
+			QSettings settings { pending.Target_.FileName_, pending.Target_.Format_ };
+#if QT_VERSION >= 0x050A00
+			settings.setAtomicSyncRequired (true);
 #endif
+			if (!pending.Target_.Group_.isEmpty ())
+				settings.beginGroup (pending.Target_.Group_);
+
+			for (auto i = pending.Values_.begin (), end = pending.Values_.end (); i != end; ++i)
+				settings.setValue (i.key (), i.value ());
+
+			settings.sync ();
+			if (settings.status () != QSettings::NoError)
+			{
+				qWarning () << Q_FUNC_INFO
+						<< "unable to write settings to"
+						<< pending.Target_.FileName_
+						<< settings.status ();
+				ok = false;
 			}
-		};
+#if QT_VERSION < 0x050A00 && !defined (Q_OS_WIN32)
+			else
+				backup.Commit ();
+#endif
+		}
+		catch (const std::exception& e)
+		{
+			qWarning () << Q_FUNC_INFO
+					<< "unable to write settings to"
+					<< pending.Target_.FileName_
+					<< e.what ();
+			ok = false;
+		}
+
+		const auto elapsed = timer.elapsed ();
+
+		QMutexLocker l { &Mutex_ };
+		auto& stats = Stats_ [GetKey (pending.Target_)];
+		++stats.Flushes_;
+		if (!ok)
+			++stats.Failures_;
+		stats.Written_ += pending.Values_.size ();
+		stats.LastFlushTime_ = elapsed;
+		stats.TotalFlushTime_ += elapsed;
 	}
 
-	void SettingsThread::saveScheduled ()
+	void SettingsThread::flush ()
 	{
-		decltype (Pendings_) pendings;
+		{
+			QMutexLocker l { &Mutex_ };
+			for (auto& pending : Pendings_)
+				pending.Deadline_ = 0;
+		}
+
+		saveScheduled ();
+	}
+
+	void SettingsThread::reschedule ()
+	{
+		qint64 nearest = -1;
 
 		{
 			QMutexLocker l { &Mutex_ };
-			using std::swap;
-			swap (pendings, Pendings_);
+			RescheduleQueued_ = false;
+			for (const auto& pending : Pendings_)
+				if (nearest < 0 || pending.Deadline_ < nearest)
+					nearest = pending.Deadline_;
+		}
+
+		if (nearest < 0)
+		{
+			Timer_->stop ();
+			return;
 		}
 
-		for (const auto& pair : Util::Stlize (pendings))
+		Timer_->start (static_cast<int> (std::max<qint64> (nearest - Now (), 0)));
+	}
+
+	void SettingsThread::saveScheduled ()
+	{
+		QList<Pending> due;
+
 		{
-			const auto& s = pair.first->GetSettings ();
-			for (const auto& p : pair.second)
-				s->setValue (p.first, p.second);
+			QMutexLocker l { &Mutex_ };
+			const auto now = Now ();
+			for (auto i = Pendings_.begin (); i != Pendings_.end (); )
+				if (i->Deadline_ <= now)
+				{
+					due << *i;
+					i = Pendings_.erase (i);
+				}
+				else
+					++i;
 		}
+
+		for (const auto& pending : due)
+			Write (pending);
+
+		reschedule ();
 	}
 }
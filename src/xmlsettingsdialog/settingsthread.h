@@ -27,31 +27,50 @@
  * DEALINGS IN THE SOFTWARE.
  **********************************************************************/
 
+
 #pragma once
 
+#include <QHash>
 #include <QMap>
 #include <QVariant>
 #include <QMutex>
+#include "basesettingsmanager.h"
+
+class QTimer;
 
 namespace LeechCraft
 {
-namespace Util
-{
-	class BaseSettingsManager;
-}
-
 	class SettingsThread : public QObject
 	{
 		Q_OBJECT
 
-		QMutex Mutex_;
-		QMap<Util::BaseSettingsManager*, QList<QPair<QString, QVariant>>> Pendings_;
+		struct Pending
+		{
+			Util::SettingsWriteTarget Target_;
+			QMap<QString, QVariant> Values_;
+			qint64 Deadline_;
+		};
+
+		mutable QMutex Mutex_;
+		QHash<QString, Pending> Pendings_;
+		QHash<QString, Util::SettingsWriteStats> Stats_;
+		bool RescheduleQueued_ = false;
+
+		QTimer * const Timer_;
 	public:
-		using QObject::QObject;
+		SettingsThread ();
 		~SettingsThread ();
 
-		void Save (Util::BaseSettingsManager*, QString, QVariant);
+		void Save (const Util::SettingsWriteTarget&, int window,
+				const QString& name, const QVariant& value);
+
+		Util::SettingsWriteStats GetStats (const Util::SettingsWriteTarget&) const;
+	private:
+		void Write (const Pending&);
+	public slots:
+		void flush ();
 	private slots:
+		void reschedule ();
 		void saveScheduled ();
 	};
 }
@@ -45,6 +45,9 @@ namespace LeechCraft
 
 	SettingsThreadManager::~SettingsThreadManager ()
 	{
+		if (Thread_->isRunning ())
+			QMetaObject::invokeMethod (Worker_.get (), "flush", Qt::BlockingQueuedConnection);
+
 		Thread_->quit ();
 
 		if (Thread_->isRunning () && !Thread_->wait (10000))
@@ -57,9 +60,14 @@ namespace LeechCraft
 		return stm;
 	}
 
-	void SettingsThreadManager::Add (Util::BaseSettingsManager *bsm,
+	void SettingsThreadManager::Add (const Util::SettingsWriteTarget& target, int window,
 			const QString& name, const QVariant& value)
 	{
-		Worker_->Save (bsm, name, value);
+		Worker_->Save (target, window, name, value);
+	}
+
+	Util::SettingsWriteStats SettingsThreadManager::GetStats (const Util::SettingsWriteTarget& target) const
+	{
+		return Worker_->GetStats (target);
 	}
 }
@@ -36,7 +36,8 @@ namespace LeechCraft
 {
 namespace Util
 {
-	class BaseSettingsManager;
+	struct SettingsWriteTarget;
+	struct SettingsWriteStats;
 }
 
 	class SettingsThread;
@@ -57,7 +58,9 @@ namespace Util
 
 		static SettingsThreadManager& Instance ();
 
-		void Add (Util::BaseSettingsManager*,
+		void Add (const Util::SettingsWriteTarget& target, int window,
 				const QString& name, const QVariant& value);
+
+		Util::SettingsWriteStats GetStats (const Util::SettingsWriteTarget& target) const;
 	};
 }
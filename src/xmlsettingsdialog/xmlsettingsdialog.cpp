@@ -66,6 +66,12 @@ namespace Util
 		mainLay->setContentsMargins (0, 0, 0, 0);
 		mainLay->addWidget (Pages_);
 		Widget_->setLayout (mainLay);
+
+		Widget_->installEventFilter (this);
+		connect (Pages_,
+				SIGNAL (currentChanged (int)),
+				this,
+				SLOT (handleCurrentPageChanged (int)));
 	}
 
 	XmlSettingsDialog::~XmlSettingsDialog ()
@@ -141,10 +147,12 @@ namespace Util
 				declaration = declaration.nextSiblingElement ("declare");
 			}
 
+			// The widgets are built by BuildPage() when the page is shown.
 			QDomElement pageChild = root.firstChildElement ("page");
 			while (!pageChild.isNull ())
 			{
-				ParsePage (pageChild);
+				ReadDefaults (pageChild);
+				RegisterPage (pageChild);
 				pageChild = pageChild.nextSiblingElement ("page");
 			}
 		}
@@ -293,6 +301,8 @@ namespace Util
 
 	QList<int> XmlSettingsDialog::HighlightMatches (const QString& query)
 	{
+		LastQuery_ = query;
+
 		QList<int> result;
 		if (query.isEmpty ())
 		{
@@ -313,6 +323,13 @@ namespace Util
 				continue;
 			}
 
+			if (!PendingPages_.at (i).isNull ())
+			{
+				if (PendingPageMatches (i, query))
+					result << i;
+				continue;
+			}
+
 			if (HighlightWidget (Pages_->widget (i), query, HandlersManager_))
 				result << i;
 		}
@@ -322,6 +339,8 @@ namespace Util
 
 	void XmlSettingsDialog::SetCustomWidget (const QString& name, QWidget *widget)
 	{
+		BuildPage (FindPendingPage (name));
+
 		const auto& widgets = Widget_->findChildren<QWidget*> (name);
 		if (!widgets.size ())
 			throw std::runtime_error (qPrintable (QString ("Widget %1 not "
@@ -341,6 +360,8 @@ namespace Util
 	void XmlSettingsDialog::SetDataSource (const QString& property,
 			QAbstractItemModel *dataSource)
 	{
+		BuildPage (FindPendingPage (property));
+
 		HandlersManager_->SetDataSource (property, dataSource, this);
 	}
 
@@ -376,7 +397,33 @@ namespace Util
 			DefaultLang_ = decl.attribute ("defaultlang");
 	}
 
-	void XmlSettingsDialog::ParsePage (const QDomElement& page)
+	void XmlSettingsDialog::ReadDefaults (const QDomElement& entity)
+	{
+		auto item = entity.firstChildElement ("item");
+		while (!item.isNull ())
+		{
+			const auto& property = item.attribute ("property");
+			if (!item.attribute ("type").isEmpty () && !property.isEmpty ())
+				WorkingObject_->setProperty (property.toLatin1 ().constData (), GetValue (item));
+
+			// Checkable groupboxes are items containing other items.
+			ReadDefaults (item);
+
+			item = item.nextSiblingElement ("item");
+		}
+
+		for (const auto& tagName : { "groupbox", "scrollarea", "tab" })
+		{
+			auto child = entity.firstChildElement (tagName);
+			while (!child.isNull ())
+			{
+				ReadDefaults (child);
+				child = child.nextSiblingElement (tagName);
+			}
+		}
+	}
+
+	void XmlSettingsDialog::RegisterPage (const QDomElement& page)
 	{
 		Titles_ << GetLabel (page);
 
@@ -399,6 +446,23 @@ namespace Util
 		lay->setContentsMargins (0, 0, 0, 0);
 		baseWidget->setLayout (lay);
 
+		PendingPages_ << page;
+	}
+
+	void XmlSettingsDialog::BuildPage (int index)
+	{
+		if (index < 0 || index >= PendingPages_.size ())
+			return;
+
+		const auto page = PendingPages_.at (index);
+		if (page.isNull ())
+			return;
+
+		PendingPages_ [index] = QDomElement {};
+
+		const auto baseWidget = Pages_->widget (index);
+		const auto lay = qobject_cast<QGridLayout*> (baseWidget->layout ());
+
 		ParseEntity (page, baseWidget);
 
 		bool foundExpanding = false;
@@ -413,6 +477,37 @@ namespace Util
 		if (!foundExpanding)
 			lay->addItem (new QSpacerItem (0, 0, QSizePolicy::Minimum, QSizePolicy::Expanding),
 					lay->rowCount (), 0, 1, 2);
+
+		if (!LastQuery_.isEmpty () &&
+				!Titles_.at (index).contains (LastQuery_, Qt::CaseInsensitive))
+			HighlightWidget (baseWidget, LastQuery_, HandlersManager_);
+	}
+
+	int XmlSettingsDialog::FindPendingPage (const QString& name) const
+	{
+		for (int i = 0; i < PendingPages_.size (); ++i)
+		{
+			const auto& items = PendingPages_.at (i).elementsByTagName ("item");
+			for (int j = 0; j < items.size (); ++j)
+			{
+				const auto& item = items.at (j).toElement ();
+				if (item.attribute ("property") == name ||
+						item.attribute ("name") == name)
+					return i;
+			}
+		}
+
+		return -1;
+	}
+
+	bool XmlSettingsDialog::PendingPageMatches (int index, const QString& query) const
+	{
+		const auto& labels = PendingPages_.at (index).elementsByTagName ("label");
+		for (int i = 0; i < labels.size (); ++i)
+			if (GetLabel (labels.at (i).parentNode ().toElement ()).contains (query, Qt::CaseInsensitive))
+				return true;
+
+		return false;
 	}
 
 	void XmlSettingsDialog::ParseEntity (const QDomElement& entity, QWidget *baseWidget)
@@ -507,15 +602,11 @@ namespace Util
 	{
 		const QString& type = item.attribute ("type");
 
-		const QString& property = item.attribute ("property");
-
 		if (type.isEmpty () || type.isNull ())
 			return;
 
 		if (!HandlersManager_->Handle (item, baseWidget))
 			qWarning () << Q_FUNC_INFO << "unhandled type" << type;
-
-		WorkingObject_->setProperty (property.toLatin1 ().constData (), GetValue (item));
 	}
 
 #if defined (Q_OS_WIN32)
@@ -714,6 +805,13 @@ namespace Util
 
 	bool XmlSettingsDialog::eventFilter (QObject *obj, QEvent *event)
 	{
+		if (obj == Widget_)
+		{
+			if (event->type () == QEvent::Show)
+				BuildPage (Pages_->currentIndex ());
+			return false;
+		}
+
 		if (event->type () == QEvent::DynamicPropertyChange)
 		{
 			const auto& name = static_cast<QDynamicPropertyChangeEvent*> (event)->propertyName ();
@@ -785,7 +883,9 @@ namespace Util
 		if (name.isEmpty ())
 			return;
 
-		auto child = findChild<QWidget*> (name);
+		BuildPage (FindPendingPage (name));
+
+		auto child = Widget_->findChild<QWidget*> (name);
 		if (!child)
 		{
 			qWarning () << Q_FUNC_INFO
@@ -814,5 +914,10 @@ namespace Util
 				tw->setCurrentWidget (lastTabChild);
 		}
 	}
+
+	void XmlSettingsDialog::handleCurrentPageChanged (int index)
+	{
+		BuildPage (index);
+	}
 }
 }
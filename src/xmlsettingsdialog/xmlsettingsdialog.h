@@ -34,13 +34,13 @@
 #include <QStringList>
 #include <QMap>
 #include <QVariant>
+#include <QDomElement>
 #include "xsdconfig.h"
 
 class QWidget;
 class QStackedWidget;
 class QListWidget;
 class QPushButton;
-class QDomElement;
 class QGridLayout;
 class QDomDocument;
 class QAbstractItemModel;
@@ -63,6 +63,8 @@ namespace Util
 
 		QStringList Titles_;
 		QList<QStringList> IconNames_;
+		QList<QDomElement> PendingPages_;
+		QString LastQuery_;
 
 		BaseSettingsManager *WorkingObject_ = nullptr;
 		QString DefaultLang_ = "en";
@@ -252,7 +254,11 @@ namespace Util
 		QString GetBasename () const;
 	private:
 		void HandleDeclaration (const QDomElement&);
-		void ParsePage (const QDomElement&);
+		void ReadDefaults (const QDomElement&);
+		void RegisterPage (const QDomElement&);
+		void BuildPage (int);
+		int FindPendingPage (const QString&) const;
+		bool PendingPageMatches (int, const QString&) const;
 		void ParseItem (const QDomElement&, QWidget*);
 		void UpdateXml (bool = false);
 		void UpdateSingle (const QString&, const QVariant&, QDomElement&);
@@ -267,6 +273,7 @@ namespace Util
 		void handleMoreThisStuffRequested ();
 		void handlePushButtonReleased ();
 		void handleShowPageRequested (Util::BaseSettingsManager*, const QString&);
+		void handleCurrentPageChanged (int);
 	Q_SIGNALS:
 		void pushButtonClicked (const QString&);
 		void moreThisStuffRequested (const QString&);